@@ -0,0 +1,154 @@
+/* -------------------------------------------------------------------------- *
+ *                                   Lepton                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the Lepton expression parser originating from              *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "lepton/CompiledExpression.h"
+#include "lepton/Operation.h"
+#include "lepton/ParsedExpression.h"
+
+using namespace Lepton;
+using namespace std;
+
+CompiledExpression::CompiledExpression() : resultIndex(-1) {
+}
+
+CompiledExpression::CompiledExpression(const ParsedExpression& expression) : resultIndex(-1) {
+    ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+    vector<pair<ExpressionTreeNode, int> > temps;
+    resultIndex = compileExpression(expr.getRootNode(), temps);
+    int maxArguments = 1;
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i]->getNumArguments() > maxArguments)
+            maxArguments = operation[i]->getNumArguments();
+    argValues.resize(maxArguments);
+}
+
+CompiledExpression::~CompiledExpression() {
+    for (int i = 0; i < (int) operation.size(); i++)
+        delete operation[i];
+}
+
+CompiledExpression::CompiledExpression(const CompiledExpression& expression) {
+    *this = expression;
+}
+
+CompiledExpression& CompiledExpression::operator=(const CompiledExpression& expression) {
+    if (&expression == this)
+        return *this;
+    for (int i = 0; i < (int) operation.size(); i++)
+        delete operation[i];
+    variableIndices = expression.variableIndices;
+    variableNames = expression.variableNames;
+    variablesToCopy = expression.variablesToCopy;
+    arguments = expression.arguments;
+    target = expression.target;
+    workspace = expression.workspace;
+    argValues = expression.argValues;
+    resultIndex = expression.resultIndex;
+    operation.resize(expression.operation.size());
+    for (int i = 0; i < (int) operation.size(); i++)
+        operation[i] = expression.operation[i]->clone();
+    return *this;
+}
+
+int CompiledExpression::compileExpression(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps) {
+    // If this subexpression has already been computed, reuse the result.
+
+    for (int i = 0; i < (int) temps.size(); i++)
+        if (temps[i].first == node)
+            return temps[i].second;
+    const Operation& op = node.getOperation();
+    int index = workspace.size();
+    if (op.getId() == Operation::VARIABLE) {
+        variableIndices[op.getName()] = index;
+        variableNames.insert(op.getName());
+        workspace.push_back(0.0);
+    }
+    else if (op.getId() == Operation::CONSTANT)
+        workspace.push_back(dynamic_cast<const Operation::Constant&>(op).getValue());
+    else {
+        vector<int> args;
+        for (int i = 0; i < (int) node.getChildren().size(); i++)
+            args.push_back(compileExpression(node.getChildren()[i], temps));
+        index = workspace.size();
+        workspace.push_back(0.0);
+        arguments.push_back(args);
+        target.push_back(index);
+        operation.push_back(op.clone());
+    }
+    temps.push_back(make_pair(node, index));
+    return index;
+}
+
+const set<string>& CompiledExpression::getVariables() const {
+    return variableNames;
+}
+
+double& CompiledExpression::getVariableReference(const string& name) {
+    map<string, int>::const_iterator iter = variableIndices.find(name);
+    if (iter == variableIndices.end())
+        throw Exception("getVariableReference: Unknown variable '"+name+"'");
+    for (int i = 0; i < (int) variablesToCopy.size(); i++)
+        if (variablesToCopy[i].second == iter->second)
+            throw Exception("getVariableReference: The location of variable '"+name+"' has been set with setVariableLocations()");
+    return workspace[iter->second];
+}
+
+void CompiledExpression::setVariableLocations(const map<string, double*>& variableLocations) {
+    variablesToCopy.clear();
+    for (map<string, int>::const_iterator iter = variableIndices.begin(); iter != variableIndices.end(); ++iter) {
+        map<string, double*>::const_iterator location = variableLocations.find(iter->first);
+        if (location != variableLocations.end())
+            variablesToCopy.push_back(make_pair(location->second, iter->second));
+    }
+}
+
+double CompiledExpression::evaluate() const {
+    if (resultIndex == -1)
+        throw Exception("evaluate: The CompiledExpression has not been initialized");
+    for (int i = 0; i < (int) variablesToCopy.size(); i++)
+        workspace[variablesToCopy[i].second] = *variablesToCopy[i].first;
+
+    // Loop over the operations and evaluate each one.  Operations other than variables never look at
+    // the variable map, so an empty one is passed.
+
+    static const map<string, double> noVariables;
+    for (int step = 0; step < (int) operation.size(); step++) {
+        const vector<int>& args = arguments[step];
+        if (args.size() == 1)
+            workspace[target[step]] = operation[step]->evaluate(&workspace[args[0]], noVariables);
+        else {
+            for (int i = 0; i < (int) args.size(); i++)
+                argValues[i] = workspace[args[i]];
+            workspace[target[step]] = operation[step]->evaluate(&argValues[0], noVariables);
+        }
+    }
+    return workspace[resultIndex];
+}
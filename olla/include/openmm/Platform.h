@@ -124,6 +124,16 @@ public:
      * @param properties a set of values for platform-specific properties.  Keys are the property names.
      */
     virtual void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
+    /**
+     * This is called instead of contextCreated() when a new Context is created as a clone of an existing one.
+     * Both Contexts use the same System, so the Platform may share any data that depends only on the System
+     * between them rather than computing it again.  The default implementation calls contextCreated(),
+     * passing it the property values of the original Context.
+     *
+     * @param context          the newly created context
+     * @param originalContext  the context it was cloned from
+     */
+    virtual void linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const;
     /**
      * This is called whenever a Context is deleted.  It gives the Platform a chance to clean up
      * any platform-specific data that was stored in it.
@@ -199,14 +209,32 @@ public:
     static void loadPluginLibrary(const std::string& file);
     /**
      * Load multiple dynamic libraries (DLLs) which contain OpenMM plugins from a single directory.
-     * This method loops over every file contained in the specified directory and calls loadPluginLibrary()
-     * for each one.  If an error occurs while trying to load a particular file, that file is simply
-     * ignored.
+     *
+     * This only scans the directory for files.  Loading and initializing the libraries is deferred until
+     * they might be needed: when the list of all Platforms is requested (by getNumPlatforms(), getPlatform(),
+     * or findPlatform()), when getPlatformByName() is called with a name that has not been registered, or
+     * when a Platform is asked for a kernel it does not support.  A program that only uses a Platform built
+     * into the main library (such as Reference) therefore never loads plugins for other hardware.  Loading
+     * is serialized by a lock, so these methods may safely be called from several threads at once.
+     *
+     * If an error occurs while trying to load a particular file, that file is skipped.  A description
+     * of the error can be retrieved with getPluginLoadFailures().
+     *
+     * Because nothing has been loaded yet when this returns, the list it returns includes every file
+     * that was found, not only the ones that load successfully.  (Earlier versions loaded the libraries
+     * immediately and returned only the successful ones.)  Call getPluginLoadFailures() to find out
+     * which of them could not be loaded.
      *
      * @param directory    the path to the directory containing libraries to load
-     * @return the names of all files which were successfully loaded as libraries
+     * @return the names of all files which were found in the directory and will be loaded
      */
     static std::vector<std::string> loadPluginsFromDirectory(const std::string& directory);
+    /**
+     * Get a description of every error that has occurred while loading libraries found by
+     * loadPluginsFromDirectory().  Any libraries that have been found but not loaded yet are
+     * loaded first, so the result covers every directory scanned so far.
+     */
+    static std::vector<std::string> getPluginLoadFailures();
     /**
      * Get the default directory from which to load plugins.  If the environment variable
      * OPENMM_PLUGIN_DIR is set, this returns its value.  Otherwise, it returns a platform
@@ -107,6 +107,15 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     virtual double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups) = 0;
+    /**
+     * Get whether every force kernel on this platform returns its contribution to the energy directly, rather
+     * than adding it to an internal buffer, and whether an energy-only computation leaves the forces unchanged.
+     * If so, the energy of a subset of ForceImpls can be computed by calling calcForcesAndEnergy() on only those
+     * ones.  Otherwise finishComputation() includes the energy of every ForceImpl in the selected force groups.
+     */
+    virtual bool reportsEnergyPerForce() const {
+        return false;
+    }
 };
 
 /**
@@ -570,6 +579,32 @@ public:
      * @param force      the NonbondedForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const NonbondedForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context, when it is known that only the parameters of certain
+     * particles and exceptions have changed since the last time parameters were copied.  The default
+     * implementation simply calls copyParametersToContext().  Platforms can override it to avoid the
+     * cost of copying every parameter when only a few have changed.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the NonbondedForce to copy the parameters from
+     * @param particles  the indices of the particles whose parameters may have changed, in increasing order
+     * @param exceptions the indices of the exceptions whose parameters may have changed, in increasing order
+     */
+    virtual void copyChangedParametersToContext(ContextImpl& context, const NonbondedForce& force, const std::vector<int>& particles, const std::vector<int>& exceptions) {
+        copyParametersToContext(context, force);
+    }
+    /**
+     * Calculate only the interactions that involve at least one particle from a subset.  The default
+     * implementation returns false to indicate this is not supported.  See ForceImpl::calcSubsetForcesAndEnergy().
+     *
+     * @param context    the context in which to execute this kernel
+     * @param subset     the indices of the particles in the subset
+     * @param energy     on exit, the energy of the interactions that were computed
+     * @return true if the interactions were computed, false if this is not supported
+     */
+    virtual bool executeSubset(ContextImpl& context, const std::vector<int>& subset, double& energy) {
+        return false;
+    }
 };
 
 /**
@@ -610,6 +645,18 @@ public:
      * @param force      the CustomNonbondedForce to copy the parameters from
      */
     virtual void copyParametersToContext(ContextImpl& context, const CustomNonbondedForce& force) = 0;
+    /**
+     * Copy changed parameters over to a context, when it is known that only the parameters of certain
+     * particles have changed since the last time parameters were copied.  The default implementation
+     * simply calls copyParametersToContext().
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the CustomNonbondedForce to copy the parameters from
+     * @param particles  the indices of the particles whose parameters may have changed, in increasing order
+     */
+    virtual void copyChangedParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, const std::vector<int>& particles) {
+        copyParametersToContext(context, force);
+    }
 };
 
 /**
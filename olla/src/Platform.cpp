@@ -34,6 +34,7 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/Kernel.h"
 #include "openmm/KernelFactory.h"
+#include "openmm/internal/ContextImpl.h"
 #ifdef WIN32
 #include <windows.h>
 #include <sstream>
@@ -43,6 +44,7 @@
 #include <cstdlib>
 #endif
 #include <set>
+#include <pthread.h>
 
 #include "ReferencePlatform.h"
 
@@ -60,6 +62,35 @@ static int registerPlatforms() {
 
 static int platformInitializer = registerPlatforms();
 
+static void loadPendingPlugins();
+
+/**
+ * Plugins may be loaded lazily from any method that looks up a Platform or kernel, so the lists of Platforms,
+ * kernel factories, and pending plugins are guarded by a single lock.  It is recursive because initializing
+ * a plugin calls back into those same methods.
+ */
+static pthread_once_t pluginLockOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pluginLock;
+
+static void initPluginLock() {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&pluginLock, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+class PluginLocker {
+public:
+    PluginLocker() {
+        pthread_once(&pluginLockOnce, initPluginLock);
+        pthread_mutex_lock(&pluginLock);
+    }
+    ~PluginLocker() {
+        pthread_mutex_unlock(&pluginLock);
+    }
+};
+
 Platform::~Platform() {
     set<KernelFactory*> uniqueKernelFactories;
     for (map<string, KernelFactory*>::const_iterator iter = kernelFactories.begin(); iter != kernelFactories.end(); ++iter)
@@ -94,24 +125,45 @@ void Platform::setPropertyDefaultValue(const string& property, const string& val
 void Platform::contextCreated(ContextImpl& context, const map<string, string>& properties) const {
 }
 
+void Platform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
+    map<string, string> properties;
+    for (int i = 0; i < (int) platformProperties.size(); i++)
+        properties[platformProperties[i]] = getPropertyValue(originalContext.getOwner(), platformProperties[i]);
+    contextCreated(context, properties);
+}
+
 void Platform::contextDestroyed(ContextImpl& context) const {
 }
 
 void Platform::registerKernelFactory(const string& name, KernelFactory* factory) {
+    PluginLocker locker;
     kernelFactories[name] = factory;
 }
 
 bool Platform::supportsKernels(const vector<string>& kernelNames) const {
+    PluginLocker locker;
     for (int i = 0; i < (int) kernelNames.size(); ++i)
-        if (kernelFactories.find(kernelNames[i]) == kernelFactories.end())
-            return false;
+        if (kernelFactories.find(kernelNames[i]) == kernelFactories.end()) {
+            // A plugin that has not been loaded yet might provide it.
+
+            loadPendingPlugins();
+            if (kernelFactories.find(kernelNames[i]) == kernelFactories.end())
+                return false;
+        }
     return true;
 }
 
 Kernel Platform::createKernel(const string& name, ContextImpl& context) const {
-    if (kernelFactories.find(name) == kernelFactories.end())
-        throw OpenMMException("Called createKernel() on a Platform which does not support the requested kernel");
-    return Kernel(kernelFactories.find(name)->second->createKernelImpl(name, *this, context));
+    KernelFactory* factory;
+    {
+        PluginLocker locker;
+        if (kernelFactories.find(name) == kernelFactories.end())
+            loadPendingPlugins();
+        if (kernelFactories.find(name) == kernelFactories.end())
+            throw OpenMMException("Called createKernel() on a Platform which does not support the requested kernel");
+        factory = kernelFactories.find(name)->second;
+    }
+    return Kernel(factory->createKernelImpl(name, *this, context));
 }
 vector<Platform*>& Platform::getPlatforms() {
     static vector<Platform*> platforms;
@@ -119,25 +171,40 @@ vector<Platform*>& Platform::getPlatforms() {
 }
 
 void Platform::registerPlatform(Platform* platform) {
+    PluginLocker locker;
     getPlatforms().push_back(platform);
 }
 
 int Platform::getNumPlatforms() {
+    PluginLocker locker;
+    loadPendingPlugins();
     return getPlatforms().size();
 }
 
 Platform& Platform::getPlatform(int index) {
+    PluginLocker locker;
+    loadPendingPlugins();
     return *getPlatforms()[index];
 }
 
 Platform& Platform::getPlatformByName(const string& name) {
-    for (int i = 0; i < getNumPlatforms(); i++)
-        if (getPlatform(i).getName() == name)
-            return getPlatform(i);
+    // Only load plugins if the Platform is not already registered.
+
+    PluginLocker locker;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        vector<Platform*>& platforms = getPlatforms();
+        for (int i = 0; i < (int) platforms.size(); i++)
+            if (platforms[i]->getName() == name)
+                return *platforms[i];
+        if (attempt == 0)
+            loadPendingPlugins();
+    }
     throw OpenMMException("There is no registered Platform called \""+name+"\"");
 }
 
 Platform& Platform::findPlatform(const vector<string>& kernelNames) {
+    PluginLocker locker;
+    loadPendingPlugins();
     Platform* best = 0;
     vector<Platform*>& platforms = getPlatforms();
     double speed = 0.0;
@@ -152,6 +219,33 @@ Platform& Platform::findPlatform(const vector<string>& kernelNames) {
     return *best;
 }
 
+static vector<string>& getPendingPluginFiles() {
+    static vector<string> files;
+    return files;
+}
+
+static vector<string>& getPluginLoadFailureList() {
+    static vector<string> failures;
+    return failures;
+}
+
+/**
+ * Call one of a plugin's initialization functions.  If failures is NULL, exceptions are passed on to the caller.
+ * Otherwise they are recorded there.
+ */
+static void callInitializer(void (*init)(), const string& file, vector<string>* failures) {
+    if (failures == NULL) {
+        (*init)();
+        return;
+    }
+    try {
+        (*init)();
+    }
+    catch (exception& ex) {
+        failures->push_back("Error initializing library "+file+": "+ex.what());
+    }
+}
+
 #ifdef WIN32
 static HMODULE loadOneLibrary(const string& file) {
     // Tell Windows not to bother the user with ugly error boxes.
@@ -166,19 +260,15 @@ static HMODULE loadOneLibrary(const string& file) {
     return handle;
 }
 
-static void initializePlugins(vector<HMODULE>& plugins) {
-    for (int i = 0; i < (int) plugins.size(); i++) {
-        void (*init)();
-        *(void **)(&init) = GetProcAddress(plugins[i], "registerPlatforms");
-        if (init != NULL)
-            (*init)();
-    }
-    for (int i = 0; i < (int) plugins.size(); i++) {
-        void (*init)();
-        *(void **)(&init) = GetProcAddress(plugins[i], "registerKernelFactories");
-        if (init != NULL)
-            (*init)();
-    }
+static void initializePlugins(vector<HMODULE>& plugins, const vector<string>& files, vector<string>* failures=NULL) {
+    const char* functionNames[] = {"registerPlatforms", "registerKernelFactories"};
+    for (int stage = 0; stage < 2; stage++)
+        for (int i = 0; i < (int) plugins.size(); i++) {
+            void (*init)();
+            *(void **)(&init) = GetProcAddress(plugins[i], functionNames[stage]);
+            if (init != NULL)
+                callInitializer(init, files[i], failures);
+        }
 }
 #else
 static void* loadOneLibrary(const string& file) {
@@ -188,19 +278,15 @@ static void* loadOneLibrary(const string& file) {
     return handle;
 }
 
-static void initializePlugins(vector<void*>& plugins) {
-    for (int i = 0; i < (int) plugins.size(); i++) {
-        void (*init)();
-        *(void **)(&init) = dlsym(plugins[i], "registerPlatforms");
-        if (init != NULL)
-            (*init)();
-    }
-    for (int i = 0; i < (int) plugins.size(); i++) {
-        void (*init)();
-        *(void **)(&init) = dlsym(plugins[i], "registerKernelFactories");
-        if (init != NULL)
-            (*init)();
-    }
+static void initializePlugins(vector<void*>& plugins, const vector<string>& files, vector<string>* failures=NULL) {
+    const char* functionNames[] = {"registerPlatforms", "registerKernelFactories"};
+    for (int stage = 0; stage < 2; stage++)
+        for (int i = 0; i < (int) plugins.size(); i++) {
+            void (*init)();
+            *(void **)(&init) = dlsym(plugins[i], functionNames[stage]);
+            if (init != NULL)
+                callInitializer(init, files[i], failures);
+        }
 }
 #endif
 
@@ -210,8 +296,40 @@ void Platform::loadPluginLibrary(const string& file) {
 #else
     vector<void*> plugins;
 #endif
+    PluginLocker locker;
     plugins.push_back(loadOneLibrary(file));
-    initializePlugins(plugins);
+    initializePlugins(plugins, vector<string>(1, file));
+}
+
+/**
+ * Load all libraries that were found by loadPluginsFromDirectory() but have not been loaded yet.
+ */
+static void loadPendingPlugins() {
+    PluginLocker locker;
+    if (getPendingPluginFiles().size() == 0)
+        return;
+
+    // Take the files off the list first, since initializing a plugin may call methods that would
+    // otherwise try to load them again.
+
+    vector<string> files;
+    files.swap(getPendingPluginFiles());
+#ifdef WIN32
+    vector<HMODULE> plugins;
+#else
+    vector<void*> plugins;
+#endif
+    vector<string> loadedFiles;
+    vector<string>& failures = getPluginLoadFailureList();
+    for (int i = 0; i < (int) files.size(); i++) {
+        try {
+            plugins.push_back(loadOneLibrary(files[i]));
+            loadedFiles.push_back(files[i]);
+        } catch (OpenMMException& ex) {
+            failures.push_back(ex.what());
+        }
+    }
+    initializePlugins(plugins, loadedFiles, &failures);
 }
 
 vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
@@ -229,7 +347,6 @@ vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
         } while (FindNextFile(findHandle, &fileInfo));
         FindClose(findHandle);
     }
-    vector<HMODULE> plugins;
 #else
     dirSeparator = '/';
     DIR* dir;
@@ -242,19 +359,17 @@ vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
         }
         closedir(dir);
     }
-    vector<void*> plugins;
 #endif
-    vector<string> loadedLibraries;
-    for (unsigned int i = 0; i < files.size(); ++i) {
-        try {
-            plugins.push_back(loadOneLibrary(directory+dirSeparator+files[i]));
-            loadedLibraries.push_back(files[i]);
-        } catch (OpenMMException& ex) {
-            // Just ignore it.
-        }
-    }
-    initializePlugins(plugins);
-    return loadedLibraries;
+    PluginLocker locker;
+    for (int i = 0; i < (int) files.size(); i++)
+        getPendingPluginFiles().push_back(directory+dirSeparator+files[i]);
+    return files;
+}
+
+vector<string> Platform::getPluginLoadFailures() {
+    PluginLocker locker;
+    loadPendingPlugins();
+    return getPluginLoadFailureList();
 }
 
 const string& Platform::getDefaultPluginsDirectory() {
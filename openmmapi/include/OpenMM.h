@@ -45,6 +45,7 @@
 #include "openmm/CustomHbondForce.h"
 #include "openmm/CustomIntegrator.h"
 #include "openmm/CustomNonbondedForce.h"
+#include "openmm/DCDWriter.h"
 #include "openmm/Force.h"
 #include "openmm/GBSAOBCForce.h"
 #include "openmm/GBVIForce.h"
@@ -60,6 +61,7 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/RBTorsionForce.h"
+#include "openmm/ReplicaExchange.h"
 #include "openmm/State.h"
 #include "openmm/System.h"
 #include "openmm/Units.h"
@@ -129,6 +129,12 @@ protected:
      * Compute the kinetic energy of the system at the current time.
      */
     double computeKineticEnergy();
+    /**
+     * Brownian dynamics has no offset between positions and velocities, so the kinetic energy does not depend on forces.
+     */
+    bool kineticEnergyRequiresForce() const {
+        return false;
+    }
 private:
     double temperature, friction;
     int randomNumberSeed;
@@ -92,7 +92,30 @@ public:
      * @param properties  a set of values for platform-specific properties.  Keys are the property names.
      */
     Context(const System& system, Integrator& integrator, Platform& platform, const std::map<std::string, std::string>& properties);
+    /**
+     * Construct a new Context that simulates the same System as an existing one, using the same Platform
+     * and platform-specific properties.  Its time, periodic box vectors, positions, velocities, and parameters
+     * are initialized from the template Context.
+     *
+     * This is faster than creating a Context from scratch, because data that depends only on the System
+     * (and therefore cannot differ between the two Contexts) can be shared with the template rather than
+     * being computed again.  Exactly what gets shared depends on the Platform.  Both Contexts remain fully
+     * independent: changing the state of one has no effect on the other, and either one may be deleted first.
+     *
+     * @param templateContext   the Context to copy
+     * @param integrator        the Integrator which will be used to simulate the System.  It must not
+     *                          already be in use by another Context.
+     */
+    Context(const Context& templateContext, Integrator& integrator);
     ~Context();
+    /**
+     * Create a new Context that simulates the same System as this one, starting from the same state.
+     * This is equivalent to calling the Context(const Context&, Integrator&) constructor.  The caller
+     * is responsible for deleting the returned object.
+     *
+     * @param integrator  the Integrator which will be used by the new Context.  It must not already be in use by another Context.
+     */
+    Context* clone(Integrator& integrator) const;
     /**
      * Get System being simulated in this context.
      */
@@ -117,7 +140,10 @@ public:
      * Get a State object recording the current state information stored in this context.
      * 
      * @param types the set of data types which should be stored in the State object.  This
-     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).  Including
+     * State::EnergyByGroup or State::EnergyByForce breaks the potential energy down by force group
+     * or by Force.  On the Reference platform, all of these are computed in a single evaluation.  Other
+     * platforms evaluate each force group separately, and do not support State::EnergyByForce.
      * @param enforcePeriodicBox if false, the position of each particle will be whatever position
      * is stored in the Context, regardless of periodic boundary conditions.  If true, particle
      * positions will be translated so the center of every molecule lies in the same periodic box.
@@ -178,6 +204,25 @@ public:
      * @param value the value of the parameter
      */
     void setParameter(const std::string& name, double value);
+    /**
+     * Compute the potential energy of the current configuration for each of several sets of
+     * parameter values.  This is equivalent to calling setParameter() for each set, then
+     * calling getState() to compute the energy, but can be much faster: on platforms that report
+     * the energy of each Force separately (such as Reference), Forces that do not depend on any of
+     * the parameters being varied are only evaluated once, and their energy is reused for every set.
+     * On other platforms every Force is evaluated for each set.  This is useful for computing the
+     * reduced potentials needed by MBAR and similar free energy methods.
+     *
+     * Parameters that are not listed in a set keep their current values.  On return, all parameters
+     * are restored to the values they had before this method was called.
+     *
+     * @param parameterSets  each element maps parameter names to the values to use for one evaluation
+     * @param groups         a set of bit flags for which force groups to include when computing
+     *                       energies.  Group i will be included if (groups&(1<<i)) != 0.  The default
+     *                       value includes all groups.
+     * @return a vector containing the potential energy (in kJ/mol) for each element of parameterSets
+     */
+    std::vector<double> getPotentialEnergies(const std::vector<std::map<std::string, double> >& parameterSets, int groups=0xFFFFFFFF);
     /**
      * Set the vectors defining the axes of the periodic box (measured in nm).  They will affect
      * any Force that uses periodic boundary conditions.
@@ -250,6 +295,7 @@ public:
 private:
     friend class Force;
     friend class Platform;
+    friend class ReplicaExchange;
     ContextImpl& getImpl();
     ContextImpl* impl;
     std::map<std::string, std::string> properties;
@@ -463,6 +463,12 @@ protected:
      * Compute the kinetic energy of the system at the current time.
      */
     double computeKineticEnergy();
+    /**
+     * The kernel computes forces itself if the kinetic energy expression needs them.
+     */
+    bool kineticEnergyRequiresForce() const {
+        return false;
+    }
 private:
     class ComputationInfo;
     std::vector<std::string> globalNames;
@@ -392,6 +392,11 @@ private:
     std::vector<ParticleInfo> particles;
     std::vector<ExclusionInfo> exclusions;
     std::vector<FunctionInfo> functions;
+    // The indices of particles whose parameters have been modified, which CustomNonbondedForceImpl uses to copy
+    // only those particles in updateParametersInContext().  This works the same way as in NonbondedForce.
+    friend class CustomNonbondedForceImpl;
+    std::vector<int> changedParticles;
+    long long numDiscardedParticleChanges;
 };
 
 /**
@@ -0,0 +1,112 @@
+#ifndef OPENMM_DCDWRITER_H_
+#define OPENMM_DCDWRITER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Vec3.h"
+#include <string>
+#include <vector>
+#include "internal/windowsExport.h"
+
+namespace OpenMM {
+
+class Context;
+
+/**
+ * This class writes a simulation trajectory to a DCD file.  DCD is supported by many programs, such as
+ * CHARMM, NAMD, and VMD.  Different programs produce subtly different versions of the format.  This class
+ * generates the CHARMM version with little-endian byte ordering, the same as the DCDFile class in the
+ * Python application layer.
+ *
+ * Frames are written on a background thread, so writeFrame() returns as soon as the positions have been
+ * copied and checked.  The header is updated whenever the background thread has written all the frames
+ * queued so far, so the file is always readable.  If an error occurs while writing, it is reported as an
+ * exception by the next call to writeFrame() or flush().
+ */
+
+class OPENMM_EXPORT DCDWriter {
+public:
+    /**
+     * Create a DCDWriter.  This creates the file (overwriting any existing file of the same name) and
+     * writes the header.
+     *
+     * @param filename        the name of the file to write
+     * @param numParticles    the number of particles in each frame
+     * @param stepSize        the integration step size (in ps)
+     * @param firstStep       the index of the time step corresponding to the first frame
+     * @param interval        the number of time steps between frames
+     * @param usePeriodicBox  if true, the periodic box dimensions are written along with each frame
+     */
+    DCDWriter(const std::string& filename, int numParticles, double stepSize, int firstStep=0, int interval=1, bool usePeriodicBox=false);
+    /**
+     * Any frames that have not yet been written are written before the file is closed.
+     */
+    ~DCDWriter();
+    /**
+     * Get the number of frames that have been passed to writeFrame().
+     */
+    int getNumFrames() const {
+        return numFrames;
+    }
+    /**
+     * Write a frame containing the current positions and periodic box of a Context.
+     *
+     * @param context             the Context to record
+     * @param enforcePeriodicBox  if true, particle positions are translated so the center of every molecule
+     *                            lies in the same periodic box, as in Context::getState()
+     */
+    void writeFrame(Context& context, bool enforcePeriodicBox=false);
+    /**
+     * Write a frame.
+     *
+     * @param positions   the position of each particle (in nm)
+     * @param a           the vector defining the first edge of the periodic box (in nm)
+     * @param b           the vector defining the second edge of the periodic box (in nm)
+     * @param c           the vector defining the third edge of the periodic box (in nm)
+     */
+    void writeFrame(const std::vector<Vec3>& positions, const Vec3& a, const Vec3& b, const Vec3& c);
+    /**
+     * Block until all frames passed to writeFrame() have been written to the file.
+     */
+    void flush();
+private:
+    class Frame;
+    class WriterThread;
+    void checkForError();
+    int numParticles, firstStep, interval, numFrames;
+    bool usePeriodicBox;
+    WriterThread* thread;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_DCDWRITER_H_*/
@@ -69,6 +69,24 @@ public:
      * @return the index of the bond that was added
      */
     int addBond(int particle1, int particle2, double length, double k);
+    /**
+     * Add many bond terms to the force field at once.  This is equivalent to calling addBond() once for
+     * each bond, but avoids the overhead of the individual calls.  All the arrays must have the same length.
+     *
+     * @param particles1 the index of the first particle connected by each bond
+     * @param particles2 the index of the second particle connected by each bond
+     * @param lengths    the equilibrium length of each bond, measured in nm
+     * @param k          the harmonic force constant for each bond, measured in kJ/mol/nm^2
+     * @return the index of the first bond that was added
+     */
+    int addBonds(const std::vector<int>& particles1, const std::vector<int>& particles2, const std::vector<double>& lengths, const std::vector<double>& k);
+    /**
+     * Preallocate storage for the specified total number of bonds.  This does not change the number of
+     * bonds, but avoids repeated reallocation when they are added one at a time.
+     *
+     * @param numBonds   the total number of bonds this force is expected to contain
+     */
+    void reserveBonds(int numBonds);
     /**
      * Get the force field parameters for a bond term.
      * 
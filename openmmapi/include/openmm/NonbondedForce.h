@@ -204,6 +204,23 @@ public:
      * @return the index of the particle that was added
      */
     int addParticle(double charge, double sigma, double epsilon);
+    /**
+     * Add the nonbonded force parameters for many particles at once.  This is equivalent to calling addParticle()
+     * once for each particle, but avoids the overhead of the individual calls.  All the arrays must have the same length.
+     *
+     * @param charges   the charge of each particle, measured in units of the proton charge
+     * @param sigmas    the sigma parameter of the Lennard-Jones potential for each particle, measured in nm
+     * @param epsilons  the epsilon parameter of the Lennard-Jones potential for each particle, measured in kJ/mol
+     * @return the index of the first particle that was added
+     */
+    int addParticles(const std::vector<double>& charges, const std::vector<double>& sigmas, const std::vector<double>& epsilons);
+    /**
+     * Preallocate storage for the specified total number of particles.  This does not change the number
+     * of particles, but avoids repeated reallocation when they are added one at a time.
+     *
+     * @param numParticles   the total number of particles this force is expected to contain
+     */
+    void reserveParticles(int numParticles);
     /**
      * Get the nonbonded force parameters for a particle.
      *
@@ -224,6 +241,15 @@ public:
      * @param epsilon   the epsilon parameter of the Lennard-Jones potential (corresponding to the well depth of the van der Waals interaction), measured in kJ/mol
      */
     void setParticleParameters(int index, double charge, double sigma, double epsilon);
+    /**
+     * Set the nonbonded force parameters for every particle at once.  Each array must have one element for every
+     * particle that has been added to this force.
+     *
+     * @param charges   the charge of each particle, measured in units of the proton charge
+     * @param sigmas    the sigma parameter of the Lennard-Jones potential for each particle, measured in nm
+     * @param epsilons  the epsilon parameter of the Lennard-Jones potential for each particle, measured in kJ/mol
+     */
+    void setAllParticleParameters(const std::vector<double>& charges, const std::vector<double>& sigmas, const std::vector<double>& epsilons);
     /**
      * Add an interaction to the list of exceptions that should be calculated differently from other interactions.
      * If chargeProd and epsilon are both equal to 0, this will cause the interaction to be completely omitted from
@@ -241,6 +267,26 @@ public:
      * @return the index of the exception that was added
      */
     int addException(int particle1, int particle2, double chargeProd, double sigma, double epsilon, bool replace = false);
+    /**
+     * Add many exceptions at once.  This is equivalent to calling addException() once for each exception with
+     * replace set to false, but avoids the overhead of the individual calls.  All the arrays must have the same length.
+     *
+     * @param particles1  the index of the first particle involved in each interaction
+     * @param particles2  the index of the second particle involved in each interaction
+     * @param chargeProds the scaled product of the atomic charges for each interaction, measured in units of the proton charge squared
+     * @param sigmas      the sigma parameter of the Lennard-Jones potential for each interaction, measured in nm
+     * @param epsilons    the epsilon parameter of the Lennard-Jones potential for each interaction, measured in kJ/mol
+     * @return the index of the first exception that was added
+     */
+    int addExceptions(const std::vector<int>& particles1, const std::vector<int>& particles2, const std::vector<double>& chargeProds,
+            const std::vector<double>& sigmas, const std::vector<double>& epsilons);
+    /**
+     * Preallocate storage for the specified total number of exceptions.  This does not change the number
+     * of exceptions, but avoids repeated reallocation when they are added one at a time.
+     *
+     * @param numExceptions   the total number of exceptions this force is expected to contain
+     */
+    void reserveExceptions(int numExceptions);
     /**
      * Get the force field parameters for an interaction that should be calculated differently from others.
      * 
@@ -335,10 +381,20 @@ private:
     double cutoffDistance, switchingDistance, rfDielectric, ewaldErrorTol;
     bool useSwitchingFunction, useDispersionCorrection;
     int recipForceGroup;
-    void addExclusionsToSet(const std::vector<std::set<int> >& bonded12, std::set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const;
+    void addExclusionsToList(const std::vector<int>& bondOffset, const std::vector<int>& bonded12, std::vector<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const;
+    void recordParticleChange(int index);
+    void recordExceptionChange(int index);
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::map<std::pair<int, int>, int> exceptionMap;
+    // The indices of particles and exceptions whose parameters have been modified, in the order the changes were made.
+    // Each NonbondedForceImpl remembers how far through these lists it has read, so updateParametersInContext() only
+    // needs to copy the parameters that changed since the last time it was called for that Context.  The lists are
+    // periodically discarded to keep them from growing without bound; the counts of discarded entries let an Impl
+    // detect that some changes it has not seen are gone, in which case it copies everything.
+    friend class NonbondedForceImpl;
+    std::vector<int> changedParticles, changedExceptions;
+    long long numDiscardedParticleChanges, numDiscardedExceptionChanges;
 };
 
 /**
@@ -0,0 +1,260 @@
+#ifndef OPENMM_REPLICAEXCHANGE_H_
+#define OPENMM_REPLICAEXCHANGE_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "Integrator.h"
+#include "openmm/Platform.h"
+#include "System.h"
+#include "Vec3.h"
+#include <map>
+#include <string>
+#include <vector>
+#include "internal/windowsExport.h"
+
+namespace OpenMM_SFMT {
+    class SFMT;
+}
+
+namespace OpenMM {
+
+class Context;
+class MonteCarloBarostatImpl;
+class ThreadPool;
+
+/**
+ * This class performs replica exchange simulations.  It simulates a set of replicas, each in one of
+ * an equal number of thermodynamic states, and periodically attempts to exchange replicas between
+ * neighboring states using the Metropolis criterion.  Thermodynamic states may differ in temperature,
+ * in the values of global parameters defined by Forces in the System (Hamiltonian replica exchange),
+ * or both.
+ *
+ * Rather than creating a Context for every replica, all replicas are multiplexed onto a small number
+ * of Contexts that share a single System.  Each replica only stores its own positions, velocities, and
+ * periodic box vectors.  An exchange simply reassigns replicas to thermodynamic states; no coordinates
+ * are copied.  Each Integrator passed to the ReplicaExchange gets its own Context.  If you provide more
+ * than one (by calling addIntegrator()), replicas are divided between them and propagated in parallel
+ * on separate threads.  The Reference platform uses a single random number generator for all Contexts,
+ * so on that platform replicas are always propagated one at a time.
+ *
+ * Internal state that evolves during a simulation is saved and restored separately for each replica.
+ * This includes the global and per-DOF variables of a CustomIntegrator, and the step counter and
+ * adaptive volume change size of a MonteCarloBarostat.
+ *
+ * To set the temperature of a thermodynamic state, the Integrator must be a LangevinIntegrator,
+ * BrownianIntegrator, or VariableLangevinIntegrator, or the System must contain an AndersenThermostat.
+ * If the System contains a MonteCarloBarostat, all states must have the same temperature, and the
+ * pressure-volume term is included in the acceptance criterion.
+ */
+
+class OPENMM_EXPORT ReplicaExchange {
+public:
+    /**
+     * Create a ReplicaExchange.
+     *
+     * @param system       the System to simulate.  It is shared by all replicas, so it must not be modified
+     *                     or deleted while the ReplicaExchange exists.
+     * @param integrator   the Integrator to use for propagating replicas.  It must not be deleted while
+     *                     the ReplicaExchange exists.
+     * @param numReplicas  the number of replicas, which is also the number of thermodynamic states
+     */
+    ReplicaExchange(const System& system, Integrator& integrator, int numReplicas);
+    /**
+     * Create a ReplicaExchange.
+     *
+     * @param system       the System to simulate.  It is shared by all replicas, so it must not be modified
+     *                     or deleted while the ReplicaExchange exists.
+     * @param integrator   the Integrator to use for propagating replicas.  It must not be deleted while
+     *                     the ReplicaExchange exists.
+     * @param numReplicas  the number of replicas, which is also the number of thermodynamic states
+     * @param platform     the Platform to use for calculations
+     */
+    ReplicaExchange(const System& system, Integrator& integrator, int numReplicas, Platform& platform);
+    ~ReplicaExchange();
+    /**
+     * Add another Integrator for propagating replicas.  A separate Context is created for each Integrator,
+     * and replicas are divided between them and propagated in parallel (except on the Reference platform,
+     * where only the first Context is used).  It should be of the same type
+     * and have the same settings as the one passed to the constructor.  This must be called before the
+     * first call to run().
+     */
+    void addIntegrator(Integrator& integrator);
+    /**
+     * Get the number of replicas (and thermodynamic states).
+     */
+    int getNumReplicas() const {
+        return numReplicas;
+    }
+    /**
+     * Get the temperature of a thermodynamic state (in Kelvin).
+     */
+    double getTemperature(int state) const;
+    /**
+     * Set the temperature of a thermodynamic state (in Kelvin).
+     */
+    void setTemperature(int state, double temperature);
+    /**
+     * Get the value of a global parameter in a thermodynamic state.  If it has not been set for this state,
+     * this returns the default value defined by the System.
+     *
+     * @param state   the index of the thermodynamic state
+     * @param name    the name of the parameter
+     */
+    double getParameter(int state, const std::string& name) const;
+    /**
+     * Set the value of a global parameter in a thermodynamic state.
+     *
+     * @param state   the index of the thermodynamic state
+     * @param name    the name of the parameter
+     * @param value   the value of the parameter
+     */
+    void setParameter(int state, const std::string& name, double value);
+    /**
+     * Get the index of the thermodynamic state a replica is currently in.
+     */
+    int getReplicaState(int replica) const {
+        return replicaState[replica];
+    }
+    /**
+     * Get the index of the replica that is currently in a thermodynamic state.
+     */
+    int getStateReplica(int state) const {
+        return stateReplica[state];
+    }
+    /**
+     * Get the positions of all particles in a replica.
+     */
+    const std::vector<Vec3>& getPositions(int replica) const;
+    /**
+     * Set the positions of all particles in a replica.
+     */
+    void setPositions(int replica, const std::vector<Vec3>& positions);
+    /**
+     * Get the velocities of all particles in a replica.
+     */
+    const std::vector<Vec3>& getVelocities(int replica) const;
+    /**
+     * Set the velocities of all particles in a replica.  If this is never called, velocities are chosen
+     * from a Maxwell-Boltzmann distribution at the temperature of the replica's state when the simulation starts.
+     */
+    void setVelocities(int replica, const std::vector<Vec3>& velocities);
+    /**
+     * Get the periodic box vectors of a replica.
+     */
+    void getPeriodicBoxVectors(int replica, Vec3& a, Vec3& b, Vec3& c) const;
+    /**
+     * Set the periodic box vectors of a replica.  If this is never called, the System's default box
+     * vectors are used.
+     */
+    void setPeriodicBoxVectors(int replica, const Vec3& a, const Vec3& b, const Vec3& c);
+    /**
+     * Get the potential energy of a replica (in kJ/mol) in the thermodynamic state it is currently in,
+     * as of the end of the most recent iteration.
+     */
+    double getPotentialEnergy(int replica) const;
+    /**
+     * Get the random number seed used for accepting or rejecting exchanges.
+     */
+    int getRandomNumberSeed() const {
+        return randomNumberSeed;
+    }
+    /**
+     * Set the random number seed used for accepting or rejecting exchanges.  This must be called
+     * before the first call to run() to have any effect.
+     */
+    void setRandomNumberSeed(int seed) {
+        randomNumberSeed = seed;
+    }
+    /**
+     * Get the number of exchanges that have been attempted between state i and state i+1.
+     */
+    int getNumAttemptedExchanges(int state) const;
+    /**
+     * Get the number of exchanges that have been accepted between state i and state i+1.
+     */
+    int getNumAcceptedExchanges(int state) const;
+    /**
+     * Run the simulation.  Each iteration propagates every replica for the specified number of time
+     * steps, then attempts exchanges between neighboring states.  Iterations alternate between attempting
+     * exchanges of even numbered states with the following state, and odd numbered states with the following
+     * state.
+     *
+     * @param iterations        the number of iterations to run
+     * @param stepsPerIteration the number of time steps to integrate each replica in every iteration
+     */
+    void run(int iterations, int stepsPerIteration);
+private:
+    class PropagateTask;
+    class EnergyTask;
+    /**
+     * The internal state of the Integrator and MonteCarloBarostat belonging to one replica.
+     */
+    struct ReplicaDynamics {
+        std::vector<double> globals;
+        std::vector<std::vector<Vec3> > perDof;
+        int barostatStep, barostatAttempted, barostatAccepted;
+        double barostatVolumeScale;
+    };
+    void initialize();
+    MonteCarloBarostatImpl* getBarostatImpl(Context& context);
+    void saveDynamics(Context& context, int replica);
+    void restoreDynamics(Context& context, int replica);
+    void applyState(Context& context, int state);
+    void propagateReplica(Context& context, int replica, int steps);
+    double computeEnergy(Context& context, int replica, int state);
+    double getPressure(int state) const;
+    void attemptExchanges();
+    const System& system;
+    Platform* platform;
+    std::vector<Integrator*> integrators;
+    std::vector<Context*> contexts;
+    ThreadPool* threads;
+    int numReplicas, randomNumberSeed, numIterations;
+    bool isInitialized, hasBarostat;
+    double defaultPressure;
+    std::vector<double> temperature;
+    std::vector<std::map<std::string, double> > parameters;
+    std::map<std::string, double> defaultParameters;
+    std::vector<int> replicaState, stateReplica;
+    std::vector<std::vector<Vec3> > positions, velocities;
+    std::vector<Vec3> boxVectors;
+    std::vector<double> energy;
+    std::vector<ReplicaDynamics> dynamics;
+    std::vector<int> numAttempted, numAccepted;
+    std::vector<std::pair<int, int> > energyRequests;
+    std::vector<double> requestedEnergy;
+    OpenMM_SFMT::SFMT* random;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_REPLICAEXCHANGE_H_*/
@@ -57,7 +57,7 @@ public:
      * This is an enumeration of the types of data which may be stored in a State.  When you create
      * a State, use these values to specify which data types it should contain.
      */
-    enum DataType {Positions=1, Velocities=2, Forces=4, Energy=8, Parameters=16};
+    enum DataType {Positions=1, Velocities=2, Forces=4, Energy=8, Parameters=16, EnergyByGroup=32, EnergyByForce=64};
     /**
      * Construct an empty State containing no data.  This exists so State objects can be used in STL containers.
      */
@@ -91,6 +91,19 @@ public:
      * Get the total potential energy of the system.  If this State does not contain energies, this will throw an exception.
      */
     double getPotentialEnergy() const;
+    /**
+     * Get the potential energy of each force group.  Element i is the energy of group i, or 0 if that group
+     * was not included when the State was created.  If this State does not contain energies by group, this
+     * will throw an exception.
+     */
+    const std::vector<double>& getPotentialEnergyByGroup() const;
+    /**
+     * Get the potential energy of each Force in the System.  Element i is the energy of the i'th Force, or 0
+     * if its force group was not included when the State was created.  If this State does not contain energies
+     * by Force, this will throw an exception.  Only platforms that compute the energy of each Force separately,
+     * such as Reference, can create States containing it.
+     */
+    const std::vector<double>& getPotentialEnergyByForce() const;
     /**
      * Get the vectors defining the axes of the periodic box (measured in nm).
      *
@@ -114,12 +127,16 @@ private:
     void setForces(const std::vector<Vec3>& force);
     void setParameters(const std::map<std::string, double>& params);
     void setEnergy(double ke, double pe);
+    void setEnergyByGroup(const std::vector<double>& energies);
+    void setEnergyByForce(const std::vector<double>& energies);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
     int types;
     double time, ke, pe;
     std::vector<Vec3> positions;
     std::vector<Vec3> velocities;
     std::vector<Vec3> forces;
+    std::vector<double> groupEnergies;
+    std::vector<double> forceEnergies;
     Vec3 periodicBoxVectors[3];
     std::map<std::string, double> parameters;
 };
@@ -138,6 +155,8 @@ public:
     void setForces(const std::vector<Vec3>& force);
     void setParameters(const std::map<std::string, double>& params);
     void setEnergy(double ke, double pe);
+    void setEnergyByGroup(const std::vector<double>& energies);
+    void setEnergyByForce(const std::vector<double>& energies);
     void setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c);
 private:
     State state;
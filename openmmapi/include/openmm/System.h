@@ -89,6 +89,23 @@ public:
         masses.push_back(mass);
         return masses.size()-1;
     }
+    /**
+     * Add many particles to the System at once.  This is equivalent to calling addParticle() once for
+     * each element of masses, but avoids the overhead of the individual calls.
+     *
+     * @param masses   the mass of each particle to add (in atomic mass units)
+     * @return the index of the first particle that was added
+     */
+    int addParticles(const std::vector<double>& masses);
+    /**
+     * Preallocate storage for the specified total number of particles.  This does not change the number
+     * of particles in the System, but avoids repeated reallocation when they are added one at a time.
+     *
+     * @param numParticles   the total number of particles the System is expected to contain
+     */
+    void reserveParticles(int numParticles) {
+        masses.reserve(numParticles);
+    }
     /**
      * Get the mass (in atomic mass units) of a particle.  If the mass is 0, Integrators will ignore
      * the particle and not modify its position or velocity.  This is most often
@@ -59,6 +59,9 @@ public:
     }
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
+    bool involvesParticles(const std::vector<bool>& particles) const {
+        return false; // This force doesn't apply forces to particles.
+    }
     /**
      * This is a utility routine that computes the groups of particles the thermostat should be
      * applied to.
@@ -58,6 +58,9 @@ public:
         return std::map<std::string, double>(); // This force doesn't define any parameters.
     }
     std::vector<std::string> getKernelNames();
+    bool involvesParticles(const std::vector<bool>& particles) const {
+        return false; // This force doesn't apply forces to particles.
+    }
 private:
     const CMMotionRemover& owner;
     Kernel kernel;
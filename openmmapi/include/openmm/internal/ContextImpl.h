@@ -54,8 +54,12 @@ class OPENMM_EXPORT ContextImpl {
 public:
     /**
      * Create an ContextImpl for a Context;
+     *
+     * @param originalContext   if this is not NULL, the new Context is being cloned from this one.  It must
+     *                          use the same System and Platform, and may share data with it.
      */
-    ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const std::map<std::string, std::string>& properties);
+    ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const std::map<std::string, std::string>& properties,
+            ContextImpl* originalContext=NULL);
     ~ContextImpl();
     /**
      * Get the Context for which this is the implementation.
@@ -193,6 +197,68 @@ public:
      * @return the potential energy of the system, or 0 if includeEnergy is false
      */
     double calcForcesAndEnergy(bool includeForces, bool includeEnergy, int groups=0xFFFFFFFF);
+    /**
+     * Recalculate the potential energy of the system (in kJ/mol) and optionally the forces, and also report
+     * how the energy is divided between force groups and, optionally, between Forces.  When each ForceImpl
+     * returns its own energy (as on the Reference platform), this requires only a single evaluation.  On
+     * other platforms each included force group is evaluated separately, and the energy of each Force
+     * cannot be computed.
+     *
+     * @param includeForces  true if forces should be calculated
+     * @param groups         a set of bit flags for which force groups to include.  Group i will be included
+     *                       if (groups&(1<<i)) != 0.
+     * @param groupEnergies  on exit, this has 32 elements, and element i contains the energy of force group i.
+     *                       It is 0 for groups that are not included.
+     * @param forceEnergies  if this is not NULL, on exit element i contains the energy of the i'th Force in the
+     *                       System.  It is 0 for Forces that are not in any of the included groups.  If the
+     *                       platform does not report the energy of each Force, an exception is thrown.
+     * @return the potential energy of the system
+     */
+    double calcForcesAndEnergy(bool includeForces, int groups, std::vector<double>& groupEnergies, std::vector<double>* forceEnergies);
+    /**
+     * Compute the potential energy of the system (in kJ/mol) without computing forces.  Unlike
+     * calcForcesAndEnergy(), this reuses the energy computed by earlier calls to this method, or to the
+     * version of calcForcesAndEnergy() that reports group energies, for every ForceImpl whose inputs have
+     * not changed since then.  A cached energy remains valid until
+     * the positions or periodic box change, or until one of the global parameters returned by the
+     * ForceImpl's getRequiredParameters() is modified.  Energies can only be cached on platforms whose
+     * CalcForcesAndEnergyKernel reports the energy of each ForceImpl separately.  On other platforms
+     * this always evaluates every Force.
+     *
+     * @param groups         a set of bit flags for which force groups to include.  Group i will be included
+     *                       if (groups&(1<<i)) != 0.  The default value includes all groups.
+     * @return the potential energy of the system
+     */
+    double calcPotentialEnergy(int groups=0xFFFFFFFF);
+    /**
+     * Discard all energies cached by calcPotentialEnergy().  Changes to the positions and periodic box are
+     * detected automatically.  Anything that modifies the energy in some other way, such as changing
+     * per-particle parameters of a Force, must call this.
+     */
+    void invalidateCachedEnergies();
+    /**
+     * This is called when the parameters of a Force have changed.  Every ForceImpl::updateParametersInContext()
+     * calls it.  It discards cached energies and increments the value returned by getForceParametersVersion().
+     */
+    void forceParametersChanged();
+    /**
+     * Get a counter that is incremented by every call to forceParametersChanged().  Kernels that keep
+     * private copies of Force parameters can compare it to a saved value to tell whether they are out of date.
+     */
+    int getForceParametersVersion() const {
+        return forceParametersVersion;
+    }
+    /**
+     * Compute the potential energy for each of several sets of parameter values.  On platforms where
+     * calcPotentialEnergy() can cache energies, Forces that do not depend on any of the parameters being
+     * varied are evaluated at most once.  All parameters are restored to their original values before
+     * this returns.
+     *
+     * @param parameterSets  each element maps parameter names to the values to use for one evaluation
+     * @param groups         a set of bit flags for which force groups to include
+     * @return the potential energy for each element of parameterSets
+     */
+    std::vector<double> calcEnergiesForParameters(const std::vector<std::map<std::string, double> >& parameterSets, int groups=0xFFFFFFFF);
     /**
      * Get the set of force group flags that were passed to the most recent call to calcForcesAndEnergy().
      */
@@ -252,6 +318,21 @@ public:
     }
 private:
     friend class Context;
+    /**
+     * This records the energy of one ForceImpl, along with the values of the parameters it depended on
+     * when it was computed.
+     */
+    struct CachedEnergy {
+        CachedEnergy() : isValid(false) {
+        }
+        bool isValid;
+        std::map<std::string, double> parameters;
+        double energy;
+    };
+    double calcEnergyOfForces(const std::vector<int>& forces, int groups, std::vector<double>& energies);
+    void updateCachedEnergyState(int groups);
+    bool isCachedEnergyValid(int force);
+    void recordCachedEnergy(int force, double energy);
     static void tagParticlesInMolecule(int particle, int molecule, std::vector<int>& particleMolecule, std::vector<std::vector<int> >& particleBonds);
     Context& owner;
     const System& system;
@@ -259,8 +340,14 @@ private:
     std::vector<ForceImpl*> forceImpls;
     std::map<std::string, double> parameters;
     mutable std::vector<std::vector<int> > molecules;
+    mutable std::vector<std::pair<int, int> > moleculeBonds;
+    mutable bool moleculesNeedCheck;
     bool hasInitializedForces, hasSetPositions, integratorIsDeleted;
-    int lastForceGroups;
+    int lastForceGroups, cachedEnergyGroups, forceParametersVersion;
+    std::vector<Vec3> cachedEnergyPositions;
+    Vec3 cachedEnergyBox[3];
+    std::vector<std::vector<std::string> > forceRequiredParameters;
+    std::vector<CachedEnergy> cachedEnergies;
     Platform* platform;
     Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel;
     void* platformData;
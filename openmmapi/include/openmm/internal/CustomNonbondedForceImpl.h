@@ -9,7 +9,7 @@
  * Biological Structures at Stanford, funded under the NIH Roadmap for        *
  * Medical Research, grant U54 GM072970. See https://simtk.org.               *
  *                                                                            *
- * Portions copyright (c) 2008-2012 Stanford University and the Authors.      *
+ * Portions copyright (c) 2008-2013 Stanford University and the Authors.      *
  * Authors: Peter Eastman                                                     *
  * Contributors:                                                              *
  *                                                                            *
@@ -35,7 +35,7 @@
 #include "ForceImpl.h"
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/Kernel.h"
-#include "lepton/ExpressionProgram.h"
+#include "lepton/CompiledExpression.h"
 #include <utility>
 #include <map>
 #include <string>
@@ -61,17 +61,63 @@ public:
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
     void updateParametersInContext(ContextImpl& context);
+    class LongRangeCorrection;
     /**
      * Compute the coefficient which, when divided by the periodic box volume, gives the
-     * long range correction to the energy.
+     * long range correction to the energy.  If the coefficient needs to be computed repeatedly
+     * for the same force, create a LongRangeCorrection instead.
      */
     static double calcLongRangeCorrection(const CustomNonbondedForce& force, const Context& context);
 private:
     class TabulatedFunction;
-    static double integrateInteraction(const Lepton::ExpressionProgram& expression, const std::vector<double>& params1, const std::vector<double>& params2,
-            const CustomNonbondedForce& force, const Context& context);
     const CustomNonbondedForce& owner;
     Kernel kernel;
+    long long particleChangesSeen;
+};
+
+/**
+ * This class computes the long range correction for a CustomNonbondedForce.  The particle classes and
+ * the compiled energy expression are determined once when it is created, the integrals for different
+ * pairs of classes are evaluated in parallel, and both the integrals and the result are cached for the
+ * sets of global parameter values they have been computed for.  At most MaxCachedParameterSets sets are
+ * retained; when that is exceeded the cache is discarded and refilled.  When the parameters of a few
+ * particles change, call updateParticles() so that only the integrals involving new classes need to be
+ * computed.
+ */
+class OPENMM_EXPORT CustomNonbondedForceImpl::LongRangeCorrection {
+public:
+    LongRangeCorrection(const CustomNonbondedForce& force);
+    ~LongRangeCorrection();
+    /**
+     * Get the coefficient which, when divided by the periodic box volume, gives the long range
+     * correction to the energy, based on the current values of global parameters in a Context.
+     */
+    double getCoefficient(const Context& context);
+    /**
+     * Update the particle classes after the parameters of some particles have changed.
+     *
+     * @param force      the CustomNonbondedForce to get the new parameters from
+     * @param particles  the indices of the particles whose parameters may have changed
+     */
+    void updateParticles(const CustomNonbondedForce& force, const std::vector<int>& particles);
+    /**
+     * The maximum number of sets of global parameter values to cache integrals for.
+     */
+    static const int MaxCachedParameterSets = 64;
+private:
+    class IntegrationTask;
+    int findClass(const std::vector<double>& parameters);
+    double integrateInteraction(Lepton::CompiledExpression& expression, int class1, int class2, const std::vector<double>& globalValues) const;
+    int numParticles;
+    double cutoff, switchingDistance;
+    bool useSwitchingFunction;
+    std::vector<std::string> parameterNames, globalParameterNames;
+    std::vector<std::vector<double> > classes;
+    std::map<std::vector<double>, int> classIndex;
+    std::vector<int> classCounts, particleClass;
+    Lepton::CompiledExpression expression;
+    std::map<std::vector<double>, std::map<std::pair<int, int>, double> > integrals;
+    std::map<std::vector<double>, double> cache;
 };
 
 } // namespace OpenMM
@@ -93,6 +93,19 @@ public:
      * parameters and their default values will automatically be added to the Context.
      */
     virtual std::map<std::string, double> getDefaultParameters() = 0;
+    /**
+     * Get the names of all global parameters whose values affect the forces and energy computed by this
+     * ForceImpl.  The Context uses this to decide when a previously computed energy can be reused.  The
+     * default implementation returns the parameters defined by getDefaultParameters().  A ForceImpl that
+     * reads parameters defined by some other Force must override this to include them.
+     */
+    virtual std::vector<std::string> getRequiredParameters() {
+        std::map<std::string, double> defaults = getDefaultParameters();
+        std::vector<std::string> names;
+        for (std::map<std::string, double>::const_iterator iter = defaults.begin(); iter != defaults.end(); ++iter)
+            names.push_back(iter->first);
+        return names;
+    }
     /**
      * Get the names of all Kernels used by this Force.
      */
@@ -104,6 +117,33 @@ public:
     virtual std::vector<std::pair<int, int> > getBondedParticles() const {
         return std::vector<std::pair<int, int> >(0);
     }
+    /**
+     * Get whether any interaction computed by this ForceImpl might involve a particle from a set.  If this
+     * returns false, moving those particles cannot change the forces or energy it computes.  The default
+     * implementation returns true.
+     *
+     * @param particles  element i is true if particle i is in the set
+     */
+    virtual bool involvesParticles(const std::vector<bool>& particles) const {
+        return true;
+    }
+    /**
+     * Calculate only the interactions that involve at least one particle from a subset, adding the forces
+     * to the Context.  The energy differs from that returned by calcForcesAndEnergy() (with all groups
+     * included) by a contribution that does not depend on the positions of the subset.  This is useful
+     * when minimizing the energy with respect to a few particles while all others are held fixed.
+     *
+     * Not every ForceImpl can do this.  The default implementation returns false without computing
+     * anything, in which case the caller should use calcForcesAndEnergy() instead.
+     *
+     * @param context  the context in which the system is being simulated
+     * @param subset   the indices of the particles in the subset
+     * @param energy   on exit, the energy of the interactions that were computed
+     * @return true if the interactions were computed, false if this is not supported
+     */
+    virtual bool calcSubsetForcesAndEnergy(ContextImpl& context, const std::vector<int>& subset, double& energy) {
+        return false;
+    }
 };
 
 } // namespace OpenMM
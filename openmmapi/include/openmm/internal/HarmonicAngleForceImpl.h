@@ -61,6 +61,7 @@ public:
         return std::map<std::string, double>(); // This force field doesn't define any parameters.
     }
     std::vector<std::string> getKernelNames();
+    bool involvesParticles(const std::vector<bool>& particles) const;
     void updateParametersInContext(ContextImpl& context);
 private:
     const HarmonicAngleForce& owner;
@@ -58,6 +58,9 @@ public:
     }
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
+    bool involvesParticles(const std::vector<bool>& particles) const {
+        return false; // This force doesn't apply forces to particles.
+    }
 private:
     const MonteCarloAnisotropicBarostat& owner;
     int step, numAttempted[3], numAccepted[3];
@@ -58,6 +58,29 @@ public:
     }
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
+    bool involvesParticles(const std::vector<bool>& particles) const {
+        return false; // This force doesn't apply forces to particles.
+    }
+    /**
+     * Get the internal state that evolves during a simulation: the number of steps since the last Monte Carlo
+     * move, and the statistics used to adjust the size of attempted volume changes.
+     */
+    void getAdaptiveState(int& step, int& numAttempted, int& numAccepted, double& volumeScale) const {
+        step = this->step;
+        numAttempted = this->numAttempted;
+        numAccepted = this->numAccepted;
+        volumeScale = this->volumeScale;
+    }
+    /**
+     * Set the internal state that evolves during a simulation.  This is used by ReplicaExchange, which
+     * simulates several replicas with one Context, to give every replica its own barostat state.
+     */
+    void setAdaptiveState(int step, int numAttempted, int numAccepted, double volumeScale) {
+        this->step = step;
+        this->numAttempted = numAttempted;
+        this->numAccepted = numAccepted;
+        this->volumeScale = volumeScale;
+    }
 private:
     const MonteCarloBarostat& owner;
     int step, numAttempted, numAccepted;
@@ -36,6 +36,7 @@
 #include "openmm/NonbondedForce.h"
 #include "openmm/Kernel.h"
 #include <utility>
+#include <map>
 #include <set>
 #include <string>
 
@@ -63,6 +64,7 @@ public:
         return std::map<std::string, double>(); // This force field doesn't define any parameters.
     }
     std::vector<std::string> getKernelNames();
+    bool calcSubsetForcesAndEnergy(ContextImpl& context, const std::vector<int>& subset, double& energy);
     void updateParametersInContext(ContextImpl& context);
     /**
      * This is a utility routine that calculates the values to use for alpha and kmax when using
@@ -79,6 +81,7 @@ public:
      * long range dispersion correction to the energy.
      */
     static double calcDispersionCorrection(const System& system, const NonbondedForce& force);
+    class DispersionCorrection;
 private:
     class ErrorFunction;
     class EwaldErrorFunction;
@@ -86,6 +89,38 @@ private:
     static double evalIntegral(double r, double rs, double rc, double sigma);
     const NonbondedForce& owner;
     Kernel kernel;
+    long long particleChangesSeen, exceptionChangesSeen;
+};
+
+/**
+ * This class computes the long range dispersion correction for a NonbondedForce.  It records the class
+ * (defined by sigma and epsilon) of every particle and the number of particles in each class, so when the
+ * parameters of a few particles change, the coefficient can be updated without looping over all of them.
+ */
+class OPENMM_EXPORT NonbondedForceImpl::DispersionCorrection {
+public:
+    DispersionCorrection(const NonbondedForce& force);
+    /**
+     * Update the coefficient after the parameters of some particles have changed.
+     *
+     * @param force      the NonbondedForce to get the new parameters from
+     * @param particles  the indices of the particles whose parameters may have changed
+     */
+    void updateParticles(const NonbondedForce& force, const std::vector<int>& particles);
+    /**
+     * Get the coefficient which, when divided by the periodic box volume, gives the
+     * long range dispersion correction to the energy.
+     */
+    double getCoefficient() const {
+        return coefficient;
+    }
+private:
+    void computeCoefficient();
+    int numParticles;
+    double cutoff, switchingDistance, coefficient;
+    bool useSwitchingFunction;
+    std::vector<std::pair<double, double> > particleClass;
+    std::map<std::pair<double, double>, int> classCounts;
 };
 
 } // namespace OpenMM
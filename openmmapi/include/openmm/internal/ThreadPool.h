@@ -0,0 +1,113 @@
+#ifndef OPENMM_THREAD_POOL_H_
+#define OPENMM_THREAD_POOL_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "windowsExport.h"
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * A ThreadPool creates a set of worker threads that can be used to execute tasks in parallel.
+ * Call execute() to start a Task running on every thread, then waitForThreads() to block until
+ * all of them have finished it.  The threads persist between tasks, so there is very little
+ * overhead to executing a task.
+ */
+
+class OPENMM_EXPORT ThreadPool {
+public:
+    class Task;
+    class ThreadData;
+    /**
+     * Create a ThreadPool.
+     *
+     * @param numThreads  the number of worker threads to create.  If this is 0 (the default), the
+     *                    number of threads is given by getDefaultNumThreads()
+     */
+    ThreadPool(int numThreads=0);
+    ~ThreadPool();
+    /**
+     * Get the number of worker threads in the pool.
+     */
+    int getNumThreads() const;
+    /**
+     * Execute a Task in parallel on the worker threads.  This returns immediately; call waitForThreads()
+     * to wait until the task has completed.
+     */
+    void execute(Task& task);
+    /**
+     * Block until all threads have completed the current task.  If the task threw an exception on any
+     * thread, an OpenMMException with the same message is thrown here.
+     */
+    void waitForThreads();
+    /**
+     * Get the number of logical CPU cores available.
+     */
+    static int getNumProcessors();
+    /**
+     * Get the number of threads to use when none is specified.  This is the value of the OPENMM_CPU_THREADS
+     * environment variable if it is set to a positive integer, or getNumProcessors() otherwise.
+     */
+    static int getDefaultNumThreads();
+private:
+    bool isDeleted;
+    int numThreads, numCompleted, generation;
+    Task* currentTask;
+    std::string errorMessage;
+    std::vector<pthread_t> thread;
+    std::vector<ThreadData*> threadData;
+    pthread_cond_t startCondition, endCondition;
+    pthread_mutex_t lock;
+};
+
+/**
+ * This interface defines a task that can be executed by a ThreadPool.
+ */
+class ThreadPool::Task {
+public:
+    virtual ~Task() {
+    }
+    /**
+     * Execute the task on a single thread.  This is called once on each worker thread.
+     *
+     * @param pool         the ThreadPool executing the task
+     * @param threadIndex  the index of the thread invoking this method
+     */
+    virtual void execute(ThreadPool& pool, int threadIndex) = 0;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_THREAD_POOL_H_*/
@@ -52,10 +52,26 @@ Context::Context(const System& system, Integrator& integrator, Platform& platfor
     impl = new ContextImpl(*this, system, integrator, &platform, properties);
 }
 
+Context::Context(const Context& templateContext, Integrator& integrator) : properties(templateContext.properties) {
+    impl = new ContextImpl(*this, templateContext.getSystem(), integrator, &templateContext.impl->getPlatform(), properties, templateContext.impl);
+
+    // Copy the state.  Positions are only copied if they have been set, so that computing forces
+    // before setting them still produces an error.
+
+    int types = State::Velocities | State::Parameters;
+    if (templateContext.impl->hasSetPositions)
+        types |= State::Positions;
+    setState(templateContext.getState(types));
+}
+
 Context::~Context() {
     delete impl;
 }
 
+Context* Context::clone(Integrator& integrator) const {
+    return new Context(*this, integrator);
+}
+
 const System& Context::getSystem() const {
     return impl->getSystem();
 
@@ -84,8 +100,22 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
     builder.setPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
     bool includeForces = types&State::Forces;
     bool includeEnergy = types&State::Energy;
-    if (includeForces || includeEnergy) {
-        double energy = impl->calcForcesAndEnergy(includeForces || includeEnergy, includeEnergy, groups);
+    bool includeEnergyComponents = types&(State::EnergyByGroup|State::EnergyByForce);
+    if (includeForces || includeEnergy || includeEnergyComponents) {
+        double energy;
+        bool computeForces = (includeForces || impl->getIntegrator().kineticEnergyRequiresForce());
+        if (includeEnergyComponents) {
+            vector<double> forceEnergies, groupEnergies;
+            energy = impl->calcForcesAndEnergy(computeForces, groups, groupEnergies, (types&State::EnergyByForce) ? &forceEnergies : NULL);
+            if (types&State::EnergyByGroup)
+                builder.setEnergyByGroup(groupEnergies);
+            if (types&State::EnergyByForce)
+                builder.setEnergyByForce(forceEnergies);
+        }
+        else if (computeForces)
+            energy = impl->calcForcesAndEnergy(true, includeEnergy, groups);
+        else
+            energy = impl->calcPotentialEnergy(groups);
         if (includeEnergy)
             builder.setEnergy(impl->calcKineticEnergy(), energy);
         if (includeForces) {
@@ -242,6 +272,10 @@ void Context::setParameter(const string& name, double value) {
     impl->setParameter(name, value);
 }
 
+vector<double> Context::getPotentialEnergies(const vector<map<string, double> >& parameterSets, int groups) {
+    return impl->calcEnergiesForParameters(parameterSets, groups);
+}
+
 void Context::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
     impl->setPeriodicBoxVectors(a, b, c);
 }
@@ -31,6 +31,7 @@
 
 #include "openmm/Force.h"
 #include "openmm/Integrator.h"
+#include "openmm/NonbondedForce.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/System.h"
 #include "openmm/kernels.h"
@@ -47,9 +48,10 @@
 using namespace OpenMM;
 using namespace std;
 
-ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties) :
-        owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
-        lastForceGroups(-1), platform(platform), platformData(NULL) {
+ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties,
+            ContextImpl* originalContext) :
+        owner(owner), system(system), integrator(integrator), moleculesNeedCheck(false), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
+        lastForceGroups(-1), cachedEnergyGroups(0), forceParametersVersion(0), platform(platform), platformData(NULL) {
     if (system.getNumParticles() == 0)
         throw OpenMMException("Cannot create a Context for a System with no particles");
     
@@ -95,7 +97,14 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
     
     // Create and initialize kernels and other objects.
     
-    platform->contextCreated(*this, properties);
+    if (originalContext == NULL)
+        platform->contextCreated(*this, properties);
+    else {
+        platform->linkedContextCreated(*this, *originalContext);
+        molecules = originalContext->molecules;
+        moleculeBonds = originalContext->moleculeBonds;
+        moleculesNeedCheck = true;
+    }
     initializeForcesKernel = platform->createKernel(CalcForcesAndEnergyKernel::Name(), *this);
     initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>().initialize(system);
     updateStateDataKernel = platform->createKernel(UpdateStateDataKernel::Name(), *this);
@@ -107,8 +116,11 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
     Vec3 periodicBoxVectors[3];
     system.getDefaultPeriodicBoxVectors(periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPeriodicBoxVectors(*this, periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
-    for (size_t i = 0; i < forceImpls.size(); ++i)
+    for (size_t i = 0; i < forceImpls.size(); ++i) {
         forceImpls[i]->initialize(*this);
+        forceRequiredParameters.push_back(forceImpls[i]->getRequiredParameters());
+    }
+    cachedEnergies.resize(forceImpls.size());
     integrator.initialize(*this);
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setVelocities(*this, vector<Vec3>(system.getNumParticles()));
 }
@@ -146,6 +158,7 @@ void ContextImpl::getPositions(std::vector<Vec3>& positions) {
 
 void ContextImpl::setPositions(const std::vector<Vec3>& positions) {
     hasSetPositions = true;
+    invalidateCachedEnergies();
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPositions(*this, positions);
     integrator.stateChanged(State::Positions);
 }
@@ -191,10 +204,12 @@ void ContextImpl::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3
         throw OpenMMException("Second periodic box vector must be parallel to y.");
     if (c[0] != 0.0 || c[1] != 0.0)
         throw OpenMMException("Third periodic box vector must be parallel to z.");
+    invalidateCachedEnergies();
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPeriodicBoxVectors(*this, a, b, c);
 }
 
 void ContextImpl::applyConstraints(double tol) {
+    invalidateCachedEnergies();
     applyConstraintsKernel.getAs<ApplyConstraintsKernel>().apply(*this, tol);
 }
 
@@ -203,6 +218,7 @@ void ContextImpl::applyVelocityConstraints(double tol) {
 }
 
 void ContextImpl::computeVirtualSites() {
+    invalidateCachedEnergies();
     virtualSitesKernel.getAs<VirtualSitesKernel>().computePositions(*this);
 }
 
@@ -219,6 +235,221 @@ double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy,
     return energy;
 }
 
+double ContextImpl::calcForcesAndEnergy(bool includeForces, int groups, vector<double>& groupEnergies, vector<double>* forceEnergies) {
+    if (!hasSetPositions)
+        throw OpenMMException("Particle positions have not been set");
+    int numForces = forceImpls.size();
+    groupEnergies.clear();
+    groupEnergies.resize(32, 0.0);
+    CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+
+    // Find which groups each Force contributes to.  A NonbondedForce may put reciprocal space in a different group.
+
+    vector<int> energyGroup(numForces), secondGroup(numForces, -1);
+    int usedGroups = 0;
+    for (int i = 0; i < numForces; i++) {
+        energyGroup[i] = system.getForce(i).getForceGroup();
+        usedGroups |= 1<<energyGroup[i];
+        const NonbondedForce* nonbonded = dynamic_cast<const NonbondedForce*>(&system.getForce(i));
+        if (nonbonded != NULL && nonbonded->getReciprocalSpaceForceGroup() != -1) {
+            secondGroup[i] = nonbonded->getReciprocalSpaceForceGroup();
+            usedGroups |= 1<<secondGroup[i];
+        }
+    }
+    if (!kernel.reportsEnergyPerForce()) {
+        // The platform only reports the total energy, but it does respect force groups, so evaluate each
+        // group separately.
+
+        if (forceEnergies != NULL)
+            throw OpenMMException("The energy of each Force can only be computed on platforms that report it separately, such as Reference.  Put the Forces in different force groups and request the energy of each group instead.");
+        for (int i = 0; i < 32; i++)
+            if ((groups&usedGroups&(1<<i)) != 0)
+                groupEnergies[i] = calcForcesAndEnergy(false, true, 1<<i);
+        double energy = calcForcesAndEnergy(includeForces, true, groups);
+        if (!includeForces)
+            lastForceGroups = -1;
+        return energy;
+    }
+    if (forceEnergies != NULL) {
+        forceEnergies->clear();
+        forceEnergies->resize(numForces, 0.0);
+    }
+
+    // If both of a NonbondedForce's groups are included, its energy must be split between them, so compute
+    // the reciprocal space part separately.  If only one is included, all its energy goes to that group.
+
+    vector<double> secondGroupEnergy(numForces, 0.0);
+    for (int i = 0; i < numForces; i++) {
+        if (secondGroup[i] == -1 || secondGroup[i] == energyGroup[i] || (groups&(1<<secondGroup[i])) == 0)
+            secondGroup[i] = -1;
+        else if ((groups&(1<<energyGroup[i])) == 0) {
+            energyGroup[i] = secondGroup[i];
+            secondGroup[i] = -1;
+        }
+        else {
+            vector<double> reciprocalEnergy;
+            secondGroupEnergy[i] = calcEnergyOfForces(vector<int>(1, i), 1<<secondGroup[i], reciprocalEnergy);
+        }
+    }
+
+    // Compute the forces and energy in a single pass, recording the energy returned by each ForceImpl.
+
+    lastForceGroups = groups;
+    updateCachedEnergyState(groups);
+    double energy = 0.0;
+    kernel.beginComputation(*this, includeForces, true, groups);
+    for (int i = 0; i < numForces; ++i) {
+        double forceEnergy = forceImpls[i]->calcForcesAndEnergy(*this, includeForces, true, groups);
+        recordCachedEnergy(i, forceEnergy);
+        if (forceEnergies != NULL)
+            (*forceEnergies)[i] = forceEnergy;
+        if ((groups&(1<<energyGroup[i])) != 0)
+            groupEnergies[energyGroup[i]] += forceEnergy-secondGroupEnergy[i];
+        if (secondGroup[i] != -1)
+            groupEnergies[secondGroup[i]] += secondGroupEnergy[i];
+        energy += forceEnergy;
+    }
+    energy += kernel.finishComputation(*this, includeForces, true, groups);
+    return energy;
+}
+
+double ContextImpl::calcPotentialEnergy(int groups) {
+    if (!hasSetPositions)
+        throw OpenMMException("Particle positions have not been set");
+    CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+    if (!kernel.reportsEnergyPerForce()) {
+        // The energy of individual ForceImpls is not available, so evaluate all of them.  This may overwrite
+        // the forces, so an integrator must not assume they are still valid.
+
+        double energy = calcForcesAndEnergy(false, true, groups);
+        lastForceGroups = -1;
+        return energy;
+    }
+
+    // Recompute the energy of every ForceImpl whose cached energy is missing or out of date.
+
+    updateCachedEnergyState(groups);
+    vector<int> forces;
+    for (int i = 0; i < (int) forceImpls.size(); i++)
+        if (!isCachedEnergyValid(i))
+            forces.push_back(i);
+    vector<double> energies;
+    calcEnergyOfForces(forces, groups, energies);
+    for (int i = 0; i < (int) forces.size(); i++)
+        recordCachedEnergy(forces[i], energies[i]);
+    double energy = 0.0;
+    for (int i = 0; i < (int) forceImpls.size(); i++)
+        energy += cachedEnergies[i].energy;
+    return energy;
+}
+
+void ContextImpl::invalidateCachedEnergies() {
+    for (int i = 0; i < (int) cachedEnergies.size(); i++)
+        cachedEnergies[i].isValid = false;
+}
+
+void ContextImpl::forceParametersChanged() {
+    invalidateCachedEnergies();
+    forceParametersVersion++;
+}
+
+void ContextImpl::updateCachedEnergyState(int groups) {
+    // Integrators and other kernels may move particles without going through this class, so compare the
+    // positions and box to the ones the cached energies were computed for.  This costs a copy of the
+    // positions, so it is only done by the methods that getState() calls, never by the calcForcesAndEnergy()
+    // that integrators call on every step.
+
+    vector<Vec3> positions;
+    getPositions(positions);
+    Vec3 box[3];
+    getPeriodicBoxVectors(box[0], box[1], box[2]);
+    if (groups != cachedEnergyGroups || positions != cachedEnergyPositions || box[0] != cachedEnergyBox[0] ||
+            box[1] != cachedEnergyBox[1] || box[2] != cachedEnergyBox[2]) {
+        invalidateCachedEnergies();
+        cachedEnergyGroups = groups;
+        cachedEnergyPositions.swap(positions);
+        for (int i = 0; i < 3; i++)
+            cachedEnergyBox[i] = box[i];
+    }
+}
+
+bool ContextImpl::isCachedEnergyValid(int force) {
+    const CachedEnergy& cached = cachedEnergies[force];
+    if (!cached.isValid)
+        return false;
+    for (map<string, double>::const_iterator iter = cached.parameters.begin(); iter != cached.parameters.end(); ++iter)
+        if (parameters[iter->first] != iter->second)
+            return false;
+    return true;
+}
+
+void ContextImpl::recordCachedEnergy(int force, double energy) {
+    CachedEnergy& cached = cachedEnergies[force];
+    const vector<string>& names = forceRequiredParameters[force];
+    for (int i = 0; i < (int) names.size(); i++)
+        cached.parameters[names[i]] = parameters[names[i]];
+    cached.energy = energy;
+    cached.isValid = true;
+}
+
+/**
+ * Compute the energy of a subset of the ForceImpls, and the energy of each one.  This may only be used when the
+ * CalcForcesAndEnergyKernel reports the energy of each ForceImpl separately.  Forces are not computed, and the
+ * ones computed by the last call to calcForcesAndEnergy() are preserved, so lastForceGroups is left unchanged.
+ */
+double ContextImpl::calcEnergyOfForces(const vector<int>& forces, int groups, vector<double>& energies) {
+    energies.resize(forces.size());
+    if (forces.size() == 0)
+        return 0.0;
+    CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+    double energy = 0.0;
+    kernel.beginComputation(*this, false, true, groups);
+    for (int i = 0; i < (int) forces.size(); ++i) {
+        energies[i] = forceImpls[forces[i]]->calcForcesAndEnergy(*this, false, true, groups);
+        energy += energies[i];
+    }
+    kernel.finishComputation(*this, false, true, groups);
+    return energy;
+}
+
+vector<double> ContextImpl::calcEnergiesForParameters(const vector<map<string, double> >& parameterSets, int groups) {
+    if (!hasSetPositions)
+        throw OpenMMException("Particle positions have not been set");
+
+    // Find which parameters are being varied.
+
+    map<string, double> originalValues;
+    for (int i = 0; i < (int) parameterSets.size(); i++)
+        for (map<string, double>::const_iterator iter = parameterSets[i].begin(); iter != parameterSets[i].end(); ++iter) {
+            if (parameters.find(iter->first) == parameters.end())
+                throw OpenMMException("Called getPotentialEnergies() with invalid parameter name: "+iter->first);
+            originalValues[iter->first] = parameters[iter->first];
+        }
+
+    // Loop over parameter sets and compute the energy for each one.  Where the platform allows it, calcPotentialEnergy()
+    // evaluates the Forces that do not depend on the varied parameters only once and reuses their energy after that.
+    // Otherwise every Force is evaluated for every set.
+
+    vector<double> energies(parameterSets.size());
+    try {
+        for (int i = 0; i < (int) parameterSets.size(); i++) {
+            for (map<string, double>::const_iterator iter = originalValues.begin(); iter != originalValues.end(); ++iter) {
+                map<string, double>::const_iterator value = parameterSets[i].find(iter->first);
+                setParameter(iter->first, value == parameterSets[i].end() ? iter->second : value->second);
+            }
+            energies[i] = calcPotentialEnergy(groups);
+        }
+    }
+    catch (...) {
+        for (map<string, double>::const_iterator iter = originalValues.begin(); iter != originalValues.end(); ++iter)
+            setParameter(iter->first, iter->second);
+        throw;
+    }
+    for (map<string, double>::const_iterator iter = originalValues.begin(); iter != originalValues.end(); ++iter)
+        setParameter(iter->first, iter->second);
+    return energies;
+}
+
 int ContextImpl::getLastForceGroups() const {
     return lastForceGroups;
 }
@@ -228,6 +459,7 @@ double ContextImpl::calcKineticEnergy() {
 }
 
 void ContextImpl::updateContextState() {
+    invalidateCachedEnergies();
     for (int i = 0; i < (int) forceImpls.size(); ++i)
         forceImpls[i]->updateContextState(*this);
 }
@@ -255,7 +487,7 @@ void ContextImpl::setPlatformData(void* data) {
 const vector<vector<int> >& ContextImpl::getMolecules() const {
     if (!hasInitializedForces)
         throw OpenMMException("ContextImpl: getMolecules() cannot be called until all ForceImpls have been initialized");
-    if (molecules.size() > 0 || system.getNumParticles() == 0)
+    if ((molecules.size() > 0 && !moleculesNeedCheck) || system.getNumParticles() == 0)
         return molecules;
 
     // First make a list of bonds and constraints.
@@ -279,6 +511,16 @@ const vector<vector<int> >& ContextImpl::getMolecules() const {
         }
     }
 
+    // Molecules copied from another Context can be reused only if they were built from the same bonds.
+
+    if (moleculesNeedCheck) {
+        moleculesNeedCheck = false;
+        if (bonds == moleculeBonds && molecules.size() > 0)
+            return molecules;
+        molecules.clear();
+    }
+    moleculeBonds = bonds;
+
     // Make a list of every other particle to which each particle is connected
 
     int numParticles = system.getNumParticles();
@@ -354,5 +596,6 @@ void ContextImpl::loadCheckpoint(istream& stream) {
         stream.read((char*) &value, sizeof(double));
         parameters[name] = value;
     }
+    invalidateCachedEnergies();
     updateStateDataKernel.getAs<UpdateStateDataKernel>().loadCheckpoint(*this, stream);
 }
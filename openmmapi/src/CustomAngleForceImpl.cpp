@@ -107,5 +107,6 @@ map<string, double> CustomAngleForceImpl::getDefaultParameters() {
 }
 
 void CustomAngleForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomAngleForceKernel>().copyParametersToContext(context, owner);
 }
@@ -112,5 +112,6 @@ vector<pair<int, int> > CustomBondForceImpl::getBondedParticles() const {
 }
 
 void CustomBondForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomBondForceKernel>().copyParametersToContext(context, owner);
 }
@@ -194,5 +194,6 @@ ExpressionTreeNode CustomCompoundBondForceImpl::replaceFunctions(const Expressio
 }
 
 void CustomCompoundBondForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomCompoundBondForceKernel>().copyParametersToContext(context, owner);
 }
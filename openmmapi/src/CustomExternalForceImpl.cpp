@@ -96,5 +96,6 @@ map<string, double> CustomExternalForceImpl::getDefaultParameters() {
 }
 
 void CustomExternalForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomExternalForceKernel>().copyParametersToContext(context, owner);
 }
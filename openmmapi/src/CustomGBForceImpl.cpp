@@ -125,5 +125,6 @@ map<string, double> CustomGBForceImpl::getDefaultParameters() {
 }
 
 void CustomGBForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomGBForceKernel>().copyParametersToContext(context, owner);
 }
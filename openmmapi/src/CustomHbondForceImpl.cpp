@@ -268,5 +268,6 @@ ExpressionTreeNode CustomHbondForceImpl::replaceFunctions(const ExpressionTreeNo
 }
 
 void CustomHbondForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomHbondForceKernel>().copyParametersToContext(context, owner);
 }
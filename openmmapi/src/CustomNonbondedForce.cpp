@@ -48,7 +48,7 @@ using std::stringstream;
 using std::vector;
 
 CustomNonbondedForce::CustomNonbondedForce(const string& energy) : energyExpression(energy), nonbondedMethod(NoCutoff), cutoffDistance(1.0),
-    switchingDistance(-1.0), useSwitchingFunction(false), useLongRangeCorrection(false) {
+    switchingDistance(-1.0), useSwitchingFunction(false), useLongRangeCorrection(false), numDiscardedParticleChanges(0) {
 }
 
 const string& CustomNonbondedForce::getEnergyFunction() const {
@@ -152,6 +152,11 @@ void CustomNonbondedForce::getParticleParameters(int index, std::vector<double>&
 void CustomNonbondedForce::setParticleParameters(int index, const vector<double>& parameters) {
     ASSERT_VALID_INDEX(index, particles);
     particles[index].parameters = parameters;
+    if (changedParticles.size() >= particles.size()) {
+        numDiscardedParticleChanges += changedParticles.size();
+        changedParticles.clear();
+    }
+    changedParticles.push_back(index);
 }
 
 int CustomNonbondedForce::addExclusion(int particle1, int particle2) {
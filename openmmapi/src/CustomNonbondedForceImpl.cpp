@@ -36,14 +36,17 @@
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/CustomNonbondedForceImpl.h"
 #include "openmm/internal/SplineFitter.h"
+#include "openmm/internal/ThreadPool.h"
 #include "openmm/kernels.h"
 #include "lepton/CustomFunction.h"
 #include "lepton/ParsedExpression.h"
 #include "lepton/Parser.h"
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 
 using namespace OpenMM;
+using std::make_pair;
 using std::map;
 using std::pair;
 using std::vector;
@@ -51,7 +54,7 @@ using std::set;
 using std::string;
 using std::stringstream;
 
-CustomNonbondedForceImpl::CustomNonbondedForceImpl(const CustomNonbondedForce& owner) : owner(owner) {
+CustomNonbondedForceImpl::CustomNonbondedForceImpl(const CustomNonbondedForce& owner) : owner(owner), particleChangesSeen(0) {
 }
 
 CustomNonbondedForceImpl::~CustomNonbondedForceImpl() {
@@ -115,6 +118,7 @@ void CustomNonbondedForceImpl::initialize(ContextImpl& context) {
             throw OpenMMException("CustomNonbondedForce: The cutoff distance cannot be greater than half the periodic box size.");
     }
     kernel.getAs<CalcCustomNonbondedForceKernel>().initialize(context.getSystem(), owner);
+    particleChangesSeen = owner.numDiscardedParticleChanges+owner.changedParticles.size();
 }
 
 double CustomNonbondedForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
@@ -137,7 +141,19 @@ map<string, double> CustomNonbondedForceImpl::getDefaultParameters() {
 }
 
 void CustomNonbondedForceImpl::updateParametersInContext(ContextImpl& context) {
-    kernel.getAs<CalcCustomNonbondedForceKernel>().copyParametersToContext(context, owner);
+    context.forceParametersChanged();
+    // If some of the changes made since the last update have been discarded from the owner's log,
+    // we have to copy everything.
+
+    if (particleChangesSeen < owner.numDiscardedParticleChanges)
+        kernel.getAs<CalcCustomNonbondedForceKernel>().copyParametersToContext(context, owner);
+    else {
+        vector<int> particles(owner.changedParticles.begin()+(particleChangesSeen-owner.numDiscardedParticleChanges), owner.changedParticles.end());
+        std::sort(particles.begin(), particles.end());
+        particles.erase(std::unique(particles.begin(), particles.end()), particles.end());
+        kernel.getAs<CalcCustomNonbondedForceKernel>().copyChangedParametersToContext(context, owner, particles);
+    }
+    particleChangesSeen = owner.numDiscardedParticleChanges+owner.changedParticles.size();
 }
 
 class CustomNonbondedForceImpl::TabulatedFunction : public Lepton::CustomFunction {
@@ -172,26 +188,78 @@ public:
     vector<double> x, values, derivs;
 };
 
+/**
+ * All LongRangeCorrections share one thread pool, which is created the first time it is needed.
+ * A ThreadPool can only run one task at a time, so callers must hold sharedThreadsLock while using it.
+ */
+static ThreadPool* sharedThreads = NULL;
+static pthread_mutex_t sharedThreadsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * This acquires sharedThreadsLock on creation and releases it on destruction, so the lock is released
+ * even if a task throws an exception.
+ */
+class SharedThreadsLocker {
+public:
+    SharedThreadsLocker() {
+        pthread_mutex_lock(&sharedThreadsLock);
+    }
+    ~SharedThreadsLocker() {
+        pthread_mutex_unlock(&sharedThreadsLock);
+    }
+};
+
 double CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedForce& force, const Context& context) {
     if (force.getNonbondedMethod() == CustomNonbondedForce::NoCutoff || force.getNonbondedMethod() == CustomNonbondedForce::CutoffNonPeriodic)
         return 0.0;
-    
+    LongRangeCorrection correction(force);
+    return correction.getCoefficient(context);
+}
+
+class CustomNonbondedForceImpl::LongRangeCorrection::IntegrationTask : public ThreadPool::Task {
+public:
+    IntegrationTask(const LongRangeCorrection& owner, const vector<pair<int, int> >& classPairs, const vector<double>& globalValues, vector<double>& integrals) :
+            owner(owner), classPairs(classPairs), globalValues(globalValues), integrals(integrals) {
+    }
+    void execute(ThreadPool& pool, int threadIndex) {
+        // Each thread needs its own copy of the expression, since that is where variable values are stored.
+        // Pairs are divided between threads in a fixed pattern so the result does not depend on timing.
+
+        Lepton::CompiledExpression expression = owner.expression;
+        for (int i = threadIndex; i < (int) classPairs.size(); i += pool.getNumThreads())
+            integrals[i] = owner.integrateInteraction(expression, classPairs[i].first, classPairs[i].second, globalValues);
+    }
+    const LongRangeCorrection& owner;
+    const vector<pair<int, int> >& classPairs;
+    const vector<double>& globalValues;
+    vector<double>& integrals;
+};
+
+const int CustomNonbondedForceImpl::LongRangeCorrection::MaxCachedParameterSets;
+
+CustomNonbondedForceImpl::LongRangeCorrection::LongRangeCorrection(const CustomNonbondedForce& force) {
+    numParticles = force.getNumParticles();
+    cutoff = force.getCutoffDistance();
+    useSwitchingFunction = force.getUseSwitchingFunction();
+    switchingDistance = force.getSwitchingDistance();
+    for (int i = 0; i < force.getNumPerParticleParameters(); i++)
+        parameterNames.push_back(force.getPerParticleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+
     // Identify all particle classes (defined by parameters), and count the number of
     // particles in each class.
 
-    map<vector<double>, int> classCounts;
-    for (int i = 0; i < force.getNumParticles(); i++) {
-        vector<double> parameters;
+    particleClass.resize(numParticles);
+    vector<double> parameters;
+    for (int i = 0; i < numParticles; i++) {
         force.getParticleParameters(i, parameters);
-        map<vector<double>, int>::iterator entry = classCounts.find(parameters);
-        if (entry == classCounts.end())
-            classCounts[parameters] = 1;
-        else
-            entry->second++;
+        particleClass[i] = findClass(parameters);
+        classCounts[particleClass[i]]++;
     }
-    
+
     // Parse the energy expression.
-    
+
     map<string, Lepton::CustomFunction*> functions;
     for (int i = 0; i < force.getNumFunctions(); i++) {
         string name;
@@ -200,46 +268,130 @@ double CustomNonbondedForceImpl::calcLongRangeCorrection(const CustomNonbondedFo
         force.getFunctionParameters(i, name, values, min, max);
         functions[name] = new TabulatedFunction(min, max, values);
     }
-    Lepton::ExpressionProgram expression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize().createProgram();
+    expression = Lepton::Parser::parse(force.getEnergyFunction(), functions).createCompiledExpression();
+    for (map<string, Lepton::CustomFunction*>::iterator iter = functions.begin(); iter != functions.end(); ++iter)
+        delete iter->second;
+}
+
+CustomNonbondedForceImpl::LongRangeCorrection::~LongRangeCorrection() {
+}
+
+double CustomNonbondedForceImpl::LongRangeCorrection::getCoefficient(const Context& context) {
+    vector<double> globalValues(globalParameterNames.size());
+    for (int i = 0; i < (int) globalParameterNames.size(); i++)
+        globalValues[i] = context.getParameter(globalParameterNames[i]);
+    map<vector<double>, double>::const_iterator cached = cache.find(globalValues);
+    if (cached != cache.end())
+        return cached->second;
+
+    // Keep the cache from growing without limit when the global parameters take many different values.
+
+    if (integrals.find(globalValues) == integrals.end() && (int) integrals.size() >= MaxCachedParameterSets) {
+        integrals.clear();
+        cache.clear();
+    }
+
+    // Find the pairs of classes whose interaction has not already been integrated for these global
+    // parameters.  Classes that no longer contain any particles can be skipped.
+
+    map<pair<int, int>, double>& pairIntegrals = integrals[globalValues];
+    vector<pair<int, int> > classPairs;
+    for (int i = 0; i < (int) classes.size(); i++) {
+        if (classCounts[i] == 0)
+            continue;
+        for (int j = 0; j <= i; j++)
+            if (classCounts[j] > 0 && pairIntegrals.find(make_pair(i, j)) == pairIntegrals.end())
+                classPairs.push_back(make_pair(i, j));
+    }
+
+    // Integrate the interaction for each of them.
+
+    vector<double> newIntegrals(classPairs.size());
+    if (classPairs.size() > 1) {
+        SharedThreadsLocker locker;
+        if (sharedThreads == NULL)
+            sharedThreads = new ThreadPool();
+        IntegrationTask task(*this, classPairs, globalValues, newIntegrals);
+        sharedThreads->execute(task);
+        sharedThreads->waitForThreads();
+    }
+    else if (classPairs.size() == 1) {
+        Lepton::CompiledExpression expressionCopy = expression;
+        newIntegrals[0] = integrateInteraction(expressionCopy, classPairs[0].first, classPairs[0].second, globalValues);
+    }
+    for (int i = 0; i < (int) classPairs.size(); i++)
+        pairIntegrals[classPairs[i]] = newIntegrals[i];
 
-    // Loop over all pairs of classes to compute the coefficient.
+    // Combine them to compute the coefficient, weighting each pair of classes by the number of
+    // interactions it represents.
 
     double sum = 0;
-    for (map<vector<double>, int>::const_iterator entry = classCounts.begin(); entry != classCounts.end(); ++entry) {
-        int count = (entry->second*(entry->second+1))/2;
-        sum += count*integrateInteraction(expression, entry->first, entry->first, force, context);
+    for (int i = 0; i < (int) classes.size(); i++) {
+        if (classCounts[i] == 0)
+            continue;
+        sum += 0.5*classCounts[i]*(classCounts[i]+1.0)*pairIntegrals[make_pair(i, i)];
+        for (int j = 0; j < i; j++)
+            if (classCounts[j] > 0)
+                sum += (double) classCounts[i]*classCounts[j]*pairIntegrals[make_pair(i, j)];
     }
-    for (map<vector<double>, int>::const_iterator class1 = classCounts.begin(); class1 != classCounts.end(); ++class1)
-        for (map<vector<double>, int>::const_iterator class2 = classCounts.begin(); class2 != class1; ++class2) {
-            int count = class1->second*class2->second;
-            sum += count*integrateInteraction(expression, class1->first, class2->first, force, context);
-        }
-    int numParticles = force.getNumParticles();
-    int numInteractions = (numParticles*(numParticles+1))/2;
+    double numInteractions = 0.5*numParticles*(numParticles+1.0);
     sum /= numInteractions;
-    return 2*M_PI*numParticles*numParticles*sum;
+    double coefficient = 2*M_PI*numParticles*numParticles*sum;
+    cache[globalValues] = coefficient;
+    return coefficient;
 }
 
-double CustomNonbondedForceImpl::integrateInteraction(const Lepton::ExpressionProgram& expression, const vector<double>& params1, const vector<double>& params2,
-        const CustomNonbondedForce& force, const Context& context) {
-    map<std::string, double> variables;
-    for (int i = 0; i < force.getNumPerParticleParameters(); i++) {
-        stringstream name1, name2;
-        name1 << force.getPerParticleParameterName(i) << 1;
-        name2 << force.getPerParticleParameterName(i) << 2;
-        variables[name1.str()] = params1[i];
-        variables[name2.str()] = params2[i];
+void CustomNonbondedForceImpl::LongRangeCorrection::updateParticles(const CustomNonbondedForce& force, const vector<int>& particles) {
+    vector<double> parameters;
+    for (int i = 0; i < (int) particles.size(); i++) {
+        int index = particles[i];
+        force.getParticleParameters(index, parameters);
+        int newClass = findClass(parameters);
+        if (newClass == particleClass[index])
+            continue;
+        classCounts[particleClass[index]]--;
+        classCounts[newClass]++;
+        particleClass[index] = newClass;
+
+        // The integrals are still valid, but the coefficients computed from them are not.
+
+        cache.clear();
     }
-    for (int i = 0; i < force.getNumGlobalParameters(); i++) {
-        const string& name = force.getGlobalParameterName(i);
-        variables[name] = context.getParameter(name);
+}
+
+int CustomNonbondedForceImpl::LongRangeCorrection::findClass(const vector<double>& parameters) {
+    map<vector<double>, int>::const_iterator entry = classIndex.find(parameters);
+    if (entry != classIndex.end())
+        return entry->second;
+    int index = classes.size();
+    classIndex[parameters] = index;
+    classes.push_back(parameters);
+    classCounts.push_back(0);
+    return index;
+}
+
+double CustomNonbondedForceImpl::LongRangeCorrection::integrateInteraction(Lepton::CompiledExpression& expression, int class1, int class2,
+        const vector<double>& globalValues) const {
+    const set<string>& variables = expression.getVariables();
+    for (int i = 0; i < (int) parameterNames.size(); i++) {
+        stringstream name1, name2;
+        name1 << parameterNames[i] << 1;
+        name2 << parameterNames[i] << 2;
+        if (variables.find(name1.str()) != variables.end())
+            expression.getVariableReference(name1.str()) = classes[class1][i];
+        if (variables.find(name2.str()) != variables.end())
+            expression.getVariableReference(name2.str()) = classes[class2][i];
     }
+    for (int i = 0; i < (int) globalParameterNames.size(); i++)
+        if (variables.find(globalParameterNames[i]) != variables.end())
+            expression.getVariableReference(globalParameterNames[i]) = globalValues[i];
+    double dummy = 0;
+    double& r = (variables.find("r") == variables.end() ? dummy : expression.getVariableReference("r"));
     
     // To integrate from r_cutoff to infinity, make the change of variables x=r_cutoff/r and integrate from 0 to 1.
     // This introduces another r^2 into the integral, which along with the r^2 in the formula for the correction
     // means we multiply the function by r^4.  Use the midpoint method.
 
-    double cutoff = force.getCutoffDistance();
     double sum = 0;
     int numPoints = 1;
     for (int iteration = 0; ; iteration++) {
@@ -249,10 +401,9 @@ double CustomNonbondedForceImpl::integrateInteraction(const Lepton::ExpressionPr
             if (i%3 == 1)
                 continue;
             double x = (i+0.5)/numPoints;
-            double r = cutoff/x;
-            variables["r"] = r;
+            r = cutoff/x;
             double r2 = r*r;
-            newSum += expression.evaluate(variables)*r2*r2;
+            newSum += expression.evaluate()*r2*r2;
         }
         sum = newSum/numPoints + oldSum/3;
         if (iteration > 2 && (fabs((sum-oldSum)/sum) < 1e-5 || sum == 0))
@@ -265,8 +416,8 @@ double CustomNonbondedForceImpl::integrateInteraction(const Lepton::ExpressionPr
     // If a switching function is used, integrate over the switching interval.
     
     double sum2 = 0;
-    if (force.getUseSwitchingFunction()) {
-        double rswitch = force.getSwitchingDistance();
+    if (useSwitchingFunction) {
+        double rswitch = switchingDistance;
         sum2 = 0;
         numPoints = 1;
         for (int iteration = 0; ; iteration++) {
@@ -276,10 +427,9 @@ double CustomNonbondedForceImpl::integrateInteraction(const Lepton::ExpressionPr
                 if (i%3 == 1)
                     continue;
                 double x = (i+0.5)/numPoints;
-                double r = rswitch+x*(cutoff-rswitch);
+                r = rswitch+x*(cutoff-rswitch);
                 double switchValue = x*x*x*(10+x*(-15+x*6));
-                variables["r"] = r;
-                newSum += switchValue*expression.evaluate(variables)*r*r;
+                newSum += switchValue*expression.evaluate()*r*r;
             }
             sum2 = newSum/numPoints + oldSum/3;
             if (iteration > 2 && (fabs((sum2-oldSum)/sum2) < 1e-5 || sum2 == 0))
@@ -114,5 +114,6 @@ map<string, double> CustomTorsionForceImpl::getDefaultParameters() {
 }
 
 void CustomTorsionForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcCustomTorsionForceKernel>().copyParametersToContext(context, owner);
 }
@@ -0,0 +1,299 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/DCDWriter.h"
+#include "openmm/Context.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <pthread.h>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * The maximum number of frames that may be waiting to be written.  If writeFrame() is called when this many
+ * are already queued, it blocks until the background thread catches up.
+ */
+static const int MAX_QUEUED_FRAMES = 8;
+
+static bool isLittleEndian() {
+    int one = 1;
+    return (*reinterpret_cast<char*>(&one) == 1);
+}
+
+/**
+ * Append a value to a buffer in little-endian byte order.
+ */
+template <class T>
+static void append(vector<char>& buffer, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    if (isLittleEndian())
+        buffer.insert(buffer.end(), bytes, bytes+sizeof(T));
+    else
+        for (int i = sizeof(T)-1; i >= 0; i--)
+            buffer.push_back(bytes[i]);
+}
+
+static void appendString(vector<char>& buffer, const string& str, int length) {
+    for (int i = 0; i < length; i++)
+        buffer.push_back(i < (int) str.size() ? str[i] : '\0');
+}
+
+class DCDWriter::Frame {
+public:
+    vector<Vec3> positions;
+    Vec3 boxSize;
+};
+
+class DCDWriter::WriterThread {
+public:
+    WriterThread(const string& filename, bool usePeriodicBox, int firstStep, int interval) : usePeriodicBox(usePeriodicBox),
+            firstStep(firstStep), interval(interval), numWritten(0), isDeleted(false) {
+        file.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+        if (!file.is_open())
+            throw OpenMMException("DCDWriter: Unable to open file "+filename);
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&queueCondition, NULL);
+        pthread_cond_init(&writtenCondition, NULL);
+    }
+    ~WriterThread() {
+        pthread_mutex_destroy(&lock);
+        pthread_cond_destroy(&queueCondition);
+        pthread_cond_destroy(&writtenCondition);
+        for (int i = 0; i < (int) queue.size(); i++)
+            delete queue[i];
+    }
+    void start() {
+        pthread_create(&thread, NULL, threadBody, this);
+    }
+    void stop() {
+        pthread_mutex_lock(&lock);
+        isDeleted = true;
+        pthread_cond_broadcast(&queueCondition);
+        pthread_mutex_unlock(&lock);
+        pthread_join(thread, NULL);
+        file.close();
+    }
+    void addFrame(Frame* frame) {
+        pthread_mutex_lock(&lock);
+        while ((int) queue.size() >= MAX_QUEUED_FRAMES && errorMessage.size() == 0)
+            pthread_cond_wait(&writtenCondition, &lock);
+        queue.push_back(frame);
+        pthread_cond_signal(&queueCondition);
+        pthread_mutex_unlock(&lock);
+    }
+    void waitForFrames() {
+        pthread_mutex_lock(&lock);
+        while (queue.size() > 0 && errorMessage.size() == 0)
+            pthread_cond_wait(&writtenCondition, &lock);
+        pthread_mutex_unlock(&lock);
+    }
+    string getError() {
+        pthread_mutex_lock(&lock);
+        string error = errorMessage;
+        pthread_mutex_unlock(&lock);
+        return error;
+    }
+    void writeBuffer(const vector<char>& buffer) {
+        file.write(&buffer[0], buffer.size());
+    }
+    void run() {
+        vector<char> buffer;
+        vector<float> coords;
+        pthread_mutex_lock(&lock);
+        while (true) {
+            while (queue.size() == 0 && !isDeleted)
+                pthread_cond_wait(&queueCondition, &lock);
+            if (queue.size() == 0)
+                break;
+            Frame* frame = queue.front();
+            pthread_mutex_unlock(&lock);
+
+            // Write the frame.  Coordinates are stored in Angstroms.
+
+            buffer.clear();
+            if (usePeriodicBox) {
+                append<int>(buffer, 48);
+                append<double>(buffer, 10*frame->boxSize[0]);
+                append<double>(buffer, 0.0);
+                append<double>(buffer, 10*frame->boxSize[1]);
+                append<double>(buffer, 0.0);
+                append<double>(buffer, 0.0);
+                append<double>(buffer, 10*frame->boxSize[2]);
+                append<int>(buffer, 48);
+            }
+            int numParticles = frame->positions.size();
+            for (int axis = 0; axis < 3; axis++) {
+                append<int>(buffer, 4*numParticles);
+                for (int i = 0; i < numParticles; i++)
+                    append<float>(buffer, (float) (10*frame->positions[i][axis]));
+                append<int>(buffer, 4*numParticles);
+            }
+            writeBuffer(buffer);
+            delete frame;
+            numWritten++;
+
+            // If everything queued so far has been written, update the header.  The frame is only removed from
+            // the queue afterward, so waitForFrames() cannot return before the header is complete.
+
+            pthread_mutex_lock(&lock);
+            if (queue.size() == 1) {
+                pthread_mutex_unlock(&lock);
+                updateHeader();
+                pthread_mutex_lock(&lock);
+            }
+            queue.pop_front();
+            if (!file.good() && errorMessage.size() == 0)
+                errorMessage = "DCDWriter: Error writing to file";
+            pthread_cond_broadcast(&writtenCondition);
+        }
+        pthread_mutex_unlock(&lock);
+    }
+    void updateHeader() {
+        vector<char> buffer;
+        append<int>(buffer, numWritten);
+        file.seekp(8, ios::beg);
+        writeBuffer(buffer);
+        buffer.clear();
+        append<int>(buffer, firstStep+numWritten*interval);
+        file.seekp(20, ios::beg);
+        writeBuffer(buffer);
+        file.seekp(0, ios::end);
+        file.flush();
+    }
+    static void* threadBody(void* args) {
+        reinterpret_cast<WriterThread*>(args)->run();
+        return 0;
+    }
+    fstream file;
+    bool usePeriodicBox;
+    int firstStep, interval, numWritten;
+    bool isDeleted;
+    deque<Frame*> queue;
+    string errorMessage;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t queueCondition, writtenCondition;
+};
+
+DCDWriter::DCDWriter(const string& filename, int numParticles, double stepSize, int firstStep, int interval, bool usePeriodicBox) :
+        numParticles(numParticles), firstStep(firstStep), interval(interval), numFrames(0), usePeriodicBox(usePeriodicBox), thread(NULL) {
+    if (numParticles <= 0)
+        throw OpenMMException("DCDWriter: The number of particles must be positive");
+    if (interval <= 0)
+        throw OpenMMException("DCDWriter: The interval must be positive");
+    thread = new WriterThread(filename, usePeriodicBox, firstStep, interval);
+
+    // Write the header.  The step size is stored in AKMA time units.
+
+    vector<char> buffer;
+    append<int>(buffer, 84);
+    appendString(buffer, "CORD", 4);
+    append<int>(buffer, 0);
+    append<int>(buffer, firstStep);
+    append<int>(buffer, interval);
+    for (int i = 0; i < 6; i++)
+        append<int>(buffer, 0);
+    append<float>(buffer, (float) (stepSize/0.04888821));
+    append<int>(buffer, usePeriodicBox ? 1 : 0);
+    for (int i = 0; i < 8; i++)
+        append<int>(buffer, 0);
+    append<int>(buffer, 24);
+    append<int>(buffer, 84);
+    append<int>(buffer, 164);
+    append<int>(buffer, 2);
+    appendString(buffer, "Created by OpenMM", 80);
+    time_t currentTime = time(NULL);
+    string timeString = asctime(localtime(&currentTime));
+    if (timeString.size() > 0 && timeString[timeString.size()-1] == '\n')
+        timeString.erase(timeString.size()-1);
+    appendString(buffer, "Created "+timeString, 80);
+    append<int>(buffer, 164);
+    append<int>(buffer, 4);
+    append<int>(buffer, numParticles);
+    append<int>(buffer, 4);
+    thread->writeBuffer(buffer);
+    thread->file.flush();
+    if (!thread->file.good()) {
+        delete thread;
+        throw OpenMMException("DCDWriter: Error writing to file "+filename);
+    }
+    thread->start();
+}
+
+DCDWriter::~DCDWriter() {
+    if (thread != NULL) {
+        thread->stop();
+        delete thread;
+    }
+}
+
+void DCDWriter::writeFrame(Context& context, bool enforcePeriodicBox) {
+    State state = context.getState(State::Positions, enforcePeriodicBox);
+    Vec3 a, b, c;
+    state.getPeriodicBoxVectors(a, b, c);
+    writeFrame(state.getPositions(), a, b, c);
+}
+
+void DCDWriter::writeFrame(const vector<Vec3>& positions, const Vec3& a, const Vec3& b, const Vec3& c) {
+    checkForError();
+    if ((int) positions.size() != numParticles)
+        throw OpenMMException("DCDWriter: The number of positions does not match the number of particles");
+    for (int i = 0; i < numParticles; i++)
+        for (int j = 0; j < 3; j++) {
+            double x = positions[i][j];
+            if (x != x)
+                throw OpenMMException("DCDWriter: Particle position is NaN");
+            if (x-x != 0.0)
+                throw OpenMMException("DCDWriter: Particle position is infinite");
+        }
+    Frame* frame = new Frame();
+    frame->positions = positions;
+    frame->boxSize = Vec3(a[0], b[1], c[2]);
+    thread->addFrame(frame);
+    numFrames++;
+}
+
+void DCDWriter::flush() {
+    thread->waitForFrames();
+    checkForError();
+}
+
+void DCDWriter::checkForError() {
+    string error = thread->getError();
+    if (error.size() > 0)
+        throw OpenMMException(error);
+}
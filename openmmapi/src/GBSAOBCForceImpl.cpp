@@ -68,5 +68,6 @@ std::vector<std::string> GBSAOBCForceImpl::getKernelNames() {
 }
 
 void GBSAOBCForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcGBSAOBCForceKernel>().copyParametersToContext(context, owner);
 }
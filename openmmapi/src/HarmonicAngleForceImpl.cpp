@@ -61,6 +61,18 @@ std::vector<std::string> HarmonicAngleForceImpl::getKernelNames() {
     return names;
 }
 
+bool HarmonicAngleForceImpl::involvesParticles(const vector<bool>& particles) const {
+    for (int i = 0; i < owner.getNumAngles(); i++) {
+        int particle1, particle2, particle3;
+        double angle, k;
+        owner.getAngleParameters(i, particle1, particle2, particle3, angle, k);
+        if (particles[particle1] || particles[particle2] || particles[particle3])
+            return true;
+    }
+    return false;
+}
+
 void HarmonicAngleForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcHarmonicAngleForceKernel>().copyParametersToContext(context, owner);
 }
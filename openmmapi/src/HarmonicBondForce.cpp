@@ -36,6 +36,7 @@
 #include "openmm/internal/HarmonicBondForceImpl.h"
 
 using namespace OpenMM;
+using std::vector;
 
 HarmonicBondForce::HarmonicBondForce() {
 }
@@ -45,6 +46,20 @@ int HarmonicBondForce::addBond(int particle1, int particle2, double length, doub
     return bonds.size()-1;
 }
 
+int HarmonicBondForce::addBonds(const vector<int>& particles1, const vector<int>& particles2, const vector<double>& lengths, const vector<double>& k) {
+    int numBonds = particles1.size();
+    if ((int) particles2.size() != numBonds || (int) lengths.size() != numBonds || (int) k.size() != numBonds)
+        throw OpenMMException("HarmonicBondForce: The arrays passed to addBonds() must all have the same length");
+    int first = bonds.size();
+    for (int i = 0; i < numBonds; i++)
+        bonds.push_back(BondInfo(particles1[i], particles2[i], lengths[i], k[i]));
+    return first;
+}
+
+void HarmonicBondForce::reserveBonds(int numBonds) {
+    bonds.reserve(numBonds);
+}
+
 void HarmonicBondForce::getBondParameters(int index, int& particle1, int& particle2, double& length, double& k) const {
     ASSERT_VALID_INDEX(index, bonds);
     particle1 = bonds[index].particle1;
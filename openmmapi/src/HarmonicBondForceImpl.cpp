@@ -71,6 +71,18 @@ vector<pair<int, int> > HarmonicBondForceImpl::getBondedParticles() const {
     return bonds;
 }
 
+bool HarmonicBondForceImpl::involvesParticles(const vector<bool>& particles) const {
+    for (int i = 0; i < owner.getNumBonds(); i++) {
+        int particle1, particle2;
+        double length, k;
+        owner.getBondParameters(i, particle1, particle2, length, k);
+        if (particles[particle1] || particles[particle2])
+            return true;
+    }
+    return false;
+}
+
 void HarmonicBondForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcHarmonicBondForceKernel>().copyParametersToContext(context, owner);
 }
@@ -34,6 +34,7 @@
 #include "openmm/NonbondedForce.h"
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <sstream>
@@ -48,7 +49,8 @@ using std::stringstream;
 using std::vector;
 
 NonbondedForce::NonbondedForce() : nonbondedMethod(NoCutoff), cutoffDistance(1.0), switchingDistance(-1.0), rfDielectric(78.3),
-        ewaldErrorTol(5e-4), useSwitchingFunction(false), useDispersionCorrection(true), recipForceGroup(-1) {
+        ewaldErrorTol(5e-4), useSwitchingFunction(false), useDispersionCorrection(true), recipForceGroup(-1),
+        numDiscardedParticleChanges(0), numDiscardedExceptionChanges(0) {
 }
 
 NonbondedForce::NonbondedMethod NonbondedForce::getNonbondedMethod() const {
@@ -105,6 +107,20 @@ int NonbondedForce::addParticle(double charge, double sigma, double epsilon) {
     return particles.size()-1;
 }
 
+int NonbondedForce::addParticles(const vector<double>& charges, const vector<double>& sigmas, const vector<double>& epsilons) {
+    int numParticles = charges.size();
+    if ((int) sigmas.size() != numParticles || (int) epsilons.size() != numParticles)
+        throw OpenMMException("NonbondedForce: The arrays passed to addParticles() must all have the same length");
+    int first = particles.size();
+    for (int i = 0; i < numParticles; i++)
+        particles.push_back(ParticleInfo(charges[i], sigmas[i], epsilons[i]));
+    return first;
+}
+
+void NonbondedForce::reserveParticles(int numParticles) {
+    particles.reserve(numParticles);
+}
+
 void NonbondedForce::getParticleParameters(int index, double& charge, double& sigma, double& epsilon) const {
     ASSERT_VALID_INDEX(index, particles);
     charge = particles[index].charge;
@@ -117,6 +133,24 @@ void NonbondedForce::setParticleParameters(int index, double charge, double sigm
     particles[index].charge = charge;
     particles[index].sigma = sigma;
     particles[index].epsilon = epsilon;
+    recordParticleChange(index);
+}
+
+void NonbondedForce::setAllParticleParameters(const vector<double>& charges, const vector<double>& sigmas, const vector<double>& epsilons) {
+    int numParticles = particles.size();
+    if ((int) charges.size() != numParticles || (int) sigmas.size() != numParticles || (int) epsilons.size() != numParticles)
+        throw OpenMMException("NonbondedForce: The arrays passed to setAllParticleParameters() must have one element for every particle");
+    for (int i = 0; i < numParticles; i++) {
+        particles[i].charge = charges[i];
+        particles[i].sigma = sigmas[i];
+        particles[i].epsilon = epsilons[i];
+    }
+
+    // Every particle has changed, so discard the log.  Any Context that has not yet seen all of it will copy
+    // everything the next time it is updated.
+
+    numDiscardedParticleChanges += changedParticles.size()+1;
+    changedParticles.clear();
 }
 
 int NonbondedForce::addException(int particle1, int particle2, double chargeProd, double sigma, double epsilon, bool replace) {
@@ -136,6 +170,7 @@ int NonbondedForce::addException(int particle1, int particle2, double chargeProd
         exceptions[iter->second] = ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon);
         newIndex = iter->second;
         exceptionMap.erase(iter->first);
+        recordExceptionChange(newIndex);
     }
     else {
         exceptions.push_back(ExceptionInfo(particle1, particle2, chargeProd, sigma, epsilon));
@@ -144,6 +179,42 @@ int NonbondedForce::addException(int particle1, int particle2, double chargeProd
     exceptionMap[pair<int, int>(particle1, particle2)] = newIndex;
     return newIndex;
 }
+
+int NonbondedForce::addExceptions(const vector<int>& particles1, const vector<int>& particles2, const vector<double>& chargeProds,
+        const vector<double>& sigmas, const vector<double>& epsilons) {
+    int numExceptions = particles1.size();
+    if ((int) particles2.size() != numExceptions || (int) chargeProds.size() != numExceptions || (int) sigmas.size() != numExceptions || (int) epsilons.size() != numExceptions)
+        throw OpenMMException("NonbondedForce: The arrays passed to addExceptions() must all have the same length");
+
+    // Check every pair, including duplicates within the new ones, before changing anything so that a failure
+    // leaves the Force unmodified.
+
+    set<pair<int, int> > newPairs;
+    for (int i = 0; i < numExceptions; i++) {
+        pair<int, int> key(std::min(particles1[i], particles2[i]), std::max(particles1[i], particles2[i]));
+        if (exceptionMap.find(pair<int, int>(particles1[i], particles2[i])) != exceptionMap.end() ||
+                exceptionMap.find(pair<int, int>(particles2[i], particles1[i])) != exceptionMap.end() ||
+                !newPairs.insert(key).second) {
+            stringstream msg;
+            msg << "NonbondedForce: There is already an exception for particles ";
+            msg << particles1[i];
+            msg << " and ";
+            msg << particles2[i];
+            throw OpenMMException(msg.str());
+        }
+    }
+    int first = exceptions.size();
+    for (int i = 0; i < numExceptions; i++) {
+        exceptions.push_back(ExceptionInfo(particles1[i], particles2[i], chargeProds[i], sigmas[i], epsilons[i]));
+        exceptionMap[pair<int, int>(particles1[i], particles2[i])] = first+i;
+    }
+    return first;
+}
+
+void NonbondedForce::reserveExceptions(int numExceptions) {
+    exceptions.reserve(numExceptions);
+}
+
 void NonbondedForce::getExceptionParameters(int index, int& particle1, int& particle2, double& chargeProd, double& sigma, double& epsilon) const {
     ASSERT_VALID_INDEX(index, exceptions);
     particle1 = exceptions[index].particle1;
@@ -160,6 +231,25 @@ void NonbondedForce::setExceptionParameters(int index, int particle1, int partic
     exceptions[index].chargeProd = chargeProd;
     exceptions[index].sigma = sigma;
     exceptions[index].epsilon = epsilon;
+    recordExceptionChange(index);
+}
+
+void NonbondedForce::recordParticleChange(int index) {
+    // Once there are more changes than particles, it is no cheaper to copy only the changed ones.
+
+    if (changedParticles.size() >= particles.size()) {
+        numDiscardedParticleChanges += changedParticles.size();
+        changedParticles.clear();
+    }
+    changedParticles.push_back(index);
+}
+
+void NonbondedForce::recordExceptionChange(int index) {
+    if (changedExceptions.size() >= exceptions.size()) {
+        numDiscardedExceptionChanges += changedExceptions.size();
+        changedExceptions.clear();
+    }
+    changedExceptions.push_back(index);
 }
 
 ForceImpl* NonbondedForce::createImpl() const {
@@ -168,49 +258,62 @@ ForceImpl* NonbondedForce::createImpl() const {
 
 void NonbondedForce::createExceptionsFromBonds(const vector<pair<int, int> >& bonds, double coulomb14Scale, double lj14Scale) {
 
-    // Find particles separated by 1, 2, or 3 bonds.
+    // Build a compressed list of the particles bonded to each one.
 
-    vector<set<int> > exclusions(particles.size());
-    vector<set<int> > bonded12(exclusions.size());
+    int numParticles = particles.size();
+    vector<int> bondOffset(numParticles+1, 0);
+    for (int i = 0; i < (int) bonds.size(); ++i) {
+        bondOffset[bonds[i].first+1]++;
+        bondOffset[bonds[i].second+1]++;
+    }
+    for (int i = 0; i < numParticles; ++i)
+        bondOffset[i+1] += bondOffset[i];
+    vector<int> bonded12(bondOffset[numParticles]);
+    vector<int> nextIndex(bondOffset.begin(), bondOffset.end()-1);
     for (int i = 0; i < (int) bonds.size(); ++i) {
-        bonded12[bonds[i].first].insert(bonds[i].second);
-        bonded12[bonds[i].second].insert(bonds[i].first);
+        bonded12[nextIndex[bonds[i].first]++] = bonds[i].second;
+        bonded12[nextIndex[bonds[i].second]++] = bonds[i].first;
     }
-    for (int i = 0; i < (int) exclusions.size(); ++i)
-        addExclusionsToSet(bonded12, exclusions[i], i, i, 2);
-
-    // Find particles separated by 1 or 2 bonds and create the exceptions.
-
-    for (int i = 0; i < (int) exclusions.size(); ++i) {
-        set<int> bonded13;
-        addExclusionsToSet(bonded12, bonded13, i, i, 1);
-        for (set<int>::const_iterator iter = exclusions[i].begin(); iter != exclusions[i].end(); ++iter)
-            if (*iter < i) {
-                if (bonded13.find(*iter) == bonded13.end()) {
-                    // This is a 1-4 interaction.
-
-                    const ParticleInfo& particle1 = particles[*iter];
-                    const ParticleInfo& particle2 = particles[i];
-                    const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
-                    const double sigma = 0.5*(particle1.sigma+particle2.sigma);
-                    const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
-                    addException(*iter, i, chargeProd, sigma, epsilon);
-                }
-                else {
-                    // This interaction should be completely excluded.
-
-                    addException(*iter, i, 0.0, 1.0, 0.0);
-                }
+
+    // For each particle, find the particles separated from it by 1, 2, or 3 bonds and by 1 or 2 bonds,
+    // then create the exceptions.
+
+    vector<int> exclusions, bonded13;
+    for (int i = 0; i < numParticles; ++i) {
+        exclusions.clear();
+        bonded13.clear();
+        addExclusionsToList(bondOffset, bonded12, exclusions, i, i, 2);
+        addExclusionsToList(bondOffset, bonded12, bonded13, i, i, 1);
+        sort(exclusions.begin(), exclusions.end());
+        exclusions.erase(unique(exclusions.begin(), exclusions.end()), exclusions.end());
+        sort(bonded13.begin(), bonded13.end());
+        for (vector<int>::const_iterator iter = exclusions.begin(); iter != exclusions.end() && *iter < i; ++iter) {
+            if (!binary_search(bonded13.begin(), bonded13.end(), *iter)) {
+                // This is a 1-4 interaction.
+
+                const ParticleInfo& particle1 = particles[*iter];
+                const ParticleInfo& particle2 = particles[i];
+                const double chargeProd = coulomb14Scale*particle1.charge*particle2.charge;
+                const double sigma = 0.5*(particle1.sigma+particle2.sigma);
+                const double epsilon = lj14Scale*std::sqrt(particle1.epsilon*particle2.epsilon);
+                addException(*iter, i, chargeProd, sigma, epsilon);
+            }
+            else {
+                // This interaction should be completely excluded.
+
+                addException(*iter, i, 0.0, 1.0, 0.0);
             }
+        }
     }
 }
 
-void NonbondedForce::addExclusionsToSet(const vector<set<int> >& bonded12, set<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const {
-    for (set<int>::const_iterator iter = bonded12[fromParticle].begin(); iter != bonded12[fromParticle].end(); ++iter) {
-        if (*iter != baseParticle)
-            exclusions.insert(*iter);
+void NonbondedForce::addExclusionsToList(const vector<int>& bondOffset, const vector<int>& bonded12, vector<int>& exclusions, int baseParticle, int fromParticle, int currentLevel) const {
+    for (int i = bondOffset[fromParticle]; i < bondOffset[fromParticle+1]; ++i) {
+        int particle = bonded12[i];
+        if (particle != baseParticle)
+            exclusions.push_back(particle);
         if (currentLevel > 0)
-            addExclusionsToSet(bonded12, exclusions, baseParticle, *iter, currentLevel-1);
+            addExclusionsToList(bondOffset, bonded12, exclusions, baseParticle, particle, currentLevel-1);
     }
 }
 
@@ -36,6 +36,7 @@
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
 #include "openmm/kernels.h"
+#include <algorithm>
 #include <cmath>
 #include <map>
 #include <sstream>
@@ -43,7 +44,7 @@
 using namespace OpenMM;
 using namespace std;
 
-NonbondedForceImpl::NonbondedForceImpl(const NonbondedForce& owner) : owner(owner) {
+NonbondedForceImpl::NonbondedForceImpl(const NonbondedForce& owner) : owner(owner), particleChangesSeen(0), exceptionChangesSeen(0) {
 }
 
 NonbondedForceImpl::~NonbondedForceImpl() {
@@ -99,6 +100,8 @@ void NonbondedForceImpl::initialize(ContextImpl& context) {
             throw OpenMMException("NonbondedForce: The cutoff distance cannot be greater than half the periodic box size.");
     }
     kernel.getAs<CalcNonbondedForceKernel>().initialize(context.getSystem(), owner);
+    particleChangesSeen = owner.numDiscardedParticleChanges+owner.changedParticles.size();
+    exceptionChangesSeen = owner.numDiscardedExceptionChanges+owner.changedExceptions.size();
 }
 
 double NonbondedForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includeForces, bool includeEnergy, int groups) {
@@ -109,6 +112,10 @@ double NonbondedForceImpl::calcForcesAndEnergy(ContextImpl& context, bool includ
     return kernel.getAs<CalcNonbondedForceKernel>().execute(context, includeForces, includeEnergy, includeDirect, includeReciprocal);
 }
 
+bool NonbondedForceImpl::calcSubsetForcesAndEnergy(ContextImpl& context, const std::vector<int>& subset, double& energy) {
+    return kernel.getAs<CalcNonbondedForceKernel>().executeSubset(context, subset, energy);
+}
+
 std::vector<std::string> NonbondedForceImpl::getKernelNames() {
     std::vector<std::string> names;
     names.push_back(CalcNonbondedForceKernel::Name());
@@ -214,28 +221,56 @@ double NonbondedForceImpl::evalIntegral(double r, double rs, double rc, double s
 double NonbondedForceImpl::calcDispersionCorrection(const System& system, const NonbondedForce& force) {
     if (force.getNonbondedMethod() == NonbondedForce::NoCutoff || force.getNonbondedMethod() == NonbondedForce::CutoffNonPeriodic)
         return 0.0;
-    
+    return DispersionCorrection(force).getCoefficient();
+}
+
+NonbondedForceImpl::DispersionCorrection::DispersionCorrection(const NonbondedForce& force) {
+    numParticles = force.getNumParticles();
+    cutoff = force.getCutoffDistance();
+    useSwitchingFunction = force.getUseSwitchingFunction();
+    switchingDistance = force.getSwitchingDistance();
+
     // Identify all particle classes (defined by sigma and epsilon), and count the number of
     // particles in each class.
 
-    map<pair<double, double>, int> classCounts;
-    for (int i = 0; i < force.getNumParticles(); i++) {
+    particleClass.resize(numParticles);
+    for (int i = 0; i < numParticles; i++) {
         double charge, sigma, epsilon;
         force.getParticleParameters(i, charge, sigma, epsilon);
-        pair<double, double> key = make_pair(sigma, epsilon);
-        map<pair<double, double>, int>::iterator entry = classCounts.find(key);
-        if (entry == classCounts.end())
-            classCounts[key] = 1;
-        else
-            entry->second++;
+        particleClass[i] = make_pair(sigma, epsilon);
+        classCounts[particleClass[i]]++;
+    }
+    computeCoefficient();
+}
+
+void NonbondedForceImpl::DispersionCorrection::updateParticles(const NonbondedForce& force, const vector<int>& particles) {
+    bool changed = false;
+    for (int i = 0; i < (int) particles.size(); i++) {
+        int index = particles[i];
+        double charge, sigma, epsilon;
+        force.getParticleParameters(index, charge, sigma, epsilon);
+        pair<double, double> newClass = make_pair(sigma, epsilon);
+        if (newClass == particleClass[index])
+            continue;
+
+        // Move the particle to its new class.  Classes that become empty are removed, so the set
+        // of classes is always the same as if it had been built from scratch.
+
+        map<pair<double, double>, int>::iterator oldEntry = classCounts.find(particleClass[index]);
+        if (--oldEntry->second == 0)
+            classCounts.erase(oldEntry);
+        classCounts[newClass]++;
+        particleClass[index] = newClass;
+        changed = true;
     }
+    if (changed)
+        computeCoefficient();
+}
 
+void NonbondedForceImpl::DispersionCorrection::computeCoefficient() {
     // Loop over all pairs of classes to compute the coefficient.
 
     double sum1 = 0, sum2 = 0, sum3 = 0;
-    bool useSwitch = force.getUseSwitchingFunction();
-    double cutoff = force.getCutoffDistance();
-    double switchDist = force.getSwitchingDistance();
     for (map<pair<double, double>, int>::const_iterator entry = classCounts.begin(); entry != classCounts.end(); ++entry) {
         double sigma = entry->first.first;
         double epsilon = entry->first.second;
@@ -244,8 +279,8 @@ double NonbondedForceImpl::calcDispersionCorrection(const System& system, const
         double sigma6 = sigma2*sigma2*sigma2;
         sum1 += count*epsilon*sigma6*sigma6;
         sum2 += count*epsilon*sigma6;
-        if (useSwitch)
-            sum3 += count*epsilon*(evalIntegral(cutoff, switchDist, cutoff, sigma)-evalIntegral(switchDist, switchDist, cutoff, sigma));
+        if (useSwitchingFunction)
+            sum3 += count*epsilon*(evalIntegral(cutoff, switchingDistance, cutoff, sigma)-evalIntegral(switchingDistance, switchingDistance, cutoff, sigma));
     }
     for (map<pair<double, double>, int>::const_iterator class1 = classCounts.begin(); class1 != classCounts.end(); ++class1)
         for (map<pair<double, double>, int>::const_iterator class2 = classCounts.begin(); class2 != class1; ++class2) {
@@ -256,17 +291,42 @@ double NonbondedForceImpl::calcDispersionCorrection(const System& system, const
             double sigma6 = sigma2*sigma2*sigma2;
             sum1 += count*epsilon*sigma6*sigma6;
             sum2 += count*epsilon*sigma6;
-            if (useSwitch)
-                sum3 += count*epsilon*(evalIntegral(cutoff, switchDist, cutoff, sigma)-evalIntegral(switchDist, switchDist, cutoff, sigma));
+            if (useSwitchingFunction)
+                sum3 += count*epsilon*(evalIntegral(cutoff, switchingDistance, cutoff, sigma)-evalIntegral(switchingDistance, switchingDistance, cutoff, sigma));
         }
-    int numParticles = system.getNumParticles();
     int numInteractions = (numParticles*(numParticles+1))/2;
     sum1 /= numInteractions;
     sum2 /= numInteractions;
     sum3 /= numInteractions;
-    return 8*numParticles*numParticles*M_PI*(sum1/(9*pow(cutoff, 9))-sum2/(3*pow(cutoff, 3))+sum3);
+    coefficient = 8*numParticles*numParticles*M_PI*(sum1/(9*pow(cutoff, 9))-sum2/(3*pow(cutoff, 3))+sum3);
+}
+
+/**
+ * Find the indices that have been added to a Force's change log since the position an Impl last read up to,
+ * and advance the position to the end of the log.  Returns false if some of those changes have already been
+ * discarded from the log, in which case all parameters must be copied.
+ */
+static bool findChanges(const vector<int>& log, long long numDiscarded, long long& position, vector<int>& changed) {
+    bool complete = (position >= numDiscarded);
+    if (complete) {
+        changed.assign(log.begin()+(position-numDiscarded), log.end());
+        sort(changed.begin(), changed.end());
+        changed.erase(unique(changed.begin(), changed.end()), changed.end());
+    }
+    position = numDiscarded+log.size();
+    return complete;
 }
 
 void NonbondedForceImpl::updateParametersInContext(ContextImpl& context) {
-    kernel.getAs<CalcNonbondedForceKernel>().copyParametersToContext(context, owner);
+    context.forceParametersChanged();
+    vector<int> particles, exceptions;
+    long long particlePosition = particleChangesSeen, exceptionPosition = exceptionChangesSeen;
+    bool particlesKnown = findChanges(owner.changedParticles, owner.numDiscardedParticleChanges, particlePosition, particles);
+    bool exceptionsKnown = findChanges(owner.changedExceptions, owner.numDiscardedExceptionChanges, exceptionPosition, exceptions);
+    if (particlesKnown && exceptionsKnown)
+        kernel.getAs<CalcNonbondedForceKernel>().copyChangedParametersToContext(context, owner, particles, exceptions);
+    else
+        kernel.getAs<CalcNonbondedForceKernel>().copyParametersToContext(context, owner);
+    particleChangesSeen = particlePosition;
+    exceptionChangesSeen = exceptionPosition;
 }
@@ -61,6 +61,18 @@ std::vector<std::string> PeriodicTorsionForceImpl::getKernelNames() {
     return names;
 }
 
+bool PeriodicTorsionForceImpl::involvesParticles(const vector<bool>& particles) const {
+    for (int i = 0; i < owner.getNumTorsions(); i++) {
+        int particle1, particle2, particle3, particle4, periodicity;
+        double phase, k;
+        owner.getTorsionParameters(i, particle1, particle2, particle3, particle4, periodicity, phase, k);
+        if (particles[particle1] || particles[particle2] || particles[particle3] || particles[particle4])
+            return true;
+    }
+    return false;
+}
+
 void PeriodicTorsionForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcPeriodicTorsionForceKernel>().copyParametersToContext(context, owner);
 }
@@ -61,6 +61,18 @@ std::vector<std::string> RBTorsionForceImpl::getKernelNames() {
     return names;
 }
 
+bool RBTorsionForceImpl::involvesParticles(const vector<bool>& particles) const {
+    for (int i = 0; i < owner.getNumTorsions(); i++) {
+        int particle1, particle2, particle3, particle4;
+        double c0, c1, c2, c3, c4, c5;
+        owner.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
+        if (particles[particle1] || particles[particle2] || particles[particle3] || particles[particle4])
+            return true;
+    }
+    return false;
+}
+
 void RBTorsionForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcRBTorsionForceKernel>().copyParametersToContext(context, owner);
 }
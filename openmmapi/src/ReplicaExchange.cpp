@@ -0,0 +1,455 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/ReplicaExchange.h"
+#include "openmm/AndersenThermostat.h"
+#include "openmm/BrownianIntegrator.h"
+#include "openmm/Context.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/LangevinIntegrator.h"
+#include "openmm/MonteCarloAnisotropicBarostat.h"
+#include "openmm/MonteCarloBarostat.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/State.h"
+#include "openmm/VariableLangevinIntegrator.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/MonteCarloBarostatImpl.h"
+#include "openmm/internal/ThreadPool.h"
+#include "sfmt/SFMT.h"
+#include <cmath>
+#include <ctime>
+
+using namespace OpenMM;
+using namespace OpenMM_SFMT;
+using namespace std;
+
+const double BOLTZMANN = 1.380658e-23; // (J/K)
+const double AVOGADRO = 6.0221367e23;
+const double RGAS = BOLTZMANN*AVOGADRO; // (J/(mol K))
+const double BOLTZ = RGAS/1000;         // (kJ/(mol K))
+
+class ReplicaExchange::PropagateTask : public ThreadPool::Task {
+public:
+    PropagateTask(ReplicaExchange& owner, int steps) : owner(owner), steps(steps) {
+    }
+    void execute(ThreadPool& pool, int threadIndex) {
+        for (int i = threadIndex; i < owner.numReplicas; i += pool.getNumThreads())
+            owner.propagateReplica(*owner.contexts[threadIndex], i, steps);
+    }
+private:
+    ReplicaExchange& owner;
+    int steps;
+};
+
+class ReplicaExchange::EnergyTask : public ThreadPool::Task {
+public:
+    EnergyTask(ReplicaExchange& owner) : owner(owner) {
+    }
+    void execute(ThreadPool& pool, int threadIndex) {
+        for (int i = threadIndex; i < (int) owner.energyRequests.size(); i += pool.getNumThreads())
+            owner.requestedEnergy[i] = owner.computeEnergy(*owner.contexts[threadIndex], owner.energyRequests[i].first, owner.energyRequests[i].second);
+    }
+private:
+    ReplicaExchange& owner;
+};
+
+static bool canSetTemperature(const Integrator& integrator) {
+    return (dynamic_cast<const LangevinIntegrator*>(&integrator) != NULL ||
+            dynamic_cast<const BrownianIntegrator*>(&integrator) != NULL ||
+            dynamic_cast<const VariableLangevinIntegrator*>(&integrator) != NULL);
+}
+
+ReplicaExchange::ReplicaExchange(const System& system, Integrator& integrator, int numReplicas) : system(system), platform(NULL),
+        threads(NULL), numReplicas(numReplicas), numIterations(0), isInitialized(false), random(NULL) {
+    initialize();
+    addIntegrator(integrator);
+}
+
+ReplicaExchange::ReplicaExchange(const System& system, Integrator& integrator, int numReplicas, Platform& platform) : system(system),
+        platform(&platform), threads(NULL), numReplicas(numReplicas), numIterations(0), isInitialized(false), random(NULL) {
+    initialize();
+    addIntegrator(integrator);
+}
+
+ReplicaExchange::~ReplicaExchange() {
+    for (int i = 0; i < (int) contexts.size(); i++)
+        delete contexts[i];
+    if (threads != NULL)
+        delete threads;
+    if (random != NULL)
+        delete random;
+}
+
+void ReplicaExchange::initialize() {
+    if (numReplicas < 1)
+        throw OpenMMException("ReplicaExchange: The number of replicas must be at least 1");
+    setRandomNumberSeed((int) time(NULL));
+    hasBarostat = false;
+    defaultPressure = 0.0;
+    double defaultTemperature = 0.0;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const MonteCarloBarostat* barostat = dynamic_cast<const MonteCarloBarostat*>(&system.getForce(i));
+        if (barostat != NULL) {
+            hasBarostat = true;
+            defaultPressure = barostat->getDefaultPressure();
+        }
+        if (dynamic_cast<const MonteCarloAnisotropicBarostat*>(&system.getForce(i)) != NULL)
+            throw OpenMMException("ReplicaExchange does not support MonteCarloAnisotropicBarostat");
+        const AndersenThermostat* thermostat = dynamic_cast<const AndersenThermostat*>(&system.getForce(i));
+        if (thermostat != NULL)
+            defaultTemperature = thermostat->getDefaultTemperature();
+    }
+    temperature.resize(numReplicas, defaultTemperature);
+    parameters.resize(numReplicas);
+    replicaState.resize(numReplicas);
+    stateReplica.resize(numReplicas);
+    for (int i = 0; i < numReplicas; i++) {
+        replicaState[i] = i;
+        stateReplica[i] = i;
+    }
+    positions.resize(numReplicas);
+    velocities.resize(numReplicas);
+    boxVectors.resize(3*numReplicas);
+    for (int i = 0; i < numReplicas; i++)
+        system.getDefaultPeriodicBoxVectors(boxVectors[3*i], boxVectors[3*i+1], boxVectors[3*i+2]);
+    energy.resize(numReplicas, 0.0);
+    dynamics.resize(numReplicas);
+    numAttempted.resize(numReplicas, 0);
+    numAccepted.resize(numReplicas, 0);
+}
+
+void ReplicaExchange::addIntegrator(Integrator& integrator) {
+    if (isInitialized)
+        throw OpenMMException("ReplicaExchange: addIntegrator() must be called before the simulation is started");
+    if (integrators.size() == 0 && canSetTemperature(integrator)) {
+        const LangevinIntegrator* langevin = dynamic_cast<const LangevinIntegrator*>(&integrator);
+        const BrownianIntegrator* brownian = dynamic_cast<const BrownianIntegrator*>(&integrator);
+        const VariableLangevinIntegrator* variable = dynamic_cast<const VariableLangevinIntegrator*>(&integrator);
+        double t = (langevin != NULL ? langevin->getTemperature() : brownian != NULL ? brownian->getTemperature() : variable->getTemperature());
+        temperature.assign(numReplicas, t);
+    }
+    integrators.push_back(&integrator);
+    Context* context = (platform == NULL ? new Context(system, integrator) : new Context(system, integrator, *platform));
+    contexts.push_back(context);
+    if (contexts.size() == 1)
+        defaultParameters = context->getState(State::Parameters).getParameters();
+}
+
+double ReplicaExchange::getTemperature(int state) const {
+    ASSERT_VALID_INDEX(state, temperature);
+    return temperature[state];
+}
+
+void ReplicaExchange::setTemperature(int state, double temperature) {
+    ASSERT_VALID_INDEX(state, this->temperature);
+    this->temperature[state] = temperature;
+}
+
+double ReplicaExchange::getParameter(int state, const string& name) const {
+    ASSERT_VALID_INDEX(state, parameters);
+    map<string, double>::const_iterator value = parameters[state].find(name);
+    if (value != parameters[state].end())
+        return value->second;
+    value = defaultParameters.find(name);
+    if (value == defaultParameters.end())
+        throw OpenMMException("ReplicaExchange: Illegal parameter name: "+name);
+    return value->second;
+}
+
+void ReplicaExchange::setParameter(int state, const string& name, double value) {
+    ASSERT_VALID_INDEX(state, parameters);
+    if (defaultParameters.find(name) == defaultParameters.end())
+        throw OpenMMException("ReplicaExchange: Illegal parameter name: "+name);
+    parameters[state][name] = value;
+}
+
+const vector<Vec3>& ReplicaExchange::getPositions(int replica) const {
+    ASSERT_VALID_INDEX(replica, positions);
+    return positions[replica];
+}
+
+void ReplicaExchange::setPositions(int replica, const vector<Vec3>& positions) {
+    ASSERT_VALID_INDEX(replica, this->positions);
+    if ((int) positions.size() != system.getNumParticles())
+        throw OpenMMException("ReplicaExchange: Called setPositions() on a replica with the wrong number of positions");
+    this->positions[replica] = positions;
+}
+
+const vector<Vec3>& ReplicaExchange::getVelocities(int replica) const {
+    ASSERT_VALID_INDEX(replica, velocities);
+    return velocities[replica];
+}
+
+void ReplicaExchange::setVelocities(int replica, const vector<Vec3>& velocities) {
+    ASSERT_VALID_INDEX(replica, this->velocities);
+    if ((int) velocities.size() != system.getNumParticles())
+        throw OpenMMException("ReplicaExchange: Called setVelocities() on a replica with the wrong number of velocities");
+    this->velocities[replica] = velocities;
+}
+
+void ReplicaExchange::getPeriodicBoxVectors(int replica, Vec3& a, Vec3& b, Vec3& c) const {
+    ASSERT_VALID_INDEX(replica, positions);
+    a = boxVectors[3*replica];
+    b = boxVectors[3*replica+1];
+    c = boxVectors[3*replica+2];
+}
+
+void ReplicaExchange::setPeriodicBoxVectors(int replica, const Vec3& a, const Vec3& b, const Vec3& c) {
+    ASSERT_VALID_INDEX(replica, positions);
+    boxVectors[3*replica] = a;
+    boxVectors[3*replica+1] = b;
+    boxVectors[3*replica+2] = c;
+}
+
+double ReplicaExchange::getPotentialEnergy(int replica) const {
+    ASSERT_VALID_INDEX(replica, energy);
+    return energy[replica];
+}
+
+int ReplicaExchange::getNumAttemptedExchanges(int state) const {
+    ASSERT_VALID_INDEX(state, numAttempted);
+    return numAttempted[state];
+}
+
+int ReplicaExchange::getNumAcceptedExchanges(int state) const {
+    ASSERT_VALID_INDEX(state, numAccepted);
+    return numAccepted[state];
+}
+
+void ReplicaExchange::applyState(Context& context, int state) {
+    for (map<string, double>::const_iterator iter = defaultParameters.begin(); iter != defaultParameters.end(); ++iter) {
+        map<string, double>::const_iterator value = parameters[state].find(iter->first);
+        context.setParameter(iter->first, value == parameters[state].end() ? iter->second : value->second);
+    }
+    Integrator& integrator = context.getIntegrator();
+    LangevinIntegrator* langevin = dynamic_cast<LangevinIntegrator*>(&integrator);
+    BrownianIntegrator* brownian = dynamic_cast<BrownianIntegrator*>(&integrator);
+    VariableLangevinIntegrator* variable = dynamic_cast<VariableLangevinIntegrator*>(&integrator);
+    if (langevin != NULL)
+        langevin->setTemperature(temperature[state]);
+    else if (brownian != NULL)
+        brownian->setTemperature(temperature[state]);
+    else if (variable != NULL)
+        variable->setTemperature(temperature[state]);
+    if (defaultParameters.find(AndersenThermostat::Temperature()) != defaultParameters.end())
+        context.setParameter(AndersenThermostat::Temperature(), temperature[state]);
+}
+
+MonteCarloBarostatImpl* ReplicaExchange::getBarostatImpl(Context& context) {
+    vector<ForceImpl*>& impls = context.getImpl().getForceImpls();
+    for (int i = 0; i < (int) impls.size(); i++) {
+        MonteCarloBarostatImpl* barostat = dynamic_cast<MonteCarloBarostatImpl*>(impls[i]);
+        if (barostat != NULL)
+            return barostat;
+    }
+    return NULL;
+}
+
+void ReplicaExchange::saveDynamics(Context& context, int replica) {
+    ReplicaDynamics& d = dynamics[replica];
+    CustomIntegrator* custom = dynamic_cast<CustomIntegrator*>(&context.getIntegrator());
+    if (custom != NULL) {
+        d.globals.resize(custom->getNumGlobalVariables());
+        for (int i = 0; i < (int) d.globals.size(); i++)
+            d.globals[i] = custom->getGlobalVariable(i);
+        d.perDof.resize(custom->getNumPerDofVariables());
+        for (int i = 0; i < (int) d.perDof.size(); i++)
+            custom->getPerDofVariable(i, d.perDof[i]);
+    }
+    MonteCarloBarostatImpl* barostat = getBarostatImpl(context);
+    if (barostat != NULL)
+        barostat->getAdaptiveState(d.barostatStep, d.barostatAttempted, d.barostatAccepted, d.barostatVolumeScale);
+}
+
+void ReplicaExchange::restoreDynamics(Context& context, int replica) {
+    const ReplicaDynamics& d = dynamics[replica];
+    CustomIntegrator* custom = dynamic_cast<CustomIntegrator*>(&context.getIntegrator());
+    if (custom != NULL) {
+        for (int i = 0; i < (int) d.globals.size(); i++)
+            custom->setGlobalVariable(i, d.globals[i]);
+        for (int i = 0; i < (int) d.perDof.size(); i++)
+            custom->setPerDofVariable(i, d.perDof[i]);
+    }
+    MonteCarloBarostatImpl* barostat = getBarostatImpl(context);
+    if (barostat != NULL)
+        barostat->setAdaptiveState(d.barostatStep, d.barostatAttempted, d.barostatAccepted, d.barostatVolumeScale);
+}
+
+void ReplicaExchange::propagateReplica(Context& context, int replica, int steps) {
+    int state = replicaState[replica];
+    applyState(context, state);
+    restoreDynamics(context, replica);
+    context.setPeriodicBoxVectors(boxVectors[3*replica], boxVectors[3*replica+1], boxVectors[3*replica+2]);
+    context.setPositions(positions[replica]);
+    if (velocities[replica].size() == 0)
+        context.setVelocitiesToTemperature(temperature[state], randomNumberSeed+replica+1);
+    else
+        context.setVelocities(velocities[replica]);
+    context.getIntegrator().step(steps);
+    saveDynamics(context, replica);
+    State result = context.getState(State::Positions | State::Velocities | State::Energy);
+    positions[replica] = result.getPositions();
+    velocities[replica] = result.getVelocities();
+    result.getPeriodicBoxVectors(boxVectors[3*replica], boxVectors[3*replica+1], boxVectors[3*replica+2]);
+    energy[replica] = result.getPotentialEnergy();
+}
+
+double ReplicaExchange::computeEnergy(Context& context, int replica, int state) {
+    applyState(context, state);
+    context.setPeriodicBoxVectors(boxVectors[3*replica], boxVectors[3*replica+1], boxVectors[3*replica+2]);
+    context.setPositions(positions[replica]);
+    return context.getState(State::Energy).getPotentialEnergy();
+}
+
+double ReplicaExchange::getPressure(int state) const {
+    if (!hasBarostat)
+        return 0.0;
+    map<string, double>::const_iterator value = parameters[state].find(MonteCarloBarostat::Pressure());
+    double pressure = (value == parameters[state].end() ? defaultPressure : value->second);
+    return pressure*(AVOGADRO*1e-25);
+}
+
+void ReplicaExchange::attemptExchanges() {
+    // Decide which pairs of states to attempt exchanges between.  When two states differ only in
+    // temperature, the energies from the end of the propagation can be used directly.  Otherwise,
+    // each replica's energy must be computed in the other state.
+    
+    vector<int> pairs;
+    vector<bool> sameHamiltonian;
+    energyRequests.clear();
+    for (int i = numIterations%2; i+1 < numReplicas; i += 2) {
+        bool same = true;
+        for (map<string, double>::const_iterator iter = defaultParameters.begin(); iter != defaultParameters.end() && same; ++iter)
+            if (iter->first != MonteCarloBarostat::Pressure() && iter->first != AndersenThermostat::Temperature())
+                same = (getParameter(i, iter->first) == getParameter(i+1, iter->first));
+        pairs.push_back(i);
+        sameHamiltonian.push_back(same);
+        if (!same) {
+            energyRequests.push_back(make_pair(stateReplica[i], i+1));
+            energyRequests.push_back(make_pair(stateReplica[i+1], i));
+        }
+    }
+    requestedEnergy.resize(energyRequests.size());
+    if (energyRequests.size() > 0) {
+        if (threads == NULL)
+            for (int i = 0; i < (int) energyRequests.size(); i++)
+                requestedEnergy[i] = computeEnergy(*contexts[0], energyRequests[i].first, energyRequests[i].second);
+        else {
+            EnergyTask task(*this);
+            threads->execute(task);
+            threads->waitForThreads();
+        }
+    }
+    
+    // Apply the Metropolis criterion to each pair.
+    
+    int nextRequest = 0;
+    for (int k = 0; k < (int) pairs.size(); k++) {
+        int i = pairs[k];
+        int j = i+1;
+        int a = stateReplica[i];
+        int b = stateReplica[j];
+        double energyAj = energy[a];
+        double energyBi = energy[b];
+        if (!sameHamiltonian[k]) {
+            energyAj = requestedEnergy[nextRequest++];
+            energyBi = requestedEnergy[nextRequest++];
+        }
+        double volumeA = boxVectors[3*a][0]*boxVectors[3*a+1][1]*boxVectors[3*a+2][2];
+        double volumeB = boxVectors[3*b][0]*boxVectors[3*b+1][1]*boxVectors[3*b+2][2];
+        double betaI = 1.0/(BOLTZ*temperature[i]);
+        double betaJ = 1.0/(BOLTZ*temperature[j]);
+        double pressureI = getPressure(i);
+        double pressureJ = getPressure(j);
+        double delta = betaI*(energyBi+pressureI*volumeB) + betaJ*(energyAj+pressureJ*volumeA)
+                     - betaI*(energy[a]+pressureI*volumeA) - betaJ*(energy[b]+pressureJ*volumeB);
+        numAttempted[i]++;
+        if (delta <= 0.0 || genrand_real2(*random) < exp(-delta)) {
+            numAccepted[i]++;
+            replicaState[a] = j;
+            replicaState[b] = i;
+            stateReplica[i] = b;
+            stateReplica[j] = a;
+            energy[a] = energyAj;
+            energy[b] = energyBi;
+            
+            // Rescale the velocities to the new temperatures.
+            
+            double scale = sqrt(temperature[j]/temperature[i]);
+            for (int m = 0; m < (int) velocities[a].size(); m++)
+                velocities[a][m] *= scale;
+            for (int m = 0; m < (int) velocities[b].size(); m++)
+                velocities[b][m] *= 1.0/scale;
+        }
+    }
+}
+
+void ReplicaExchange::run(int iterations, int stepsPerIteration) {
+    if (!isInitialized) {
+        for (int i = 0; i < numReplicas; i++)
+            if ((int) positions[i].size() != system.getNumParticles())
+                throw OpenMMException("ReplicaExchange: Positions have not been set for every replica");
+        bool sameTemperature = true;
+        for (int i = 0; i < numReplicas; i++) {
+            if (temperature[i] <= 0.0)
+                throw OpenMMException("ReplicaExchange: A positive temperature must be specified for every thermodynamic state");
+            if (temperature[i] != temperature[0])
+                sameTemperature = false;
+        }
+        if (!sameTemperature) {
+            if (hasBarostat)
+                throw OpenMMException("ReplicaExchange: All states must have the same temperature when the System contains a MonteCarloBarostat");
+            if (!canSetTemperature(*integrators[0]) && defaultParameters.find(AndersenThermostat::Temperature()) == defaultParameters.end())
+                throw OpenMMException("ReplicaExchange: States have different temperatures, but the Integrator does not support setting the temperature");
+        }
+        for (int i = 0; i < numReplicas; i++)
+            saveDynamics(*contexts[0], i);
+        
+        if (contexts.size() > 1)
+            threads = new ThreadPool(contexts.size());
+        random = new SFMT();
+        init_gen_rand(randomNumberSeed, *random);
+        isInitialized = true;
+    }
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        if (threads == NULL)
+            for (int i = 0; i < numReplicas; i++)
+                propagateReplica(*contexts[0], i, stepsPerIteration);
+        else {
+            PropagateTask task(*this, stepsPerIteration);
+            threads->execute(task);
+            threads->waitForThreads();
+        }
+        attemptExchanges();
+        numIterations++;
+    }
+}
@@ -63,6 +63,16 @@ double State::getPotentialEnergy() const {
         throw OpenMMException("Invoked getPotentialEnergy() on a State which does not contain energies.");
     return pe;
 }
+const vector<double>& State::getPotentialEnergyByGroup() const {
+    if ((types&EnergyByGroup) == 0)
+        throw OpenMMException("Invoked getPotentialEnergyByGroup() on a State which does not contain energies by group.");
+    return groupEnergies;
+}
+const vector<double>& State::getPotentialEnergyByForce() const {
+    if ((types&EnergyByForce) == 0)
+        throw OpenMMException("Invoked getPotentialEnergyByForce() on a State which does not contain energies by force.");
+    return forceEnergies;
+}
 void State::getPeriodicBoxVectors(Vec3& a, Vec3& b, Vec3& c) const {
     a = periodicBoxVectors[0];
     b = periodicBoxVectors[1];
@@ -106,6 +116,16 @@ void State::setEnergy(double kinetic, double potential) {
     types |= Energy;
 }
 
+void State::setEnergyByGroup(const std::vector<double>& energies) {
+    groupEnergies = energies;
+    types |= EnergyByGroup;
+}
+
+void State::setEnergyByForce(const std::vector<double>& energies) {
+    forceEnergies = energies;
+    types |= EnergyByForce;
+}
+
 void State::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
     periodicBoxVectors[0] = a;
     periodicBoxVectors[1] = b;
@@ -139,6 +159,14 @@ void State::StateBuilder::setEnergy(double ke, double pe) {
     state.setEnergy(ke, pe);
 }
 
+void State::StateBuilder::setEnergyByGroup(const std::vector<double>& energies) {
+    state.setEnergyByGroup(energies);
+}
+
+void State::StateBuilder::setEnergyByForce(const std::vector<double>& energies) {
+    state.setEnergyByForce(energies);
+}
+
 void State::StateBuilder::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3& c) {
     state.setPeriodicBoxVectors(a, b, c);
 }
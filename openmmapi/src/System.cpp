@@ -60,6 +60,12 @@ void System::setParticleMass(int index, double mass) {
     masses[index] = mass;
 }
 
+int System::addParticles(const std::vector<double>& masses) {
+    int first = this->masses.size();
+    this->masses.insert(this->masses.end(), masses.begin(), masses.end());
+    return first;
+}
+
 
 void System::setVirtualSite(int index, VirtualSite* virtualSite) {
     if (index >= (int) virtualSites.size())
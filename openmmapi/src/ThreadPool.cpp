@@ -0,0 +1,174 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/OpenMMException.h"
+#include <cstdlib>
+#include <exception>
+#ifdef __APPLE__
+   #include <sys/sysctl.h>
+#else
+   #ifdef WIN32
+      #include <windows.h>
+   #else
+      #include <unistd.h>
+   #endif
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+class ThreadPool::ThreadData {
+public:
+    ThreadData(ThreadPool& owner, int index) : owner(owner), index(index) {
+    }
+    void run() {
+        int lastGeneration = 0;
+        pthread_mutex_lock(&owner.lock);
+        while (true) {
+            while (owner.generation == lastGeneration && !owner.isDeleted)
+                pthread_cond_wait(&owner.startCondition, &owner.lock);
+            if (owner.isDeleted)
+                break;
+            lastGeneration = owner.generation;
+            Task* task = owner.currentTask;
+            pthread_mutex_unlock(&owner.lock);
+            string error;
+            try {
+                task->execute(owner, index);
+            }
+            catch (exception& ex) {
+                error = ex.what();
+            }
+            pthread_mutex_lock(&owner.lock);
+            if (error.size() > 0 && owner.errorMessage.size() == 0)
+                owner.errorMessage = error;
+            owner.numCompleted++;
+            pthread_cond_signal(&owner.endCondition);
+        }
+        pthread_mutex_unlock(&owner.lock);
+    }
+    ThreadPool& owner;
+    int index;
+};
+
+static void* threadBody(void* args) {
+    reinterpret_cast<ThreadPool::ThreadData*>(args)->run();
+    return 0;
+}
+
+ThreadPool::ThreadPool(int numThreads) : isDeleted(false), numThreads(numThreads), numCompleted(0), generation(0), currentTask(NULL) {
+    if (this->numThreads <= 0)
+        this->numThreads = getDefaultNumThreads();
+    pthread_cond_init(&startCondition, NULL);
+    pthread_cond_init(&endCondition, NULL);
+    pthread_mutex_init(&lock, NULL);
+    thread.resize(this->numThreads);
+    for (int i = 0; i < this->numThreads; i++) {
+        threadData.push_back(new ThreadData(*this, i));
+        pthread_create(&thread[i], NULL, threadBody, threadData[i]);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&lock);
+    isDeleted = true;
+    pthread_cond_broadcast(&startCondition);
+    pthread_mutex_unlock(&lock);
+    for (int i = 0; i < numThreads; i++) {
+        pthread_join(thread[i], NULL);
+        delete threadData[i];
+    }
+    pthread_mutex_destroy(&lock);
+    pthread_cond_destroy(&startCondition);
+    pthread_cond_destroy(&endCondition);
+}
+
+int ThreadPool::getNumThreads() const {
+    return numThreads;
+}
+
+void ThreadPool::execute(Task& task) {
+    pthread_mutex_lock(&lock);
+    currentTask = &task;
+    numCompleted = 0;
+    errorMessage = "";
+    generation++;
+    pthread_cond_broadcast(&startCondition);
+    pthread_mutex_unlock(&lock);
+}
+
+void ThreadPool::waitForThreads() {
+    pthread_mutex_lock(&lock);
+    while (numCompleted < numThreads)
+        pthread_cond_wait(&endCondition, &lock);
+    string error = errorMessage;
+    pthread_mutex_unlock(&lock);
+    if (error.size() > 0)
+        throw OpenMMException(error);
+}
+
+int ThreadPool::getDefaultNumThreads() {
+    char* threadsVar = getenv("OPENMM_CPU_THREADS");
+    if (threadsVar != NULL) {
+        int threads = atoi(threadsVar);
+        if (threads > 0)
+            return threads;
+    }
+    return getNumProcessors();
+}
+
+int ThreadPool::getNumProcessors() {
+#ifdef __APPLE__
+    int ncpu;
+    size_t len = 4;
+    if (sysctlbyname("hw.logicalcpu", &ncpu, &len, NULL, 0) == 0)
+       return ncpu;
+    else
+       return 1;
+#else
+#ifdef WIN32
+    SYSTEM_INFO siSysInfo;
+    int ncpu;
+    GetSystemInfo(&siSysInfo);
+    ncpu = siSysInfo.dwNumberOfProcessors;
+    if (ncpu < 1)
+        ncpu = 1;
+    return ncpu;
+#else
+    long nProcessorsOnline = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nProcessorsOnline == -1)
+        return 1;
+    else
+        return (int) nProcessorsOnline;
+#endif
+#endif
+}
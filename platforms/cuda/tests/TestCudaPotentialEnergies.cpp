@@ -0,0 +1,219 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests Context::getPotentialEnergies() and the decomposition of energy by force group with the CUDA
+ * platform.  Unlike on the reference platform, CUDA accumulates the energy of most Forces internally, so it
+ * cannot evaluate only some of them.
+ */
+
+#include "CudaPlatform.h"
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const double TOL = 1e-4;
+
+CudaPlatform platform;
+
+void testMultipleParameterSets() {
+    const int numParticles = 20;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(1.5);
+    HarmonicBondForce* harmonic = new HarmonicBondForce();
+    harmonic->setForceGroup(1);
+    CustomBondForce* custom = new CustomBondForce("lambda*k*(r-r0)^2");
+    custom->addGlobalParameter("lambda", 1.0);
+    custom->addGlobalParameter("r0", 0.2);
+    custom->addPerBondParameter("k");
+    CustomExternalForce* external = new CustomExternalForce("scale*x^2");
+    external->addGlobalParameter("scale", 0.5);
+    vector<double> params(1);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.2, 0.5);
+        external->addParticle(i, vector<double>());
+        if (i > 0) {
+            harmonic->addBond(i-1, i, 0.15, 100.0);
+            params[0] = 10.0*i;
+            custom->addBond(i-1, i, params);
+        }
+    }
+    system.addForce(nonbonded);
+    system.addForce(harmonic);
+    system.addForce(custom);
+    system.addForce(external);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.3*i, 0.5*genrand_real2(sfmt), 0.5*genrand_real2(sfmt));
+    context.setPositions(positions);
+
+    // Build a set of states, some of which only specify some of the parameters.
+
+    vector<map<string, double> > states(4);
+    states[0]["lambda"] = 0.0;
+    states[1]["lambda"] = 0.5;
+    states[2]["lambda"] = 1.0;
+    states[2]["r0"] = 0.3;
+    states[3]["scale"] = 2.0;
+
+    // Compare to the energies computed one state at a time.  The energy of the Forces that do not depend on
+    // the parameters must be counted exactly once.
+
+    for (int groups = 0; groups < 3; groups++) {
+        int flags = (groups == 2 ? 0xFFFFFFFF : 1<<groups);
+        vector<double> energies = context.getPotentialEnergies(states, flags);
+        ASSERT_EQUAL(states.size(), energies.size());
+        for (int i = 0; i < (int) states.size(); i++) {
+            context.setParameter("lambda", 1.0);
+            context.setParameter("r0", 0.2);
+            context.setParameter("scale", 0.5);
+            for (map<string, double>::const_iterator iter = states[i].begin(); iter != states[i].end(); ++iter)
+                context.setParameter(iter->first, iter->second);
+            double expected = context.getState(State::Energy, false, flags).getPotentialEnergy();
+            ASSERT_EQUAL_TOL(expected, energies[i], TOL);
+        }
+        context.setParameter("lambda", 1.0);
+        context.setParameter("r0", 0.2);
+        context.setParameter("scale", 0.5);
+    }
+
+    // The parameters should have been left unchanged, and the forces should still be correct.
+
+    context.setParameter("lambda", 0.7);
+    State state1 = context.getState(State::Forces);
+    context.getPotentialEnergies(states);
+    ASSERT_EQUAL(0.7, context.getParameter("lambda"));
+    ASSERT_EQUAL(0.2, context.getParameter("r0"));
+    ASSERT_EQUAL(0.5, context.getParameter("scale"));
+    State state2 = context.getState(State::Forces);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], TOL);
+}
+
+void testEnergyDecomposition() {
+    const int numParticles = 10;
+    const double boxSize = 2.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* harmonic = new HarmonicBondForce();
+    CustomExternalForce* external = new CustomExternalForce("scale*x^2");
+    external->addGlobalParameter("scale", 0.5);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        external->addParticle(i, vector<double>());
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.1);
+        if (i > 0)
+            harmonic->addBond(i-1, i, 0.15, 100.0);
+    }
+    system.addForce(harmonic);
+    system.addForce(external);
+    system.addForce(nonbonded);
+    harmonic->setForceGroup(1);
+    external->setForceGroup(2);
+    nonbonded->setForceGroup(2);
+    nonbonded->setReciprocalSpaceForceGroup(3);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    context.setPositions(positions);
+
+    // Compare the energy of each group to computing it separately.
+
+    State state = context.getState(State::Energy | State::Forces | State::EnergyByGroup);
+    const vector<double>& groupEnergies = state.getPotentialEnergyByGroup();
+    ASSERT_EQUAL(32, groupEnergies.size());
+    double groupSum = 0.0;
+    for (int i = 0; i < 32; i++) {
+        ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<i).getPotentialEnergy(), groupEnergies[i], TOL);
+        groupSum += groupEnergies[i];
+    }
+    ASSERT_EQUAL_TOL(state.getPotentialEnergy(), groupSum, TOL);
+    ASSERT(groupEnergies[3] != 0.0);
+
+    // The forces should not be affected.
+
+    State forceState = context.getState(State::Forces);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(forceState.getForces()[i], state.getForces()[i], TOL);
+
+    // The energy of each Force is not available on this platform.
+
+    bool threwException = false;
+    try {
+        context.getState(State::EnergyByForce);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 1)
+            platform.setPropertyDefaultValue("CudaPrecision", string(argv[1]));
+        testMultipleParameterSets();
+        testEnergyDecomposition();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
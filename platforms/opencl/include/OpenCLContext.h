@@ -162,7 +162,7 @@ public:
     class ForcePostComputation;
     static const int ThreadBlockSize;
     static const int TileSize;
-    OpenCLContext(const System& system, int platformIndex, int deviceIndex, const std::string& precision, OpenCLPlatform::PlatformData& platformData);
+    OpenCLContext(const System& system, int platformIndex, int deviceIndex, const std::string& precision, const std::string& cacheDir, OpenCLPlatform::PlatformData& platformData);
     ~OpenCLContext();
     /**
      * This is called to initialize internal data structures after all Forces in the system
@@ -293,7 +293,9 @@ public:
      */
     cl::Program createProgram(const std::string source, const char* optimizationFlags = NULL);
     /**
-     * Create an OpenCL Program from source code.
+     * Create an OpenCL Program from source code.  If a cache directory has been specified, compiled
+     * programs are saved there and reused by later Contexts that use the same source code, options,
+     * device, and driver version, so they do not need to be compiled again.
      *
      * @param source             the source code of the program
      * @param defines            a set of preprocessor definitions (name, value) to define when compiling the program
@@ -601,6 +603,14 @@ private:
      */
     template <class Real, class Real4, class Mixed, class Mixed4>
     void reorderAtomsImpl();
+    /**
+     * Try to load a compiled program from the cache.  Returns true if it was loaded successfully.
+     */
+    bool loadCachedProgram(const std::string& cacheFile, const std::string& options, cl::Program& program);
+    /**
+     * Save a compiled program to the cache.
+     */
+    void saveCachedProgram(const std::string& cacheFile, cl::Program& program);
     const System& system;
     double time;
     OpenCLPlatform::PlatformData& platformData;
@@ -618,7 +628,7 @@ private:
     bool supports64BitGlobalAtomics, supportsDoublePrecision, useDoublePrecision, useMixedPrecision, atomsWereReordered;
     mm_float4 periodicBoxSize, invPeriodicBoxSize;
     mm_double4 periodicBoxSizeDouble, invPeriodicBoxSizeDouble;
-    std::string defaultOptimizationOptions;
+    std::string defaultOptimizationOptions, cacheDir, cacheKeyPrefix;
     std::map<std::string, std::string> compilationDefines;
     cl::Context context;
     cl::Device device;
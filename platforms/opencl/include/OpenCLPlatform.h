@@ -94,11 +94,22 @@ public:
         static const std::string key = "OpenCLUseCpuPme";
         return key;
     }
+    /**
+     * This is the name of the parameter for specifying the directory in which to cache compiled kernels.
+     * If it is an empty string, compiled kernels are not cached.  The directory is created if it does
+     * not exist.  On Unix, caching is disabled if the directory is not owned by the current user or
+     * can be written by other users.
+     */
+    static const std::string& OpenCLCacheDirectory() {
+        static const std::string key = "OpenCLCacheDirectory";
+        return key;
+    }
 };
 
 class OPENMM_EXPORT_OPENCL OpenCLPlatform::PlatformData {
 public:
-    PlatformData(const System& system, const std::string& platformPropValue, const std::string& deviceIndexProperty, const std::string& precisionProperty, const std::string& cpuPmeProperty);
+    PlatformData(const System& system, const std::string& platformPropValue, const std::string& deviceIndexProperty, const std::string& precisionProperty,
+            const std::string& cpuPmeProperty, const std::string& cacheDirProperty);
     ~PlatformData();
     void initializeContexts(const System& system);
     void syncContexts();
@@ -35,15 +35,28 @@
 #include "OpenCLIntegrationUtilities.h"
 #include "OpenCLKernelSources.h"
 #include "OpenCLNonbondedUtilities.h"
+#include "SHA1.h"
 #include "hilbert.h"
 #include "openmm/Platform.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <typeinfo>
+#ifdef WIN32
+  #include <direct.h>
+  #include <process.h>
+  #define getpid _getpid
+#else
+  #include <sys/stat.h>
+  #include <sys/types.h>
+  #include <unistd.h>
+#endif
 
 using namespace OpenMM;
 using namespace std;
@@ -58,6 +71,28 @@ using namespace std;
 const int OpenCLContext::ThreadBlockSize = 64;
 const int OpenCLContext::TileSize = 32;
 
+/**
+ * Create the directory for caching compiled programs if it does not exist, and check that it is
+ * safe to load binaries from it.  Anyone who can write to the directory could substitute their own
+ * code, so it must be owned by the current user and not writable by anyone else.
+ */
+static bool prepareCacheDirectory(const string& dir) {
+#ifdef WIN32
+    _mkdir(dir.c_str());
+    return true;
+#else
+    // Create any missing parent directories first.
+
+    for (size_t pos = dir.find('/', 1); pos != string::npos; pos = dir.find('/', pos+1))
+        mkdir(dir.substr(0, pos).c_str(), 0700);
+    mkdir(dir.c_str(), 0700);
+    struct stat info;
+    if (stat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+        return false;
+    return (info.st_uid == getuid() && (info.st_mode & (S_IWGRP | S_IWOTH)) == 0);
+#endif
+}
+
 static void CL_CALLBACK errorCallback(const char* errinfo, const void* private_info, size_t cb, void* user_data) {
     string skip = "OpenCL Build Warning : Compiler build log:";
     if (strncmp(errinfo, skip.c_str(), skip.length()) == 0)
@@ -65,7 +100,7 @@ static void CL_CALLBACK errorCallback(const char* errinfo, const void* private_i
     std::cerr << "OpenCL internal error: " << errinfo << std::endl;
 }
 
-OpenCLContext::OpenCLContext(const System& system, int platformIndex, int deviceIndex, const string& precision, OpenCLPlatform::PlatformData& platformData) :
+OpenCLContext::OpenCLContext(const System& system, int platformIndex, int deviceIndex, const string& precision, const string& cacheDir, OpenCLPlatform::PlatformData& platformData) :
         system(system), time(0.0), platformData(platformData), stepCount(0), computeForceCount(0), stepsSinceReorder(99999), atomsWereReordered(false), posq(NULL),
         posqCorrection(NULL), velm(NULL), forceBuffers(NULL), longForceBuffer(NULL), energyBuffer(NULL), atomIndexDevice(NULL), integration(NULL),
         expression(NULL), bonded(NULL), nonbonded(NULL), thread(NULL) {
@@ -83,6 +118,13 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
     }
     else
         throw OpenMMException("Illegal value for OpenCLPrecision: "+precision);
+    if (!cacheDir.empty() && prepareCacheDirectory(cacheDir)) {
+#ifdef WIN32
+        this->cacheDir = cacheDir+"\\";
+#else
+        this->cacheDir = cacheDir+"/";
+#endif
+    }
     try {
         contextIndex = platformData.contexts.size();
         std::vector<cl::Platform> platforms;
@@ -145,6 +187,8 @@ OpenCLContext::OpenCLContext(const System& system, int platformIndex, int device
             throw OpenMMException("No compatible OpenCL device is available");
         device = devices[deviceIndex];
         this->deviceIndex = deviceIndex;
+        cacheKeyPrefix = platforms[platformIndex].getInfo<CL_PLATFORM_VERSION>()+'\n'+device.getInfo<CL_DEVICE_NAME>()+'\n'+
+                device.getInfo<CL_DEVICE_VERSION>()+'\n'+device.getInfo<CL_DRIVER_VERSION>()+'\n';
         if (device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>() < minThreadBlockSize)
             throw OpenMMException("The specified OpenCL device is not compatible with OpenMM");
         compilationDefines["WORK_GROUP_SIZE"] = intToString(ThreadBlockSize);
@@ -480,6 +524,28 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     // Get length before using c_str() to avoid length() call invalidating the c_str() value.
     string src_string = src.str();
     ::size_t src_length = src_string.length();
+
+    // See whether we already have a compiled binary for this program cached.  The key includes
+    // the device and driver version, since binaries cannot be used with any others.
+
+    string cacheFile;
+    if (!cacheDir.empty()) {
+        string key = cacheKeyPrefix+options+'\n'+src_string;
+        CSHA1 sha1;
+        sha1.Update((const UINT_8*) key.c_str(), key.size());
+        sha1.Final();
+        UINT_8 hash[20];
+        sha1.GetHash(hash);
+        stringstream file;
+        file << cacheDir << "openmmOpenCL_";
+        file.flags(ios::hex);
+        for (int i = 0; i < 20; i++)
+            file << setw(2) << setfill('0') << (int) hash[i];
+        cacheFile = file.str();
+        cl::Program program;
+        if (loadCachedProgram(cacheFile, options, program))
+            return program;
+    }
     cl::Program::Sources sources(1, make_pair(src_string.c_str(), src_length));
     cl::Program program(context, sources);
     try {
@@ -487,9 +553,58 @@ cl::Program OpenCLContext::createProgram(const string source, const map<string,
     } catch (cl::Error err) {
         throw OpenMMException("Error compiling kernel: "+program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device));
     }
+    if (!cacheFile.empty())
+        saveCachedProgram(cacheFile, program);
     return program;
 }
 
+bool OpenCLContext::loadCachedProgram(const string& cacheFile, const string& options, cl::Program& program) {
+    ifstream file(cacheFile.c_str(), ios::in | ios::binary);
+    if (!file.is_open())
+        return false;
+    vector<char> binary((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    file.close();
+    if (binary.size() == 0)
+        return false;
+    try {
+        vector<cl::Device> devices(1, device);
+        cl::Program::Binaries binaries(1, make_pair((const void*) &binary[0], binary.size()));
+        program = cl::Program(context, devices, binaries);
+        program.build(devices, options.c_str());
+        return true;
+    }
+    catch (cl::Error err) {
+        // The driver rejected the binary, so just compile it from source.
+
+        return false;
+    }
+}
+
+void OpenCLContext::saveCachedProgram(const string& cacheFile, cl::Program& program) {
+    // Failing to write the cache is not an error, so this silently returns if anything goes wrong.
+
+    ::size_t size;
+    if (clGetProgramInfo(program(), CL_PROGRAM_BINARY_SIZES, sizeof(::size_t), &size, NULL) != CL_SUCCESS || size == 0)
+        return;
+    vector<char> binary(size);
+    char* binaryPointer = &binary[0];
+    if (clGetProgramInfo(program(), CL_PROGRAM_BINARIES, sizeof(char*), &binaryPointer, NULL) != CL_SUCCESS)
+        return;
+
+    // Write it to a temporary file and then rename it, so other processes never see a partially
+    // written file.
+
+    stringstream tempFile;
+    tempFile << cacheFile << '_' << this << '_' << getpid();
+    ofstream out(tempFile.str().c_str(), ios::out | ios::binary);
+    if (!out.is_open())
+        return;
+    out.write(&binary[0], size);
+    out.close();
+    if (out.fail() || rename(tempFile.str().c_str(), cacheFile.c_str()) != 0)
+        remove(tempFile.str().c_str());
+}
+
 string OpenCLContext::doubleToString(double value) {
     stringstream s;
     s.precision(useDoublePrecision ? 16 : 8);
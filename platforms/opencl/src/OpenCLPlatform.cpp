@@ -32,6 +32,8 @@
 #include "openmm/Context.h"
 #include "openmm/System.h"
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <sstream>
 
 using namespace OpenMM;
@@ -80,12 +82,36 @@ OpenCLPlatform::OpenCLPlatform() {
     platformProperties.push_back(OpenCLPlatformName());
     platformProperties.push_back(OpenCLPrecision());
     platformProperties.push_back(OpenCLUseCpuPme());
+    platformProperties.push_back(OpenCLCacheDirectory());
     setPropertyDefaultValue(OpenCLDeviceIndex(), "");
     setPropertyDefaultValue(OpenCLDeviceName(), "");
     setPropertyDefaultValue(OpenCLPlatformIndex(), "");
     setPropertyDefaultValue(OpenCLPlatformName(), "");
     setPropertyDefaultValue(OpenCLPrecision(), "single");
     setPropertyDefaultValue(OpenCLUseCpuPme(), "false");
+
+    // Compiled binaries are executed without further checks, so the default cache is a directory
+    // private to the current user rather than the shared temporary directory.  If none can be
+    // determined, caching is disabled.
+
+    char* cacheVariable = getenv("OPENMM_CACHE_DIR");
+    if (cacheVariable != NULL)
+        setPropertyDefaultValue(OpenCLCacheDirectory(), string(cacheVariable));
+    else {
+#ifdef _MSC_VER
+        char* appDataVariable = getenv("LOCALAPPDATA");
+        setPropertyDefaultValue(OpenCLCacheDirectory(), appDataVariable == NULL ? "" : string(appDataVariable)+"\\OpenMM");
+#else
+        char* cacheHomeVariable = getenv("XDG_CACHE_HOME");
+        char* homeVariable = getenv("HOME");
+        if (cacheHomeVariable != NULL && cacheHomeVariable[0] == '/')
+            setPropertyDefaultValue(OpenCLCacheDirectory(), string(cacheHomeVariable)+"/openmm");
+        else if (homeVariable != NULL && homeVariable[0] == '/')
+            setPropertyDefaultValue(OpenCLCacheDirectory(), string(homeVariable)+"/.cache/openmm");
+        else
+            setPropertyDefaultValue(OpenCLCacheDirectory(), "");
+#endif
+    }
 }
 
 double OpenCLPlatform::getSpeed() const {
@@ -117,13 +143,15 @@ void OpenCLPlatform::contextCreated(ContextImpl& context, const map<string, stri
             getPropertyDefaultValue(OpenCLPrecision()) : properties.find(OpenCLPrecision())->second);
     string cpuPmePropValue = (properties.find(OpenCLUseCpuPme()) == properties.end() ?
             getPropertyDefaultValue(OpenCLUseCpuPme()) : properties.find(OpenCLUseCpuPme())->second);
+    const string& cacheDirPropValue = (properties.find(OpenCLCacheDirectory()) == properties.end() ?
+            getPropertyDefaultValue(OpenCLCacheDirectory()) : properties.find(OpenCLCacheDirectory())->second);
     transform(precisionPropValue.begin(), precisionPropValue.end(), precisionPropValue.begin(), ::tolower);
     transform(cpuPmePropValue.begin(), cpuPmePropValue.end(), cpuPmePropValue.begin(), ::tolower);
     vector<string> pmeKernelName;
     pmeKernelName.push_back(CalcPmeReciprocalForceKernel::Name());
     if (!supportsKernels(pmeKernelName))
         cpuPmePropValue = "false";
-    context.setPlatformData(new PlatformData(context.getSystem(), platformPropValue, devicePropValue, precisionPropValue, cpuPmePropValue));
+    context.setPlatformData(new PlatformData(context.getSystem(), platformPropValue, devicePropValue, precisionPropValue, cpuPmePropValue, cacheDirPropValue));
 }
 
 void OpenCLPlatform::contextDestroyed(ContextImpl& context) const {
@@ -132,7 +160,7 @@ void OpenCLPlatform::contextDestroyed(ContextImpl& context) const {
 }
 
 OpenCLPlatform::PlatformData::PlatformData(const System& system, const string& platformPropValue, const string& deviceIndexProperty,
-        const string& precisionProperty, const string& cpuPmeProperty) : removeCM(false), stepCount(0), computeForceCount(0), time(0.0)  {
+        const string& precisionProperty, const string& cpuPmeProperty, const string& cacheDirProperty) : removeCM(false), stepCount(0), computeForceCount(0), time(0.0)  {
     int platformIndex = 0;
     if (platformPropValue.length() > 0)
         stringstream(platformPropValue) >> platformIndex;
@@ -147,11 +175,11 @@ OpenCLPlatform::PlatformData::PlatformData(const System& system, const string& p
         if (devices[i].length() > 0) {
             unsigned int deviceIndex;
             stringstream(devices[i]) >> deviceIndex;
-            contexts.push_back(new OpenCLContext(system, platformIndex, deviceIndex, precisionProperty, *this));
+            contexts.push_back(new OpenCLContext(system, platformIndex, deviceIndex, precisionProperty, cacheDirProperty, *this));
         }
     }
     if (contexts.size() == 0)
-        contexts.push_back(new OpenCLContext(system, platformIndex, -1, precisionProperty, *this));
+        contexts.push_back(new OpenCLContext(system, platformIndex, -1, precisionProperty, cacheDirProperty, *this));
     stringstream deviceIndex, deviceName;
     for (int i = 0; i < (int) contexts.size(); i++) {
         if (i > 0) {
@@ -170,6 +198,7 @@ OpenCLPlatform::PlatformData::PlatformData(const System& system, const string& p
     propertyValues[OpenCLPlatform::OpenCLPlatformName()] = platforms[platformIndex].getInfo<CL_PLATFORM_NAME>();
     propertyValues[OpenCLPlatform::OpenCLPrecision()] = precisionProperty;
     propertyValues[OpenCLPlatform::OpenCLUseCpuPme()] = useCpuPme ? "true" : "false";
+    propertyValues[OpenCLPlatform::OpenCLCacheDirectory()] = cacheDirProperty;
     contextEnergy.resize(contexts.size());
 }
 
@@ -0,0 +1,193 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests caching of compiled programs by the OpenCL platform.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "OpenCLArray.h"
+#include "OpenCLContext.h"
+#include "openmm/System.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#ifndef WIN32
+  #include <dirent.h>
+  #include <stdlib.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+static OpenCLPlatform platform;
+
+/**
+ * Create a program whose kernel fills an array with a constant value.
+ */
+string createSource(int value) {
+    stringstream source;
+    source << "__kernel void fill(__global int* data) {\n";
+    source << "    data[get_global_id(0)] = " << value << ";\n";
+    source << "}\n";
+    return source.str();
+}
+
+/**
+ * Execute the kernel in a program created by createSource() and return the value it writes.
+ */
+int executeProgram(OpenCLContext& context, cl::Program program) {
+    const int size = 64;
+    OpenCLArray* data = OpenCLArray::create<cl_int>(context, size, "data");
+    cl::Kernel kernel(program, "fill");
+    kernel.setArg<cl::Buffer>(0, data->getDeviceBuffer());
+    context.executeKernel(kernel, size);
+    vector<cl_int> values;
+    data->download(values);
+    delete data;
+    for (int i = 1; i < size; i++)
+        ASSERT_EQUAL(values[0], values[i]);
+    return values[0];
+}
+
+#ifndef WIN32
+set<string> listFiles(const string& dir) {
+    set<string> files;
+    DIR* d = opendir(dir.c_str());
+    ASSERT(d != NULL);
+    struct dirent* entry;
+    while ((entry = readdir(d)) != NULL)
+        if (entry->d_name[0] != '.')
+            files.insert(dir+"/"+entry->d_name);
+    closedir(d);
+    return files;
+}
+
+/**
+ * Create a program, and return the name of the cache file that was written for it.
+ */
+string createCachedProgram(OpenCLContext& context, const string& dir, const string& source) {
+    set<string> before = listFiles(dir);
+    context.createProgram(source);
+    set<string> after = listFiles(dir);
+    ASSERT_EQUAL(before.size()+1, after.size());
+    for (set<string>::const_iterator iter = after.begin(); iter != after.end(); ++iter)
+        if (before.find(*iter) == before.end())
+            return *iter;
+    return "";
+}
+
+string readFile(const string& file) {
+    ifstream in(file.c_str(), ios::in | ios::binary);
+    return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+void writeFile(const string& file, const string& contents) {
+    ofstream out(file.c_str(), ios::out | ios::binary);
+    out.write(contents.c_str(), contents.size());
+}
+
+void testProgramCache() {
+    char dirTemplate[] = "/tmp/openmmCacheTestXXXXXX";
+    ASSERT(mkdtemp(dirTemplate) != NULL);
+    string dir = dirTemplate;
+    System system;
+    system.addParticle(1.0);
+    string sourceA = createSource(1);
+    string sourceB = createSource(2);
+    string fileA, fileB;
+    {
+        OpenCLPlatform::PlatformData platformData(system, "", "", platform.getPropertyDefaultValue("OpenCLPrecision"), "false", dir);
+        OpenCLContext& context = *platformData.contexts[0];
+        context.initialize();
+        fileA = createCachedProgram(context, dir, sourceA);
+        fileB = createCachedProgram(context, dir, sourceB);
+        ASSERT(fileA != fileB);
+
+        // Put the binary for B in the file for A.  The next time A is created, it should be
+        // loaded from the cache without writing any new files.
+
+        writeFile(fileA, readFile(fileB));
+        set<string> before = listFiles(dir);
+        ASSERT_EQUAL(2, executeProgram(context, context.createProgram(sourceA)));
+        ASSERT(before == listFiles(dir));
+
+        // A corrupt file should be ignored, and replaced with a valid binary.
+
+        string garbage = "This is not a valid program binary.";
+        writeFile(fileA, garbage);
+        ASSERT_EQUAL(1, executeProgram(context, context.createProgram(sourceA)));
+        string binary = readFile(fileA);
+        ASSERT(binary.size() > 0 && binary != garbage);
+        writeFile(fileA, "");
+        ASSERT_EQUAL(1, executeProgram(context, context.createProgram(sourceA)));
+    }
+
+    // If other users can write to the directory, it must not be used.
+
+    writeFile(fileA, readFile(fileB));
+    chmod(dir.c_str(), 0777);
+    {
+        OpenCLPlatform::PlatformData platformData(system, "", "", platform.getPropertyDefaultValue("OpenCLPrecision"), "false", dir);
+        OpenCLContext& context = *platformData.contexts[0];
+        context.initialize();
+        ASSERT_EQUAL(1, executeProgram(context, context.createProgram(sourceA)));
+    }
+
+    // Clean up.
+
+    set<string> files = listFiles(dir);
+    for (set<string>::const_iterator iter = files.begin(); iter != files.end(); ++iter)
+        remove(iter->c_str());
+    rmdir(dir.c_str());
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 1)
+            platform.setPropertyDefaultValue("OpenCLPrecision", string(argv[1]));
+#ifndef WIN32
+        testProgramCache();
+#endif
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
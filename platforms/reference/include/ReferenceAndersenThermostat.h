@@ -26,6 +26,7 @@
 #define __ReferenceAndersenThermostat_H__
 
 #include "SimTKOpenMMCommon.h"
+#include "ReferenceRandomStreams.h"
 #include <vector>
 
 // ---------------------------------------------------------------------------------------
@@ -62,11 +63,12 @@ class ReferenceAndersenThermostat {
          @param temperature        thermostat temperature in Kelvin
          @param collisionFrequency collision frequency for each atom in fs^-1
          @param stepSize           integration step size in fs
+         @param random             the random number generator to use
                   
          --------------------------------------------------------------------------------------- */
           
       void applyThermostat( const std::vector<std::vector<int> >& atomGroups, std::vector<OpenMM::RealVec>& atomVelocities, std::vector<RealOpenMM>& atomMasses,
-              RealOpenMM temperature, RealOpenMM collisionFrequency, RealOpenMM stepSize ) const;
+              RealOpenMM temperature, RealOpenMM collisionFrequency, RealOpenMM stepSize, OpenMM::ReferenceRandomStreams& random ) const;
       
 };
 
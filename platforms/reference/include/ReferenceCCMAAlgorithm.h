@@ -52,6 +52,8 @@ class OPENMM_EXPORT ReferenceCCMAAlgorithm : public ReferenceConstraintAlgorithm
 
    private:
 
+      void initialize( int numberOfConstraints, const std::vector<std::pair<int, int> >& atomIndices, const std::vector<RealOpenMM>& distance, RealOpenMM tolerance );
+
       int applyConstraints(int numberOfAtoms, std::vector<OpenMM::RealVec>& atomCoordinates,
                        std::vector<OpenMM::RealVec>& atomCoordinatesP, std::vector<RealOpenMM>& inverseMasses, bool constrainingVelocities);
           
@@ -74,6 +76,22 @@ class OPENMM_EXPORT ReferenceCCMAAlgorithm : public ReferenceConstraintAlgorithm
 
       ReferenceCCMAAlgorithm( int numberOfAtoms, int numberOfConstraints, const std::vector<std::pair<int, int> >& atomIndices, const std::vector<RealOpenMM>& distance, std::vector<RealOpenMM>& masses, std::vector<AngleInfo>& angles, RealOpenMM tolerance );
 
+      /**---------------------------------------------------------------------------------------
+
+         ReferenceCCMAAlgorithm constructor, using a coupling matrix that was previously computed
+         by another instance for the same constraints (see getMatrix())
+
+         @param numberOfAtoms    number of atoms
+         @param numberOfConstraints      number of constraints
+         @param atomIndices              atom indices for contraints
+         @param distance                 distances for constraints
+         @param matrix                   inverse constraint coupling matrix
+         @param tolerance                constraint tolerance
+
+         --------------------------------------------------------------------------------------- */
+
+      ReferenceCCMAAlgorithm( int numberOfAtoms, int numberOfConstraints, const std::vector<std::pair<int, int> >& atomIndices, const std::vector<RealOpenMM>& distance, const std::vector<std::vector<std::pair<int, RealOpenMM> > >& matrix, RealOpenMM tolerance );
+
       /**---------------------------------------------------------------------------------------
 
          Destructor
@@ -122,6 +140,17 @@ class OPENMM_EXPORT ReferenceCCMAAlgorithm : public ReferenceConstraintAlgorithm
 
       RealOpenMM getTolerance( void ) const;
 
+      /**---------------------------------------------------------------------------------------
+
+         Get the inverse constraint coupling matrix.  It depends only on the constraints,
+         masses, and angles, so it can be reused to create other instances.
+
+         @return the matrix, stored as a list of (column, value) pairs for each row
+
+         --------------------------------------------------------------------------------------- */
+
+      const std::vector<std::vector<std::pair<int, RealOpenMM> > >& getMatrix( void ) const;
+
       /**---------------------------------------------------------------------------------------
 
          Set tolerance
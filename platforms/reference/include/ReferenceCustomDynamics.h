@@ -28,7 +28,8 @@
 #include "ReferenceDynamics.h"
 #include "openmm/CustomIntegrator.h"
 #include "openmm/internal/ContextImpl.h"
-#include "lepton/ExpressionProgram.h"
+#include "lepton/ParsedExpression.h"
+#include "lepton/CompiledExpression.h"
 
 #include <map>
 #include <string>
@@ -44,19 +45,37 @@ private:
     std::vector<OpenMM::RealVec> sumBuffer, oldPos;
     std::vector<OpenMM::CustomIntegrator::ComputationType> stepType;
     std::vector<std::string> stepVariable, forceName, energyName;
-    std::vector<Lepton::ExpressionProgram> stepExpression;
+    std::vector<Lepton::ParsedExpression> stepParsedExpression;
+    std::vector<Lepton::CompiledExpression> stepExpression;
     std::vector<bool> invalidatesForces, needsForces, needsEnergy;
-    std::vector<int> forceGroup;
+    std::vector<bool> stepNeedsUniform, stepNeedsGaussian;
+    std::vector<int> forceGroup, stepTarget, energyIndex;
+    std::vector<std::vector<int> > stepPerDofVariables;
     RealOpenMM energy;
-    Lepton::ExpressionProgram kineticEnergyExpression;
-    bool kineticEnergyNeedsForce;
-    
+    Lepton::CompiledExpression kineticEnergyExpression;
+    bool kineticEnergyNeedsForce, kineticEnergyNeedsUniform, kineticEnergyNeedsGaussian;
+    std::vector<int> kineticEnergyPerDofVariables;
+    std::vector<std::string> globalNames;
+    std::map<std::string, int> globalIndex;
+    std::vector<int> parameterIndex;
+    std::vector<double> globalValues, perDofValues;
+    double dofPosition, dofVelocity, dofForce, dofMass, uniformValue, gaussianValue;
+
+    void initialize(OpenMM::ContextImpl& context, std::vector<RealOpenMM>& masses, std::map<std::string, RealOpenMM>& globals);
+
+    Lepton::CompiledExpression compileExpression(const Lepton::ParsedExpression& expression, bool isPerDof, const std::string& forceName,
+                  bool& needsUniform, bool& needsGaussian, std::vector<int>& perDofVariables);
+
     void computePerDof(int numberOfAtoms, std::vector<OpenMM::RealVec>& results, const std::vector<OpenMM::RealVec>& atomCoordinates,
                   const std::vector<OpenMM::RealVec>& velocities, const std::vector<OpenMM::RealVec>& forces, const std::vector<RealOpenMM>& masses,
-                  const std::map<std::string, RealOpenMM>& globals, const std::vector<std::vector<OpenMM::RealVec> >& perDof,
-                  const Lepton::ExpressionProgram& expression, const std::string& forceName);
+                  const std::vector<std::vector<OpenMM::RealVec> >& perDof, const Lepton::CompiledExpression& expression,
+                  bool needsUniform, bool needsGaussian, const std::vector<int>& perDofVariables);
     
-    void recordChangedParameters(OpenMM::ContextImpl& context, std::map<std::string, RealOpenMM>& globals);
+    void loadGlobals(const std::map<std::string, RealOpenMM>& globals);
+
+    void storeGlobals(std::map<std::string, RealOpenMM>& globals) const;
+
+    void recordChangedParameters(OpenMM::ContextImpl& context);
       
 public:
 
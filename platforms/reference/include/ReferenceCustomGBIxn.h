@@ -90,7 +90,7 @@ class ReferenceCustomGBIxn {
       void calculateParticlePairValue(int index, int numAtoms, std::vector<OpenMM::RealVec>& atomCoordinates, RealOpenMM** atomParameters,
                                       std::vector<std::vector<RealOpenMM> >& values,
                                       const std::map<std::string, double>& globalParameters,
-                                      const std::vector<std::set<int> >& exclusions, bool useExclusions) const;
+                                      const OpenMM::ReferenceExclusionList& exclusions, bool useExclusions) const;
 
       /**---------------------------------------------------------------------------------------
 
@@ -151,7 +151,7 @@ class ReferenceCustomGBIxn {
       void calculateParticlePairEnergyTerm(int index, int numAtoms, std::vector<OpenMM::RealVec>& atomCoordinates, RealOpenMM** atomParameters,
                                       const std::vector<std::vector<RealOpenMM> >& values,
                                       const std::map<std::string, double>& globalParameters,
-                                      const std::vector<std::set<int> >& exclusions, bool useExclusions,
+                                      const OpenMM::ReferenceExclusionList& exclusions, bool useExclusions,
                                       std::vector<OpenMM::RealVec>& forces, RealOpenMM* totalEnergy, std::vector<std::vector<RealOpenMM> >& dEdV) const;
 
       /**---------------------------------------------------------------------------------------
@@ -194,7 +194,7 @@ class ReferenceCustomGBIxn {
       void calculateChainRuleForces(int numAtoms, std::vector<OpenMM::RealVec>& atomCoordinates, RealOpenMM** atomParameters,
                                       const std::vector<std::vector<RealOpenMM> >& values,
                                       const std::map<std::string, double>& globalParameters,
-                                      const std::vector<std::set<int> >& exclusions,
+                                      const OpenMM::ReferenceExclusionList& exclusions,
                                       std::vector<OpenMM::RealVec>& forces, std::vector<std::vector<RealOpenMM> >& dEdV) const;
 
       /**---------------------------------------------------------------------------------------
@@ -283,7 +283,7 @@ class ReferenceCustomGBIxn {
 
          --------------------------------------------------------------------------------------- */
 
-      void calculateIxn(int numberOfAtoms, std::vector<OpenMM::RealVec>& atomCoordinates, RealOpenMM** atomParameters, const std::vector<std::set<int> >& exclusions,
+      void calculateIxn(int numberOfAtoms, std::vector<OpenMM::RealVec>& atomCoordinates, RealOpenMM** atomParameters, const OpenMM::ReferenceExclusionList& exclusions,
                        std::map<std::string, double>& globalParameters, std::vector<OpenMM::RealVec>& forces, RealOpenMM* totalEnergy) const;
 
 // ---------------------------------------------------------------------------------------
@@ -26,6 +26,7 @@
 #define __ReferenceDynamics_H__
 
 #include "ReferenceConstraintAlgorithm.h"
+#include "ReferenceRandomStreams.h"
 #include "SimTKOpenMMCommon.h"
 #include "openmm/System.h"
 #include <cstddef>
@@ -55,6 +56,7 @@ class OPENMM_EXPORT ReferenceDynamics {
 
       int _ownReferenceConstraint;
       ReferenceConstraintAlgorithm* _referenceConstraint;
+      OpenMM::ReferenceRandomStreams* _randomStreams;
       
    public:
 
@@ -170,6 +172,27 @@ class OPENMM_EXPORT ReferenceDynamics {
          --------------------------------------------------------------------------------------- */
       
       void setReferenceConstraintAlgorithm( ReferenceConstraintAlgorithm* referenceConstraint );
+
+      /**---------------------------------------------------------------------------------------
+      
+         Get the random number generator
+      
+         @return the generator, or NULL if none has been set
+      
+         --------------------------------------------------------------------------------------- */
+      
+      OpenMM::ReferenceRandomStreams* getRandomNumberGenerator( void ) const;
+      
+      /**---------------------------------------------------------------------------------------
+      
+         Set the random number generator.  Stochastic integrators must have one set before
+         update() is called.  It is not owned by this object.
+      
+         @param randomStreams  the random number generator for the Context being integrated
+      
+         --------------------------------------------------------------------------------------- */
+      
+      void setRandomNumberGenerator( OpenMM::ReferenceRandomStreams* randomStreams );
 };
 
 // ---------------------------------------------------------------------------------------
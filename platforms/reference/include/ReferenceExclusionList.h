@@ -0,0 +1,116 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#ifndef OPENMM_REFERENCE_EXCLUSIONLIST_H_
+#define OPENMM_REFERENCE_EXCLUSIONLIST_H_
+
+#include "openmm/internal/windowsExport.h"
+#include <algorithm>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class stores the set of excluded particle pairs for a nonbonded interaction in a compact form.  The
+ * exclusions of each particle are stored as a sorted row of a compressed sparse row (CSR) array.  In addition,
+ * exclusions between particles whose indices differ by less than TileHalfWidth are recorded in a per-particle
+ * bitmask, so the common case of checking whether two nearby particles in the same molecule are excluded
+ * takes a single bit test.  Other pairs are found by binary search within the row.
+ *
+ * Exclusions are always symmetric: if i excludes j, then j excludes i.
+ */
+
+class OPENMM_EXPORT ReferenceExclusionList {
+public:
+    static const int TileHalfWidth = 32;
+    /**
+     * Create an empty exclusion list with no particles.
+     */
+    ReferenceExclusionList();
+    /**
+     * Create an exclusion list from a list of excluded pairs.  The order of each pair does not matter,
+     * duplicate pairs are ignored, and a particle is never considered to exclude itself.
+     *
+     * @param numParticles    the number of particles
+     * @param excludedPairs   the pairs of particles to exclude
+     */
+    ReferenceExclusionList(int numParticles, const std::vector<std::pair<int, int> >& excludedPairs);
+    /**
+     * Create an exclusion list from a set of excluded particles for each particle.
+     *
+     * @param exclusions      exclusions[i] contains the indices of all particles excluded from particle i
+     */
+    explicit ReferenceExclusionList(const std::vector<std::set<int> >& exclusions);
+    /**
+     * Get the number of particles.
+     */
+    int getNumParticles() const {
+        return numParticles;
+    }
+    /**
+     * Get the number of particles excluded from a particle.
+     */
+    int getNumExclusions(int particle) const {
+        return offset[particle+1]-offset[particle];
+    }
+    /**
+     * Get a pointer to the (sorted) indices of the particles excluded from a particle.  There are
+     * getNumExclusions(particle) of them.
+     */
+    const int* getExclusions(int particle) const {
+        return (index.size() == 0 ? NULL : &index[offset[particle]]);
+    }
+    /**
+     * Get whether an interaction between two particles is excluded.
+     */
+    bool isExcluded(int particle1, int particle2) const {
+        int delta = particle2-particle1+TileHalfWidth;
+        if (delta >= 0 && delta < 2*TileHalfWidth)
+            return ((tile[particle1]>>delta)&1) != 0;
+        if (index.size() == 0)
+            return false;
+        const int* begin = &index[0]+offset[particle1];
+        const int* end = &index[0]+offset[particle1+1];
+        return std::binary_search(begin, end, particle2);
+    }
+private:
+    void build(int numParticles, std::vector<std::pair<int, int> >& pairs);
+    int numParticles;
+    std::vector<int> offset;
+    std::vector<int> index;
+    std::vector<unsigned long long> tile;
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_REFERENCE_EXCLUSIONLIST_H_
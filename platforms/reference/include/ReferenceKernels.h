@@ -34,8 +34,11 @@
 
 #include "ReferencePlatform.h"
 #include "openmm/kernels.h"
+#include "openmm/internal/CustomNonbondedForceImpl.h"
+#include "openmm/internal/NonbondedForceImpl.h"
 #include "SimTKOpenMMRealType.h"
 #include "ReferenceNeighborList.h"
+#include "ReferenceSpatialOrder.h"
 #include "lepton/ExpressionProgram.h"
 
 class CpuObc;
@@ -92,6 +95,13 @@ public:
      * energy directly, <i>or</i> add it to an internal buffer so that it will be included here.
      */
     double finishComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups);
+    /**
+     * Every reference force kernel returns its energy directly, and the forces are restored after
+     * an energy-only computation.
+     */
+    bool reportsEnergyPerForce() const {
+        return true;
+    }
 private:
     std::vector<RealVec> savedForces;
 };
@@ -543,7 +553,8 @@ private:
  */
 class ReferenceCalcNonbondedForceKernel : public CalcNonbondedForceKernel {
 public:
-    ReferenceCalcNonbondedForceKernel(std::string name, const Platform& platform) : CalcNonbondedForceKernel(name, platform) {
+    ReferenceCalcNonbondedForceKernel(std::string name, const Platform& platform) : CalcNonbondedForceKernel(name, platform),
+            sortedParamArray(NULL), stepsSinceReorder(0), sortedParamsValid(false), dispersionCorrection(NULL) {
     }
     ~ReferenceCalcNonbondedForceKernel();
     /**
@@ -570,16 +581,61 @@ public:
      * @param force      the NonbondedForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const NonbondedForce& force);
+    /**
+     * Copy changed parameters over to a context, when only the parameters of certain particles and
+     * exceptions have changed.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the NonbondedForce to copy the parameters from
+     * @param particles  the indices of the particles whose parameters may have changed
+     * @param exceptions the indices of the exceptions whose parameters may have changed
+     */
+    void copyChangedParametersToContext(ContextImpl& context, const NonbondedForce& force, const std::vector<int>& particles, const std::vector<int>& exceptions);
+    /**
+     * Calculate only the direct space interactions that involve at least one particle from a subset.
+     * Interactions among the remaining particles, and the long range dispersion correction, are
+     * omitted, so the result differs from execute() by a contribution that does not depend on the
+     * positions of the subset.  This is useful when minimizing the energy with respect to a small
+     * set of particles while all others are held fixed.  It is not supported for Ewald or PME.
+     *
+     * @param context        the context in which to execute this kernel
+     * @param subset         the indices of the particles whose interactions should be computed
+     * @param energy         on exit, the potential energy of the interactions involving the subset
+     * @return true if the interactions were computed, false for Ewald and PME
+     */
+    bool executeSubset(ContextImpl& context, const std::vector<int>& subset, double& energy);
 private:
     int numParticles, num14;
-    int **exclusionArray, **bonded14IndexArray;
+    int **bonded14IndexArray;
     RealOpenMM **particleParamArray, **bonded14ParamArray;
     RealOpenMM nonbondedCutoff, switchingDistance, rfDielectric, ewaldAlpha, dispersionCoefficient;
     int kmax[3], gridSize[3];
     bool useSwitchingFunction;
-    std::vector<std::set<int> > exclusions;
+    ReferenceExclusionList exclusions;
     NonbondedMethod nonbondedMethod;
     NeighborList* neighborList;
+    // When a cutoff is used, interactions are computed on copies of the positions and parameters stored in a
+    // spatially coherent order.  sortedOrder[i] is the original index of the particle at sorted position i,
+    // and sortedIndex is its inverse.
+    std::vector<int> sortedOrder, sortedIndex;
+    std::vector<RealVec> sortedPositions, sortedForces;
+    RealOpenMM **sortedParamArray;
+    ReferenceExclusionList sortedExclusions;
+    int stepsSinceReorder;
+    bool sortedParamsValid;
+    // nb14Index[i] is the position of exception i in the 1-4 arrays, or -1 if it is excluded.
+    std::vector<int> nb14Index;
+    NonbondedForceImpl::DispersionCorrection* dispersionCorrection;
+    // Candidate pairs for executeSubset(), built with a padded cutoff so they stay valid while only
+    // the subset moves by small amounts.
+    std::vector<int> subsetParticles;
+    std::vector<bool> isInSubset;
+    std::vector<int> subset14;
+    std::vector<RealVec> subsetReferencePositions;
+    RealVec subsetReferenceBox;
+    NeighborList subsetCandidates, subsetNeighbors;
+    void updateSortedOrder(ContextImpl& context);
+    void updateSubsetCandidates(ContextImpl& context, const std::vector<int>& subset);
 };
 
 /**
@@ -587,7 +643,7 @@ private:
  */
 class ReferenceCalcCustomNonbondedForceKernel : public CalcCustomNonbondedForceKernel {
 public:
-    ReferenceCalcCustomNonbondedForceKernel(std::string name, const Platform& platform) : CalcCustomNonbondedForceKernel(name, platform), forceCopy(NULL) {
+    ReferenceCalcCustomNonbondedForceKernel(std::string name, const Platform& platform) : CalcCustomNonbondedForceKernel(name, platform), longRangeCorrection(NULL) {
     }
     ~ReferenceCalcCustomNonbondedForceKernel();
     /**
@@ -613,15 +669,22 @@ public:
      * @param force      the CustomNonbondedForce to copy the parameters from
      */
     void copyParametersToContext(ContextImpl& context, const CustomNonbondedForce& force);
+    /**
+     * Copy changed parameters over to a context, when only the parameters of certain particles have changed.
+     *
+     * @param context    the context to copy parameters to
+     * @param force      the CustomNonbondedForce to copy the parameters from
+     * @param particles  the indices of the particles whose parameters may have changed
+     */
+    void copyChangedParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, const std::vector<int>& particles);
 private:
     int numParticles;
-    int **exclusionArray;
     RealOpenMM **particleParamArray;
     RealOpenMM nonbondedCutoff, switchingDistance, periodicBoxSize[3], longRangeCoefficient;
     bool useSwitchingFunction, hasInitializedLongRangeCorrection;
-    CustomNonbondedForce* forceCopy;
+    CustomNonbondedForceImpl::LongRangeCorrection* longRangeCorrection;
     std::map<std::string, double> globalParamValues;
-    std::vector<std::set<int> > exclusions;
+    ReferenceExclusionList exclusions;
     Lepton::ExpressionProgram energyExpression, forceExpression;
     std::vector<std::string> parameterNames, globalParameterNames;
     NonbondedMethod nonbondedMethod;
@@ -732,7 +795,7 @@ private:
     bool isPeriodic;
     RealOpenMM **particleParamArray;
     RealOpenMM nonbondedCutoff;
-    std::vector<std::set<int> > exclusions;
+    ReferenceExclusionList exclusions;
     std::vector<std::string> particleParameterNames, globalParameterNames, valueNames;
     std::vector<Lepton::ExpressionProgram> valueExpressions;
     std::vector<std::vector<Lepton::ExpressionProgram> > valueDerivExpressions;
@@ -1146,7 +1209,8 @@ private:
  */
 class ReferenceApplyAndersenThermostatKernel : public ApplyAndersenThermostatKernel {
 public:
-    ReferenceApplyAndersenThermostatKernel(std::string name, const Platform& platform) : ApplyAndersenThermostatKernel(name, platform), thermostat(0) {
+    ReferenceApplyAndersenThermostatKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : ApplyAndersenThermostatKernel(name, platform),
+            data(data), thermostat(0) {
     }
     ~ReferenceApplyAndersenThermostatKernel();
     /**
@@ -1163,6 +1227,7 @@ public:
      */
     void execute(ContextImpl& context);
 private:
+    ReferencePlatform::PlatformData& data;
     ReferenceAndersenThermostat* thermostat;
     std::vector<std::vector<int> > particleGroups;
     std::vector<RealOpenMM> masses;
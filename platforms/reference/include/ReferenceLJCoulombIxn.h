@@ -156,10 +156,7 @@ class ReferenceLJCoulombIxn {
          @param numberOfAtoms    number of atoms
          @param atomCoordinates  atom coordinates
          @param atomParameters   atom parameters (charges, c6, c12, ...)     atomParameters[atomIndex][paramterIndex]
-         @param exclusions       atom exclusion indices                      exclusions[atomIndex][atomToExcludeIndex]
-                                 exclusions[atomIndex][0] = number of exclusions
-                                 exclusions[atomIndex][1-no.] = atom indices of atoms to excluded from
-                                 interacting w/ atom atomIndex
+         @param exclusions       the pairs of atoms that should not interact
          @param fixedParameters  non atom parameters (not currently used)
          @param forces           force array (forces added)
          @param energyByAtom     atom energy
@@ -170,9 +167,27 @@ class ReferenceLJCoulombIxn {
          --------------------------------------------------------------------------------------- */
           
       void calculatePairIxn(int numberOfAtoms, std::vector<OpenMM::RealVec>& atomCoordinates,
-                            RealOpenMM** atomParameters, int** exclusions,
+                            RealOpenMM** atomParameters, const OpenMM::ReferenceExclusionList& exclusions,
                             RealOpenMM* fixedParameters, std::vector<OpenMM::RealVec>& forces,
                             RealOpenMM* energyByAtom, RealOpenMM* totalEnergy, bool includeDirect, bool includeReciprocal) const;
+      
+      /**---------------------------------------------------------------------------------------
+      
+         Calculate LJ Coulomb ixn for an explicit list of atom pairs.  Exclusions are not
+         checked, and if a cutoff is used every pair is assumed to be inside it.  Ewald and
+         PME are not supported.
+      
+         @param pairs            the pairs of atoms to compute interactions between
+         @param atomCoordinates  atom coordinates
+         @param atomParameters   atom parameters (charges, c6, c12, ...)     atomParameters[atomIndex][paramterIndex]
+         @param forces           force array (forces added)
+         @param totalEnergy      total energy
+      
+         --------------------------------------------------------------------------------------- */
+          
+      void calculatePairListIxn(const OpenMM::NeighborList& pairs, std::vector<OpenMM::RealVec>& atomCoordinates,
+                                RealOpenMM** atomParameters, std::vector<OpenMM::RealVec>& forces,
+                                RealOpenMM* totalEnergy) const;
 
 private:
       /**---------------------------------------------------------------------------------------
@@ -182,10 +197,7 @@ private:
          @param numberOfAtoms    number of atoms
          @param atomCoordinates  atom coordinates
          @param atomParameters   atom parameters (charges, c6, c12, ...)     atomParameters[atomIndex][paramterIndex]
-         @param exclusions       atom exclusion indices                      exclusions[atomIndex][atomToExcludeIndex]
-                                 exclusions[atomIndex][0] = number of exclusions
-                                 exclusions[atomIndex][1-no.] = atom indices of atoms to excluded from
-                                 interacting w/ atom atomIndex
+         @param exclusions       the pairs of atoms that should not interact
          @param fixedParameters  non atom parameters (not currently used)
          @param forces           force array (forces added)
          @param energyByAtom     atom energy
@@ -196,7 +208,7 @@ private:
          --------------------------------------------------------------------------------------- */
           
       void calculateEwaldIxn(int numberOfAtoms, std::vector<OpenMM::RealVec>& atomCoordinates,
-                            RealOpenMM** atomParameters, int** exclusions,
+                            RealOpenMM** atomParameters, const OpenMM::ReferenceExclusionList& exclusions,
                             RealOpenMM* fixedParameters, std::vector<OpenMM::RealVec>& forces,
                             RealOpenMM* energyByAtom, RealOpenMM* totalEnergy, bool includeDirect, bool includeReciprocal) const;
 };
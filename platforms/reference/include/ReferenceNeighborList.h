@@ -2,6 +2,7 @@
 #define OPENMM_REFERENCE_NEIGHBORLIST_H_
 
 #include "RealVec.h"
+#include "ReferenceExclusionList.h"
 #include "openmm/internal/windowsExport.h"
 #include <set>
 #include <vector>
@@ -29,6 +30,18 @@ void OPENMM_EXPORT computeNeighborListNaive(
                               bool reportSymmetricPairs = false
                              );
 
+void OPENMM_EXPORT computeNeighborListNaive(
+                              NeighborList& neighborList,
+                              int nAtoms,
+                              const AtomLocationList& atomLocations, 
+                              const ReferenceExclusionList& exclusions,
+                              const RealVec& periodicBoxSize,
+                              bool usePeriodic,
+                              double maxDistance,
+                              double minDistance = 0.0,
+                              bool reportSymmetricPairs = false
+                             );
+
 // O(n) neighbor list method using voxel hash data structure
 // parameter neighborList is automatically clear()ed before 
 // neighbors are added
@@ -44,6 +57,18 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
                               bool reportSymmetricPairs = false
                              );
 
+void OPENMM_EXPORT computeNeighborListVoxelHash(
+                              NeighborList& neighborList,
+                              int nAtoms,
+                              const AtomLocationList& atomLocations, 
+                              const ReferenceExclusionList& exclusions,
+                              const RealVec& periodicBoxSize,
+                              bool usePeriodic,
+                              double maxDistance,
+                              double minDistance = 0.0,
+                              bool reportSymmetricPairs = false
+                             );
+
 } // namespace OpenMM
 
 #endif // OPENMM_REFERENCE_NEIGHBORLIST_H_
@@ -34,9 +34,15 @@
 
 #include "openmm/Platform.h"
 #include "openmm/internal/windowsExport.h"
+#include <pthread.h>
+#include <map>
+#include <string>
+#include <vector>
 
 namespace OpenMM {
 
+class ReferenceRandomStreams;
+
 /**
  * This Platform subclass uses the reference implementations of all the OpenMM kernels.
  */
@@ -44,6 +50,7 @@ namespace OpenMM {
 class OPENMM_EXPORT ReferencePlatform : public Platform {
 public:
     class PlatformData;
+    class SharedData;
     ReferencePlatform();
     const std::string& getName() const {
         static const std::string name = "Reference";
@@ -52,12 +59,17 @@ public:
     double getSpeed() const;
     bool supportsDoublePrecision() const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
+    void linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const;
     void contextDestroyed(ContextImpl& context) const;
 };
 
 class ReferencePlatform::PlatformData {
 public:
-    PlatformData(int numParticles);
+    /**
+     * Create the data for a Context.  If sharedData is NULL a new SharedData is created, otherwise the
+     * existing one (belonging to the Context this one was cloned from) is used.
+     */
+    PlatformData(int numParticles, SharedData* sharedData=NULL);
     ~PlatformData();
     int numParticles, stepCount;
     double time;
@@ -65,7 +77,48 @@ public:
     void* velocities;
     void* forces;
     void* periodicBoxSize;
+    /**
+     * Additional per-Context state that kernels need preserved across checkpoints (for example,
+     * extrapolation history).  Each entry is written to and restored from checkpoints by name.
+     */
+    std::map<std::string, std::vector<double> > checkpointData;
+    /**
+     * The random number generator used by integrators and thermostats in this Context.
+     */
+    ReferenceRandomStreams* random;
+    SharedData* sharedData;
 };
+
+/**
+ * This class holds data that depends only on the System, so it can be shared between a Context and any
+ * Contexts cloned from it.  It is reference counted, and is deleted along with the last PlatformData
+ * that uses it.  Kernels in different Contexts may access it at the same time, so they should hold the
+ * lock while reading or writing its fields.
+ */
+class ReferencePlatform::SharedData {
+public:
+    SharedData();
+    ~SharedData();
+    void addReference();
+    /**
+     * Remove a reference.  Returns true if there are none left, so the object should be deleted.
+     */
+    bool removeReference();
+    pthread_mutex_t lock;
+    /**
+     * The inverse constraint coupling matrix used by CCMA (a vector<vector<pair<int, RealOpenMM> > >),
+     * or NULL if it has not been computed yet.
+     */
+    void* ccmaMatrix;
+    /**
+     * The constraints, masses, and angles ccmaMatrix was computed from, flattened into a single array.
+     * A Context whose inputs differ must compute its own matrix.
+     */
+    std::vector<double> ccmaMatrixInputs;
+private:
+    int referenceCount;
+};
+
 } // namespace OpenMM
 
 #endif /*OPENMM_REFERENCEPLATFORM_H_*/
@@ -0,0 +1,114 @@
+#ifndef OPENMM_REFERENCERANDOMSTREAMS_H_
+#define OPENMM_REFERENCERANDOMSTREAMS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class generates the random numbers used by integrators and thermostats on the Reference platform.
+ * Every Context has its own instance, so simulations in different Contexts do not affect each other.
+ *
+ * Large arrays of Gaussian values are divided into blocks of BlockSize elements.  Each block is drawn from
+ * its own SFMT stream, seeded from the random number seed, the number of arrays generated so far, and the
+ * index of the block.  Blocks are distributed between threads, and because the value of every element is
+ * determined only by its position, the result is identical for any number of threads.  All instances share
+ * one ThreadPool, which is created the first time a multi-block array is requested.  Scalar values come
+ * from a separate sequential stream.  The complete state can be saved to and restored from a checkpoint.
+ */
+
+class OPENMM_EXPORT ReferenceRandomStreams {
+public:
+    /**
+     * The number of values generated from each stream by fillNormallyDistributedRandomNumbers().
+     */
+    static const int BlockSize = 4096;
+    ReferenceRandomStreams();
+    ~ReferenceRandomStreams();
+    /**
+     * Get the random number seed.
+     */
+    uint32_t getRandomNumberSeed() const {
+        return seed;
+    }
+    /**
+     * Set the random number seed.  This resets all streams.
+     */
+    void setRandomNumberSeed(uint32_t seed);
+    /**
+     * Fill an array with normally distributed random numbers.  Large arrays are generated in parallel.
+     *
+     * @param values     on exit, contains the random values
+     * @param numValues  the number of values to generate
+     */
+    void fillNormallyDistributedRandomNumbers(RealOpenMM* values, int numValues);
+    /**
+     * Get a normally distributed random number from the sequential stream.
+     */
+    RealOpenMM getNormallyDistributedRandomNumber();
+    /**
+     * Get a uniformly distributed random number in the range [0, 1) from the sequential stream.
+     */
+    RealOpenMM getUniformlyDistributedRandomNumber();
+    /**
+     * Write the state of all streams to a checkpoint.
+     */
+    void createCheckpoint(std::ostream& stream);
+    /**
+     * Load a checkpoint created by createCheckpoint().
+     */
+    void loadCheckpoint(std::istream& stream);
+    /**
+     * Load the random number state from a checkpoint written by SimTKOpenMMUtilities::createCheckpoint(),
+     * as found in Reference checkpoints of version 2 and earlier.  The sequential stream continues from
+     * where that generator left off.  Arrays restart from the first one for the stored seed.
+     */
+    void loadLegacyCheckpoint(std::istream& stream);
+private:
+    class FillTask;
+    void fillBlock(RealOpenMM* values, int numValues, int block, OpenMM_SFMT::SFMT& sfmt);
+    uint32_t seed, numArrays;
+    bool nextGaussianIsValid;
+    RealOpenMM nextGaussian;
+    OpenMM_SFMT::SFMT sequential;
+    std::vector<OpenMM_SFMT::SFMT*> threadStreams;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_REFERENCERANDOMSTREAMS_H_*/
@@ -0,0 +1,68 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#ifndef OPENMM_REFERENCE_SPATIALORDER_H_
+#define OPENMM_REFERENCE_SPATIALORDER_H_
+
+#include "RealVec.h"
+#include "openmm/internal/windowsExport.h"
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes an order in which to store particles so that particles that are close together in space
+ * are also close together in memory.  Kernels that loop over pairs of nearby particles can copy their inputs
+ * into this order before computing the interactions, which greatly improves cache usage for systems (such as
+ * solvated ones built by Modeller) whose particles are scattered in memory relative to their spatial neighbors.
+ *
+ * Molecules are never split up: the atoms of each molecule remain contiguous and in their original relative
+ * order, and whole molecules are sorted by the position of their centers along a Hilbert curve.
+ */
+
+class OPENMM_EXPORT ReferenceSpatialOrder {
+public:
+    /**
+     * Compute a spatially coherent order for the particles.
+     *
+     * @param molecules       the particles in each molecule, as returned by ContextImpl::getMolecules()
+     * @param positions       the particle positions
+     * @param periodicBoxSize the size of the periodic box
+     * @param usePeriodic     whether to apply periodic boundary conditions when locating molecules
+     * @param order           on exit, order[i] is the index of the particle that should be placed at position i
+     */
+    static void computeOrder(const std::vector<std::vector<int> >& molecules, const std::vector<RealVec>& positions,
+                             const RealVec& periodicBoxSize, bool usePeriodic, std::vector<int>& order);
+};
+
+} // namespace OpenMM
+
+#endif // OPENMM_REFERENCE_SPATIALORDER_H_
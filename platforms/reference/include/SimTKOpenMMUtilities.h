@@ -169,6 +169,19 @@ class OPENMM_EXPORT SimTKOpenMMUtilities {
       
       static RealOpenMM getNormallyDistributedRandomNumber( void );
       
+      /**---------------------------------------------------------------------------------------
+      
+         Fill an array with normally distributed random numbers.  This draws from the same
+         stream as getNormallyDistributedRandomNumber(), but is much faster than calling it
+         once for each value.
+      
+         @param values     on exit, contains the random values
+         @param numValues  the number of values to generate
+      
+         --------------------------------------------------------------------------------------- */
+      
+      static void fillNormallyDistributedRandomNumbers( RealOpenMM* values, int numValues );
+      
       /**---------------------------------------------------------------------------------------
       
          Get uniformly distributed random number in the range [0, 1)
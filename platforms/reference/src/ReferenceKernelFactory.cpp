@@ -93,7 +93,7 @@ KernelImpl* ReferenceKernelFactory::createKernelImpl(std::string name, const Pla
     if (name == IntegrateCustomStepKernel::Name())
         return new ReferenceIntegrateCustomStepKernel(name, platform, data);
     if (name == ApplyAndersenThermostatKernel::Name())
-        return new ReferenceApplyAndersenThermostatKernel(name, platform);
+        return new ReferenceApplyAndersenThermostatKernel(name, platform, data);
     if (name == ApplyMonteCarloBarostatKernel::Name())
         return new ReferenceApplyMonteCarloBarostatKernel(name, platform);
     if (name == RemoveCMMotionKernel::Name())
@@ -146,6 +146,46 @@ static void findAnglesForCCMA(const System& system, vector<ReferenceCCMAAlgorith
     }
 }
 
+/**
+ * Create the CCMA object for a Context.  Building the coupling matrix is expensive, and it depends only on
+ * the System, so it is computed once and then shared by all kernels of the Context and any Contexts cloned
+ * from it.  The inputs it was built from are stored with it, and a Context whose System has since been
+ * modified computes a new matrix.
+ */
+static ReferenceCCMAAlgorithm* createCCMAAlgorithm(ReferencePlatform::PlatformData& data, const System& system, const vector<pair<int, int> >& constraintIndices,
+        const vector<RealOpenMM>& constraintDistances, vector<RealOpenMM>& masses, RealOpenMM tolerance) {
+    typedef vector<vector<pair<int, RealOpenMM> > > Matrix;
+    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
+    findAnglesForCCMA(system, angles);
+    vector<double> inputs;
+    for (int i = 0; i < (int) constraintIndices.size(); i++) {
+        inputs.push_back(constraintIndices[i].first);
+        inputs.push_back(constraintIndices[i].second);
+        inputs.push_back(constraintDistances[i]);
+    }
+    inputs.insert(inputs.end(), masses.begin(), masses.end());
+    for (int i = 0; i < (int) angles.size(); i++) {
+        inputs.push_back(angles[i].atom1);
+        inputs.push_back(angles[i].atom2);
+        inputs.push_back(angles[i].atom3);
+        inputs.push_back(angles[i].angle);
+    }
+    ReferencePlatform::SharedData& shared = *data.sharedData;
+    ReferenceCCMAAlgorithm* ccma;
+    pthread_mutex_lock(&shared.lock);
+    if (shared.ccmaMatrix != NULL && shared.ccmaMatrixInputs == inputs)
+        ccma = new ReferenceCCMAAlgorithm(system.getNumParticles(), constraintIndices.size(), constraintIndices, constraintDistances, *(Matrix*) shared.ccmaMatrix, tolerance);
+    else {
+        ccma = new ReferenceCCMAAlgorithm(system.getNumParticles(), constraintIndices.size(), constraintIndices, constraintDistances, masses, angles, tolerance);
+        if (shared.ccmaMatrix == NULL) {
+            shared.ccmaMatrix = new Matrix(ccma->getMatrix());
+            shared.ccmaMatrixInputs = inputs;
+        }
+    }
+    pthread_mutex_unlock(&shared.lock);
+    return ccma;
+}
+
 /**
  * Compute the kinetic energy of the system, possibly shifting the velocities in time to account
  * for a leapfrog integrator.
@@ -280,7 +320,7 @@ void ReferenceUpdateStateDataKernel::setPeriodicBoxVectors(ContextImpl& context,
 }
 
 void ReferenceUpdateStateDataKernel::createCheckpoint(ContextImpl& context, ostream& stream) {
-    int version = 1;
+    int version = 3;
     stream.write((char*) &version, sizeof(int));
     stream.write((char*) &data.time, sizeof(data.time));
     vector<RealVec>& posData = extractPositions(context);
@@ -289,13 +329,24 @@ void ReferenceUpdateStateDataKernel::createCheckpoint(ContextImpl& context, ostr
     stream.write((char*) &velData[0], sizeof(RealVec)*velData.size());
     RealVec& box = extractBoxSize(context);
     stream.write((char*) &box, sizeof(RealVec));
-    SimTKOpenMMUtilities::createCheckpoint(stream);
+    data.random->createCheckpoint(stream);
+    int numEntries = data.checkpointData.size();
+    stream.write((char*) &numEntries, sizeof(int));
+    for (map<string, vector<double> >::const_iterator iter = data.checkpointData.begin(); iter != data.checkpointData.end(); ++iter) {
+        int nameLength = iter->first.size();
+        stream.write((char*) &nameLength, sizeof(int));
+        stream.write(iter->first.c_str(), nameLength);
+        int size = iter->second.size();
+        stream.write((char*) &size, sizeof(int));
+        if (size > 0)
+            stream.write((char*) &iter->second[0], sizeof(double)*size);
+    }
 }
 
 void ReferenceUpdateStateDataKernel::loadCheckpoint(ContextImpl& context, istream& stream) {
     int version;
     stream.read((char*) &version, sizeof(int));
-    if (version != 1)
+    if (version < 1 || version > 3)
         throw OpenMMException("Checkpoint was created with a different version of OpenMM");
     stream.read((char*) &data.time, sizeof(data.time));
     vector<RealVec>& posData = extractPositions(context);
@@ -304,7 +355,28 @@ void ReferenceUpdateStateDataKernel::loadCheckpoint(ContextImpl& context, istrea
     stream.read((char*) &velData[0], sizeof(RealVec)*velData.size());
     RealVec& box = extractBoxSize(context);
     stream.read((char*) &box, sizeof(RealVec));
-    SimTKOpenMMUtilities::loadCheckpoint(stream);
+    if (version > 2)
+        data.random->loadCheckpoint(stream);
+    else
+        data.random->loadLegacyCheckpoint(stream);
+    data.checkpointData.clear();
+    if (version > 1) {
+        int numEntries;
+        stream.read((char*) &numEntries, sizeof(int));
+        for (int i = 0; i < numEntries; i++) {
+            int nameLength;
+            stream.read((char*) &nameLength, sizeof(int));
+            vector<char> name(nameLength);
+            if (nameLength > 0)
+                stream.read(&name[0], nameLength);
+            int size;
+            stream.read((char*) &size, sizeof(int));
+            vector<double>& values = data.checkpointData[string(name.begin(), name.end())];
+            values.resize(size);
+            if (size > 0)
+                stream.read((char*) &values[0], sizeof(double)*size);
+        }
+    }
 }
 
 void ReferenceApplyConstraintsKernel::initialize(const System& system) {
@@ -335,9 +407,7 @@ ReferenceApplyConstraintsKernel::~ReferenceApplyConstraintsKernel() {
 
 void ReferenceApplyConstraintsKernel::apply(ContextImpl& context, double tol) {
     if (constraints == NULL) {
-        vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-        findAnglesForCCMA(context.getSystem(), angles);
-        constraints = new ReferenceCCMAAlgorithm(context.getSystem().getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, tol);
+        constraints = createCCMAAlgorithm(data, context.getSystem(), constraintIndices, constraintDistances, masses, tol);
     }
     vector<RealVec>& positions = extractPositions(context);
     constraints->setTolerance(tol);
@@ -347,9 +417,7 @@ void ReferenceApplyConstraintsKernel::apply(ContextImpl& context, double tol) {
 
 void ReferenceApplyConstraintsKernel::applyToVelocities(ContextImpl& context, double tol) {
     if (constraints == NULL) {
-        vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-        findAnglesForCCMA(context.getSystem(), angles);
-        constraints = new ReferenceCCMAAlgorithm(context.getSystem().getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, tol);
+        constraints = createCCMAAlgorithm(data, context.getSystem(), constraintIndices, constraintDistances, masses, tol);
     }
     vector<RealVec>& positions = extractPositions(context);
     vector<RealVec>& velocities = extractVelocities(context);
@@ -805,11 +873,14 @@ void ReferenceCalcCustomTorsionForceKernel::copyParametersToContext(ContextImpl&
 
 ReferenceCalcNonbondedForceKernel::~ReferenceCalcNonbondedForceKernel() {
     disposeRealArray(particleParamArray, numParticles);
-    disposeIntArray(exclusionArray, numParticles);
+    if (sortedParamArray != NULL)
+        disposeRealArray(sortedParamArray, numParticles);
     disposeIntArray(bonded14IndexArray, num14);
     disposeRealArray(bonded14ParamArray, num14);
     if (neighborList != NULL)
         delete neighborList;
+    if (dispersionCorrection != NULL)
+        delete dispersionCorrection;
 }
 
 void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const NonbondedForce& force) {
@@ -817,17 +888,21 @@ void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const N
     // Identify which exceptions are 1-4 interactions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs;
     vector<int> nb14s;
+    nb14Index.resize(force.getNumExceptions());
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-        if (chargeProd != 0.0 || epsilon != 0.0)
+        excludedPairs.push_back(make_pair(particle1, particle2));
+        nb14Index[i] = -1;
+        if (chargeProd != 0.0 || epsilon != 0.0) {
+            nb14Index[i] = nb14s.size();
             nb14s.push_back(i);
+        }
     }
+    exclusions = ReferenceExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -842,15 +917,6 @@ void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const N
         particleParamArray[i][1] = static_cast<RealOpenMM>(2.0*sqrt(depth));
         particleParamArray[i][2] = static_cast<RealOpenMM>(charge);
     }
-    this->exclusions = exclusions;
-    exclusionArray = new int*[numParticles];
-    for (int i = 0; i < numParticles; ++i) {
-        exclusionArray[i] = new int[exclusions[i].size()+1];
-        exclusionArray[i][0] = exclusions[i].size();
-        int index = 0;
-        for (set<int>::const_iterator iter = exclusions[i].begin(); iter != exclusions[i].end(); ++iter)
-            exclusionArray[i][++index] = *iter;
-    }
     for (int i = 0; i < num14; ++i) {
         int particle1, particle2;
         double charge, radius, depth;
@@ -883,8 +949,10 @@ void ReferenceCalcNonbondedForceKernel::initialize(const System& system, const N
         ewaldAlpha = (RealOpenMM) alpha;
     }
     rfDielectric = (RealOpenMM)force.getReactionFieldDielectric();
-    if (force.getUseDispersionCorrection())
-        dispersionCoefficient = NonbondedForceImpl::calcDispersionCorrection(system, force);
+    if (force.getUseDispersionCorrection() && (nonbondedMethod == CutoffPeriodic || nonbondedMethod == Ewald || nonbondedMethod == PME)) {
+        dispersionCorrection = new NonbondedForceImpl::DispersionCorrection(force);
+        dispersionCoefficient = dispersionCorrection->getCoefficient();
+    }
     else
         dispersionCoefficient = 0.0;
 }
@@ -898,7 +966,10 @@ double ReferenceCalcNonbondedForceKernel::execute(ContextImpl& context, bool inc
     bool ewald  = (nonbondedMethod == Ewald);
     bool pme  = (nonbondedMethod == PME);
     if (nonbondedMethod != NoCutoff) {
-        computeNeighborListVoxelHash(*neighborList, numParticles, posData, exclusions, extractBoxSize(context), periodic || ewald || pme, nonbondedCutoff, 0.0);
+        updateSortedOrder(context);
+        for (int i = 0; i < numParticles; i++)
+            sortedPositions[i] = posData[sortedOrder[i]];
+        computeNeighborListVoxelHash(*neighborList, numParticles, sortedPositions, sortedExclusions, extractBoxSize(context), periodic || ewald || pme, nonbondedCutoff, 0.0);
         clj.setUseCutoff(nonbondedCutoff, *neighborList, rfDielectric);
     }
     if (periodic || ewald || pme) {
@@ -914,7 +985,15 @@ double ReferenceCalcNonbondedForceKernel::execute(ContextImpl& context, bool inc
         clj.setUsePME(ewaldAlpha, gridSize);
     if (useSwitchingFunction)
         clj.setUseSwitchingFunction(switchingDistance);
-    clj.calculatePairIxn(numParticles, posData, particleParamArray, exclusionArray, 0, forceData, 0, includeEnergy ? &energy : NULL, includeDirect, includeReciprocal);
+    if (nonbondedMethod == NoCutoff)
+        clj.calculatePairIxn(numParticles, posData, particleParamArray, exclusions, 0, forceData, 0, includeEnergy ? &energy : NULL, includeDirect, includeReciprocal);
+    else {
+        for (int i = 0; i < numParticles; i++)
+            sortedForces[i] = RealVec();
+        clj.calculatePairIxn(numParticles, sortedPositions, sortedParamArray, sortedExclusions, 0, sortedForces, 0, includeEnergy ? &energy : NULL, includeDirect, includeReciprocal);
+        for (int i = 0; i < numParticles; i++)
+            forceData[sortedOrder[i]] += sortedForces[i];
+    }
     if (includeDirect) {
         ReferenceBondForce refBondForce;
         ReferenceLJCoulomb14 nonbonded14;
@@ -927,19 +1006,59 @@ double ReferenceCalcNonbondedForceKernel::execute(ContextImpl& context, bool inc
     return energy;
 }
 
+void ReferenceCalcNonbondedForceKernel::updateSortedOrder(ContextImpl& context) {
+    // Particles diffuse slowly, so the order only needs to be recomputed occasionally.  The order affects
+    // performance but not results, so it does not matter if it is somewhat out of date.
+
+    const int reorderInterval = 100;
+    if (sortedOrder.size() == 0 || stepsSinceReorder >= reorderInterval) {
+        RealVec& box = extractBoxSize(context);
+        bool periodic = (nonbondedMethod == CutoffPeriodic || nonbondedMethod == Ewald || nonbondedMethod == PME);
+        ReferenceSpatialOrder::computeOrder(context.getMolecules(), extractPositions(context), box, periodic, sortedOrder);
+        sortedIndex.resize(numParticles);
+        for (int i = 0; i < numParticles; i++)
+            sortedIndex[sortedOrder[i]] = i;
+        vector<pair<int, int> > sortedPairs;
+        for (int i = 0; i < numParticles; i++)
+            for (int j = 0; j < exclusions.getNumExclusions(i); j++) {
+                int k = exclusions.getExclusions(i)[j];
+                if (k > i)
+                    sortedPairs.push_back(make_pair(sortedIndex[i], sortedIndex[k]));
+            }
+        sortedExclusions = ReferenceExclusionList(numParticles, sortedPairs);
+        sortedPositions.resize(numParticles);
+        sortedForces.resize(numParticles);
+        sortedParamsValid = false;
+        stepsSinceReorder = 0;
+    }
+    stepsSinceReorder++;
+    if (!sortedParamsValid) {
+        if (sortedParamArray == NULL)
+            sortedParamArray = allocateRealArray(numParticles, 3);
+        for (int i = 0; i < numParticles; i++)
+            for (int j = 0; j < 3; j++)
+                sortedParamArray[i][j] = particleParamArray[sortedOrder[i]][j];
+        sortedParamsValid = true;
+    }
+}
+
 void ReferenceCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& context, const NonbondedForce& force) {
     if (force.getNumParticles() != numParticles)
         throw OpenMMException("updateParametersInContext: The number of particles has changed");
     vector<int> nb14s;
+    vector<int> newNb14Index(force.getNumExceptions(), -1);
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        if (chargeProd != 0.0 || epsilon != 0.0)
+        if (chargeProd != 0.0 || epsilon != 0.0) {
+            newNb14Index[i] = nb14s.size();
             nb14s.push_back(i);
+        }
     }
     if (nb14s.size() != num14)
         throw OpenMMException("updateParametersInContext: The number of non-excluded exceptions has changed");
+    nb14Index = newNb14Index;
 
     // Record the values.
 
@@ -950,6 +1069,7 @@ void ReferenceCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& con
         particleParamArray[i][1] = static_cast<RealOpenMM>(2.0*sqrt(depth));
         particleParamArray[i][2] = static_cast<RealOpenMM>(charge);
     }
+    sortedParamsValid = false;
     for (int i = 0; i < num14; ++i) {
         int particle1, particle2;
         double charge, radius, depth;
@@ -963,9 +1083,174 @@ void ReferenceCalcNonbondedForceKernel::copyParametersToContext(ContextImpl& con
     
     // Recompute the coefficient for the dispersion correction.
 
-    NonbondedForce::NonbondedMethod method = force.getNonbondedMethod();
-    if (force.getUseDispersionCorrection() && (method == NonbondedForce::CutoffPeriodic || method == NonbondedForce::Ewald || method == NonbondedForce::PME))
-        dispersionCoefficient = NonbondedForceImpl::calcDispersionCorrection(context.getSystem(), force);
+    if (dispersionCorrection != NULL) {
+        delete dispersionCorrection;
+        dispersionCorrection = new NonbondedForceImpl::DispersionCorrection(force);
+        dispersionCoefficient = dispersionCorrection->getCoefficient();
+    }
+    
+    // The exceptions involving a subset may have changed.
+    
+    subsetParticles.clear();
+}
+
+void ReferenceCalcNonbondedForceKernel::copyChangedParametersToContext(ContextImpl& context, const NonbondedForce& force, const vector<int>& particles, const vector<int>& exceptions) {
+    if (force.getNumParticles() != numParticles)
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // If exceptions have been added, or one has switched between being excluded and being a 1-4
+    // interaction, the 1-4 arrays need to be rebuilt.
+
+    bool rebuild14 = (force.getNumExceptions() != (int) nb14Index.size());
+    for (int i = 0; i < (int) exceptions.size() && !rebuild14; i++) {
+        int particle1, particle2;
+        double chargeProd, sigma, epsilon;
+        force.getExceptionParameters(exceptions[i], particle1, particle2, chargeProd, sigma, epsilon);
+        if ((chargeProd != 0.0 || epsilon != 0.0) != (nb14Index[exceptions[i]] != -1))
+            rebuild14 = true;
+    }
+    if (rebuild14) {
+        copyParametersToContext(context, force);
+        return;
+    }
+
+    // Record the values that have changed.
+
+    for (int i = 0; i < (int) particles.size(); i++) {
+        int index = particles[i];
+        double charge, radius, depth;
+        force.getParticleParameters(index, charge, radius, depth);
+        particleParamArray[index][0] = static_cast<RealOpenMM>(0.5*radius);
+        particleParamArray[index][1] = static_cast<RealOpenMM>(2.0*sqrt(depth));
+        particleParamArray[index][2] = static_cast<RealOpenMM>(charge);
+        if (sortedParamsValid)
+            for (int j = 0; j < 3; j++)
+                sortedParamArray[sortedIndex[index]][j] = particleParamArray[index][j];
+    }
+    for (int i = 0; i < (int) exceptions.size(); i++) {
+        int index = nb14Index[exceptions[i]];
+        if (index == -1)
+            continue;
+        int particle1, particle2;
+        double charge, radius, depth;
+        force.getExceptionParameters(exceptions[i], particle1, particle2, charge, radius, depth);
+        if (particle1 != bonded14IndexArray[index][0] || particle2 != bonded14IndexArray[index][1]) {
+            // The exceptions involving a subset may have changed.
+
+            bonded14IndexArray[index][0] = particle1;
+            bonded14IndexArray[index][1] = particle2;
+            subsetParticles.clear();
+        }
+        bonded14ParamArray[index][0] = static_cast<RealOpenMM>(radius);
+        bonded14ParamArray[index][1] = static_cast<RealOpenMM>(4.0*depth);
+        bonded14ParamArray[index][2] = static_cast<RealOpenMM>(charge);
+    }
+
+    // Only the classes of the changed particles need to be updated for the dispersion correction.
+
+    if (dispersionCorrection != NULL) {
+        dispersionCorrection->updateParticles(force, particles);
+        dispersionCoefficient = dispersionCorrection->getCoefficient();
+    }
+}
+
+bool ReferenceCalcNonbondedForceKernel::executeSubset(ContextImpl& context, const vector<int>& subset, double& totalEnergy) {
+    if (nonbondedMethod == Ewald || nonbondedMethod == PME)
+        return false;
+    updateSubsetCandidates(context, subset);
+    vector<RealVec>& posData = extractPositions(context);
+    vector<RealVec>& forceData = extractForces(context);
+    RealOpenMM energy = 0;
+    ReferenceLJCoulombIxn clj;
+    if (nonbondedMethod == NoCutoff)
+        clj.calculatePairListIxn(subsetCandidates, posData, particleParamArray, forceData, &energy);
+    else {
+        // Select the candidate pairs that are currently inside the cutoff.
+        
+        bool periodic = (nonbondedMethod == CutoffPeriodic);
+        RealVec& box = extractBoxSize(context);
+        RealOpenMM boxSize[3] = {box[0], box[1], box[2]};
+        RealOpenMM cutoffSquared = nonbondedCutoff*nonbondedCutoff;
+        RealOpenMM deltaR[ReferenceForce::LastDeltaRIndex];
+        subsetNeighbors.clear();
+        for (int i = 0; i < (int) subsetCandidates.size(); i++) {
+            const AtomPair& pair = subsetCandidates[i];
+            if (periodic)
+                ReferenceForce::getDeltaRPeriodic(posData[pair.second], posData[pair.first], boxSize, deltaR);
+            else
+                ReferenceForce::getDeltaR(posData[pair.second], posData[pair.first], deltaR);
+            if (deltaR[ReferenceForce::R2Index] <= cutoffSquared)
+                subsetNeighbors.push_back(pair);
+        }
+        clj.setUseCutoff(nonbondedCutoff, subsetNeighbors, rfDielectric);
+        if (periodic)
+            clj.setPeriodic(box);
+        if (useSwitchingFunction)
+            clj.setUseSwitchingFunction(switchingDistance);
+        clj.calculatePairListIxn(subsetNeighbors, posData, particleParamArray, forceData, &energy);
+    }
+    ReferenceLJCoulomb14 nonbonded14;
+    for (int i = 0; i < (int) subset14.size(); i++)
+        nonbonded14.calculateBondIxn(bonded14IndexArray[subset14[i]], posData, bonded14ParamArray[subset14[i]], forceData, &energy);
+    totalEnergy = energy;
+    return true;
+}
+
+void ReferenceCalcNonbondedForceKernel::updateSubsetCandidates(ContextImpl& context, const vector<int>& subset) {
+    vector<RealVec>& posData = extractPositions(context);
+    RealVec& box = extractBoxSize(context);
+    bool useCutoff = (nonbondedMethod != NoCutoff);
+    RealOpenMM padding = 0.1*nonbondedCutoff;
+    
+    // The candidates remain valid as long as the subset is unchanged, no other particle has moved,
+    // and no particle in the subset has moved more than half the padding.
+    
+    bool subsetChanged = (subset != subsetParticles);
+    bool rebuild = subsetChanged;
+    if (!rebuild && useCutoff) {
+        if (box[0] != subsetReferenceBox[0] || box[1] != subsetReferenceBox[1] || box[2] != subsetReferenceBox[2])
+            rebuild = true;
+        RealOpenMM maxMoveSquared = 0.25*padding*padding;
+        for (int i = 0; i < numParticles && !rebuild; i++) {
+            RealVec delta = posData[i]-subsetReferencePositions[i];
+            if (isInSubset[i])
+                rebuild = (delta.dot(delta) > maxMoveSquared);
+            else
+                rebuild = (delta[0] != 0 || delta[1] != 0 || delta[2] != 0);
+        }
+    }
+    if (!rebuild)
+        return;
+    if (subsetChanged) {
+        subsetParticles = subset;
+        isInSubset.assign(numParticles, false);
+        for (int i = 0; i < (int) subset.size(); i++)
+            isInSubset[subset[i]] = true;
+        subset14.clear();
+        for (int i = 0; i < num14; i++)
+            if (isInSubset[bonded14IndexArray[i][0]] || isInSubset[bonded14IndexArray[i][1]])
+                subset14.push_back(i);
+    }
+    subsetCandidates.clear();
+    if (useCutoff) {
+        NeighborList allPairs;
+        computeNeighborListVoxelHash(allPairs, numParticles, posData, exclusions, box, nonbondedMethod == CutoffPeriodic, nonbondedCutoff+padding, 0.0);
+        for (int i = 0; i < (int) allPairs.size(); i++)
+            if (isInSubset[allPairs[i].first] || isInSubset[allPairs[i].second])
+                subsetCandidates.push_back(allPairs[i]);
+        subsetReferencePositions = posData;
+        subsetReferenceBox = box;
+    }
+    else {
+        // Without a cutoff every pair interacts, so the candidates only depend on the subset.
+        
+        for (int i = 0; i < (int) subset.size(); i++) {
+            int p1 = subset[i];
+            for (int p2 = 0; p2 < numParticles; p2++)
+                if (p2 != p1 && !(isInSubset[p2] && p2 < p1) && !exclusions.isExcluded(p1, p2))
+                    subsetCandidates.push_back(AtomPair(p1, p2));
+        }
+    }
 }
 
 class ReferenceTabulatedFunction : public Lepton::CustomFunction {
@@ -1002,11 +1287,10 @@ public:
 
 ReferenceCalcCustomNonbondedForceKernel::~ReferenceCalcCustomNonbondedForceKernel() {
     disposeRealArray(particleParamArray, numParticles);
-    disposeIntArray(exclusionArray, numParticles);
     if (neighborList != NULL)
         delete neighborList;
-    if (forceCopy != NULL)
-        delete forceCopy;
+    if (longRangeCorrection != NULL)
+        delete longRangeCorrection;
 }
 
 void ReferenceCalcCustomNonbondedForceKernel::initialize(const System& system, const CustomNonbondedForce& force) {
@@ -1014,13 +1298,10 @@ void ReferenceCalcCustomNonbondedForceKernel::initialize(const System& system, c
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ReferenceExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1032,14 +1313,6 @@ void ReferenceCalcCustomNonbondedForceKernel::initialize(const System& system, c
         for (int j = 0; j < numParameters; j++)
             particleParamArray[i][j] = static_cast<RealOpenMM>(parameters[j]);
     }
-    exclusionArray = new int*[numParticles];
-    for (int i = 0; i < numParticles; ++i) {
-        exclusionArray[i] = new int[exclusions[i].size()+1];
-        exclusionArray[i][0] = exclusions[i].size();
-        int index = 0;
-        for (set<int>::const_iterator iter = exclusions[i].begin(); iter != exclusions[i].end(); ++iter)
-            exclusionArray[i][++index] = *iter;
-    }
     nonbondedMethod = CalcCustomNonbondedForceKernel::NonbondedMethod(force.getNonbondedMethod());
     nonbondedCutoff = (RealOpenMM) force.getCutoffDistance();
     if (nonbondedMethod == NoCutoff) {
@@ -1083,7 +1356,7 @@ void ReferenceCalcCustomNonbondedForceKernel::initialize(const System& system, c
     // Record information for the long range correction.
     
     if (force.getNonbondedMethod() == CustomNonbondedForce::CutoffPeriodic && force.getUseLongRangeCorrection()) {
-        forceCopy = new CustomNonbondedForce(force);
+        longRangeCorrection = new CustomNonbondedForceImpl::LongRangeCorrection(force);
         hasInitializedLongRangeCorrection = false;
     }
     else {
@@ -1118,12 +1391,12 @@ double ReferenceCalcCustomNonbondedForceKernel::execute(ContextImpl& context, bo
     }
     if (useSwitchingFunction)
         ixn.setUseSwitchingFunction(switchingDistance);
-    ixn.calculatePairIxn(numParticles, posData, particleParamArray, exclusionArray, 0, globalParamValues, forceData, 0, includeEnergy ? &energy : NULL);
+    ixn.calculatePairIxn(numParticles, posData, particleParamArray, exclusions, 0, globalParamValues, forceData, 0, includeEnergy ? &energy : NULL);
     
     // Add in the long range correction.
     
-    if (!hasInitializedLongRangeCorrection || (globalParamsChanged && forceCopy != NULL)) {
-        longRangeCoefficient = CustomNonbondedForceImpl::calcLongRangeCorrection(*forceCopy, context.getOwner());
+    if (!hasInitializedLongRangeCorrection || (globalParamsChanged && longRangeCorrection != NULL)) {
+        longRangeCoefficient = longRangeCorrection->getCoefficient(context.getOwner());
         hasInitializedLongRangeCorrection = true;
     }
     energy += longRangeCoefficient/(box[0]*box[1]*box[2]);
@@ -1147,10 +1420,34 @@ void ReferenceCalcCustomNonbondedForceKernel::copyParametersToContext(ContextImp
     
     // If necessary, recompute the long range correction.
     
-    if (forceCopy != NULL) {
-        longRangeCoefficient = CustomNonbondedForceImpl::calcLongRangeCorrection(force, context.getOwner());
+    if (longRangeCorrection != NULL) {
+        delete longRangeCorrection;
+        longRangeCorrection = new CustomNonbondedForceImpl::LongRangeCorrection(force);
+        longRangeCoefficient = longRangeCorrection->getCoefficient(context.getOwner());
+        hasInitializedLongRangeCorrection = true;
+    }
+}
+
+void ReferenceCalcCustomNonbondedForceKernel::copyChangedParametersToContext(ContextImpl& context, const CustomNonbondedForce& force, const vector<int>& particles) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+
+    // Record the values that have changed.
+
+    int numParameters = force.getNumPerParticleParameters();
+    vector<double> parameters;
+    for (int i = 0; i < (int) particles.size(); ++i) {
+        force.getParticleParameters(particles[i], parameters);
+        for (int j = 0; j < numParameters; j++)
+            particleParamArray[particles[i]][j] = static_cast<RealOpenMM>(parameters[j]);
+    }
+
+    // Update the long range correction, reusing the integrals for classes that were already present.
+
+    if (longRangeCorrection != NULL && particles.size() > 0) {
+        longRangeCorrection->updateParticles(force, particles);
+        longRangeCoefficient = longRangeCorrection->getCoefficient(context.getOwner());
         hasInitializedLongRangeCorrection = true;
-        *forceCopy = force;
     }
 }
 
@@ -1300,13 +1597,10 @@ void ReferenceCalcCustomGBForceKernel::initialize(const System& system, const Cu
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions = ReferenceExclusionList(numParticles, excludedPairs);
 
     // Build the arrays.
 
@@ -1743,9 +2037,7 @@ void ReferenceIntegrateVerletStepKernel::initialize(const System& system, const
         constraintIndices[i].second = particle2;
         constraintDistances[i] = static_cast<RealOpenMM>(distance);
     }
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
 }
 
 void ReferenceIntegrateVerletStepKernel::execute(ContextImpl& context, const VerletIntegrator& integrator) {
@@ -1795,10 +2087,8 @@ void ReferenceIntegrateLangevinStepKernel::initialize(const System& system, cons
         constraintIndices[i].second = particle2;
         constraintDistances[i] = static_cast<RealOpenMM>(distance);
     }
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
 }
 
 void ReferenceIntegrateLangevinStepKernel::execute(ContextImpl& context, const LangevinIntegrator& integrator) {
@@ -1820,6 +2110,7 @@ void ReferenceIntegrateLangevinStepKernel::execute(ContextImpl& context, const L
                 static_cast<RealOpenMM>(tau), 
                 static_cast<RealOpenMM>(temperature) );
         dynamics->setReferenceConstraintAlgorithm(constraints);
+        dynamics->setRandomNumberGenerator(data.random);
         prevTemp = temperature;
         prevFriction = friction;
         prevStepSize = stepSize;
@@ -1857,10 +2148,8 @@ void ReferenceIntegrateBrownianStepKernel::initialize(const System& system, cons
         constraintIndices[i].second = particle2;
         constraintDistances[i] = static_cast<RealOpenMM>(distance);
     }
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
 }
 
 void ReferenceIntegrateBrownianStepKernel::execute(ContextImpl& context, const BrownianIntegrator& integrator) {
@@ -1881,6 +2170,7 @@ void ReferenceIntegrateBrownianStepKernel::execute(ContextImpl& context, const B
                 static_cast<RealOpenMM>(friction), 
                 static_cast<RealOpenMM>(temperature) );
         dynamics->setReferenceConstraintAlgorithm(constraints);
+        dynamics->setRandomNumberGenerator(data.random);
         prevTemp = temperature;
         prevFriction = friction;
         prevStepSize = stepSize;
@@ -1918,10 +2208,8 @@ void ReferenceIntegrateVariableLangevinStepKernel::initialize(const System& syst
         constraintIndices[i].second = particle2;
         constraintDistances[i] = static_cast<RealOpenMM>(distance);
     }
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
 }
 
 double ReferenceIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) {
@@ -1939,6 +2227,7 @@ double ReferenceIntegrateVariableLangevinStepKernel::execute(ContextImpl& contex
         RealOpenMM tau = static_cast<RealOpenMM>( friction == 0.0 ? 0.0 : 1.0/friction );
         dynamics = new ReferenceVariableStochasticDynamics(context.getSystem().getNumParticles(), (RealOpenMM) tau, (RealOpenMM) temperature, (RealOpenMM) errorTol);
         dynamics->setReferenceConstraintAlgorithm(constraints);
+        dynamics->setRandomNumberGenerator(data.random);
         prevTemp = temperature;
         prevFriction = friction;
         prevErrorTol = errorTol;
@@ -1980,9 +2269,7 @@ void ReferenceIntegrateVariableVerletStepKernel::initialize(const System& system
         constraintIndices[i].second = particle2;
         constraintDistances[i] = static_cast<RealOpenMM>(distance);
     }
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
 }
 
 double ReferenceIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) {
@@ -2042,11 +2329,11 @@ void ReferenceIntegrateCustomStepKernel::initialize(const System& system, const
 
     // Create the computation objects.
 
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
     dynamics = new ReferenceCustomDynamics(system.getNumParticles(), integrator);
-    vector<ReferenceCCMAAlgorithm::AngleInfo> angles;
-    findAnglesForCCMA(system, angles);
-    constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, masses, angles, (RealOpenMM)integrator.getConstraintTolerance());
+    constraints = createCCMAAlgorithm(data, system, constraintIndices, constraintDistances, masses, (RealOpenMM)integrator.getConstraintTolerance());
     dynamics->setReferenceConstraintAlgorithm(constraints);
+    dynamics->setRandomNumberGenerator(data.random);
 }
 
 void ReferenceIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
@@ -2123,7 +2410,7 @@ void ReferenceApplyAndersenThermostatKernel::initialize(const System& system, co
     for (int i = 0; i < numParticles; ++i)
         masses[i] = static_cast<RealOpenMM>(system.getParticleMass(i));
     this->thermostat = new ReferenceAndersenThermostat();
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) thermostat.getRandomNumberSeed());
+    data.random->setRandomNumberSeed((unsigned int) thermostat.getRandomNumberSeed());
     particleGroups = AndersenThermostatImpl::calcParticleGroups(system);
 }
 
@@ -2132,7 +2419,7 @@ void ReferenceApplyAndersenThermostatKernel::execute(ContextImpl& context) {
     thermostat->applyThermostat(particleGroups, velData, masses,
         static_cast<RealOpenMM>(context.getParameter(AndersenThermostat::Temperature())),
         static_cast<RealOpenMM>(context.getParameter(AndersenThermostat::CollisionFrequency())),
-        static_cast<RealOpenMM>(context.getIntegrator().getStepSize()));
+        static_cast<RealOpenMM>(context.getIntegrator().getStepSize()), *data.random);
 }
 
 ReferenceApplyMonteCarloBarostatKernel::~ReferenceApplyMonteCarloBarostatKernel() {
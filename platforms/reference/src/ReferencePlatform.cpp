@@ -32,6 +32,7 @@
 #include "ReferencePlatform.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
+#include "ReferenceRandomStreams.h"
 #include "openmm/internal/ContextImpl.h"
 #include "SimTKOpenMMRealType.h"
 #include "RealVec.h"
@@ -85,16 +86,27 @@ void ReferencePlatform::contextCreated(ContextImpl& context, const map<string, s
     context.setPlatformData(new PlatformData(context.getSystem().getNumParticles()));
 }
 
+void ReferencePlatform::linkedContextCreated(ContextImpl& context, ContextImpl& originalContext) const {
+    PlatformData* originalData = reinterpret_cast<PlatformData*>(originalContext.getPlatformData());
+    context.setPlatformData(new PlatformData(context.getSystem().getNumParticles(), originalData->sharedData));
+}
+
 void ReferencePlatform::contextDestroyed(ContextImpl& context) const {
     PlatformData* data = reinterpret_cast<PlatformData*>(context.getPlatformData());
     delete data;
 }
 
-ReferencePlatform::PlatformData::PlatformData(int numParticles) : time(0.0), stepCount(0), numParticles(numParticles) {
+ReferencePlatform::PlatformData::PlatformData(int numParticles, SharedData* sharedData) : time(0.0), stepCount(0), numParticles(numParticles),
+        sharedData(sharedData) {
     positions = new vector<RealVec>(numParticles);
     velocities = new vector<RealVec>(numParticles);
     forces = new vector<RealVec>(numParticles);
     periodicBoxSize = new RealVec();
+    random = new ReferenceRandomStreams();
+    if (sharedData == NULL)
+        this->sharedData = new SharedData();
+    else
+        sharedData->addReference();
 }
 
 ReferencePlatform::PlatformData::~PlatformData() {
@@ -102,4 +114,29 @@ ReferencePlatform::PlatformData::~PlatformData() {
     delete (vector<RealVec>*) velocities;
     delete (vector<RealVec>*) forces;
     delete (RealVec*) periodicBoxSize;
+    delete random;
+    if (sharedData->removeReference())
+        delete sharedData;
+}
+
+ReferencePlatform::SharedData::SharedData() : ccmaMatrix(NULL), referenceCount(1) {
+    pthread_mutex_init(&lock, NULL);
+}
+
+ReferencePlatform::SharedData::~SharedData() {
+    delete (vector<vector<pair<int, RealOpenMM> > >*) ccmaMatrix;
+    pthread_mutex_destroy(&lock);
+}
+
+void ReferencePlatform::SharedData::addReference() {
+    pthread_mutex_lock(&lock);
+    referenceCount++;
+    pthread_mutex_unlock(&lock);
+}
+
+bool ReferencePlatform::SharedData::removeReference() {
+    pthread_mutex_lock(&lock);
+    bool isLast = (--referenceCount == 0);
+    pthread_mutex_unlock(&lock);
+    return isLast;
 }
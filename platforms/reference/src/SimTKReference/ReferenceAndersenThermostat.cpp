@@ -58,24 +58,25 @@ using OpenMM::RealVec;
          @param temperature        thermostat temperature in Kelvin
          @param collisionFrequency collision frequency for each atom in fs^-1
          @param stepSize           integration step size in fs
+         @param random             the random number generator to use
                   
          --------------------------------------------------------------------------------------- */
           
       void ReferenceAndersenThermostat::applyThermostat( const vector<vector<int> >& atomGroups, vector<RealVec>& atomVelocities, vector<RealOpenMM>& atomMasses,
-              RealOpenMM temperature, RealOpenMM collisionFrequency, RealOpenMM stepSize ) const {
+              RealOpenMM temperature, RealOpenMM collisionFrequency, RealOpenMM stepSize, OpenMM::ReferenceRandomStreams& random ) const {
           
           const RealOpenMM collisionProbability = 1.0f - EXP(-collisionFrequency*stepSize);
           for (int i = 0; i < (int) atomGroups.size(); ++i) {
-              if (SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber() < collisionProbability) {
+              if (random.getUniformlyDistributedRandomNumber() < collisionProbability) {
                   
                   // A collision occurred, so set the velocities to new values chosen from a Boltzmann distribution.
 
                   for (int j = 0; j < (int) atomGroups[i].size(); j++) {
                       int atom = atomGroups[i][j];
                       const RealOpenMM velocityScale = static_cast<RealOpenMM>(sqrt(BOLTZ*temperature/atomMasses[atom]));
-                      atomVelocities[atom][0] = velocityScale*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                      atomVelocities[atom][1] = velocityScale*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                      atomVelocities[atom][2] = velocityScale*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+                      atomVelocities[atom][0] = velocityScale*random.getNormallyDistributedRandomNumber();
+                      atomVelocities[atom][1] = velocityScale*random.getNormallyDistributedRandomNumber();
+                      atomVelocities[atom][2] = velocityScale*random.getNormallyDistributedRandomNumber();
                   }
               }
           }
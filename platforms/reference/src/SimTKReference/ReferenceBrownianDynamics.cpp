@@ -154,10 +154,12 @@ void ReferenceBrownianDynamics::update(const OpenMM::System& system, vector<Real
    
    const RealOpenMM noiseAmplitude = static_cast<RealOpenMM>( sqrt(2.0*BOLTZ*getTemperature()*getDeltaT()/getFriction()) );
    const RealOpenMM forceScale = getDeltaT()/getFriction();
+   vector<RealOpenMM> noise(3*numberOfAtoms);
+   getRandomNumberGenerator()->fillNormallyDistributedRandomNumbers(&noise[0], 3*numberOfAtoms);
    for (int i = 0; i < numberOfAtoms; ++i) {
        if (masses[i] != zero)
            for (int j = 0; j < 3; ++j) {
-               xPrime[i][j] = atomCoordinates[i][j] + forceScale*inverseMasses[i]*forces[i][j] + noiseAmplitude*SQRT(inverseMasses[i])*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+               xPrime[i][j] = atomCoordinates[i][j] + forceScale*inverseMasses[i]*forces[i][j] + noiseAmplitude*SQRT(inverseMasses[i])*noise[3*i+j];
            }
    }
    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
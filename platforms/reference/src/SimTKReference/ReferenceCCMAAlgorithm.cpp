@@ -77,22 +77,7 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm( int numberOfAtoms,
 
    // ---------------------------------------------------------------------------------------
 
-   _numberOfConstraints        = numberOfConstraints;
-   _atomIndices                = atomIndices;
-   _distance                   = distance;
-
-   _maximumNumberOfIterations  = 150;
-   _tolerance                  = tolerance;
-   _hasInitializedMasses       = false;
-
-   // work arrays
-
-   if (_numberOfConstraints > 0) {
-       _r_ij.resize(numberOfConstraints);
-       _d_ij2                      = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "dij_2" );
-       _distanceTolerance          = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "distanceTolerance" );
-       _reducedMasses              = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "reducedMasses" );
-   }
+   initialize( numberOfConstraints, atomIndices, distance, tolerance );
    if (numberOfConstraints > 0)
    {
        // Compute the constraint coupling matrix
@@ -208,6 +193,60 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm( int numberOfAtoms,
    }
 }
 
+/**---------------------------------------------------------------------------------------
+
+   ReferenceCCMAAlgorithm constructor, using a precomputed coupling matrix
+
+         @param numberOfAtoms    number of atoms
+         @param numberOfConstraints      number of constraints
+         @param atomIndices              atom indices for contraints
+         @param distance                 distances for constraints
+         @param matrix                   inverse constraint coupling matrix
+         @param tolerance                constraint tolerance
+
+   --------------------------------------------------------------------------------------- */
+
+ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm( int numberOfAtoms,
+                                                  int numberOfConstraints,
+                                                  const vector<pair<int, int> >& atomIndices,
+                                                  const vector<RealOpenMM>& distance,
+                                                  const vector<vector<pair<int, RealOpenMM> > >& matrix,
+                                                  RealOpenMM tolerance){
+   initialize( numberOfConstraints, atomIndices, distance, tolerance );
+   _matrix = matrix;
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Record the constraints and allocate work arrays (shared by both constructors)
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceCCMAAlgorithm::initialize( int numberOfConstraints,
+                                         const vector<pair<int, int> >& atomIndices,
+                                         const vector<RealOpenMM>& distance,
+                                         RealOpenMM tolerance ){
+
+   static const RealOpenMM zero        =  0.0;
+
+   _numberOfConstraints        = numberOfConstraints;
+   _atomIndices                = atomIndices;
+   _distance                   = distance;
+
+   _maximumNumberOfIterations  = 150;
+   _tolerance                  = tolerance;
+   _hasInitializedMasses       = false;
+
+   // work arrays
+
+   if (_numberOfConstraints > 0) {
+       _r_ij.resize(numberOfConstraints);
+       _d_ij2                      = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "dij_2" );
+       _distanceTolerance          = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "distanceTolerance" );
+       _reducedMasses              = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray( numberOfConstraints, NULL, 1, zero, "reducedMasses" );
+   }
+}
+
 /**---------------------------------------------------------------------------------------
 
    ReferenceCCMAAlgorithm destructor
@@ -305,6 +344,18 @@ RealOpenMM ReferenceCCMAAlgorithm::getTolerance( void ) const {
    return _tolerance;
 }
 
+/**---------------------------------------------------------------------------------------
+
+   Get the inverse constraint coupling matrix
+
+   @return matrix
+
+   --------------------------------------------------------------------------------------- */
+
+const vector<vector<pair<int, RealOpenMM> > >& ReferenceCCMAAlgorithm::getMatrix( void ) const {
+   return _matrix;
+}
+
 /**---------------------------------------------------------------------------------------
 
    Set tolerance
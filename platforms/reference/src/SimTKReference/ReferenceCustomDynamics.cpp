@@ -30,6 +30,7 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/ForceImpl.h"
+#include "lepton/ExpressionProgram.h"
 #include "lepton/Operation.h"
 #include "lepton/ParsedExpression.h"
 #include "lepton/Parser.h"
@@ -54,20 +55,14 @@ ReferenceCustomDynamics::ReferenceCustomDynamics(int numberOfAtoms, const Custom
     oldPos.resize(numberOfAtoms);
     stepType.resize(integrator.getNumComputations());
     stepVariable.resize(integrator.getNumComputations());
-    stepExpression.resize(integrator.getNumComputations());
+    stepParsedExpression.resize(integrator.getNumComputations());
     for (int i = 0; i < integrator.getNumComputations(); i++) {
         string expression;
         integrator.getComputationStep(i, stepType[i], stepVariable[i], expression);
         if (expression.length() > 0)
-            stepExpression[i] = Lepton::Parser::parse(expression).optimize().createProgram();
-    }
-    kineticEnergyExpression = Lepton::Parser::parse(integrator.getKineticEnergyExpression()).optimize().createProgram();
-    kineticEnergyNeedsForce = false;
-    for (int i = 0; i < kineticEnergyExpression.getNumOperations(); i++) {
-        const Lepton::Operation& op = kineticEnergyExpression.getOperation(i);
-        if (op.getId() == Lepton::Operation::VARIABLE && op.getName() == "f")
-            kineticEnergyNeedsForce = true;
+            stepParsedExpression[i] = Lepton::Parser::parse(expression).optimize();
     }
+    perDofValues.resize(integrator.getNumPerDofVariables());
 }
 
 /**---------------------------------------------------------------------------------------
@@ -79,6 +74,205 @@ ReferenceCustomDynamics::ReferenceCustomDynamics(int numberOfAtoms, const Custom
 ReferenceCustomDynamics::~ReferenceCustomDynamics() {
 }
 
+/**---------------------------------------------------------------------------------------
+
+   Analyze the integrator the first time it is used: work out when forces and energies
+   need to be computed, assign a storage slot to every global variable, and compile
+   every expression so that it reads its variables from those slots rather than
+   looking them up by name.
+
+   @param context             the context this integrator is updating
+   @param masses              atom masses
+   @param globals             a map containing values of global variables
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceCustomDynamics::initialize(ContextImpl& context, vector<RealOpenMM>& masses, map<string, RealOpenMM>& globals) {
+    int numSteps = stepType.size();
+    int numberOfAtoms = masses.size();
+
+    // Work out when to recompute forces and energy.  First build a list of every step that invalidates the forces.
+
+    invalidatesForces.resize(numSteps, false);
+    needsForces.resize(numSteps, false);
+    needsEnergy.resize(numSteps, false);
+    forceGroup.resize(numSteps, -2);
+    forceName.resize(numSteps, "f");
+    energyName.resize(numSteps, "energy");
+    set<string> affectsForce;
+    affectsForce.insert("x");
+    for (vector<ForceImpl*>::const_iterator iter = context.getForceImpls().begin(); iter != context.getForceImpls().end(); ++iter) {
+        const map<string, double> params = (*iter)->getDefaultParameters();
+        for (map<string, double>::const_iterator param = params.begin(); param != params.end(); ++param)
+            affectsForce.insert(param->first);
+    }
+    for (int i = 0; i < numSteps; i++)
+        invalidatesForces[i] = (stepType[i] == CustomIntegrator::ConstrainPositions || affectsForce.find(stepVariable[i]) != affectsForce.end());
+
+    // Make a list of which steps require valid forces or energy to be known.
+
+    vector<string> forceGroupName;
+    vector<string> energyGroupName;
+    for (int i = 0; i < 32; i++) {
+        stringstream fname;
+        fname << "f" << i;
+        forceGroupName.push_back(fname.str());
+        stringstream ename;
+        ename << "energy" << i;
+        energyGroupName.push_back(ename.str());
+    }
+    for (int i = 0; i < numSteps; i++) {
+        if (stepType[i] == CustomIntegrator::ComputeGlobal || stepType[i] == CustomIntegrator::ComputePerDof || stepType[i] == CustomIntegrator::ComputeSum) {
+            Lepton::ExpressionProgram program = stepParsedExpression[i].createProgram();
+            for (int j = 0; j < program.getNumOperations(); j++) {
+                const Lepton::Operation& op = program.getOperation(j);
+                if (op.getId() == Lepton::Operation::VARIABLE) {
+                    if (op.getName() == "energy") {
+                        if (forceGroup[i] != -2)
+                            throw OpenMMException("A single computation step cannot depend on multiple force groups");
+                        needsEnergy[i] = true;
+                        forceGroup[i] = -1;
+                    }
+                    else if (op.getName().substr(0, 6) == "energy") {
+                        for (int k = 0; k < (int) energyGroupName.size(); k++)
+                            if (op.getName() == energyGroupName[k]) {
+                                if (forceGroup[i] != -2)
+                                    throw OpenMMException("A single computation step cannot depend on multiple force groups");
+                                needsForces[i] = true;
+                                forceGroup[i] = 1<<k;
+                                energyName[i] = energyGroupName[k];
+                                break;
+                            }
+                    }
+                    else if (op.getName() == "f") {
+                        if (forceGroup[i] != -2)
+                            throw OpenMMException("A single computation step cannot depend on multiple force groups");
+                        needsForces[i] = true;
+                        forceGroup[i] = -1;
+                    }
+                    else if (op.getName()[0] == 'f') {
+                        for (int k = 0; k < (int) forceGroupName.size(); k++)
+                            if (op.getName() == forceGroupName[k]) {
+                                if (forceGroup[i] != -2)
+                                    throw OpenMMException("A single computation step cannot depend on multiple force groups");
+                                needsForces[i] = true;
+                                forceGroup[i] = 1<<k;
+                                forceName[i] = forceGroupName[k];
+                                break;
+                            }
+                    }
+                }
+            }
+        }
+    }
+
+    // Assign a slot to every global value: the integrator's own variables, the context parameters,
+    // the energies, and any other variable a global step assigns to.
+
+    globalNames.clear();
+    globalIndex.clear();
+    for (map<string, RealOpenMM>::const_iterator iter = globals.begin(); iter != globals.end(); ++iter)
+        globalNames.push_back(iter->first);
+    globalNames.push_back("energy");
+    for (int i = 0; i < (int) energyGroupName.size(); i++)
+        globalNames.push_back(energyGroupName[i]);
+    for (int i = 0; i < numSteps; i++)
+        if (stepType[i] == CustomIntegrator::ComputeGlobal || stepType[i] == CustomIntegrator::ComputeSum)
+            globalNames.push_back(stepVariable[i]);
+    for (int i = 0; i < (int) globalNames.size(); i++)
+        if (globalIndex.find(globalNames[i]) == globalIndex.end()) {
+            int index = globalIndex.size();
+            globalIndex[globalNames[i]] = index;
+        }
+    globalNames.resize(globalIndex.size());
+    for (map<string, int>::const_iterator iter = globalIndex.begin(); iter != globalIndex.end(); ++iter)
+        globalNames[iter->second] = iter->first;
+    globalValues.resize(globalNames.size(), 0.0);
+    parameterIndex.clear();
+    for (map<string, double>::const_iterator iter = context.getParameters().begin(); iter != context.getParameters().end(); ++iter)
+        parameterIndex.push_back(globalIndex[iter->first]);
+
+    // Compile the expressions.
+
+    stepExpression.resize(numSteps);
+    stepTarget.resize(numSteps, -1);
+    energyIndex.resize(numSteps);
+    stepNeedsUniform.resize(numSteps, false);
+    stepNeedsGaussian.resize(numSteps, false);
+    stepPerDofVariables.resize(numSteps);
+    for (int i = 0; i < numSteps; i++) {
+        energyIndex[i] = globalIndex[energyName[i]];
+        if (stepType[i] == CustomIntegrator::ComputeGlobal || stepType[i] == CustomIntegrator::ComputePerDof || stepType[i] == CustomIntegrator::ComputeSum) {
+            bool needsUniform, needsGaussian;
+            stepExpression[i] = compileExpression(stepParsedExpression[i], stepType[i] != CustomIntegrator::ComputeGlobal, forceName[i],
+                    needsUniform, needsGaussian, stepPerDofVariables[i]);
+            stepNeedsUniform[i] = needsUniform;
+            stepNeedsGaussian[i] = needsGaussian;
+        }
+        if (stepType[i] == CustomIntegrator::ComputeGlobal || stepType[i] == CustomIntegrator::ComputeSum)
+            stepTarget[i] = globalIndex[stepVariable[i]];
+    }
+    Lepton::ParsedExpression kineticEnergy = Lepton::Parser::parse(integrator.getKineticEnergyExpression()).optimize();
+    kineticEnergyExpression = compileExpression(kineticEnergy, true, "f", kineticEnergyNeedsUniform, kineticEnergyNeedsGaussian, kineticEnergyPerDofVariables);
+    kineticEnergyNeedsForce = (kineticEnergyExpression.getVariables().find("f") != kineticEnergyExpression.getVariables().end());
+
+    // Build the list of inverse masses.
+
+    inverseMasses.resize(numberOfAtoms);
+    for (int i = 0; i < numberOfAtoms; i++) {
+        if (masses[i] == 0.0)
+            inverseMasses[i] = 0.0;
+        else
+            inverseMasses[i] = 1.0/masses[i];
+    }
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Compile an expression, binding each variable it uses to the slot holding its value.
+
+   @param expression          the expression to compile
+   @param isPerDof            whether the expression is evaluated once for every degree of freedom
+   @param forceName           the name by which the expression refers to the force
+   @param needsUniform        on exit, whether the expression uses a uniform random number
+   @param needsGaussian       on exit, whether the expression uses a Gaussian random number
+   @param perDofVariables     on exit, the indices of the per-DOF variables the expression uses
+
+   @return the compiled expression
+
+   --------------------------------------------------------------------------------------- */
+
+Lepton::CompiledExpression ReferenceCustomDynamics::compileExpression(const Lepton::ParsedExpression& expression, bool isPerDof, const string& forceName,
+        bool& needsUniform, bool& needsGaussian, vector<int>& perDofVariables) {
+    Lepton::CompiledExpression compiled = expression.createCompiledExpression();
+    map<string, double*> locations;
+    for (int i = 0; i < (int) globalNames.size(); i++)
+        locations[globalNames[i]] = &globalValues[i];
+    locations["uniform"] = &uniformValue;
+    locations["gaussian"] = &gaussianValue;
+    if (isPerDof) {
+        locations["x"] = &dofPosition;
+        locations["v"] = &dofVelocity;
+        locations["m"] = &dofMass;
+        locations[forceName] = &dofForce;
+        for (int i = 0; i < integrator.getNumPerDofVariables(); i++)
+            locations[integrator.getPerDofVariableName(i)] = &perDofValues[i];
+    }
+    const set<string>& variables = compiled.getVariables();
+    for (set<string>::const_iterator iter = variables.begin(); iter != variables.end(); ++iter)
+        if (locations.find(*iter) == locations.end())
+            throw OpenMMException("CustomIntegrator: Unknown variable '"+*iter+"' in expression");
+    compiled.setVariableLocations(locations);
+    needsUniform = (variables.find("uniform") != variables.end());
+    needsGaussian = (variables.find("gaussian") != variables.end());
+    perDofVariables.clear();
+    if (isPerDof)
+        for (int i = 0; i < integrator.getNumPerDofVariables(); i++)
+            if (variables.find(integrator.getPerDofVariableName(i)) != variables.end())
+                perDofVariables.push_back(i);
+    return compiled;
+}
+
 /**---------------------------------------------------------------------------------------
 
    Update -- driver routine for performing Custom dynamics update of coordinates
@@ -101,92 +295,9 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
     int numSteps = stepType.size();
     globals.insert(context.getParameters().begin(), context.getParameters().end());
     oldPos = atomCoordinates;
-    if (invalidatesForces.size() == 0) {
-        // The first time this is called, work out when to recompute forces and energy.  First build a
-        // list of every step that invalidates the forces.
-        
-        invalidatesForces.resize(numSteps, false);
-        needsForces.resize(numSteps, false);
-        needsEnergy.resize(numSteps, false);
-        forceGroup.resize(numSteps, -2);
-        forceName.resize(numSteps, "f");
-        energyName.resize(numSteps, "energy");
-        set<string> affectsForce;
-        affectsForce.insert("x");
-        for (vector<ForceImpl*>::const_iterator iter = context.getForceImpls().begin(); iter != context.getForceImpls().end(); ++iter) {
-            const map<string, double> params = (*iter)->getDefaultParameters();
-            for (map<string, double>::const_iterator param = params.begin(); param != params.end(); ++param)
-                affectsForce.insert(param->first);
-        }
-        for (int i = 0; i < numSteps; i++)
-            invalidatesForces[i] = (stepType[i] == CustomIntegrator::ConstrainPositions || affectsForce.find(stepVariable[i]) != affectsForce.end());
-        
-        // Make a list of which steps require valid forces or energy to be known.
-        
-        vector<string> forceGroupName;
-        vector<string> energyGroupName;
-        for (int i = 0; i < 32; i++) {
-            stringstream fname;
-            fname << "f" << i;
-            forceGroupName.push_back(fname.str());
-            stringstream ename;
-            ename << "energy" << i;
-            energyGroupName.push_back(ename.str());
-        }
-        for (int i = 0; i < numSteps; i++) {
-            if (stepType[i] == CustomIntegrator::ComputeGlobal || stepType[i] == CustomIntegrator::ComputePerDof || stepType[i] == CustomIntegrator::ComputeSum) {
-                for (int j = 0; j < stepExpression[i].getNumOperations(); j++) {
-                    const Lepton::Operation& op = stepExpression[i].getOperation(j);
-                    if (op.getId() == Lepton::Operation::VARIABLE) {
-                        if (op.getName() == "energy") {
-                            if (forceGroup[i] != -2)
-                                throw OpenMMException("A single computation step cannot depend on multiple force groups");
-                            needsEnergy[i] = true;
-                            forceGroup[i] = -1;
-                        }
-                        else if (op.getName().substr(0, 6) == "energy") {
-                            for (int k = 0; k < (int) energyGroupName.size(); k++)
-                                if (op.getName() == energyGroupName[k]) {
-                                    if (forceGroup[i] != -2)
-                                        throw OpenMMException("A single computation step cannot depend on multiple force groups");
-                                    needsForces[i] = true;
-                                    forceGroup[i] = 1<<k;
-                                    energyName[i] = energyGroupName[k];
-                                    break;
-                                }
-                        }
-                        else if (op.getName() == "f") {
-                            if (forceGroup[i] != -2)
-                                throw OpenMMException("A single computation step cannot depend on multiple force groups");
-                            needsForces[i] = true;
-                            forceGroup[i] = -1;
-                        }
-                        else if (op.getName()[0] == 'f') {
-                            for (int k = 0; k < (int) forceGroupName.size(); k++)
-                                if (op.getName() == forceGroupName[k]) {
-                                    if (forceGroup[i] != -2)
-                                        throw OpenMMException("A single computation step cannot depend on multiple force groups");
-                                    needsForces[i] = true;
-                                    forceGroup[i] = 1<<k;
-                                    forceName[i] = forceGroupName[k];
-                                    break;
-                                }
-                        }
-                    }
-                }
-            }
-        }
-        
-        // Build the list of inverse masses.
-        
-        inverseMasses.resize(numberOfAtoms);
-        for (int i = 0; i < numberOfAtoms; i++) {
-            if (masses[i] == 0.0)
-                inverseMasses[i] = 0.0;
-            else
-                inverseMasses[i] = 1.0/masses[i];
-        }
-    }
+    if (invalidatesForces.size() == 0)
+        initialize(context, masses, globals);
+    loadGlobals(globals);
     
     // Loop over steps and execute them.
     
@@ -208,22 +319,23 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
                 if (j == i-1)
                     break;
             }
-            recordChangedParameters(context, globals);
+            recordChangedParameters(context);
             RealOpenMM e = context.calcForcesAndEnergy(computeForce, computeEnergy, forceGroup[i]);
             if (computeEnergy)
                 energy = e;
             forcesAreValid = true;
         }
-        globals[energyName[i]] = energy;
+        globalValues[energyIndex[i]] = energy;
         
         // Execute the step.
         
         switch (stepType[i]) {
             case CustomIntegrator::ComputeGlobal: {
-                map<string, RealOpenMM> variables = globals;
-                variables["uniform"] = SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber();
-                variables["gaussian"] = SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                globals[stepVariable[i]] = stepExpression[i].evaluate(variables);
+                if (stepNeedsUniform[i])
+                    uniformValue = getRandomNumberGenerator()->getUniformlyDistributedRandomNumber();
+                if (stepNeedsGaussian[i])
+                    gaussianValue = getRandomNumberGenerator()->getNormallyDistributedRandomNumber();
+                globalValues[stepTarget[i]] = stepExpression[i].evaluate();
                 break;
             }
             case CustomIntegrator::ComputePerDof: {
@@ -239,16 +351,18 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
                 }
                 if (results == NULL)
                     throw OpenMMException("Illegal per-DOF output variable: "+stepVariable[i]);
-                computePerDof(numberOfAtoms, *results, atomCoordinates, velocities, forces, masses, globals, perDof, stepExpression[i], forceName[i]);
+                computePerDof(numberOfAtoms, *results, atomCoordinates, velocities, forces, masses, perDof, stepExpression[i],
+                        stepNeedsUniform[i], stepNeedsGaussian[i], stepPerDofVariables[i]);
                 break;
             }
             case CustomIntegrator::ComputeSum: {
-                computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, globals, perDof, stepExpression[i], forceName[i]);
+                computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, perDof, stepExpression[i],
+                        stepNeedsUniform[i], stepNeedsGaussian[i], stepPerDofVariables[i]);
                 RealOpenMM sum = 0.0;
                 for (int j = 0; j < numberOfAtoms; j++)
                     if (masses[j] != 0.0)
                         sum += sumBuffer[j][0]+sumBuffer[j][1]+sumBuffer[j][2];
-                globals[stepVariable[i]] = sum;
+                globalValues[stepTarget[i]] = sum;
                 break;
             }
             case CustomIntegrator::ConstrainPositions: {
@@ -261,9 +375,8 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
                 break;
             }
             case CustomIntegrator::UpdateContextState: {
-                recordChangedParameters(context, globals);
+                recordChangedParameters(context);
                 context.updateContextState();
-                globals.insert(context.getParameters().begin(), context.getParameters().end());
             }
         }
         if (invalidatesForces[i])
@@ -271,44 +384,72 @@ void ReferenceCustomDynamics::update(ContextImpl& context, int numberOfAtoms, ve
     }
     ReferenceVirtualSites::computePositions(context.getSystem(), atomCoordinates);
     incrementTimeStep();
-    recordChangedParameters(context, globals);
+    recordChangedParameters(context);
+    storeGlobals(globals);
 }
 
 void ReferenceCustomDynamics::computePerDof(int numberOfAtoms, vector<RealVec>& results, const vector<RealVec>& atomCoordinates,
               const vector<RealVec>& velocities, const vector<RealVec>& forces, const vector<RealOpenMM>& masses,
-              const map<string, RealOpenMM>& globals, const vector<vector<RealVec> >& perDof,
-              const Lepton::ExpressionProgram& expression, const std::string& forceName) {
-    // Loop over all degrees of freedom.
+              const vector<vector<RealVec> >& perDof, const Lepton::CompiledExpression& expression,
+              bool needsUniform, bool needsGaussian, const vector<int>& perDofVariables) {
+    // Loop over all degrees of freedom.  The expression reads its inputs directly from the
+    // dof* fields and per-DOF slots, so only the variables it actually uses need to be set.
     
-    map<string, RealOpenMM> variables = globals;
+    int numPerDofVariables = perDofVariables.size();
+    vector<RealOpenMM> gaussian;
+    if (needsGaussian) {
+        gaussian.resize(3*numberOfAtoms);
+        getRandomNumberGenerator()->fillNormallyDistributedRandomNumbers(&gaussian[0], 3*numberOfAtoms);
+    }
     for (int i = 0; i < numberOfAtoms; i++) {
         if (masses[i] != 0.0) {
-            variables["m"] = masses[i];
+            dofMass = masses[i];
             for (int j = 0; j < 3; j++) {
                 // Compute the expression.
 
-                variables["x"] = atomCoordinates[i][j];
-                variables["v"] = velocities[i][j];
-                variables[forceName] = forces[i][j];
-                variables["uniform"] = SimTKOpenMMUtilities::getUniformlyDistributedRandomNumber();
-                variables["gaussian"] = SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                for (int k = 0; k < (int) perDof.size(); k++)
-                    variables[integrator.getPerDofVariableName(k)] = perDof[k][i][j];
-                results[i][j] = expression.evaluate(variables);
+                dofPosition = atomCoordinates[i][j];
+                dofVelocity = velocities[i][j];
+                dofForce = forces[i][j];
+                if (needsUniform)
+                    uniformValue = getRandomNumberGenerator()->getUniformlyDistributedRandomNumber();
+                if (needsGaussian)
+                    gaussianValue = gaussian[3*i+j];
+                for (int k = 0; k < numPerDofVariables; k++)
+                    perDofValues[perDofVariables[k]] = perDof[perDofVariables[k]][i][j];
+                results[i][j] = expression.evaluate();
             }
         }
     }
 }
 
+/**
+ * Copy the values of global variables from a map into the slots the compiled expressions read from.
+ */
+void ReferenceCustomDynamics::loadGlobals(const map<string, RealOpenMM>& globals) {
+    for (int i = 0; i < (int) globalNames.size(); i++) {
+        map<string, RealOpenMM>::const_iterator iter = globals.find(globalNames[i]);
+        if (iter != globals.end())
+            globalValues[i] = iter->second;
+    }
+}
+
+/**
+ * Copy the values of global variables from their slots back into a map.
+ */
+void ReferenceCustomDynamics::storeGlobals(map<string, RealOpenMM>& globals) const {
+    for (int i = 0; i < (int) globalNames.size(); i++)
+        globals[globalNames[i]] = globalValues[i];
+}
+
 /**
  * Check which context parameters have changed and register them with the context.
  */
-void ReferenceCustomDynamics::recordChangedParameters(OpenMM::ContextImpl& context, std::map<std::string, RealOpenMM>& globals) {
-    for (map<string, double>::const_iterator iter = context.getParameters().begin(); iter != context.getParameters().end(); ++iter) {
-        string name = iter->first;
-        double value = globals[name];
+void ReferenceCustomDynamics::recordChangedParameters(OpenMM::ContextImpl& context) {
+    int index = 0;
+    for (map<string, double>::const_iterator iter = context.getParameters().begin(); iter != context.getParameters().end(); ++iter, ++index) {
+        double value = globalValues[parameterIndex[index]];
         if (value != iter->second)
-            context.setParameter(name, globals[name]);
+            context.setParameter(iter->first, value);
     }
 }
 
@@ -332,11 +473,15 @@ double ReferenceCustomDynamics::computeKineticEnergy(OpenMM::ContextImpl& contex
         std::vector<OpenMM::RealVec>& velocities, std::vector<OpenMM::RealVec>& forces, std::vector<RealOpenMM>& masses,
         std::map<std::string, RealOpenMM>& globals, std::vector<std::vector<OpenMM::RealVec> >& perDof, bool& forcesAreValid) {
     globals.insert(context.getParameters().begin(), context.getParameters().end());
+    if (invalidatesForces.size() == 0)
+        initialize(context, masses, globals);
+    loadGlobals(globals);
     if (kineticEnergyNeedsForce) {
         energy = context.calcForcesAndEnergy(true, true, -1);
         forcesAreValid = true;
     }
-    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, globals, perDof, kineticEnergyExpression, "f");
+    computePerDof(numberOfAtoms, sumBuffer, atomCoordinates, velocities, forces, masses, perDof, kineticEnergyExpression,
+            kineticEnergyNeedsUniform, kineticEnergyNeedsGaussian, kineticEnergyPerDofVariables);
     RealOpenMM sum = 0.0;
     for (int j = 0; j < numberOfAtoms; j++)
         if (masses[j] != 0.0)
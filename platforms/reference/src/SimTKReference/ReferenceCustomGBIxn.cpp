@@ -37,6 +37,7 @@ using std::string;
 using std::stringstream;
 using std::vector;
 using OpenMM::RealVec;
+using OpenMM::ReferenceExclusionList;
 
 /**---------------------------------------------------------------------------------------
 
@@ -136,7 +137,7 @@ ReferenceCustomGBIxn::~ReferenceCustomGBIxn( ){
   }
 
 void ReferenceCustomGBIxn::calculateIxn(int numberOfAtoms, vector<RealVec>& atomCoordinates, RealOpenMM** atomParameters,
-                                           const vector<set<int> >& exclusions, map<string, double>& globalParameters, vector<RealVec>& forces,
+                                           const ReferenceExclusionList& exclusions, map<string, double>& globalParameters, vector<RealVec>& forces,
                                            RealOpenMM* totalEnergy) const {
     // First calculate the computed values.
 
@@ -185,7 +186,7 @@ void ReferenceCustomGBIxn::calculateSingleParticleValue(int index, int numAtoms,
 }
 
 void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, vector<RealVec>& atomCoordinates, RealOpenMM** atomParameters,
-        vector<vector<RealOpenMM> >& values, const map<string, double>& globalParameters, const vector<set<int> >& exclusions, bool useExclusions) const {
+        vector<vector<RealOpenMM> >& values, const map<string, double>& globalParameters, const ReferenceExclusionList& exclusions, bool useExclusions) const {
     values[index].resize(numAtoms);
     for (int i = 0; i < numAtoms; i++)
         values[index][i] = (RealOpenMM) 0.0;
@@ -194,7 +195,7 @@ void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, v
 
         for (int i = 0; i < (int) neighborList->size(); i++) {
             OpenMM::AtomPair pair = (*neighborList)[i];
-            if (useExclusions && exclusions[pair.first].find(pair.second) != exclusions[pair.first].end())
+            if (useExclusions && exclusions.isExcluded(pair.first, pair.second))
                 continue;
             calculateOnePairValue(index, pair.first, pair.second, atomCoordinates, atomParameters, globalParameters, values);
             calculateOnePairValue(index, pair.second, pair.first, atomCoordinates, atomParameters, globalParameters, values);
@@ -205,7 +206,7 @@ void ReferenceCustomGBIxn::calculateParticlePairValue(int index, int numAtoms, v
 
         for (int i = 0; i < numAtoms; i++){
             for (int j = i+1; j < numAtoms; j++ ){
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairValue(index, i, j, atomCoordinates, atomParameters, globalParameters, values);
                 calculateOnePairValue(index, j, i, atomCoordinates, atomParameters, globalParameters, values);
@@ -260,14 +261,14 @@ void ReferenceCustomGBIxn::calculateSingleParticleEnergyTerm(int index, int numA
 }
 
 void ReferenceCustomGBIxn::calculateParticlePairEnergyTerm(int index, int numAtoms, vector<RealVec>& atomCoordinates, RealOpenMM** atomParameters,
-        const vector<vector<RealOpenMM> >& values, const map<string, double>& globalParameters, const vector<set<int> >& exclusions, bool useExclusions,
+        const vector<vector<RealOpenMM> >& values, const map<string, double>& globalParameters, const ReferenceExclusionList& exclusions, bool useExclusions,
         vector<RealVec>& forces, RealOpenMM* totalEnergy, vector<vector<RealOpenMM> >& dEdV) const {
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
         for (int i = 0; i < (int) neighborList->size(); i++) {
             OpenMM::AtomPair pair = (*neighborList)[i];
-            if (useExclusions && exclusions[pair.first].find(pair.second) != exclusions[pair.first].end())
+            if (useExclusions && exclusions.isExcluded(pair.first, pair.second))
                 continue;
             calculateOnePairEnergyTerm(index, pair.first, pair.second, atomCoordinates, atomParameters, globalParameters, values, forces, totalEnergy, dEdV);
         }
@@ -277,7 +278,7 @@ void ReferenceCustomGBIxn::calculateParticlePairEnergyTerm(int index, int numAto
 
         for (int i = 0; i < numAtoms; i++){
             for (int j = i+1; j < numAtoms; j++ ){
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
                 calculateOnePairEnergyTerm(index, i, j, atomCoordinates, atomParameters, globalParameters, values, forces, totalEnergy, dEdV);
            }
@@ -330,13 +331,13 @@ void ReferenceCustomGBIxn::calculateOnePairEnergyTerm(int index, int atom1, int
 
 void ReferenceCustomGBIxn::calculateChainRuleForces(int numAtoms, vector<RealVec>& atomCoordinates, RealOpenMM** atomParameters,
         const vector<vector<RealOpenMM> >& values, const map<string, double>& globalParameters,
-        const vector<set<int> >& exclusions, vector<RealVec>& forces, vector<vector<RealOpenMM> >& dEdV) const {
+        const ReferenceExclusionList& exclusions, vector<RealVec>& forces, vector<vector<RealOpenMM> >& dEdV) const {
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
         for (int i = 0; i < (int) neighborList->size(); i++) {
             OpenMM::AtomPair pair = (*neighborList)[i];
-            bool isExcluded = (exclusions[pair.first].find(pair.second) != exclusions[pair.first].end());
+            bool isExcluded = exclusions.isExcluded(pair.first, pair.second);
             calculateOnePairChainRule(pair.first, pair.second, atomCoordinates, atomParameters, globalParameters, values, forces, dEdV, isExcluded);
             calculateOnePairChainRule(pair.second, pair.first, atomCoordinates, atomParameters, globalParameters, values, forces, dEdV, isExcluded);
         }
@@ -346,7 +347,7 @@ void ReferenceCustomGBIxn::calculateChainRuleForces(int numAtoms, vector<RealVec
 
         for (int i = 0; i < numAtoms; i++){
             for (int j = i+1; j < numAtoms; j++ ){
-                bool isExcluded = (exclusions[i].find(j) != exclusions[i].end());
+                bool isExcluded = exclusions.isExcluded(i, j);
                 calculateOnePairChainRule(i, j, atomCoordinates, atomParameters, globalParameters, values, forces, dEdV, isExcluded);
                 calculateOnePairChainRule(j, i, atomCoordinates, atomParameters, globalParameters, values, forces, dEdV, isExcluded);
            }
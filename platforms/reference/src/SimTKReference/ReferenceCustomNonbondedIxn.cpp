@@ -36,6 +36,7 @@ using std::string;
 using std::stringstream;
 using std::vector;
 using OpenMM::RealVec;
+using OpenMM::ReferenceExclusionList;
 
 /**---------------------------------------------------------------------------------------
 
@@ -138,10 +139,7 @@ void ReferenceCustomNonbondedIxn::setUseSwitchingFunction( RealOpenMM distance )
    @param numberOfAtoms    number of atoms
    @param atomCoordinates  atom coordinates
    @param atomParameters   atom parameters                             atomParameters[atomIndex][paramterIndex]
-   @param exclusions       atom exclusion indices                      exclusions[atomIndex][atomToExcludeIndex]
-                           exclusions[atomIndex][0] = number of exclusions
-                           exclusions[atomIndex][1-no.] = atom indices of atoms to excluded from
-                           interacting w/ atom atomIndex
+   @param exclusions       the pairs of atoms that should not interact
    @param fixedParameters  non atom parameters (not currently used)
    @param globalParameters the values of global parameters
    @param forces           force array (forces added)
@@ -151,7 +149,7 @@ void ReferenceCustomNonbondedIxn::setUseSwitchingFunction( RealOpenMM distance )
    --------------------------------------------------------------------------------------- */
 
 void ReferenceCustomNonbondedIxn::calculatePairIxn( int numberOfAtoms, vector<RealVec>& atomCoordinates,
-                                             RealOpenMM** atomParameters, int** exclusions,
+                                             RealOpenMM** atomParameters, const ReferenceExclusionList& exclusions,
                                              RealOpenMM* fixedParameters, const map<string, double>& globalParameters, vector<RealVec>& forces,
                                              RealOpenMM* energyByAtom, RealOpenMM* totalEnergy ) const {
 
@@ -178,8 +176,9 @@ void ReferenceCustomNonbondedIxn::calculatePairIxn( int numberOfAtoms, vector<Re
 
           // set exclusions
 
-          for( int jj = 1; jj <= exclusions[ii][0]; jj++ ){
-             exclusionIndices[exclusions[ii][jj]] = ii;
+          const int* excluded = exclusions.getExclusions(ii);
+          for( int jj = 0; jj < exclusions.getNumExclusions(ii); jj++ ){
+             exclusionIndices[excluded[jj]] = ii;
           }
 
           // loop over atom pairs
@@ -61,6 +61,7 @@ ReferenceDynamics::ReferenceDynamics( int numberOfAtoms,  RealOpenMM deltaT, Rea
 
    _ownReferenceConstraint = false;
    _referenceConstraint    = NULL;
+   _randomStreams          = NULL;
 }
 
 /**---------------------------------------------------------------------------------------
@@ -264,3 +265,27 @@ void ReferenceDynamics::update(const OpenMM::System& system, vector<RealVec>& at
 
    // ---------------------------------------------------------------------------------------
 }
+
+/**---------------------------------------------------------------------------------------
+
+   Get the random number generator
+
+   @return the generator, or NULL if none has been set
+
+   --------------------------------------------------------------------------------------- */
+
+OpenMM::ReferenceRandomStreams* ReferenceDynamics::getRandomNumberGenerator( void ) const {
+   return _randomStreams;
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Set the random number generator
+
+   @param randomStreams  the random number generator for the Context being integrated
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceDynamics::setRandomNumberGenerator( OpenMM::ReferenceRandomStreams* randomStreams ){
+   _randomStreams = randomStreams;
+}
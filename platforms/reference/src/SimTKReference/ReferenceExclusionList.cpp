@@ -0,0 +1,84 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceExclusionList.h"
+
+using namespace OpenMM;
+using namespace std;
+
+ReferenceExclusionList::ReferenceExclusionList() : numParticles(0), offset(1, 0) {
+}
+
+ReferenceExclusionList::ReferenceExclusionList(int numParticles, const vector<pair<int, int> >& excludedPairs) {
+    vector<pair<int, int> > pairs;
+    pairs.reserve(2*excludedPairs.size());
+    for (int i = 0; i < (int) excludedPairs.size(); i++) {
+        pairs.push_back(excludedPairs[i]);
+        pairs.push_back(make_pair(excludedPairs[i].second, excludedPairs[i].first));
+    }
+    build(numParticles, pairs);
+}
+
+ReferenceExclusionList::ReferenceExclusionList(const vector<set<int> >& exclusions) {
+    vector<pair<int, int> > pairs;
+    for (int i = 0; i < (int) exclusions.size(); i++)
+        for (set<int>::const_iterator iter = exclusions[i].begin(); iter != exclusions[i].end(); ++iter) {
+            pairs.push_back(make_pair(i, *iter));
+            pairs.push_back(make_pair(*iter, i));
+        }
+    build(exclusions.size(), pairs);
+}
+
+void ReferenceExclusionList::build(int numParticles, vector<pair<int, int> >& pairs) {
+    this->numParticles = numParticles;
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+    offset.resize(numParticles+1);
+    index.clear();
+    index.reserve(pairs.size());
+    tile.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        tile[i] = 0;
+    int next = 0;
+    for (int i = 0; i < numParticles; i++) {
+        offset[i] = index.size();
+        for (; next < (int) pairs.size() && pairs[next].first == i; next++) {
+            int j = pairs[next].second;
+            if (j == i)
+                continue;
+            index.push_back(j);
+            int delta = j-i+TileHalfWidth;
+            if (delta >= 0 && delta < 2*TileHalfWidth)
+                tile[i] |= 1ULL<<delta;
+        }
+    }
+    offset[numParticles] = index.size();
+}
@@ -39,6 +39,7 @@
 
 using std::vector;
 using OpenMM::RealVec;
+using OpenMM::ReferenceExclusionList;
 
 /**---------------------------------------------------------------------------------------
 
@@ -169,10 +170,7 @@ void ReferenceLJCoulombIxn::setUseSwitchingFunction( RealOpenMM distance ) {
    @param numberOfAtoms    number of atoms
    @param atomCoordinates  atom coordinates
    @param atomParameters   atom parameters                             atomParameters[atomIndex][paramterIndex]
-   @param exclusions       atom exclusion indices                      exclusions[atomIndex][atomToExcludeIndex]
-                           exclusions[atomIndex][0] = number of exclusions
-                           exclusions[atomIndex][1-no.] = atom indices of atoms to excluded from
-                           interacting w/ atom atomIndex
+   @param exclusions       the pairs of atoms that should not interact
    @param fixedParameters  non atom parameters (not currently used)
    @param forces           force array (forces added)
    @param energyByAtom     atom energy
@@ -183,7 +181,7 @@ void ReferenceLJCoulombIxn::setUseSwitchingFunction( RealOpenMM distance ) {
    --------------------------------------------------------------------------------------- */
 
 void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<RealVec>& atomCoordinates,
-                                             RealOpenMM** atomParameters, int** exclusions,
+                                             RealOpenMM** atomParameters, const ReferenceExclusionList& exclusions,
                                              RealOpenMM* fixedParameters, vector<RealVec>& forces,
                                              RealOpenMM* energyByAtom, RealOpenMM* totalEnergy, bool includeDirect, bool includeReciprocal) const {
     typedef std::complex<RealOpenMM> d_complex;
@@ -423,10 +421,10 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<RealVec>
 
     RealOpenMM totalExclusionEnergy = 0.0f;
     for (int i = 0; i < numberOfAtoms; i++)
-        for (int j = 1; j <= exclusions[i][0]; j++)
-            if (exclusions[i][j] > i) {
+        for (int j = 0; j < exclusions.getNumExclusions(i); j++)
+            if (exclusions.getExclusions(i)[j] > i) {
                int ii = i;
-               int jj = exclusions[i][j];
+               int jj = exclusions.getExclusions(i)[j];
 
                RealOpenMM deltaR[2][ReferenceForce::LastDeltaRIndex];
                ReferenceForce::getDeltaR( atomCoordinates[jj], atomCoordinates[ii], deltaR[0] );
@@ -467,10 +465,7 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<RealVec>
    @param numberOfAtoms    number of atoms
    @param atomCoordinates  atom coordinates
    @param atomParameters   atom parameters                             atomParameters[atomIndex][paramterIndex]
-   @param exclusions       atom exclusion indices                      exclusions[atomIndex][atomToExcludeIndex]
-                           exclusions[atomIndex][0] = number of exclusions
-                           exclusions[atomIndex][1-no.] = atom indices of atoms to excluded from
-                           interacting w/ atom atomIndex
+   @param exclusions       the pairs of atoms that should not interact
    @param fixedParameters  non atom parameters (not currently used)
    @param forces           force array (forces added)
    @param energyByAtom     atom energy
@@ -481,7 +476,7 @@ void ReferenceLJCoulombIxn::calculateEwaldIxn(int numberOfAtoms, vector<RealVec>
    --------------------------------------------------------------------------------------- */
 
 void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<RealVec>& atomCoordinates,
-                                             RealOpenMM** atomParameters, int** exclusions,
+                                             RealOpenMM** atomParameters, const ReferenceExclusionList& exclusions,
                                              RealOpenMM* fixedParameters, vector<RealVec>& forces,
                                              RealOpenMM* energyByAtom, RealOpenMM* totalEnergy, bool includeDirect, bool includeReciprocal) const {
 
@@ -510,8 +505,9 @@ void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<RealVec>&
 
           // set exclusions
 
-          for( int jj = 1; jj <= exclusions[ii][0]; jj++ ){
-             exclusionIndices[exclusions[ii][jj]] = ii;
+          const int* excluded = exclusions.getExclusions(ii);
+          for( int jj = 0; jj < exclusions.getNumExclusions(ii); jj++ ){
+             exclusionIndices[excluded[jj]] = ii;
           }
 
           // loop over atom pairs
@@ -528,6 +524,28 @@ void ReferenceLJCoulombIxn::calculatePairIxn(int numberOfAtoms, vector<RealVec>&
    }
 }
 
+  /**---------------------------------------------------------------------------------------
+
+     Calculate LJ Coulomb ixn for an explicit list of atom pairs.  Exclusions are not
+     checked, and if a cutoff is used every pair is assumed to be inside it.  Ewald and
+     PME are not supported.
+
+     @param pairs            the pairs of atoms to compute interactions between
+     @param atomCoordinates  atom coordinates
+     @param atomParameters   atom parameters (charges, c6, c12, ...)     atomParameters[atomIndex][paramterIndex]
+     @param forces           force array (forces added)
+     @param totalEnergy      total energy
+
+     --------------------------------------------------------------------------------------- */
+
+void ReferenceLJCoulombIxn::calculatePairListIxn(const OpenMM::NeighborList& pairs, vector<RealVec>& atomCoordinates,
+                                                 RealOpenMM** atomParameters, vector<RealVec>& forces,
+                                                 RealOpenMM* totalEnergy) const {
+   assert(!ewald && !pme);
+   for (int i = 0; i < (int) pairs.size(); i++)
+       calculateOneIxn(pairs[i].first, pairs[i].second, atomCoordinates, atomParameters, forces, NULL, totalEnergy);
+}
+
   /**---------------------------------------------------------------------------------------
 
      Calculate LJ Coulomb pair ixn between two atoms
@@ -46,6 +46,22 @@ void OPENMM_EXPORT computeNeighborListNaive(
                               double minDistance,
                               bool reportSymmetricPairs
                              )
+{
+    computeNeighborListNaive(neighborList, nAtoms, atomLocations, ReferenceExclusionList(exclusions),
+            periodicBoxSize, usePeriodic, maxDistance, minDistance, reportSymmetricPairs);
+}
+
+void OPENMM_EXPORT computeNeighborListNaive(
+                              NeighborList& neighborList,
+                              int nAtoms,
+                              const AtomLocationList& atomLocations, 
+                              const ReferenceExclusionList& exclusions,
+                              const RealVec& periodicBoxSize,
+                              bool usePeriodic,
+                              double maxDistance,
+                              double minDistance,
+                              bool reportSymmetricPairs
+                             )
 {
     neighborList.clear();
     
@@ -58,7 +74,7 @@ void OPENMM_EXPORT computeNeighborListNaive(
         {
             double pairDistanceSquared = compPairDistanceSquared(atomLocations[atomI], atomLocations[atomJ], periodicBoxSize, usePeriodic);
             if ( (pairDistanceSquared <= maxDistanceSquared)  && (pairDistanceSquared >= minDistanceSquared))
-                if (exclusions[atomI].find(atomJ) == exclusions[atomI].end())
+                if (!exclusions.isExcluded(atomI, atomJ))
                 {
                     neighborList.push_back( AtomPair(atomI, atomJ) );
                     if (reportSymmetricPairs)
@@ -136,7 +152,7 @@ public:
     void getNeighbors(
             NeighborList& neighbors, 
             const VoxelItem& referencePoint, 
-            const vector<set<int> >& exclusions,
+            const ReferenceExclusionList& exclusions,
             bool reportSymmetricPairs,
             double maxDistance, 
             double minDistance) const 
@@ -191,7 +207,7 @@ public:
                         if (atomI == atomJ) continue;
                         
                         // Ignore exclusions.
-                        if (exclusions[atomI].find(atomJ) != exclusions[atomI].end()) continue;
+                        if (exclusions.isExcluded(atomI, atomJ)) continue;
                         
                         double dSquared = compPairDistanceSquared(locationI, locationJ, periodicBoxSize, usePeriodic);
                         if (dSquared > maxDistanceSquared) continue;
@@ -227,6 +243,22 @@ void OPENMM_EXPORT computeNeighborListVoxelHash(
                               double minDistance,
                               bool reportSymmetricPairs
                              )
+{
+    computeNeighborListVoxelHash(neighborList, nAtoms, atomLocations, ReferenceExclusionList(exclusions),
+            periodicBoxSize, usePeriodic, maxDistance, minDistance, reportSymmetricPairs);
+}
+
+void OPENMM_EXPORT computeNeighborListVoxelHash(
+                              NeighborList& neighborList,
+                              int nAtoms,
+                              const AtomLocationList& atomLocations, 
+                              const ReferenceExclusionList& exclusions,
+                              const RealVec& periodicBoxSize,
+                              bool usePeriodic,
+                              double maxDistance,
+                              double minDistance,
+                              bool reportSymmetricPairs
+                             )
 {
     neighborList.clear();
 
@@ -0,0 +1,194 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceRandomStreams.h"
+#include "openmm/internal/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace OpenMM_SFMT;
+using namespace std;
+
+const int ReferenceRandomStreams::BlockSize;
+
+/**
+ * All instances share one thread pool, which is created the first time it is needed.  A ThreadPool can only
+ * run one task at a time, so callers must hold sharedThreadsLock while using it.
+ */
+static ThreadPool* sharedThreads = NULL;
+static pthread_mutex_t sharedThreadsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * This acquires sharedThreadsLock on creation and releases it on destruction, so the lock is released
+ * even if a task throws an exception.
+ */
+class SharedThreadsLocker {
+public:
+    SharedThreadsLocker() {
+        pthread_mutex_lock(&sharedThreadsLock);
+    }
+    ~SharedThreadsLocker() {
+        pthread_mutex_unlock(&sharedThreadsLock);
+    }
+};
+
+class ReferenceRandomStreams::FillTask : public ThreadPool::Task {
+public:
+    FillTask(ReferenceRandomStreams& owner, RealOpenMM* values, int numValues, int numBlocks) :
+            owner(owner), values(values), numValues(numValues), numBlocks(numBlocks) {
+    }
+    void execute(ThreadPool& threads, int threadIndex) {
+        for (int block = threadIndex; block < numBlocks; block += threads.getNumThreads())
+            owner.fillBlock(values, numValues, block, *owner.threadStreams[threadIndex]);
+    }
+    ReferenceRandomStreams& owner;
+    RealOpenMM* values;
+    int numValues, numBlocks;
+};
+
+ReferenceRandomStreams::ReferenceRandomStreams() {
+    setRandomNumberSeed(0);
+}
+
+ReferenceRandomStreams::~ReferenceRandomStreams() {
+    for (int i = 0; i < (int) threadStreams.size(); i++)
+        delete threadStreams[i];
+}
+
+void ReferenceRandomStreams::setRandomNumberSeed(uint32_t seed) {
+    this->seed = seed;
+    numArrays = 0;
+    nextGaussianIsValid = false;
+    init_gen_rand(seed, sequential);
+}
+
+void ReferenceRandomStreams::fillBlock(RealOpenMM* values, int numValues, int block, SFMT& sfmt) {
+    int start = block*BlockSize;
+    int end = min(start+BlockSize, numValues);
+    uint32_t key[3] = {seed, numArrays, (uint32_t) block};
+    init_by_array(key, 3, sfmt);
+
+    // Draw all the uniform values first, then transform them in a separate loop.  The basic Box-Muller
+    // transformation is used rather than the polar form so the second loop has no branches and can be
+    // vectorized.  1-u is used as the radial deviate so it lies in (0, 1].
+
+    int numPairs = (end-start+1)/2;
+    vector<double> uniform(2*numPairs);
+    for (int i = 0; i < 2*numPairs; i++)
+        uniform[i] = genrand_real2(sfmt);
+    vector<RealOpenMM> gaussian(2*numPairs);
+    for (int i = 0; i < numPairs; i++) {
+        double r = sqrt(-2.0*log(1.0-uniform[2*i]));
+        double theta = 2.0*PI_M*uniform[2*i+1];
+        gaussian[2*i] = static_cast<RealOpenMM>(r*cos(theta));
+        gaussian[2*i+1] = static_cast<RealOpenMM>(r*sin(theta));
+    }
+    for (int i = start; i < end; i++)
+        values[i] = gaussian[i-start];
+}
+
+void ReferenceRandomStreams::fillNormallyDistributedRandomNumbers(RealOpenMM* values, int numValues) {
+    if (numValues <= 0)
+        return;
+    int numBlocks = (numValues+BlockSize-1)/BlockSize;
+    if (numBlocks > 1 && ThreadPool::getDefaultNumThreads() > 1) {
+        SharedThreadsLocker locker;
+        if (sharedThreads == NULL)
+            sharedThreads = new ThreadPool();
+        while ((int) threadStreams.size() < sharedThreads->getNumThreads())
+            threadStreams.push_back(new SFMT());
+        FillTask task(*this, values, numValues, numBlocks);
+        sharedThreads->execute(task);
+        sharedThreads->waitForThreads();
+    }
+    else {
+        if (threadStreams.size() == 0)
+            threadStreams.push_back(new SFMT());
+        for (int block = 0; block < numBlocks; block++)
+            fillBlock(values, numValues, block, *threadStreams[0]);
+    }
+    numArrays++;
+}
+
+RealOpenMM ReferenceRandomStreams::getNormallyDistributedRandomNumber() {
+    if (nextGaussianIsValid) {
+        nextGaussianIsValid = false;
+        return nextGaussian;
+    }
+
+    // Use the polar form of the Box-Muller transformation to generate two Gaussian random numbers.
+
+    RealOpenMM x, y, r2;
+    do {
+        x = static_cast<RealOpenMM>(2.0*genrand_real2(sequential)-1.0);
+        y = static_cast<RealOpenMM>(2.0*genrand_real2(sequential)-1.0);
+        r2 = x*x + y*y;
+    } while (r2 >= 1.0 || r2 == 0.0);
+    RealOpenMM multiplier = static_cast<RealOpenMM>(sqrt((-2.0*log(r2))/r2));
+    nextGaussian = y*multiplier;
+    nextGaussianIsValid = true;
+    return x*multiplier;
+}
+
+RealOpenMM ReferenceRandomStreams::getUniformlyDistributedRandomNumber() {
+    return static_cast<RealOpenMM>(genrand_real2(sequential));
+}
+
+void ReferenceRandomStreams::createCheckpoint(ostream& stream) {
+    stream.write((char*) &seed, sizeof(uint32_t));
+    stream.write((char*) &numArrays, sizeof(uint32_t));
+    stream.write((char*) &nextGaussianIsValid, sizeof(bool));
+    stream.write((char*) &nextGaussian, sizeof(RealOpenMM));
+    sequential.createCheckpoint(stream);
+}
+
+void ReferenceRandomStreams::loadCheckpoint(istream& stream) {
+    stream.read((char*) &seed, sizeof(uint32_t));
+    stream.read((char*) &numArrays, sizeof(uint32_t));
+    stream.read((char*) &nextGaussianIsValid, sizeof(bool));
+    stream.read((char*) &nextGaussian, sizeof(RealOpenMM));
+    sequential.loadCheckpoint(stream);
+}
+
+void ReferenceRandomStreams::loadLegacyCheckpoint(istream& stream) {
+    uint32_t legacySeed;
+    bool initialized;
+    stream.read((char*) &legacySeed, sizeof(uint32_t));
+    stream.read((char*) &initialized, sizeof(bool));
+    setRandomNumberSeed(legacySeed);
+    if (initialized) {
+        stream.read((char*) &nextGaussianIsValid, sizeof(bool));
+        stream.read((char*) &nextGaussian, sizeof(RealOpenMM));
+        sequential.loadCheckpoint(stream);
+    }
+}
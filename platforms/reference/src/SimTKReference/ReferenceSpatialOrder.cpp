@@ -0,0 +1,98 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2013 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceSpatialOrder.h"
+#include "hilbert.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+using namespace OpenMM;
+using namespace std;
+
+void ReferenceSpatialOrder::computeOrder(const vector<vector<int> >& molecules, const vector<RealVec>& positions,
+                                         const RealVec& periodicBoxSize, bool usePeriodic, vector<int>& order) {
+    int numMolecules = molecules.size();
+    int numParticles = positions.size();
+    order.clear();
+    if (numMolecules == 0)
+        return;
+
+    // Find the center of each molecule, translated into the periodic box if appropriate.
+
+    vector<RealVec> center(numMolecules);
+    RealVec minPos, maxPos;
+    for (int i = 0; i < numMolecules; i++) {
+        const vector<int>& atoms = molecules[i];
+        RealVec sum;
+        for (int j = 0; j < (int) atoms.size(); j++)
+            sum += positions[atoms[j]];
+        center[i] = sum*(1.0/max((int) atoms.size(), 1));
+        if (usePeriodic)
+            for (int k = 0; k < 3; k++)
+                center[i][k] -= floor(center[i][k]/periodicBoxSize[k])*periodicBoxSize[k];
+        for (int k = 0; k < 3; k++) {
+            if (i == 0 || center[i][k] < minPos[k])
+                minPos[k] = center[i][k];
+            if (i == 0 || center[i][k] > maxPos[k])
+                maxPos[k] = center[i][k];
+        }
+    }
+
+    // Assign each molecule to a bin along a Hilbert curve, then sort them by bin.
+
+    const int bitsPerDim = 10;
+    double range = max(max(maxPos[0]-minPos[0], maxPos[1]-minPos[1]), maxPos[2]-minPos[2]);
+    double invBinWidth = (range > 0.0 ? ((1<<bitsPerDim)-1)/range : 0.0);
+    vector<pair<bitmask_t, int> > molBins(numMolecules);
+    bitmask_t coords[3];
+    for (int i = 0; i < numMolecules; i++) {
+        for (int k = 0; k < 3; k++)
+            coords[k] = (bitmask_t) ((center[i][k]-minPos[k])*invBinWidth);
+        molBins[i] = make_pair(hilbert_c2i(3, bitsPerDim, coords), i);
+    }
+    sort(molBins.begin(), molBins.end());
+
+    // Build the list of particles, keeping the atoms of each molecule together.
+
+    order.reserve(numParticles);
+    for (int i = 0; i < numMolecules; i++) {
+        const vector<int>& atoms = molecules[molBins[i].second];
+        order.insert(order.end(), atoms.begin(), atoms.end());
+    }
+    if ((int) order.size() != numParticles) {
+        // The molecules do not cover every particle exactly once, so just use the original order.
+
+        order.resize(numParticles);
+        for (int i = 0; i < numParticles; i++)
+            order[i] = i;
+    }
+}
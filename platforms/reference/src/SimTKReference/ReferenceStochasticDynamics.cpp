@@ -144,11 +144,13 @@ void ReferenceStochasticDynamics::updatePart1( int numberOfAtoms, vector<RealVec
    const RealOpenMM kT = BOLTZ*getTemperature();
    const RealOpenMM noisescale = SQRT(2*kT/tau)*SQRT(0.5*(1-vscale*vscale)*tau);
 
+   vector<RealOpenMM> noise(3*numberOfAtoms);
+   getRandomNumberGenerator()->fillNormallyDistributedRandomNumbers(&noise[0], 3*numberOfAtoms);
    for (int ii = 0; ii < numberOfAtoms; ii++) {
        if (inverseMasses[ii] != 0.0) {
            RealOpenMM sqrtInvMass = SQRT(inverseMasses[ii]);
            for (int jj = 0; jj < 3; jj++) {
-               velocities[ii][jj]  = vscale*velocities[ii][jj] + fscale*inverseMasses[ii]*forces[ii][jj] + noisescale*sqrtInvMass*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+               velocities[ii][jj]  = vscale*velocities[ii][jj] + fscale*inverseMasses[ii]*forces[ii][jj] + noisescale*sqrtInvMass*noise[3*ii+jj];
            }
        }
    }
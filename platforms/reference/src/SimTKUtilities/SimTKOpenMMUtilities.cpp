@@ -34,6 +34,7 @@
 #include <cstdio>
 #include <string.h>
 #include <iostream>
+#include <vector>
 
 uint32_t SimTKOpenMMUtilities::_randomNumberSeed = 0;
 bool SimTKOpenMMUtilities::_randomInitialized = false;
@@ -308,6 +309,53 @@ RealOpenMM SimTKOpenMMUtilities::getNormallyDistributedRandomNumber( void ) {
     return x*multiplier;
 }
 
+/**---------------------------------------------------------------------------------------
+
+   Fill an array with normally distributed random numbers
+
+   @param values     on exit, contains the random values
+   @param numValues  the number of values to generate
+
+   --------------------------------------------------------------------------------------- */
+
+void SimTKOpenMMUtilities::fillNormallyDistributedRandomNumbers( RealOpenMM* values, int numValues ) {
+    if (numValues <= 0)
+        return;
+    int start = 0;
+    if (nextGaussianIsValid) {
+        values[start++] = nextGaussian;
+        nextGaussianIsValid = false;
+    }
+    if (!_randomInitialized) {
+        init_gen_rand(_randomNumberSeed, sfmt);
+        _randomInitialized = true;
+    }
+    int numPairs = (numValues-start+1)/2;
+    if (numPairs == 0)
+        return;
+
+    // Draw all the uniform values first, then transform them in a separate loop.  The basic Box-Muller
+    // transformation is used rather than the polar form so the second loop has no branches and can be
+    // vectorized.  1-u is used as the radial deviate so it lies in (0, 1].
+
+    std::vector<double> uniform(2*numPairs);
+    for (int i = 0; i < 2*numPairs; i++)
+        uniform[i] = genrand_real2(sfmt);
+    std::vector<RealOpenMM> gaussian(2*numPairs);
+    for (int i = 0; i < numPairs; i++) {
+        double r = sqrt(-2.0*log(1.0-uniform[2*i]));
+        double theta = 2.0*PI_M*uniform[2*i+1];
+        gaussian[2*i] = static_cast<RealOpenMM>(r*cos(theta));
+        gaussian[2*i+1] = static_cast<RealOpenMM>(r*sin(theta));
+    }
+    for (int i = start; i < numValues; i++)
+        values[i] = gaussian[i-start];
+    if ((numValues-start)%2 == 1) {
+        nextGaussian = gaussian[2*numPairs-1];
+        nextGaussianIsValid = true;
+    }
+}
+
 /**---------------------------------------------------------------------------------------
 
    Get uniformly distributed random number in the range [0, 1)
@@ -37,6 +37,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/AndersenThermostat.h"
 #include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
@@ -176,10 +177,110 @@ void testSetState() {
     }
 }
 
+void testClone() {
+    const int numMolecules = 10;
+    const double boxSize = 3.0;
+    const double temperature = 200.0;
+    ReferencePlatform platform;
+    System system;
+    system.addForce(new AndersenThermostat(temperature, 0.0));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    system.addForce(angles);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        // Add a water-like molecule with two constraints and a flexible angle.
+
+        int first = system.getNumParticles();
+        system.addParticle(16.0);
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        nonbonded->addParticle(-0.8, 0.3, 0.5);
+        nonbonded->addParticle(0.4, 0.1, 0.0);
+        nonbonded->addParticle(0.4, 0.1, 0.0);
+        nonbonded->addException(first, first+1, 0, 1, 0);
+        nonbonded->addException(first, first+2, 0, 1, 0);
+        nonbonded->addException(first+1, first+2, 0, 1, 0);
+        system.addConstraint(first, first+1, 0.1);
+        system.addConstraint(first, first+2, 0.1);
+        angles->addAngle(first+1, first, first+2, 1.8, 400.0);
+        Vec3 center(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(center);
+        positions.push_back(center+Vec3(0.1, 0, 0));
+        positions.push_back(center+Vec3(0.1*cos(1.8), 0.1*sin(1.8), 0));
+    }
+    VerletIntegrator integrator1(0.001);
+    Context* context1 = new Context(system, integrator1, platform);
+    context1->setPositions(positions);
+    context1->setPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    integrator1.step(10);
+
+    // Clone it and see if the state and forces are identical.
+
+    VerletIntegrator integrator2(0.001);
+    Context* context2 = context1->clone(integrator2);
+    ASSERT_EQUAL(&context1->getPlatform(), &context2->getPlatform());
+    int types = State::Positions | State::Velocities | State::Parameters | State::Forces | State::Energy;
+    State s1 = context1->getState(types);
+    State s2 = context2->getState(types);
+    compareStates(s1, s2);
+    ASSERT_EQUAL_TOL(s1.getPotentialEnergy(), s2.getPotentialEnergy(), TOL);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(s1.getForces()[i], s2.getForces()[i], TOL);
+
+    // Changing the clone should not affect the original.
+
+    integrator2.step(10);
+    context2->setParameter(AndersenThermostat::Temperature(), temperature+10);
+    State s3 = context1->getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s1, s3);
+
+    // Both should produce the same trajectory, and the clone should keep working after
+    // the original is deleted.
+
+    integrator1.step(10);
+    context2->setParameter(AndersenThermostat::Temperature(), temperature);
+    State s4 = context1->getState(State::Positions | State::Velocities | State::Parameters);
+    delete context1;
+    State s5 = context2->getState(State::Positions | State::Velocities | State::Parameters);
+    compareStates(s4, s5);
+    integrator2.step(10);
+    State s6 = context2->getState(State::Positions);
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 delta1 = s6.getPositions()[3*i+1]-s6.getPositions()[3*i];
+        Vec3 delta2 = s6.getPositions()[3*i+2]-s6.getPositions()[3*i];
+        ASSERT_EQUAL_TOL(0.1, sqrt(delta1.dot(delta1)), 1e-4);
+        ASSERT_EQUAL_TOL(0.1, sqrt(delta2.dot(delta2)), 1e-4);
+    }
+
+    // If the System is modified, a new clone should give exactly the same trajectory as a new Context,
+    // not reuse the constraint matrix computed for the old System.
+
+    system.setParticleMass(0, 8.0);
+    angles->setAngleParameters(0, 1, 0, 2, 1.6, 400.0);
+    VerletIntegrator integrator3(0.001), integrator4(0.001);
+    Context* context3 = context2->clone(integrator3);
+    Context context4(system, integrator4, platform);
+    context4.setState(context2->getState(State::Positions | State::Velocities | State::Parameters));
+    integrator3.step(10);
+    integrator4.step(10);
+    State s7 = context3->getState(State::Positions);
+    State s8 = context4.getState(State::Positions);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(s7.getPositions()[i], s8.getPositions()[i], 0.0);
+    delete context3;
+    delete context2;
+}
+
 int main() {
     try {
         testCheckpoint();
         testSetState();
+        testClone();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
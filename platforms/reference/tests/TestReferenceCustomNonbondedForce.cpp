@@ -40,8 +40,11 @@
 #include "ReferencePlatform.h"
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
+#include "openmm/internal/CustomNonbondedForceImpl.h"
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 
@@ -455,11 +458,16 @@ void testLongRangeCorrection() {
     context1.setPositions(positions);
     double standardEnergy2 = context1.getState(State::Energy).getPotentialEnergy();
 
-    // Compute the correction for the custom force.
+    // Compute the correction for the custom force.  The integrals are computed by a shared thread pool
+    // which is created the first time it is needed, so make sure it uses several threads.
 
+    static char threadsMany[] = "OPENMM_CPU_THREADS=3";
+    static char threadsDefault[] = "OPENMM_CPU_THREADS=";
+    putenv(threadsMany);
     Context context2(customSystem, integrator2, platform);
     context2.setPositions(positions);
     double customEnergy1 = context2.getState(State::Energy).getPotentialEnergy();
+    putenv(threadsDefault);
     customNonbonded->setUseLongRangeCorrection(false);
     context2.reinitialize();
     context2.setPositions(positions);
@@ -470,6 +478,149 @@ void testLongRangeCorrection() {
     ASSERT_EQUAL_TOL(standardEnergy1-standardEnergy2, customEnergy1-customEnergy2, 1e-4);
 }
 
+void testLongRangeCorrectionFailure() {
+    // An interaction that decays too slowly makes the integration fail on the shared thread pool.  The error
+    // must be reported every time, rather than leaving the pool locked so that later attempts hang.
+
+    System system;
+    CustomNonbondedForce* force = new CustomNonbondedForce("a1*a2/r");
+    force->addPerParticleParameter("a");
+    vector<double> params(1);
+    for (int i = 0; i < 4; i++) {
+        system.addParticle(1.0);
+        params[0] = 1.0+i;
+        force->addParticle(params);
+    }
+    force->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    force->setCutoffDistance(1.0);
+    force->setUseLongRangeCorrection(true);
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    system.addForce(force);
+    vector<Vec3> positions(4);
+    for (int i = 0; i < 4; i++)
+        positions[i] = Vec3(0.5*i, 0.3*i, 0);
+    ReferencePlatform platform;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        VerletIntegrator integrator(0.01);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        bool threwException = false;
+        try {
+            context.getState(State::Energy);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+    }
+}
+
+void testLongRangeCorrectionGlobalParameter() {
+    // The correction is proportional to a global scale factor, so changing the parameter back and
+    // forth (which reuses cached values) should scale it accordingly.
+
+    int numParticles = 20;
+    double boxSize = 3.0;
+    ReferencePlatform platform;
+    System system;
+    VerletIntegrator integrator(0.01);
+    CustomNonbondedForce* nonbonded = new CustomNonbondedForce("scale*4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    nonbonded->addPerParticleParameter("sigma");
+    nonbonded->addPerParticleParameter("eps");
+    nonbonded->addGlobalParameter("scale", 1.0);
+    vector<Vec3> positions(numParticles);
+    vector<double> params(2);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        params[0] = 0.2+0.02*(i%4);
+        params[1] = 0.5+0.1*(i%3);
+        nonbonded->addParticle(params);
+        positions[i] = Vec3(0.15*i, 0.3*(i%5), 0.4*(i%7));
+    }
+    nonbonded->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseLongRangeCorrection(true);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(nonbonded);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double energy1 = context.getState(State::Energy).getPotentialEnergy();
+    context.setParameter("scale", 2.0);
+    double energy2 = context.getState(State::Energy).getPotentialEnergy();
+    context.setParameter("scale", 1.0);
+    double energy3 = context.getState(State::Energy).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(2*energy1, energy2, 1e-10);
+    ASSERT_EQUAL_TOL(energy1, energy3, 1e-10);
+
+    // Use more values than can be cached, and make sure earlier values are still computed correctly
+    // once they have been discarded.
+
+    int numValues = CustomNonbondedForceImpl::LongRangeCorrection::MaxCachedParameterSets+10;
+    for (int i = 0; i < numValues; i++) {
+        double scale = 1.0+0.01*i;
+        context.setParameter("scale", scale);
+        ASSERT_EQUAL_TOL(scale*energy1, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    }
+    context.setParameter("scale", 2.0);
+    ASSERT_EQUAL_TOL(energy2, context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+}
+
+void testUpdateLongRangeCorrection() {
+    // Changing the parameters of a few particles should update the long range correction to match
+    // a newly created Context, including when a particle moves to a new class or a class becomes empty.
+
+    int numParticles = 20;
+    double boxSize = 3.0;
+    ReferencePlatform platform;
+    System system;
+    CustomNonbondedForce* nonbonded = new CustomNonbondedForce("scale*4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    nonbonded->addPerParticleParameter("sigma");
+    nonbonded->addPerParticleParameter("eps");
+    nonbonded->addGlobalParameter("scale", 1.0);
+    vector<Vec3> positions(numParticles);
+    vector<double> params(2);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        params[0] = (i == 0 ? 0.3 : 0.2+0.02*(i%4));
+        params[1] = (i == 0 ? 0.9 : 0.5+0.1*(i%3));
+        nonbonded->addParticle(params);
+        positions[i] = Vec3(0.15*i, 0.3*(i%5), 0.4*(i%7));
+    }
+    nonbonded->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseLongRangeCorrection(true);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+    for (int step = 0; step < 3; step++) {
+        if (step == 0) {
+            // Move the only particle in its class into a new class.
+
+            params[0] = 0.25;
+            params[1] = 0.7;
+            nonbonded->setParticleParameters(0, params);
+        }
+        else if (step == 1) {
+            // Move a few particles into existing classes.
+
+            nonbonded->getParticleParameters(2, params);
+            nonbonded->setParticleParameters(5, params);
+            nonbonded->setParticleParameters(9, params);
+        }
+        else
+            context.setParameter("scale", 1.5);
+        nonbonded->updateParametersInContext(context);
+        VerletIntegrator integrator2(0.01);
+        Context context2(system, integrator2, platform);
+        context2.setPositions(positions);
+        context2.setParameter("scale", context.getParameter("scale"));
+        ASSERT_EQUAL_TOL(context2.getState(State::Energy).getPotentialEnergy(), context.getState(State::Energy).getPotentialEnergy(), 1e-10);
+    }
+}
+
 int main() {
     try {
         testSimpleExpression();
@@ -481,6 +632,9 @@ int main() {
         testCoulombLennardJones();
         testSwitchingFunction();
         testLongRangeCorrection();
+        testLongRangeCorrectionGlobalParameter();
+        testLongRangeCorrectionFailure();
+        testUpdateLongRangeCorrection();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
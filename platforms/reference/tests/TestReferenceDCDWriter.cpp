@@ -0,0 +1,204 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the DCDWriter class, using the reference platform to supply the Context.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "ReferencePlatform.h"
+#include "openmm/DCDWriter.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Read a file into memory.
+ */
+vector<char> readFile(const string& filename) {
+    ifstream file(filename.c_str(), ios::in | ios::binary);
+    ASSERT(file.is_open());
+    return vector<char>((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+/**
+ * Read a little-endian value from a buffer.
+ */
+template <class T>
+T readValue(const vector<char>& data, int offset) {
+    T value;
+    char* bytes = reinterpret_cast<char*>(&value);
+    int one = 1;
+    bool littleEndian = (*reinterpret_cast<char*>(&one) == 1);
+    for (int i = 0; i < (int) sizeof(T); i++)
+        bytes[littleEndian ? i : sizeof(T)-1-i] = data[offset+i];
+    return value;
+}
+
+void testWriteFrames() {
+    const int numParticles = 10;
+    const int numFrames = 25;
+    const string filename = "TestReferenceDCDWriter.dcd";
+    vector<vector<Vec3> > positions(numFrames, vector<Vec3>(numParticles));
+    for (int i = 0; i < numFrames; i++)
+        for (int j = 0; j < numParticles; j++)
+            positions[i][j] = Vec3(0.1*i+j, 0.2*j-i, 0.01*i*j);
+    Vec3 a(2, 0, 0), b(0, 3, 0), c(0, 0, 4);
+    {
+        // After each flush, the header should already be complete.
+
+        DCDWriter writer(filename, numParticles, 0.002, 100, 5, true);
+        for (int i = 0; i < numFrames; i++) {
+            writer.writeFrame(positions[i], a, b, c);
+            if (i%5 == 0) {
+                writer.flush();
+                vector<char> data = readFile(filename);
+                ASSERT_EQUAL(i+1, readValue<int>(data, 8));
+            }
+        }
+        ASSERT_EQUAL(numFrames, writer.getNumFrames());
+        writer.flush();
+        vector<char> data = readFile(filename);
+        ASSERT_EQUAL(numFrames, readValue<int>(data, 8));
+    }
+
+    // Check the header.
+
+    vector<char> data = readFile(filename);
+    int headerSize = 100+160+16;
+    int frameSize = 56+3*(4*numParticles+8);
+    ASSERT_EQUAL(headerSize+numFrames*frameSize, data.size());
+    ASSERT_EQUAL(84, readValue<int>(data, 0));
+    ASSERT(strncmp(&data[4], "CORD", 4) == 0);
+    ASSERT_EQUAL(numFrames, readValue<int>(data, 8));
+    ASSERT_EQUAL(100, readValue<int>(data, 12));
+    ASSERT_EQUAL(5, readValue<int>(data, 16));
+    ASSERT_EQUAL(100+numFrames*5, readValue<int>(data, 20));
+    ASSERT_EQUAL_TOL(0.002/0.04888821, readValue<float>(data, 44), 1e-6);
+    ASSERT_EQUAL(1, readValue<int>(data, 48));
+    ASSERT(strncmp(&data[100], "Created by OpenMM", 17) == 0);
+    ASSERT_EQUAL(numParticles, readValue<int>(data, headerSize-8));
+
+    // Check the frames.
+
+    for (int i = 0; i < numFrames; i++) {
+        int offset = headerSize+i*frameSize;
+        ASSERT_EQUAL(48, readValue<int>(data, offset));
+        ASSERT_EQUAL_TOL(20.0, readValue<double>(data, offset+4), 1e-10);
+        ASSERT_EQUAL_TOL(30.0, readValue<double>(data, offset+20), 1e-10);
+        ASSERT_EQUAL_TOL(40.0, readValue<double>(data, offset+44), 1e-10);
+        offset += 56;
+        for (int axis = 0; axis < 3; axis++) {
+            ASSERT_EQUAL(4*numParticles, readValue<int>(data, offset));
+            for (int j = 0; j < numParticles; j++)
+                ASSERT_EQUAL_TOL(10*positions[i][j][axis], readValue<float>(data, offset+4+4*j), 1e-5);
+            offset += 4*numParticles+8;
+        }
+    }
+    remove(filename.c_str());
+}
+
+void testWriteFromContext() {
+    const int numParticles = 5;
+    const string filename = "TestReferenceDCDWriterContext.dcd";
+    ReferencePlatform platform;
+    System system;
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        positions[i] = Vec3(i, -0.5*i, 0.1);
+    }
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    {
+        DCDWriter writer(filename, numParticles, 0.001);
+        writer.writeFrame(context);
+
+        // Invalid positions should be rejected without affecting what has already been written.
+
+        vector<Vec3> invalid = positions;
+        invalid[2][1] = numeric_limits<double>::quiet_NaN();
+        Vec3 a, b, c;
+        context.getState(State::Positions).getPeriodicBoxVectors(a, b, c);
+        bool threwException = false;
+        try {
+            writer.writeFrame(invalid, a, b, c);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+        invalid[2][1] = numeric_limits<double>::infinity();
+        threwException = false;
+        try {
+            writer.writeFrame(invalid, a, b, c);
+        }
+        catch (const OpenMMException& ex) {
+            threwException = true;
+        }
+        ASSERT(threwException);
+        ASSERT_EQUAL(1, writer.getNumFrames());
+    }
+    vector<char> data = readFile(filename);
+    int headerSize = 100+160+16;
+    ASSERT_EQUAL(headerSize+3*(4*numParticles+8), data.size());
+    ASSERT_EQUAL(0, readValue<int>(data, 48));
+    ASSERT_EQUAL(1, readValue<int>(data, 8));
+    for (int axis = 0; axis < 3; axis++)
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_TOL(10*positions[i][axis], readValue<float>(data, headerSize+axis*(4*numParticles+8)+4+4*i), 1e-5);
+    remove(filename.c_str());
+}
+
+int main() {
+    try {
+        testWriteFrames();
+        testWriteFromContext();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
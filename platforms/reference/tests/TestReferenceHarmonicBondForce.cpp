@@ -37,6 +37,7 @@
 #include "openmm/Context.h"
 #include "ReferencePlatform.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
 #include "SimTKOpenMMRealType.h"
@@ -89,10 +90,56 @@ void testBonds() {
     }
 }
 
+void testAddBonds() {
+    // Adding bonds as arrays should give the same result as adding them one at a time.
+
+    System system;
+    vector<double> masses(3, 1.0);
+    ASSERT_EQUAL(0, system.addParticles(masses));
+    ASSERT_EQUAL(3, system.addParticles(masses));
+    ASSERT_EQUAL(6, system.getNumParticles());
+    HarmonicBondForce force;
+    force.reserveBonds(5);
+    force.addBond(0, 1, 1.0, 2.0);
+    vector<int> particles1, particles2;
+    vector<double> lengths, k;
+    for (int i = 1; i < 5; i++) {
+        particles1.push_back(i);
+        particles2.push_back(i+1);
+        lengths.push_back(1.0+0.1*i);
+        k.push_back(2.0+i);
+    }
+    ASSERT_EQUAL(1, force.addBonds(particles1, particles2, lengths, k));
+    ASSERT_EQUAL(5, force.getNumBonds());
+    for (int i = 0; i < 5; i++) {
+        int p1, p2;
+        double length, kValue;
+        force.getBondParameters(i, p1, p2, length, kValue);
+        ASSERT_EQUAL(i, p1);
+        ASSERT_EQUAL(i+1, p2);
+        ASSERT_EQUAL_TOL(1.0+0.1*i, length, 1e-10);
+        ASSERT_EQUAL_TOL(2.0+i, kValue, 1e-10);
+    }
+
+    // Arrays of different lengths should be rejected.
+
+    k.pop_back();
+    bool threwException = false;
+    try {
+        force.addBonds(particles1, particles2, lengths, k);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(5, force.getNumBonds());
+}
+
 int main() {
     try {
         cout << "Running test..." << endl;
         testBonds();
+        testAddBonds();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -110,11 +110,57 @@ void testPeriodic() {
     verifyNeighborList(neighborList, numParticles, particleList, periodicBoxSize, cutoff);
 }
 
+void testExclusions() {
+    // Build a set of exclusions that includes pairs both inside and outside the bitmask tiles,
+    // and make sure the exclusion list agrees with it.
+
+    const int numParticles = 200;
+    vector<set<int> > exclusions(numParticles);
+    vector<pair<int, int> > excludedPairs;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < 1000; i++) {
+        int particle1 = (int) (genrand_real2(sfmt)*numParticles);
+        int particle2 = (i%2 == 0 ? particle1+(int) (genrand_real2(sfmt)*10)-5 : (int) (genrand_real2(sfmt)*numParticles));
+        if (particle2 < 0 || particle2 >= numParticles || particle2 == particle1)
+            continue;
+        exclusions[particle1].insert(particle2);
+        exclusions[particle2].insert(particle1);
+        excludedPairs.push_back(make_pair(particle1, particle2));
+    }
+    ReferenceExclusionList list(numParticles, excludedPairs);
+    ASSERT_EQUAL(numParticles, list.getNumParticles());
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL((int) exclusions[i].size(), list.getNumExclusions(i));
+        int index = 0;
+        for (set<int>::const_iterator iter = exclusions[i].begin(); iter != exclusions[i].end(); ++iter)
+            ASSERT_EQUAL(*iter, list.getExclusions(i)[index++]);
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL(exclusions[i].find(j) != exclusions[i].end(), list.isExcluded(i, j));
+    }
+
+    // The neighbor list should skip exactly the excluded pairs.
+
+    vector<RealVec> particleList(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        particleList[i] = RealVec(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+    NeighborList neighborList;
+    RealVec boxSize;
+    computeNeighborListVoxelHash(neighborList, numParticles, particleList, list, boxSize, false, 2.0);
+    int numExcluded = 0;
+    for (int i = 0; i < numParticles; i++)
+        numExcluded += exclusions[i].size();
+    ASSERT_EQUAL(numParticles*(numParticles-1)/2-numExcluded/2, (int) neighborList.size());
+    for (int i = 0; i < (int) neighborList.size(); i++)
+        ASSERT(!list.isExcluded(neighborList[i].first, neighborList[i].second));
+}
+
 int main() 
 {
 try {
     testNeighborList();
     testPeriodic();
+    testExclusions();
     
     cout << "Test Passed" << endl;
     return 0;
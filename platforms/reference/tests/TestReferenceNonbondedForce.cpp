@@ -36,11 +36,16 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/Context.h"
 #include "ReferencePlatform.h"
+#include "openmm/CustomNonbondedForce.h"
 #include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
 #include "SimTKOpenMMRealType.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/ForceImpl.h"
+#include "RealVec.h"
 #include <iostream>
 #include <vector>
 
@@ -475,6 +480,350 @@ void testSwitchingFunction(NonbondedForce::NonbondedMethod method) {
     }
 }
 
+void testArrayParameters() {
+    // Particles and exceptions added as arrays should give the same energy as ones added individually.
+
+    ReferencePlatform platform;
+    const int numParticles = 6;
+    System system1, system2;
+    NonbondedForce* force1 = new NonbondedForce();
+    NonbondedForce* force2 = new NonbondedForce();
+    vector<double> charges, sigmas, epsilons;
+    for (int i = 0; i < numParticles; i++) {
+        system1.addParticle(1.0);
+        charges.push_back(0.1*(i%3)-0.1);
+        sigmas.push_back(0.2+0.01*i);
+        epsilons.push_back(0.5+0.1*i);
+        force1->addParticle(charges[i], sigmas[i], epsilons[i]);
+    }
+    system2.reserveParticles(numParticles);
+    system2.addParticles(vector<double>(numParticles, 1.0));
+    force2->reserveParticles(numParticles);
+    force2->addParticles(vector<double>(numParticles, 0.0), sigmas, epsilons);
+    force2->setAllParticleParameters(charges, sigmas, epsilons);
+    vector<int> particles1, particles2;
+    vector<double> chargeProds, exceptionSigmas, exceptionEpsilons;
+    for (int i = 0; i < numParticles-1; i++) {
+        force1->addException(i, i+1, 0.01*i, 0.3, 0.2*i);
+        particles1.push_back(i);
+        particles2.push_back(i+1);
+        chargeProds.push_back(0.01*i);
+        exceptionSigmas.push_back(0.3);
+        exceptionEpsilons.push_back(0.2*i);
+    }
+    force2->reserveExceptions(numParticles-1);
+    ASSERT_EQUAL(0, force2->addExceptions(particles1, particles2, chargeProds, exceptionSigmas, exceptionEpsilons));
+    ASSERT_EQUAL(numParticles-1, force2->getNumExceptions());
+    system1.addForce(force1);
+    system2.addForce(force2);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.3*i, 0.1*(i%2), -0.05*i);
+    VerletIntegrator integrator1(0.01), integrator2(0.01);
+    Context context1(system1, integrator1, platform);
+    Context context2(system2, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    ASSERT_EQUAL_TOL(context1.getState(State::Energy).getPotentialEnergy(), context2.getState(State::Energy).getPotentialEnergy(), TOL);
+
+    // Duplicate exceptions and wrongly sized arrays should be rejected.
+
+    bool threwException = false;
+    try {
+        force2->addExceptions(particles2, particles1, chargeProds, exceptionSigmas, exceptionEpsilons);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(numParticles-1, force2->getNumExceptions());
+
+    // A batch that contains the same pair twice should be rejected without adding any of it.
+
+    vector<int> newParticles1(3, 0), newParticles2(3, 2);
+    newParticles2[0] = numParticles-1;
+    vector<double> newValues(3, 0.1);
+    threwException = false;
+    try {
+        force2->addExceptions(newParticles1, newParticles2, newValues, newValues, newValues);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(numParticles-1, force2->getNumExceptions());
+    force2->addException(0, 2, 0.1, 0.1, 0.1);
+    charges.pop_back();
+    threwException = false;
+    try {
+        force2->setAllParticleParameters(charges, sigmas, epsilons);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void assertMatchesNewContext(const System& system, Context& context, const vector<Vec3>& positions) {
+    // Compare a Context whose parameters have been updated to one that is created from scratch.
+
+    ReferencePlatform platform;
+    VerletIntegrator integrator(0.01);
+    Context newContext(system, integrator, platform);
+    newContext.setPositions(positions);
+    State state1 = context.getState(State::Forces | State::Energy);
+    State state2 = newContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), TOL);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], TOL);
+}
+
+void testUpdateChangedParameters() {
+    // Create a periodic system with a dispersion correction and some 1-4 interactions.
+
+    const int gridSize = 4;
+    const int numParticles = gridSize*gridSize*gridSize;
+    const double boxSize = 2.4;
+    ReferencePlatform platform;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                int index = system.addParticle(1.0);
+                nonbonded->addParticle(index%2 == 0 ? 0.2 : -0.2, 0.3, 0.5);
+                positions.push_back(Vec3(i+0.1*sin(index), j+0.1*cos(index), k+0.1*sin(2*index))*(boxSize/gridSize));
+            }
+    for (int i = 0; i < numParticles-1; i += 2)
+        nonbonded->addException(i, i+1, (i%4 == 0 ? 0.0 : 0.02), 0.3, (i%4 == 0 ? 0.0 : 0.1));
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(nonbonded);
+    VerletIntegrator integrator1(0.01), integrator2(0.01);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.getState(State::Energy);
+    context2.getState(State::Energy);
+
+    // Change a few particles and exceptions, and update only the first Context.
+
+    nonbonded->setParticleParameters(3, 0.5, 0.35, 0.7);
+    nonbonded->setParticleParameters(17, -0.1, 0.3, 0.5);
+    nonbonded->setParticleParameters(3, 0.4, 0.25, 0.8);
+    nonbonded->setExceptionParameters(1, 2, 3, 0.05, 0.25, 0.2);
+    nonbonded->updateParametersInContext(context1);
+    assertMatchesNewContext(system, context1, positions);
+
+    // Make more changes.  The second Context has not seen either set of changes.
+
+    nonbonded->setParticleParameters(40, 0.3, 0.3, 0.5);
+    nonbonded->setExceptionParameters(3, 6, 7, 0.01, 0.3, 0.15);
+    nonbonded->updateParametersInContext(context1);
+    nonbonded->updateParametersInContext(context2);
+    assertMatchesNewContext(system, context1, positions);
+    assertMatchesNewContext(system, context2, positions);
+
+    // Make enough changes that the record of them is discarded.
+
+    for (int i = 0; i < 3*numParticles; i++)
+        nonbonded->setParticleParameters((7*i)%numParticles, 0.1*(i%3)-0.1, 0.3+0.01*(i%5), 0.5);
+    nonbonded->updateParametersInContext(context1);
+    assertMatchesNewContext(system, context1, positions);
+
+    // Change every particle at once.
+
+    vector<double> charges(numParticles), sigmas(numParticles), epsilons(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        charges[i] = (i%2 == 0 ? 0.3 : -0.3);
+        sigmas[i] = 0.32;
+        epsilons[i] = 0.4+0.01*(i%3);
+    }
+    nonbonded->setAllParticleParameters(charges, sigmas, epsilons);
+    nonbonded->updateParametersInContext(context1);
+    nonbonded->updateParametersInContext(context2);
+    assertMatchesNewContext(system, context1, positions);
+    assertMatchesNewContext(system, context2, positions);
+
+    // Turning an excluded pair into a 1-4 interaction changes the number of 1-4 interactions, which is not allowed.
+
+    nonbonded->setExceptionParameters(0, 0, 1, 0.1, 0.3, 0.1);
+    bool threwException = false;
+    try {
+        nonbonded->updateParametersInContext(context1);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+/**
+ * Compute only the interactions involving a subset of particles, and return the forces that were computed.
+ */
+bool calcSubsetForces(Context& context, const vector<int>& subset, double& energy, vector<Vec3>& forces) {
+    ContextImpl* contextImpl = *reinterpret_cast<ContextImpl**>(&context);
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(contextImpl->getPlatformData());
+    vector<RealVec>& forceData = *((vector<RealVec>*) data->forces);
+    for (int i = 0; i < (int) forceData.size(); i++)
+        forceData[i] = RealVec();
+    if (!contextImpl->getForceImpls()[0]->calcSubsetForcesAndEnergy(*contextImpl, subset, energy))
+        return false;
+    forces.resize(forceData.size());
+    for (int i = 0; i < (int) forceData.size(); i++)
+        forces[i] = Vec3(forceData[i][0], forceData[i][1], forceData[i][2]);
+    return true;
+}
+
+void testSubset(NonbondedForce::NonbondedMethod method) {
+    // Create a system with exclusions and 1-4 interactions.
+
+    const int numParticles = 40;
+    const double boxSize = 2.5;
+    ReferencePlatform platform;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.2+0.01*(i%4), 0.5);
+        positions.push_back(Vec3(boxSize*fabs(sin(1.1*i)), boxSize*fabs(cos(1.7*i)), boxSize*fabs(sin(2.3*i))));
+    }
+    for (int i = 0; i < numParticles-1; i += 3)
+        nonbonded->addException(i, i+1, (i%2 == 0 ? 0.0 : 0.05), 0.3, (i%2 == 0 ? 0.0 : 0.2));
+    nonbonded->setNonbondedMethod(method);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setUseDispersionCorrection(true);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(nonbonded);
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    vector<int> subset;
+    subset.push_back(0);
+    subset.push_back(4);
+    subset.push_back(9);
+    subset.push_back(21);
+    double subsetEnergy;
+    vector<Vec3> subsetForces;
+    if (method == NonbondedForce::Ewald || method == NonbondedForce::PME) {
+        ASSERT(!calcSubsetForces(context, subset, subsetEnergy, subsetForces));
+        return;
+    }
+
+    // Move the subset particles, first by small amounts and then by a large one.  The change in the subset
+    // energy should always equal the change in the full energy, and the subset forces on the subset particles
+    // should match the full forces.
+
+    State initialState = context.getState(State::Energy);
+    ASSERT(calcSubsetForces(context, subset, subsetEnergy, subsetForces));
+    double initialSubsetEnergy = subsetEnergy;
+    for (int step = 0; step < 4; step++) {
+        double displacement = (step < 3 ? 0.01 : 0.4);
+        for (int i = 0; i < (int) subset.size(); i++)
+            positions[subset[i]] += Vec3(displacement, -0.5*displacement, 0.3*displacement);
+        context.setPositions(positions);
+        State state = context.getState(State::Energy | State::Forces);
+        ASSERT(calcSubsetForces(context, subset, subsetEnergy, subsetForces));
+        double expected = state.getPotentialEnergy()-initialState.getPotentialEnergy();
+        ASSERT_EQUAL_TOL(expected, subsetEnergy-initialSubsetEnergy, 1e-5);
+        for (int i = 0; i < (int) subset.size(); i++)
+            ASSERT_EQUAL_VEC(state.getForces()[subset[i]], subsetForces[subset[i]], 1e-5);
+    }
+}
+
+void assertMatchesCustom(Context& context, Context& customContext) {
+    State state1 = context.getState(State::Positions | State::Forces | State::Energy);
+    customContext.setPositions(state1.getPositions());
+    State state2 = customContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state2.getPotentialEnergy(), state1.getPotentialEnergy(), TOL);
+    for (int i = 0; i < (int) state1.getForces().size(); i++)
+        ASSERT_EQUAL_VEC(state2.getForces()[i], state1.getForces()[i], TOL);
+}
+
+void testSortedOrder() {
+    // The cutoff kernel evaluates interactions on a spatially sorted copy of the particles.  Compare it to
+    // a CustomNonbondedForce computing the same reaction field interaction without sorting, over enough
+    // steps that the order is recomputed, and after updating parameters.
+
+    const int numMolecules = 60;
+    const double boxSize = 3.0;
+    const double cutoff = 1.0;
+    const double eps = 78.3;
+    ReferencePlatform platform;
+    System system, customSystem;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    CustomNonbondedForce* custom = new CustomNonbondedForce("138.935456*q1*q2*(1/r+krf*r^2-crf)+4*epsilon*((sigma/r)^12-(sigma/r)^6);"
+            "sigma=0.5*(sigma1+sigma2); epsilon=sqrt(epsilon1*epsilon2)");
+    custom->addPerParticleParameter("q");
+    custom->addPerParticleParameter("sigma");
+    custom->addPerParticleParameter("epsilon");
+    custom->addGlobalParameter("krf", (1.0/(cutoff*cutoff*cutoff))*(eps-1.0)/(2.0*eps+1.0));
+    custom->addGlobalParameter("crf", (1.0/cutoff)*(3.0*eps)/(2.0*eps+1.0));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicBondForce* customBonds = new HarmonicBondForce();
+    vector<Vec3> positions;
+    vector<double> params(3);
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 center(boxSize*fabs(sin(1.1*i)), boxSize*fabs(cos(1.7*i)), boxSize*fabs(sin(2.3*i)));
+        for (int j = 0; j < 2; j++) {
+            system.addParticle(1.0);
+            customSystem.addParticle(1.0);
+            params[0] = (j == 0 ? 0.2 : -0.2);
+            params[1] = 0.2;
+            params[2] = 0.1+0.05*(i%3);
+            nonbonded->addParticle(params[0], params[1], params[2]);
+            custom->addParticle(params);
+            positions.push_back(center+Vec3(0.1*j, 0, 0));
+        }
+        bonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+        customBonds->addBond(2*i, 2*i+1, 0.1, 1000.0);
+        nonbonded->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        custom->addExclusion(2*i, 2*i+1);
+    }
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(cutoff);
+    nonbonded->setReactionFieldDielectric(eps);
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(cutoff);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    customSystem.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    customSystem.addForce(custom);
+    customSystem.addForce(customBonds);
+    VerletIntegrator integrator(0.001), customIntegrator(0.001);
+    Context context(system, integrator, platform);
+    Context customContext(customSystem, customIntegrator, platform);
+    context.setPositions(positions);
+    assertMatchesCustom(context, customContext);
+
+    // Run past the point where the order is recomputed.
+
+    for (int i = 0; i < 3; i++) {
+        integrator.step(60);
+        assertMatchesCustom(context, customContext);
+    }
+
+    // Change the parameters after the order has been recomputed.
+
+    for (int i = 0; i < system.getNumParticles(); i += 5) {
+        params[0] = (i%2 == 0 ? 0.3 : -0.1);
+        params[1] = 0.25;
+        params[2] = 0.2;
+        nonbonded->setParticleParameters(i, params[0], params[1], params[2]);
+        custom->setParticleParameters(i, params);
+    }
+    nonbonded->updateParametersInContext(context);
+    custom->updateParametersInContext(customContext);
+    assertMatchesCustom(context, customContext);
+    integrator.step(60);
+    assertMatchesCustom(context, customContext);
+}
+
 int main() {
     try {
         testCoulomb();
@@ -486,6 +835,13 @@ int main() {
         testDispersionCorrection();
         testSwitchingFunction(NonbondedForce::CutoffNonPeriodic);
         testSwitchingFunction(NonbondedForce::PME);
+        testArrayParameters();
+        testUpdateChangedParameters();
+        testSortedOrder();
+        testSubset(NonbondedForce::NoCutoff);
+        testSubset(NonbondedForce::CutoffNonPeriodic);
+        testSubset(NonbondedForce::CutoffPeriodic);
+        testSubset(NonbondedForce::PME);
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -0,0 +1,357 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests Context::getPotentialEnergies(), the reuse of cached energies by Context::getState(), and
+ * the decomposition of energy by force group and by Force on the reference platform.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "ReferencePlatform.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const double TOL = 1e-5;
+
+void testMultipleParameterSets() {
+    const int numParticles = 20;
+    ReferencePlatform platform;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(1.5);
+    HarmonicBondForce* harmonic = new HarmonicBondForce();
+    harmonic->setForceGroup(1);
+    CustomBondForce* custom = new CustomBondForce("lambda*k*(r-r0)^2");
+    custom->addGlobalParameter("lambda", 1.0);
+    custom->addGlobalParameter("r0", 0.2);
+    custom->addPerBondParameter("k");
+    CustomExternalForce* external = new CustomExternalForce("scale*x^2");
+    external->addGlobalParameter("scale", 0.5);
+    vector<double> params(1);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.3 : -0.3, 0.2, 0.5);
+        external->addParticle(i, vector<double>());
+        if (i > 0) {
+            harmonic->addBond(i-1, i, 0.15, 100.0);
+            params[0] = 10.0*i;
+            custom->addBond(i-1, i, params);
+        }
+    }
+    system.addForce(nonbonded);
+    system.addForce(harmonic);
+    system.addForce(custom);
+    system.addForce(external);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.3*i, 0.5*genrand_real2(sfmt), 0.5*genrand_real2(sfmt));
+    context.setPositions(positions);
+
+    // Build a set of states, some of which only specify some of the parameters.
+
+    vector<map<string, double> > states(5);
+    states[0]["lambda"] = 0.0;
+    states[1]["lambda"] = 0.5;
+    states[2]["lambda"] = 1.0;
+    states[2]["r0"] = 0.3;
+    states[3]["scale"] = 2.0;
+
+    // Compare to the energies computed one state at a time.
+
+    for (int groups = 0; groups < 4; groups++) {
+        int flags = (groups == 3 ? 0xFFFFFFFF : 1<<groups);
+        vector<double> energies = context.getPotentialEnergies(states, flags);
+        ASSERT_EQUAL(states.size(), energies.size());
+        for (int i = 0; i < (int) states.size(); i++) {
+            context.setParameter("lambda", 1.0);
+            context.setParameter("r0", 0.2);
+            context.setParameter("scale", 0.5);
+            for (map<string, double>::const_iterator iter = states[i].begin(); iter != states[i].end(); ++iter)
+                context.setParameter(iter->first, iter->second);
+            double expected = context.getState(State::Energy, false, flags).getPotentialEnergy();
+            ASSERT_EQUAL_TOL(expected, energies[i], TOL);
+        }
+        context.setParameter("lambda", 1.0);
+        context.setParameter("r0", 0.2);
+        context.setParameter("scale", 0.5);
+    }
+
+    // The parameters should have been left unchanged.
+
+    context.setParameter("lambda", 0.7);
+    context.getPotentialEnergies(states);
+    ASSERT_EQUAL(0.7, context.getParameter("lambda"));
+    ASSERT_EQUAL(0.2, context.getParameter("r0"));
+    ASSERT_EQUAL(0.5, context.getParameter("scale"));
+
+    // An invalid parameter name should throw an exception.
+
+    states[4]["nonexistent"] = 1.0;
+    bool threwException = false;
+    try {
+        context.getPotentialEnergies(states);
+    }
+    catch (OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+    ASSERT_EQUAL(0.7, context.getParameter("lambda"));
+}
+
+/**
+ * Compute the energy of the system in a second Context, so nothing can have been cached.
+ */
+double computeReferenceEnergy(const System& system, Context& context) {
+    VerletIntegrator integrator(0.001);
+    Context context2(system, integrator, context.getPlatform());
+    context2.setState(context.getState(State::Positions | State::Parameters));
+    return context2.getState(State::Energy).getPotentialEnergy();
+}
+
+void testCachedEnergies() {
+    const int numParticles = 10;
+    ReferencePlatform platform;
+    System system;
+    HarmonicBondForce* harmonic = new HarmonicBondForce();
+    CustomBondForce* custom = new CustomBondForce("lambda*(r-0.2)^2");
+    custom->addGlobalParameter("lambda", 1.0);
+    CustomExternalForce* external = new CustomExternalForce("scale*x^2");
+    external->addGlobalParameter("scale", 0.5);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        external->addParticle(i, vector<double>());
+        if (i > 0) {
+            harmonic->addBond(i-1, i, 0.15, 100.0);
+            custom->addBond(i-1, i, vector<double>());
+        }
+    }
+    system.addForce(harmonic);
+    system.addForce(custom);
+    system.addForce(external);
+
+    // Use an integrator that moves the particles without ever computing forces.
+
+    CustomIntegrator integrator(0.01);
+    integrator.addComputePerDof("x", "x+dt");
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.2*i, 0.05*(i%3), 0);
+    context.setPositions(positions);
+    ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+
+    // Alternate between changing the two parameters.
+
+    for (int i = 0; i < 5; i++) {
+        context.setParameter(i%2 == 0 ? "lambda" : "scale", 0.3*i);
+        ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+        ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+    }
+
+    // Make sure the cache is invalidated by anything that changes the energy.
+
+    positions[0][0] -= 0.1;
+    context.setPositions(positions);
+    ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+    integrator.step(1);
+    ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+    double energy = context.getState(State::Energy).getPotentialEnergy();
+    harmonic->setBondParameters(0, 0, 1, 0.15, 200.0);
+    harmonic->updateParametersInContext(context);
+    ASSERT(context.getState(State::Energy).getPotentialEnergy() != energy);
+    ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+
+    // Energies should be cached separately for each set of force groups.
+
+    harmonic->setForceGroup(1);
+    context.reinitialize();
+    context.setPositions(positions);
+    double harmonicEnergy = context.getState(State::Energy, false, 1<<1).getPotentialEnergy();
+    double otherEnergy = context.getState(State::Energy, false, 1<<0).getPotentialEnergy();
+    ASSERT_EQUAL_TOL(harmonicEnergy+otherEnergy, context.getState(State::Energy).getPotentialEnergy(), TOL);
+    ASSERT_EQUAL_TOL(harmonicEnergy, context.getState(State::Energy, false, 1<<1).getPotentialEnergy(), TOL);
+
+    // Energies recorded while computing forces should be reused correctly.
+
+    context.setParameter("lambda", 2.0);
+    context.getState(State::Forces | State::Energy);
+    context.setParameter("scale", 1.5);
+    ASSERT_EQUAL_TOL(computeReferenceEnergy(system, context), context.getState(State::Energy).getPotentialEnergy(), TOL);
+}
+
+void testEnergyDoesNotChangeForces() {
+    const int numParticles = 5;
+    ReferencePlatform platform;
+    System system;
+    CustomExternalForce* external1 = new CustomExternalForce("x^2+2*y");
+    CustomExternalForce* external2 = new CustomExternalForce("-3*x+z^2");
+    external2->setForceGroup(1);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        external1->addParticle(i, vector<double>());
+        external2->addParticle(i, vector<double>());
+    }
+    system.addForce(external1);
+    system.addForce(external2);
+
+    // This integrator never moves the particles, so the forces it uses stay valid unless something
+    // else overwrites them.  After each step, the forces of group 1 are the most recent ones.
+
+    CustomIntegrator integrator(0.01);
+    integrator.addComputePerDof("v", "f0");
+    integrator.addComputePerDof("v", "v+f1");
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.1*i, 0.2, -0.3*i);
+    context.setPositions(positions);
+    integrator.step(1);
+
+    // Computing only the energy of group 0 must not make the integrator think the current forces belong to it.
+
+    context.getState(State::Energy, false, 1<<0);
+    integrator.step(1);
+    vector<Vec3> velocities = context.getState(State::Velocities).getVelocities();
+    vector<Vec3> forces0 = context.getState(State::Forces, false, 1<<0).getForces();
+    vector<Vec3> forces1 = context.getState(State::Forces, false, 1<<1).getForces();
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(forces0[i]+forces1[i], velocities[i], TOL);
+}
+
+void testEnergyDecomposition() {
+    const int numParticles = 10;
+    const double boxSize = 2.0;
+    ReferencePlatform platform;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* harmonic = new HarmonicBondForce();
+    CustomExternalForce* external = new CustomExternalForce("scale*x^2");
+    external->addGlobalParameter("scale", 0.5);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        external->addParticle(i, vector<double>());
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.1);
+        if (i > 0)
+            harmonic->addBond(i-1, i, 0.15, 100.0);
+    }
+    system.addForce(harmonic);
+    system.addForce(external);
+    system.addForce(nonbonded);
+    harmonic->setForceGroup(1);
+    external->setForceGroup(2);
+    nonbonded->setForceGroup(2);
+    nonbonded->setReciprocalSpaceForceGroup(3);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    context.setPositions(positions);
+
+    // Compare the energy of each group to computing it separately.
+
+    State state = context.getState(State::Energy | State::Forces | State::EnergyByGroup | State::EnergyByForce);
+    const vector<double>& groupEnergies = state.getPotentialEnergyByGroup();
+    const vector<double>& forceEnergies = state.getPotentialEnergyByForce();
+    ASSERT_EQUAL(32, groupEnergies.size());
+    ASSERT_EQUAL(3, forceEnergies.size());
+    double groupSum = 0.0;
+    for (int i = 0; i < 32; i++) {
+        ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<i).getPotentialEnergy(), groupEnergies[i], TOL);
+        groupSum += groupEnergies[i];
+    }
+    ASSERT_EQUAL_TOL(state.getPotentialEnergy(), groupSum, TOL);
+    ASSERT(groupEnergies[3] != 0.0);
+
+    // Compare the energy of each Force.
+
+    double externalEnergy = 0.0;
+    for (int i = 0; i < numParticles; i++)
+        externalEnergy += 0.5*positions[i][0]*positions[i][0];
+    ASSERT_EQUAL_TOL(groupEnergies[1], forceEnergies[0], TOL);
+    ASSERT_EQUAL_TOL(externalEnergy, forceEnergies[1], TOL);
+    ASSERT_EQUAL_TOL(groupEnergies[2]+groupEnergies[3], forceEnergies[1]+forceEnergies[2], TOL);
+
+    // The forces should not be affected.
+
+    State forceState = context.getState(State::Forces);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(forceState.getForces()[i], state.getForces()[i], TOL);
+
+    // Try including only some groups.
+
+    state = context.getState(State::Energy | State::EnergyByGroup | State::EnergyByForce, false, (1<<1)+(1<<3));
+    ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<1).getPotentialEnergy(), state.getPotentialEnergyByGroup()[1], TOL);
+    ASSERT_EQUAL_TOL(0.0, state.getPotentialEnergyByGroup()[2], TOL);
+    ASSERT_EQUAL_TOL(context.getState(State::Energy, false, 1<<3).getPotentialEnergy(), state.getPotentialEnergyByGroup()[3], TOL);
+    ASSERT_EQUAL_TOL(0.0, state.getPotentialEnergyByForce()[1], TOL);
+    ASSERT_EQUAL_TOL(state.getPotentialEnergyByGroup()[3], state.getPotentialEnergyByForce()[2], TOL);
+    ASSERT_EQUAL_TOL(state.getPotentialEnergy(), state.getPotentialEnergyByForce()[0]+state.getPotentialEnergyByForce()[2], TOL);
+}
+
+int main() {
+    try {
+        testMultipleParameterSets();
+        testCachedEnergies();
+        testEnergyDoesNotChangeForces();
+        testEnergyDecomposition();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -35,10 +35,18 @@
 
 #include "openmm/internal/AssertionUtilities.h"
 #include "SimTKOpenMMUtilities.h"
+#include "openmm/AndersenThermostat.h"
 #include "openmm/Context.h"
+#include "openmm/LangevinIntegrator.h"
 #include "ReferencePlatform.h"
+#include "ReferenceRandomStreams.h"
 #include "openmm/VerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "RealVec.h"
+#include "sfmt/SFMT.h"
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 
 using namespace OpenMM;
 using namespace std;
@@ -112,10 +120,187 @@ void testRandomVelocities() {
     ASSERT_USUALLY_EQUAL_TOL(expected, ke, 4/sqrt((double) numParticles));
 }
 
+void testThreadedFill() {
+    // The values must not depend on the number of threads used to generate them.
+
+    const int numValues = 3*ReferenceRandomStreams::BlockSize+17;
+    static char threadsMany[] = "OPENMM_CPU_THREADS=3";
+    static char threadsOne[] = "OPENMM_CPU_THREADS=1";
+    static char threadsDefault[] = "OPENMM_CPU_THREADS=";
+    ReferenceRandomStreams random1, random2;
+    random1.setRandomNumberSeed(10);
+    random2.setRandomNumberSeed(10);
+    vector<RealOpenMM> values1(numValues), values2(numValues);
+    putenv(threadsMany);
+    random1.fillNormallyDistributedRandomNumbers(&values1[0], numValues);
+    putenv(threadsOne);
+    random2.fillNormallyDistributedRandomNumbers(&values2[0], numValues);
+    putenv(threadsDefault);
+    for (int i = 0; i < numValues; i++)
+        ASSERT_EQUAL(values1[i], values2[i]);
+
+    // Check the distribution, and that the next array is different.
+
+    double mean = 0.0, var = 0.0;
+    for (int i = 0; i < numValues; i++) {
+        mean += values1[i];
+        var += values1[i]*values1[i];
+    }
+    mean /= numValues;
+    var /= numValues;
+    ASSERT_EQUAL_TOL(0.0, mean, 0.05);
+    ASSERT_EQUAL_TOL(1.0, var-mean*mean, 0.05);
+    random1.fillNormallyDistributedRandomNumbers(&values2[0], numValues);
+    int numSame = 0;
+    for (int i = 0; i < numValues; i++)
+        if (values1[i] == values2[i])
+            numSame++;
+    ASSERT(numSame < 10);
+}
+
+/**
+ * Create a System of free particles with an AndersenThermostat, so both the vector and scalar random
+ * number streams get used.
+ */
+void createStochasticSystem(System& system, vector<Vec3>& positions) {
+    const int numParticles = 50;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+0.1*(i%3));
+        positions.push_back(Vec3(0.1*i, 0.2*(i%4), 0.3*(i%5)));
+    }
+    AndersenThermostat* thermostat = new AndersenThermostat(300.0, 50.0);
+    thermostat->setRandomNumberSeed(3);
+    system.addForce(thermostat);
+}
+
+void testIndependentContexts() {
+    // Two Contexts with the same seed must produce identical trajectories, even when
+    // their steps are interleaved.
+
+    System system;
+    vector<Vec3> positions;
+    createStochasticSystem(system, positions);
+    ReferencePlatform platform;
+    LangevinIntegrator integrator1(300.0, 10.0, 0.002);
+    LangevinIntegrator integrator2(300.0, 10.0, 0.002);
+    integrator1.setRandomNumberSeed(5);
+    integrator2.setRandomNumberSeed(5);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (int i = 0; i < 10; i++) {
+        integrator1.step(1);
+        integrator2.step(2);
+        integrator1.step(1);
+    }
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-10);
+        ASSERT_EQUAL_VEC(state1.getVelocities()[i], state2.getVelocities()[i], 1e-10);
+    }
+}
+
+void testCheckpoint() {
+    // Loading a checkpoint must restore the Context's random number streams, regardless of
+    // what other Contexts have done in the meantime.
+
+    System system;
+    vector<Vec3> positions;
+    createStochasticSystem(system, positions);
+    ReferencePlatform platform;
+    LangevinIntegrator integrator1(300.0, 10.0, 0.002);
+    LangevinIntegrator integrator2(300.0, 10.0, 0.002);
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    integrator1.step(5);
+    stringstream checkpoint;
+    context1.createCheckpoint(checkpoint);
+    integrator1.step(10);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    context1.loadCheckpoint(checkpoint);
+    integrator2.step(7);
+    integrator1.step(10);
+    State state2 = context1.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-10);
+        ASSERT_EQUAL_VEC(state1.getVelocities()[i], state2.getVelocities()[i], 1e-10);
+    }
+}
+
+void testLegacyCheckpoint() {
+    // Checkpoints from version 2 and earlier hold the state of the old global generator.  Loading one
+    // should restore it into the Context's own streams.
+
+    System system;
+    vector<Vec3> positions;
+    createStochasticSystem(system, positions);
+    ReferencePlatform platform;
+    LangevinIntegrator integrator(300.0, 10.0, 0.002);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    int numParticles = system.getNumParticles();
+    OpenMM_SFMT::SFMT sfmt;
+    OpenMM_SFMT::init_gen_rand(17, sfmt);
+    for (int i = 0; i < 5; i++)
+        OpenMM_SFMT::genrand_real2(sfmt);
+    stringstream checkpoint;
+    string platformName = platform.getName();
+    int nameSize = platformName.size(), numParameters = 0;
+    checkpoint.write((char*) &nameSize, sizeof(int));
+    checkpoint.write(platformName.c_str(), nameSize);
+    checkpoint.write((char*) &numParticles, sizeof(int));
+    checkpoint.write((char*) &numParameters, sizeof(int));
+    int version = 2;
+    double time = 1.5;
+    uint32_t seed = 17;
+    bool initialized = true, nextGaussianIsValid = false;
+    RealOpenMM nextGaussian = 0;
+    vector<RealVec> posData(numParticles), velData(numParticles);
+    RealVec box(2, 2, 2);
+    checkpoint.write((char*) &version, sizeof(int));
+    checkpoint.write((char*) &time, sizeof(double));
+    checkpoint.write((char*) &posData[0], sizeof(RealVec)*numParticles);
+    checkpoint.write((char*) &velData[0], sizeof(RealVec)*numParticles);
+    checkpoint.write((char*) &box, sizeof(RealVec));
+    checkpoint.write((char*) &seed, sizeof(uint32_t));
+    checkpoint.write((char*) &initialized, sizeof(bool));
+    checkpoint.write((char*) &nextGaussianIsValid, sizeof(bool));
+    checkpoint.write((char*) &nextGaussian, sizeof(RealOpenMM));
+    sfmt.createCheckpoint(checkpoint);
+    int numEntries = 1, nameLength = 4, size = 1;
+    double value = 3.0;
+    checkpoint.write((char*) &numEntries, sizeof(int));
+    checkpoint.write((char*) &nameLength, sizeof(int));
+    checkpoint.write("test", nameLength);
+    checkpoint.write((char*) &size, sizeof(int));
+    checkpoint.write((char*) &value, sizeof(double));
+    context.loadCheckpoint(checkpoint);
+
+    // The sequential stream should continue where the saved generator left off, and the rest of the
+    // checkpoint should still be read correctly.
+
+    ContextImpl* contextImpl = *reinterpret_cast<ContextImpl**>(&context);
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(contextImpl->getPlatformData());
+    ASSERT_EQUAL(seed, data->random->getRandomNumberSeed());
+    for (int i = 0; i < 10; i++)
+        ASSERT_EQUAL((RealOpenMM) OpenMM_SFMT::genrand_real2(sfmt), data->random->getUniformlyDistributedRandomNumber());
+    ASSERT_EQUAL(1, data->checkpointData["test"].size());
+    ASSERT_EQUAL(value, data->checkpointData["test"][0]);
+    ASSERT_EQUAL_TOL(time, context.getState(State::Positions).getTime(), 1e-10);
+}
+
 int main() {
     try {
         testGaussian();
         testRandomVelocities();
+        testThreadedFill();
+        testIndependentContexts();
+        testCheckpoint();
+        testLegacyCheckpoint();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
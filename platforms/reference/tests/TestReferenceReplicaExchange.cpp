@@ -0,0 +1,206 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests ReplicaExchange on the reference platform.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/LangevinIntegrator.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/ReplicaExchange.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "ReferencePlatform.h"
+#include "SimTKOpenMMRealType.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+const int numParticles = 20;
+
+/**
+ * Create a System of independent particles in harmonic wells whose force constant is the global parameter "k".
+ */
+void createSystem(System& system, vector<Vec3>& positions) {
+    CustomExternalForce* force = new CustomExternalForce("0.5*k*(x^2+y^2+z^2)");
+    force->addGlobalParameter("k", 100.0);
+    system.addForce(force);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i, vector<double>());
+        positions.push_back(Vec3(0.1*(i%3), 0.1*(i%5), 0.1*(i%7)));
+    }
+}
+
+/**
+ * Run a simulation and check that the average energy in every state matches the value expected from equipartition.
+ */
+void checkEnergies(ReplicaExchange& exchange) {
+    int numStates = exchange.getNumReplicas();
+    exchange.run(50, 20);
+    vector<double> meanEnergy(numStates, 0.0);
+    const int numIterations = 1000;
+    for (int i = 0; i < numIterations; i++) {
+        exchange.run(1, 20);
+        for (int j = 0; j < numStates; j++)
+            meanEnergy[j] += exchange.getPotentialEnergy(exchange.getStateReplica(j));
+    }
+    for (int i = 0; i < numStates; i++) {
+        double expected = 1.5*numParticles*BOLTZ*exchange.getTemperature(i);
+        ASSERT_EQUAL_TOL(expected, meanEnergy[i]/numIterations, 0.05);
+        ASSERT_EQUAL(i, exchange.getReplicaState(exchange.getStateReplica(i)));
+    }
+    for (int i = 0; i < numStates-1; i++) {
+        ASSERT(exchange.getNumAcceptedExchanges(i) > 0);
+        ASSERT(exchange.getNumAcceptedExchanges(i) < exchange.getNumAttemptedExchanges(i));
+    }
+}
+
+void testTemperatureExchange() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    LangevinIntegrator integrator(300.0, 20.0, 0.005);
+    ReferencePlatform platform;
+    ReplicaExchange exchange(system, integrator, 4, platform);
+    exchange.setRandomNumberSeed(5);
+    for (int i = 0; i < 4; i++) {
+        exchange.setTemperature(i, 300.0*pow(1.1, i));
+        exchange.setPositions(i, positions);
+    }
+    checkEnergies(exchange);
+}
+
+void testHamiltonianExchange() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    LangevinIntegrator integrator1(300.0, 20.0, 0.005);
+    LangevinIntegrator integrator2(300.0, 20.0, 0.005);
+    integrator2.setRandomNumberSeed(integrator1.getRandomNumberSeed()+1);
+    ReferencePlatform platform;
+    ReplicaExchange exchange(system, integrator1, 4, platform);
+    exchange.addIntegrator(integrator2);
+    for (int i = 0; i < 4; i++) {
+        exchange.setParameter(i, "k", 100.0*pow(1.2, i));
+        exchange.setPositions(i, positions);
+    }
+    ASSERT_EQUAL(300.0, exchange.getTemperature(2));
+    ASSERT_EQUAL(100.0*1.2*1.2, exchange.getParameter(2, "k"));
+    checkEnergies(exchange);
+    
+    // The reported energy of each replica should be the energy in its current state.
+    
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    for (int i = 0; i < 4; i++) {
+        context.setPositions(exchange.getPositions(i));
+        context.setParameter("k", exchange.getParameter(exchange.getReplicaState(i), "k"));
+        ASSERT_EQUAL_TOL(context.getState(State::Energy).getPotentialEnergy(), exchange.getPotentialEnergy(i), 1e-5);
+    }
+}
+
+void testUnsupportedTemperature() {
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    VerletIntegrator integrator(0.005);
+    ReferencePlatform platform;
+    ReplicaExchange exchange(system, integrator, 2, platform);
+    for (int i = 0; i < 2; i++) {
+        exchange.setTemperature(i, 300.0+10*i);
+        exchange.setPositions(i, positions);
+    }
+    bool threwException = false;
+    try {
+        exchange.run(1, 1);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
+void testIntegratorStatePerReplica() {
+    // Each step moves every particle by an amount proportional to a step counter stored in a global
+    // variable of the Integrator.  Every replica must see its own counter, even though they all share
+    // one Context.
+    
+    System system;
+    vector<Vec3> positions;
+    createSystem(system, positions);
+    CustomIntegrator integrator(0.001);
+    integrator.addGlobalVariable("n", 0.0);
+    integrator.addPerDofVariable("offset", 0.0);
+    integrator.addComputeGlobal("n", "n+1");
+    integrator.addComputePerDof("offset", "offset+0.001*n");
+    integrator.addComputePerDof("x", "x+0.001*n");
+    ReferencePlatform platform;
+    const int numReplicas = 3;
+    ReplicaExchange exchange(system, integrator, numReplicas, platform);
+    for (int i = 0; i < numReplicas; i++) {
+        exchange.setTemperature(i, 300.0);
+        exchange.setPositions(i, positions);
+    }
+    exchange.run(2, 5);
+    double expected = 0.001*55;
+    for (int i = 0; i < numReplicas; i++) {
+        const vector<Vec3>& pos = exchange.getPositions(i);
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL_VEC(positions[j]+Vec3(expected, expected, expected), pos[j], 1e-10);
+    }
+    vector<Vec3> offset;
+    integrator.getPerDofVariable(0, offset);
+    ASSERT_EQUAL_TOL(10.0, integrator.getGlobalVariable(0), 1e-10);
+    for (int j = 0; j < numParticles; j++)
+        ASSERT_EQUAL_VEC(Vec3(expected, expected, expected), offset[j], 1e-10);
+}
+
+int main() {
+    try {
+        testTemperatureExchange();
+        testHamiltonianExchange();
+        testUnsupportedTemperature();
+        testIntegratorStatePerReplica();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
@@ -82,6 +82,19 @@ public:
         Direct = 1
     };
 
+    enum InducedDipoleSolver {
+
+        /**
+         * Successive over-relaxation
+         */
+        SOR = 0,
+
+        /**
+         * Conjugate gradient, preconditioned by the polarizabilities.  This is the default.
+         */
+        PCG = 1
+    };
+
     enum MultipoleAxisTypes { ZThenX = 0, Bisector = 1, ZBisect = 2, ThreeFold = 3, ZOnly = 4, NoAxisType = 5, LastAxisTypeIndex = 6 };
 
     enum CovalentType {
@@ -282,6 +295,41 @@ public:
      */
     void setMutualInducedTargetEpsilon(double inputMutualInducedTargetEpsilon);
 
+    /**
+     * Get the number of previous time steps whose converged mutual induced dipoles are retained
+     * and extrapolated to form the initial guess for the next step.  A value of 0 (the default)
+     * means each step starts from the direct induced dipoles.
+     *
+     * @return number of retained steps
+     */
+    int getMutualInducedHistorySize(void) const;
+
+    /**
+     * Set the number of previous time steps whose converged mutual induced dipoles are retained
+     * and extrapolated to form the initial guess for the next step.  The guess is built with the
+     * always stable predictor-corrector (ASPC) coefficients for the available history.  A value of 0
+     * disables extrapolation.
+     *
+     * @param number of retained steps
+     */
+    void setMutualInducedHistorySize(int inputMutualInducedHistorySize);
+
+    /**
+     * Get the iterative method used to converge the mutual induced dipoles.
+     *
+     * @return the solver
+     */
+    InducedDipoleSolver getInducedDipoleSolver() const;
+
+    /**
+     * Set the iterative method used to converge the mutual induced dipoles.  This is only a request:
+     * platforms that do not implement the selected method (currently CUDA and OpenCL, which always
+     * use SOR) ignore it.
+     *
+     * @param solver the solver to use
+     */
+    void setInducedDipoleSolver(InducedDipoleSolver solver);
+
     /**
      * Get the error tolerance for Ewald summation.  This corresponds to the fractional error in the forces
      * which is acceptable.  This value is used to select the grid dimensions and separation (alpha)
@@ -353,6 +401,8 @@ private:
     std::vector<int> pmeGridDimension;
     int mutualInducedMaxIterations;
     double mutualInducedTargetEpsilon;
+    int mutualInducedHistorySize;
+    InducedDipoleSolver inducedDipoleSolver;
     double scalingDistanceCutoff;
     double electricConstant;
     double ewaldErrorTol;
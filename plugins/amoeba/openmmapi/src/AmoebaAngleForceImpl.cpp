@@ -63,5 +63,6 @@ std::vector<std::string> AmoebaAngleForceImpl::getKernelNames() {
 }
 
 void AmoebaAngleForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaAngleForceKernel>().copyParametersToContext(context, owner);
 }
@@ -74,5 +74,6 @@ vector<pair<int, int> > AmoebaBondForceImpl::getBondedParticles() const {
 }
 
 void AmoebaBondForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaBondForceKernel>().copyParametersToContext(context, owner);
 }
@@ -63,5 +63,6 @@ std::vector<std::string> AmoebaInPlaneAngleForceImpl::getKernelNames() {
 }
 
 void AmoebaInPlaneAngleForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaInPlaneAngleForceKernel>().copyParametersToContext(context, owner);
 }
@@ -40,7 +40,8 @@ using std::string;
 using std::vector;
 
 AmoebaMultipoleForce::AmoebaMultipoleForce() : nonbondedMethod(NoCutoff), polarizationType(Mutual), pmeBSplineOrder(5), cutoffDistance(1.0), ewaldErrorTol(1e-4), mutualInducedMaxIterations(60),
-                                               mutualInducedTargetEpsilon(1.0e-02), scalingDistanceCutoff(100.0), electricConstant(138.9354558456), aewald(0.0) {
+                                               mutualInducedTargetEpsilon(1.0e-02), mutualInducedHistorySize(0), inducedDipoleSolver(PCG),
+                                               scalingDistanceCutoff(100.0), electricConstant(138.9354558456), aewald(0.0) {
     pmeGridDimension.resize(3);
     pmeGridDimension[0] = pmeGridDimension[1] = pmeGridDimension[2];
 }
@@ -119,6 +120,24 @@ void AmoebaMultipoleForce::setMutualInducedTargetEpsilon( double inputMutualIndu
     mutualInducedTargetEpsilon = inputMutualInducedTargetEpsilon;
 }
 
+int AmoebaMultipoleForce::getMutualInducedHistorySize( void ) const {
+    return mutualInducedHistorySize;
+}
+
+void AmoebaMultipoleForce::setMutualInducedHistorySize( int inputMutualInducedHistorySize ) {
+    if (inputMutualInducedHistorySize < 0)
+        throw OpenMMException("AmoebaMultipoleForce: mutual induced history size cannot be negative");
+    mutualInducedHistorySize = inputMutualInducedHistorySize;
+}
+
+AmoebaMultipoleForce::InducedDipoleSolver AmoebaMultipoleForce::getInducedDipoleSolver( void ) const {
+    return inducedDipoleSolver;
+}
+
+void AmoebaMultipoleForce::setInducedDipoleSolver( AmoebaMultipoleForce::InducedDipoleSolver solver ) {
+    inducedDipoleSolver = solver;
+}
+
 double AmoebaMultipoleForce::getEwaldErrorTolerance() const {
     return ewaldErrorTol;
 }
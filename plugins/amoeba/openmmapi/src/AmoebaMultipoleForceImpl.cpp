@@ -193,5 +193,6 @@ void AmoebaMultipoleForceImpl::getSystemMultipoleMoments( ContextImpl& context,
 }
 
 void AmoebaMultipoleForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaMultipoleForceKernel>().copyParametersToContext(context, owner);
 }
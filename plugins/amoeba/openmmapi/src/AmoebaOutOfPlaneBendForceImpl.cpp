@@ -63,5 +63,6 @@ std::vector<std::string> AmoebaOutOfPlaneBendForceImpl::getKernelNames() {
 }
 
 void AmoebaOutOfPlaneBendForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaOutOfPlaneBendForceKernel>().copyParametersToContext(context, owner);
 }
@@ -63,5 +63,6 @@ std::vector<std::string> AmoebaPiTorsionForceImpl::getKernelNames() {
 }
 
 void AmoebaPiTorsionForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaPiTorsionForceKernel>().copyParametersToContext(context, owner);
 }
@@ -63,5 +63,6 @@ std::vector<std::string> AmoebaStretchBendForceImpl::getKernelNames() {
 }
 
 void AmoebaStretchBendForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaStretchBendForceKernel>().copyParametersToContext(context, owner);
 }
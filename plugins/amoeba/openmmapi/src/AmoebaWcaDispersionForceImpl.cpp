@@ -142,5 +142,6 @@ std::vector<std::string> AmoebaWcaDispersionForceImpl::getKernelNames() {
 }
 
 void AmoebaWcaDispersionForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcAmoebaWcaDispersionForceKernel>().copyParametersToContext(context, owner);
 }
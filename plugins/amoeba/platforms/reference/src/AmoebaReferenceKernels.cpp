@@ -46,7 +46,9 @@
 #include "openmm/NonbondedForce.h"
 #include "openmm/internal/NonbondedForceImpl.h"
 
+#include <algorithm>
 #include <cmath>
+#include <sstream>
 #ifdef _MSC_VER
 #include <windows.h>
 #endif
@@ -54,6 +56,11 @@
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * Extra distance included in the AMOEBA neighbor lists so they can be reused for several steps.
+ */
+static const double AMOEBA_NEIGHBOR_LIST_PADDING = 0.1;
+
 static vector<RealVec>& extractPositions(ContextImpl& context) {
     ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
     return *((vector<RealVec>*) data->positions);
@@ -481,12 +488,18 @@ double ReferenceCalcAmoebaTorsionTorsionForceKernel::execute(ContextImpl& contex
  * -------------------------------------------------------------------------- */
 
 ReferenceCalcAmoebaMultipoleForceKernel::ReferenceCalcAmoebaMultipoleForceKernel(std::string name, const Platform& platform, const System& system) : 
-         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedTargetEpsilon(1.0e-03),
-                                                         usePme(false),alphaEwald(0.0), cutoffDistance(1.0) {  
+         CalcAmoebaMultipoleForceKernel(name, platform), system(system), numMultipoles(0), mutualInducedMaxIterations(60), mutualInducedTargetEpsilon(1.0e-03), mutualInducedHistorySize(0), inducedDipoleSolver(AmoebaMultipoleForce::PCG),
+                                                         usePme(false),alphaEwald(0.0), cutoffDistance(1.0), neighborList(NULL), threads(NULL) {  
 
 }
 
 ReferenceCalcAmoebaMultipoleForceKernel::~ReferenceCalcAmoebaMultipoleForceKernel() {
+    if( neighborList ){
+        delete neighborList;
+    }
+    if( threads ){
+        delete threads;
+    }
 }
 
 void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, const AmoebaMultipoleForce& force) {
@@ -557,8 +570,21 @@ void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, c
     if( polarizationType == AmoebaMultipoleForce::Mutual ){
         mutualInducedMaxIterations = force.getMutualInducedMaxIterations();
         mutualInducedTargetEpsilon = force.getMutualInducedTargetEpsilon();
+        mutualInducedHistorySize   = force.getMutualInducedHistorySize();
+        inducedDipoleSolver        = force.getInducedDipoleSolver();
     }
 
+    // The induced dipole history is stored under a name that includes the index of the force in the System,
+    // so a System with several AmoebaMultipoleForces keeps a separate history for each one.
+
+    int forceIndex = 0;
+    while( forceIndex < system.getNumForces() && &system.getForce(forceIndex) != &force ){
+        forceIndex++;
+    }
+    std::stringstream key;
+    key << "AmoebaMultipoleForce" << forceIndex << ".inducedDipoles";
+    historyKey = key.str();
+
     // PME
 
     nonbondedMethod  = force.getNonbondedMethod();
@@ -577,6 +603,8 @@ void ReferenceCalcAmoebaMultipoleForceKernel::initialize(const System& system, c
             pmeGridDimension[1] = gridSizeY;
             pmeGridDimension[2] = gridSizeZ;
         }    
+        neighborList = new AmoebaReferenceNeighborList( cutoffDistance, AMOEBA_NEIGHBOR_LIST_PADDING );
+        noExclusions = ReferenceExclusionList( numMultipoles, std::vector< std::pair<int, int> >() );
     } else {
         usePme = false;
     }
@@ -645,6 +673,12 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
             throw OpenMMException("The periodic box size has decreased to less than twice the nonbonded cutoff.");
          }
          amoebaReferencePmeMultipoleForce->setPeriodicBoxSize(box);
+         if( threads == NULL ){
+             threads = new ThreadPool();
+         }
+         neighborList->update( extractPositions(context), box, true, noExclusions );
+         amoebaReferencePmeMultipoleForce->setNeighborList( &neighborList->getNeighborList() );
+         amoebaReferencePmeMultipoleForce->setThreadPool( threads );
          amoebaReferenceMultipoleForce = static_cast<AmoebaReferenceMultipoleForce*>(amoebaReferencePmeMultipoleForce);
 
     } else {
@@ -657,6 +691,11 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
         amoebaReferenceMultipoleForce->setPolarizationType( AmoebaReferenceMultipoleForce::Mutual );
         amoebaReferenceMultipoleForce->setMutualInducedDipoleTargetEpsilon( mutualInducedTargetEpsilon );
         amoebaReferenceMultipoleForce->setMaximumMutualInducedDipoleIterations( mutualInducedMaxIterations );
+        if( inducedDipoleSolver == AmoebaMultipoleForce::SOR ){
+            amoebaReferenceMultipoleForce->setInducedDipoleSolver( AmoebaReferenceMultipoleForce::SOR );
+        } else {
+            amoebaReferenceMultipoleForce->setInducedDipoleSolver( AmoebaReferenceMultipoleForce::PCG );
+        }
     } else if( polarizationType == AmoebaMultipoleForce::Direct ){
         amoebaReferenceMultipoleForce->setPolarizationType( AmoebaReferenceMultipoleForce::Direct );
     } else {
@@ -667,10 +706,68 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
 }
 
+/**
+ * Compute the always stable predictor-corrector (ASPC) coefficients used to extrapolate
+ * induced dipoles from the previous numSteps steps, most recent first (Kolafa, J. Comput.
+ * Chem. 25, 335 (2004)).
+ */
+static void computeAspcCoefficients( int numSteps, vector<double>& coefficients ){
+
+    coefficients.resize( numSteps );
+    if( numSteps == 1 ){
+        coefficients[0] = 1.0;
+        return;
+    }
+    int k = numSteps-2;
+    double denominator = 1.0;
+    for( int ii = 1; ii <= k+1; ii++ ){
+        denominator *= static_cast<double>(k+1+ii)/ii;
+    }
+    for( int jj = 1; jj <= numSteps; jj++ ){
+        double numerator = 1.0;
+        for( int ii = 1; ii <= k+2-jj; ii++ ){
+            numerator *= static_cast<double>(k+2+jj+ii)/ii;
+        }
+        coefficients[jj-1] = (jj%2 == 1 ? 1.0 : -1.0)*jj*numerator/denominator;
+    }
+}
+
 double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
 
     AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce( context );
 
+    // The converged induced dipoles of previous steps are kept in the platform data so they are
+    // included in checkpoints.  Each entry is [ number stored, time of latest, snapshots (most recent first) ],
+    // where a snapshot holds the induced dipoles followed by the polar induced dipoles.
+
+    bool useHistory = mutualInducedHistorySize > 0 && polarizationType == AmoebaMultipoleForce::Mutual &&
+                      dynamic_cast<AmoebaReferenceGeneralizedKirkwoodMultipoleForce*>(amoebaReferenceMultipoleForce) == NULL;
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    unsigned int snapshotSize = 6*numMultipoles;
+    if( useHistory ){
+        vector<double>& history = data->checkpointData[historyKey];
+        int numStored = (history.size() < 2 ? 0 : static_cast<int>(history[0]));
+        if( history.size() != 2+numStored*snapshotSize ){
+            numStored = 0;
+        }
+        numStored = std::min( numStored, mutualInducedHistorySize );
+        if( numStored > 0 ){
+            vector<double> coefficients;
+            computeAspcCoefficients( numStored, coefficients );
+            vector<RealVec> inducedDipole( numMultipoles );
+            vector<RealVec> inducedDipolePolar( numMultipoles );
+            for( int step = 0; step < numStored; step++ ){
+                const double* snapshot = &history[2+step*snapshotSize];
+                RealOpenMM scale       = static_cast<RealOpenMM>(coefficients[step]);
+                for( int ii = 0; ii < numMultipoles; ii++ ){
+                    inducedDipole[ii]      += RealVec( snapshot[3*ii], snapshot[3*ii+1], snapshot[3*ii+2] )*scale;
+                    inducedDipolePolar[ii] += RealVec( snapshot[3*(numMultipoles+ii)], snapshot[3*(numMultipoles+ii)+1], snapshot[3*(numMultipoles+ii)+2] )*scale;
+                }
+            }
+            amoebaReferenceMultipoleForce->setInitialInducedDipoles( inducedDipole, inducedDipolePolar );
+        }
+    }
+
     vector<RealVec>& posData   = extractPositions(context);
     vector<RealVec>& forceData = extractForces(context);
     RealOpenMM energy          = amoebaReferenceMultipoleForce->calculateForceAndEnergy( posData, charges, dipoles, quadrupoles, tholes,
@@ -678,6 +775,36 @@ double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bo
                                                                                          multipoleAtomZs, multipoleAtomXs, multipoleAtomYs,
                                                                                          multipoleAtomCovalentInfo, forceData);
 
+    // Record the converged dipoles.  Repeated evaluations at the same time (e.g. getState() between
+    // steps) replace the latest snapshot rather than adding a new one.
+
+    if( useHistory ){
+        vector<double>& history = data->checkpointData[historyKey];
+        int numStored = (history.size() < 2 ? 0 : static_cast<int>(history[0]));
+        if( history.size() != 2+numStored*snapshotSize ){
+            numStored = 0;
+        }
+        if( numStored > 0 && history[1] == data->time ){
+            numStored--;
+        }
+        numStored = std::min( numStored, mutualInducedHistorySize-1 );
+        vector<double> snapshot( snapshotSize );
+        vector<RealVec> inducedDipole, inducedDipolePolar;
+        amoebaReferenceMultipoleForce->getInducedDipoles( inducedDipole, inducedDipolePolar );
+        for( int ii = 0; ii < numMultipoles; ii++ ){
+            for( int jj = 0; jj < 3; jj++ ){
+                snapshot[3*ii+jj]                 = inducedDipole[ii][jj];
+                snapshot[3*(numMultipoles+ii)+jj] = inducedDipolePolar[ii][jj];
+            }
+        }
+        vector<double> updated( 2 );
+        updated[0] = numStored+1;
+        updated[1] = data->time;
+        updated.insert( updated.end(), snapshot.begin(), snapshot.end() );
+        updated.insert( updated.end(), history.begin()+2, history.begin()+2+numStored*snapshotSize );
+        history.swap( updated );
+    }
+
     delete amoebaReferenceMultipoleForce;
 
     return static_cast<double>(energy);
@@ -898,12 +1025,16 @@ ReferenceCalcAmoebaVdwForceKernel::ReferenceCalcAmoebaVdwForceKernel(std::string
     usePBC = 0;
     cutoff = 1.0e+10;
     neighborList = NULL;
+    threads = NULL;
 }
 
 ReferenceCalcAmoebaVdwForceKernel::~ReferenceCalcAmoebaVdwForceKernel() {
     if( neighborList ){
         delete neighborList;
     } 
+    if( threads ){
+        delete threads;
+    } 
 }
 
 void ReferenceCalcAmoebaVdwForceKernel::initialize(const System& system, const AmoebaVdwForce& force) {
@@ -913,11 +1044,11 @@ void ReferenceCalcAmoebaVdwForceKernel::initialize(const System& system, const A
     numParticles = system.getNumParticles();
 
     indexIVs.resize( numParticles );
-    allExclusions.resize( numParticles );
     sigmas.resize( numParticles );
     epsilons.resize( numParticles );
     reductions.resize( numParticles );
 
+    std::vector< std::pair<int, int> > excludedPairs;
     for( int ii = 0; ii < numParticles; ii++ ){
 
         int indexIV;
@@ -927,7 +1058,7 @@ void ReferenceCalcAmoebaVdwForceKernel::initialize(const System& system, const A
         force.getParticleParameters( ii, indexIV, sigma, epsilon, reduction );
         force.getParticleExclusions( ii, exclusions );
         for( unsigned int jj = 0; jj < exclusions.size(); jj++ ){
-           allExclusions[ii].insert( exclusions[jj] );
+           excludedPairs.push_back( std::make_pair( ii, exclusions[jj] ) );
         }
 
         indexIVs[ii]      = indexIV;
@@ -935,12 +1066,13 @@ void ReferenceCalcAmoebaVdwForceKernel::initialize(const System& system, const A
         epsilons[ii]      = static_cast<RealOpenMM>( epsilon );
         reductions[ii]    = static_cast<RealOpenMM>( reduction );
     }   
+    allExclusions          = ReferenceExclusionList( numParticles, excludedPairs );
     sigmaCombiningRule     = force.getSigmaCombiningRule();
     epsilonCombiningRule   = force.getEpsilonCombiningRule();
     useCutoff              = (force.getNonbondedMethod() != AmoebaVdwForce::NoCutoff);
     usePBC                 = (force.getNonbondedMethod() == AmoebaVdwForce::CutoffPeriodic);
     cutoff                 = force.getCutoff();
-    neighborList           = useCutoff ? new NeighborList() : NULL;
+    neighborList           = useCutoff ? new AmoebaReferenceNeighborList( cutoff, AMOEBA_NEIGHBOR_LIST_PADDING ) : NULL;
     dispersionCoefficient  = force.getUseDispersionCorrection() ?  AmoebaVdwForceImpl::calcDispersionCorrection(system, force) : 0.0;
 
 }
@@ -953,19 +1085,26 @@ double ReferenceCalcAmoebaVdwForceKernel::execute(ContextImpl& context, bool inc
     RealOpenMM energy;
     if( useCutoff ){
         vdwForce.setCutoff( cutoff );
-        computeNeighborListVoxelHash( *neighborList, numParticles, posData, allExclusions, extractBoxSize(context), usePBC, cutoff, 0.0);
+        if( threads == NULL ){
+            threads = new ThreadPool();
+        }
+        vdwForce.setThreadPool( threads );
+        RealVec& box = extractBoxSize(context);
         if( usePBC ){
-            vdwForce.setNonbondedMethod( AmoebaReferenceVdwForce::CutoffPeriodic);
-            RealVec& box = extractBoxSize(context);
             double minAllowedSize = 1.999999*cutoff;
             if (box[0] < minAllowedSize || box[1] < minAllowedSize || box[2] < minAllowedSize){
                 throw OpenMMException("The periodic box size has decreased to less than twice the cutoff.");
             }
+        }
+        neighborList->update( posData, box, usePBC, allExclusions );
+        if( usePBC ){
+            vdwForce.setNonbondedMethod( AmoebaReferenceVdwForce::CutoffPeriodic);
             vdwForce.setPeriodicBox(box);
-            energy  = vdwForce.calculateForceAndEnergy( numParticles, posData, indexIVs, sigmas, epsilons, reductions, *neighborList, forceData);
+            energy  = vdwForce.calculateForceAndEnergy( numParticles, posData, indexIVs, sigmas, epsilons, reductions, neighborList->getNeighborList(), forceData);
             energy += dispersionCoefficient/(box[0]*box[1]*box[2]);
         } else {
             vdwForce.setNonbondedMethod( AmoebaReferenceVdwForce::CutoffNonPeriodic);
+            energy  = vdwForce.calculateForceAndEnergy( numParticles, posData, indexIVs, sigmas, epsilons, reductions, neighborList->getNeighborList(), forceData);
         }
     } else {
         vdwForce.setNonbondedMethod( AmoebaReferenceVdwForce::NoCutoff );
@@ -31,7 +31,9 @@
 #include "openmm/amoebaKernels.h"
 #include "openmm/AmoebaMultipoleForce.h"
 #include "AmoebaReferenceMultipoleForce.h"
+#include "AmoebaReferenceNeighborList.h"
 #include "ReferenceNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
 #include "SimTKOpenMMRealType.h"
 
 namespace OpenMM {
@@ -415,11 +417,17 @@ private:
 
     int mutualInducedMaxIterations;
     RealOpenMM mutualInducedTargetEpsilon;
+    int mutualInducedHistorySize;
+    AmoebaMultipoleForce::InducedDipoleSolver inducedDipoleSolver;
+    std::string historyKey;
 
     bool usePme;
     RealOpenMM alphaEwald;
     RealOpenMM cutoffDistance;
     std::vector<int> pmeGridDimension;
+    AmoebaReferenceNeighborList* neighborList;
+    ReferenceExclusionList noExclusions;
+    ThreadPool* threads;
 
     const System& system;
 };
@@ -461,14 +469,15 @@ private:
     double cutoff;
     double dispersionCoefficient;
     std::vector<int> indexIVs;
-    std::vector< std::set<int> > allExclusions;
+    ReferenceExclusionList allExclusions;
     std::vector<RealOpenMM> sigmas;
     std::vector<RealOpenMM> epsilons;
     std::vector<RealOpenMM> reductions;
     std::string sigmaCombiningRule;
     std::string epsilonCombiningRule;
     const System& system;
-    NeighborList* neighborList;
+    AmoebaReferenceNeighborList* neighborList;
+    ThreadPool* threads;
 };
 
 /**
@@ -37,6 +37,7 @@ using OpenMM::RealVec;
 AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce( ) :
                                                    _nonbondedMethod(NoCutoff),
                                                    _numParticles(0), 
+                                                   _inducedDipoleSolver(PCG),
                                                    _electric(138.9354558456),
                                                    _dielectric(1.0),
                                                    _mutualInducedDipoleConverged(0),
@@ -53,6 +54,7 @@ AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce( ) :
 AmoebaReferenceMultipoleForce::AmoebaReferenceMultipoleForce( NonbondedMethod nonbondedMethod ) :
                                                    _nonbondedMethod(NoCutoff),
                                                    _numParticles(0), 
+                                                   _inducedDipoleSolver(PCG),
                                                    _electric(138.9354558456),
                                                    _dielectric(1.0),
                                                    _mutualInducedDipoleConverged(0),
@@ -120,6 +122,28 @@ void AmoebaReferenceMultipoleForce::setPolarizationType( AmoebaReferenceMultipol
     _polarizationType = polarizationType;
 }
 
+AmoebaReferenceMultipoleForce::InducedDipoleSolver AmoebaReferenceMultipoleForce::getInducedDipoleSolver( void ) const 
+{
+    return _inducedDipoleSolver;
+}
+
+void AmoebaReferenceMultipoleForce::setInducedDipoleSolver( AmoebaReferenceMultipoleForce::InducedDipoleSolver solver )
+{
+    _inducedDipoleSolver = solver;
+}
+
+void AmoebaReferenceMultipoleForce::setInitialInducedDipoles( const std::vector<RealVec>& inducedDipole, const std::vector<RealVec>& inducedDipolePolar )
+{
+    _initialInducedDipole      = inducedDipole;
+    _initialInducedDipolePolar = inducedDipolePolar;
+}
+
+void AmoebaReferenceMultipoleForce::getInducedDipoles( std::vector<RealVec>& inducedDipole, std::vector<RealVec>& inducedDipolePolar ) const
+{
+    inducedDipole      = _inducedDipole;
+    inducedDipolePolar = _inducedDipolePolar;
+}
+
 int AmoebaReferenceMultipoleForce::getMutualInducedDipoleConverged( void ) const 
 {
     return _mutualInducedDipoleConverged;
@@ -264,7 +288,7 @@ void AmoebaReferenceMultipoleForce::showScaleMapForParticle( unsigned int partic
 RealOpenMM AmoebaReferenceMultipoleForce::getMultipoleScaleFactor( unsigned int particleI, unsigned int particleJ, ScaleType scaleType ) const 
 {
 
-    MapIntRealOpenMM  scaleMap   = _scaleMaps[particleI][scaleType];
+    const MapIntRealOpenMM& scaleMap = _scaleMaps[particleI][scaleType];
     MapIntRealOpenMMCI isPresent = scaleMap.find( particleJ );
     if( isPresent != scaleMap.end() ){
         return isPresent->second;
@@ -671,9 +695,13 @@ void AmoebaReferenceMultipoleForce::initializeInducedDipoles( std::vector<Update
     _inducedDipole.resize( _numParticles );
     _inducedDipolePolar.resize( _numParticles );
 
+    // start from the extrapolated guess if one was supplied; otherwise from the direct induced dipoles
+
+    bool useGuess = getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual &&
+                    _initialInducedDipole.size() == _numParticles && _initialInducedDipolePolar.size() == _numParticles;
     for( unsigned int ii = 0; ii < _numParticles; ii++ ){
-        _inducedDipole[ii]       = _fixedMultipoleField[ii];
-        _inducedDipolePolar[ii]  = _fixedMultipoleFieldPolar[ii];
+        _inducedDipole[ii]       = useGuess ? _initialInducedDipole[ii]      : _fixedMultipoleField[ii];
+        _inducedDipolePolar[ii]  = useGuess ? _initialInducedDipolePolar[ii] : _fixedMultipoleFieldPolar[ii];
     }
 
     return;
@@ -781,6 +809,146 @@ RealOpenMM AmoebaReferenceMultipoleForce::updateInducedDipole( const std::vector
 void AmoebaReferenceMultipoleForce::convergeInduceDipoles( const std::vector<MultipoleParticleData>& particleData,
                                                            std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField)
 {
+    if( getInducedDipoleSolver() == AmoebaReferenceMultipoleForce::PCG ){
+        convergeInduceDipolesByPCG( particleData, updateInducedDipoleField );
+    } else {
+        convergeInduceDipolesBySOR( particleData, updateInducedDipoleField );
+    }
+    return;
+}
+
+void AmoebaReferenceMultipoleForce::convergeInduceDipolesByPCG( const std::vector<MultipoleParticleData>& particleData,
+                                                                std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField)
+{
+
+    setMutualInducedDipoleConverged( false );
+    unsigned int numSystems = updateInducedDipoleField.size();
+    RealVec zeroVec( 0.0, 0.0, 0.0 );
+
+    // Each set of induced dipoles mu solves (1/polarity - T) mu = E, where E is the fixed multipole field divided
+    // by the polarity (fixedMultipoleField already includes the polarity) and T mu is the field due to the
+    // induced dipoles.  Preconditioning by the polarity, the preconditioned residual z = polarity*r is simply the
+    // change an SOR step would make.  Particles with zero polarity have mu = 0 and are left out of the system.
+
+    std::vector<RealOpenMM> inversePolarity( _numParticles );
+    for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+        inversePolarity[ii] = (particleData[ii].polarity == 0.0 ? 0.0 : 1.0/particleData[ii].polarity);
+    }
+
+    // Compute the initial residuals from the current induced dipoles.
+
+    for( unsigned int kk = 0; kk < numSystems; kk++ ){
+        std::fill( updateInducedDipoleField[kk].inducedDipoleField.begin(), updateInducedDipoleField[kk].inducedDipoleField.end(), zeroVec );
+    }
+    calculateInducedDipoleFields( particleData, updateInducedDipoleField );
+
+    std::vector< std::vector<RealVec> > residual( numSystems, std::vector<RealVec>( _numParticles ) );
+    std::vector< std::vector<RealVec> > precondResidual( numSystems, std::vector<RealVec>( _numParticles ) );
+    std::vector< std::vector<RealVec> > searchDirection( numSystems, std::vector<RealVec>( _numParticles ) );
+    std::vector<RealOpenMM> residualDotPrecond( numSystems, 0.0 );
+    for( unsigned int kk = 0; kk < numSystems; kk++ ){
+        const std::vector<RealVec>& fixedField   = *(updateInducedDipoleField[kk].fixedMultipoleField);
+        const std::vector<RealVec>& inducedField = updateInducedDipoleField[kk].inducedDipoleField;
+        const std::vector<RealVec>& inducedDipole = *(updateInducedDipoleField[kk].inducedDipoles);
+        for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+            RealVec z                   = fixedField[ii] + inducedField[ii]*particleData[ii].polarity - inducedDipole[ii];
+            if( particleData[ii].polarity == 0.0 ){
+                z = zeroVec;
+            }
+            precondResidual[kk][ii]     = z;
+            residual[kk][ii]            = z*inversePolarity[ii];
+            searchDirection[kk][ii]     = z;
+            residualDotPrecond[kk]     += residual[kk][ii].dot( z );
+        }
+    }
+
+    // The field due to the search directions is computed with the same routines used for the induced dipoles.
+
+    std::vector<UpdateInducedDipoleFieldStruct> searchDirectionField;
+    for( unsigned int kk = 0; kk < numSystems; kk++ ){
+        searchDirectionField.push_back( UpdateInducedDipoleFieldStruct( updateInducedDipoleField[kk].fixedMultipoleField, &searchDirection[kk] ) );
+    }
+
+    int iteration             = 0;
+    RealOpenMM epsilon        = 0.0;
+    while( true ){
+
+        // Check for convergence.
+
+        epsilon = 0.0;
+        for( unsigned int kk = 0; kk < numSystems; kk++ ){
+            RealOpenMM sum = 0.0;
+            for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+                sum += precondResidual[kk][ii].dot( precondResidual[kk][ii] );
+            }
+            epsilon = sum > epsilon ? sum : epsilon;
+        }
+        epsilon = _debye*SQRT( epsilon/( static_cast<RealOpenMM>(_numParticles) ) );
+        if( epsilon < getMutualInducedDipoleTargetEpsilon() ){
+            setMutualInducedDipoleConverged( true );
+            break;
+        }
+        if( iteration >= getMaximumMutualInducedDipoleIterations() ){
+            break;
+        }
+        iteration++;
+
+        // Compute the product of the matrix with each search direction.
+
+        for( unsigned int kk = 0; kk < numSystems; kk++ ){
+            std::fill( searchDirectionField[kk].inducedDipoleField.begin(), searchDirectionField[kk].inducedDipoleField.end(), zeroVec );
+        }
+        calculateInducedDipoleFields( particleData, searchDirectionField );
+
+        for( unsigned int kk = 0; kk < numSystems; kk++ ){
+            if( residualDotPrecond[kk] == 0.0 ){
+                continue;
+            }
+            std::vector<RealVec>& p              = searchDirection[kk];
+            std::vector<RealVec>& inducedDipole  = *(updateInducedDipoleField[kk].inducedDipoles);
+            std::vector<RealVec> product( _numParticles );
+            RealOpenMM pDotProduct = 0.0;
+            for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+                if( particleData[ii].polarity != 0.0 ){
+                    product[ii]  = p[ii]*inversePolarity[ii] - searchDirectionField[kk].inducedDipoleField[ii];
+                    pDotProduct += p[ii].dot( product[ii] );
+                }
+            }
+            RealOpenMM alpha = residualDotPrecond[kk]/pDotProduct;
+            RealOpenMM newResidualDotPrecond = 0.0;
+            for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+                if( particleData[ii].polarity != 0.0 ){
+                    inducedDipole[ii]           += p[ii]*alpha;
+                    residual[kk][ii]            -= product[ii]*alpha;
+                    precondResidual[kk][ii]      = residual[kk][ii]*particleData[ii].polarity;
+                    newResidualDotPrecond       += residual[kk][ii].dot( precondResidual[kk][ii] );
+                }
+            }
+            RealOpenMM beta = newResidualDotPrecond/residualDotPrecond[kk];
+            for( unsigned int ii = 0; ii < _numParticles; ii++ ){
+                p[ii] = precondResidual[kk][ii] + p[ii]*beta;
+            }
+            residualDotPrecond[kk] = newResidualDotPrecond;
+        }
+    }
+    setMutualInducedDipoleEpsilon( epsilon );
+    setMutualInducedDipoleIterations( iteration );
+
+    // Recompute the fields from the final induced dipoles.  Subclasses may keep intermediate results of
+    // calculateInducedDipoleFields() (such as the reciprocal space potential for PME) that are used later
+    // when computing forces, and the last evaluation was for a search direction.
+
+    for( unsigned int kk = 0; kk < numSystems; kk++ ){
+        std::fill( updateInducedDipoleField[kk].inducedDipoleField.begin(), updateInducedDipoleField[kk].inducedDipoleField.end(), zeroVec );
+    }
+    calculateInducedDipoleFields( particleData, updateInducedDipoleField );
+
+    return;
+}
+
+void AmoebaReferenceMultipoleForce::convergeInduceDipolesBySOR( const std::vector<MultipoleParticleData>& particleData,
+                                                                std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField)
+{
 
     bool done                 = false;
     setMutualInducedDipoleConverged( false );
@@ -4411,10 +4579,120 @@ const int AmoebaReferencePmeMultipoleForce::AMOEBA_PME_ORDER = 5;
 
 const RealOpenMM AmoebaReferencePmeMultipoleForce::SQRT_PI = 1.77245385091;
 
+/**
+ * Get the range of neighbor list entries processed by one thread.
+ */
+static void getThreadPairRange( unsigned int numPairs, int threadIndex, int numThreads, unsigned int& start, unsigned int& end )
+{
+    unsigned int chunk = (numPairs+numThreads-1)/numThreads;
+    start              = std::min( numPairs, threadIndex*chunk );
+    end                = std::min( numPairs, start+chunk );
+}
+
+/**
+ * Accumulates the direct space fixed multipole fields for a block of the neighbor list into per-thread arrays.
+ */
+class AmoebaReferencePmeMultipoleForce::FixedMultipoleFieldTask : public OpenMM::ThreadPool::Task {
+public:
+    FixedMultipoleFieldTask( const AmoebaReferencePmeMultipoleForce& owner, const vector<MultipoleParticleData>& particleData ) :
+                    owner(owner), particleData(particleData), field(owner._threads->getNumThreads()), fieldPolar(owner._threads->getNumThreads()) {
+    }
+    void execute( OpenMM::ThreadPool& threads, int threadIndex ){
+        field[threadIndex].resize( particleData.size() );
+        fieldPolar[threadIndex].resize( particleData.size() );
+        const NeighborList& pairs = *owner._neighborList;
+        unsigned int start, end;
+        getThreadPairRange( pairs.size(), threadIndex, threads.getNumThreads(), start, end );
+        for( unsigned int kk = start; kk < end; kk++ ){
+            unsigned int ii = pairs[kk].first;
+            unsigned int jj = pairs[kk].second;
+            RealOpenMM dScale, pScale;
+            if( jj <= owner._maxScaleIndex[ii] ){
+                owner.getDScaleAndPScale( ii, jj, dScale, pScale );
+            } else {
+                dScale = pScale = 1.0;
+            }
+            owner.calculateFixedMultipoleFieldPairIxn( particleData[ii], particleData[jj], dScale, pScale, field[threadIndex], fieldPolar[threadIndex] );
+        }
+    }
+    const AmoebaReferencePmeMultipoleForce& owner;
+    const vector<MultipoleParticleData>& particleData;
+    vector<vector<RealVec> > field;
+    vector<vector<RealVec> > fieldPolar;
+};
+
+/**
+ * Accumulates the direct space induced dipole fields for a block of the neighbor list into per-thread copies
+ * of the UpdateInducedDipoleFieldStructs.
+ */
+class AmoebaReferencePmeMultipoleForce::InducedDipoleFieldTask : public OpenMM::ThreadPool::Task {
+public:
+    InducedDipoleFieldTask( AmoebaReferencePmeMultipoleForce& owner, const vector<MultipoleParticleData>& particleData,
+                            const vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields ) :
+                    owner(owner), particleData(particleData), updateInducedDipoleFields(updateInducedDipoleFields),
+                    threadFields(owner._threads->getNumThreads()) {
+    }
+    void execute( OpenMM::ThreadPool& threads, int threadIndex ){
+        vector<UpdateInducedDipoleFieldStruct>& fields = threadFields[threadIndex];
+        for( unsigned int ii = 0; ii < updateInducedDipoleFields.size(); ii++ ){
+            fields.push_back( UpdateInducedDipoleFieldStruct( updateInducedDipoleFields[ii].fixedMultipoleField, updateInducedDipoleFields[ii].inducedDipoles ) );
+        }
+        const NeighborList& pairs = *owner._neighborList;
+        unsigned int start, end;
+        getThreadPairRange( pairs.size(), threadIndex, threads.getNumThreads(), start, end );
+        for( unsigned int kk = start; kk < end; kk++ ){
+            owner.calculateDirectInducedDipolePairIxns( particleData[pairs[kk].first], particleData[pairs[kk].second], fields );
+        }
+    }
+    AmoebaReferencePmeMultipoleForce& owner;
+    const vector<MultipoleParticleData>& particleData;
+    const vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields;
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields;
+};
+
+/**
+ * Computes the direct space electrostatic energy, forces, and torques for a block of the neighbor list.
+ */
+class AmoebaReferencePmeMultipoleForce::ElectrostaticTask : public OpenMM::ThreadPool::Task {
+public:
+    ElectrostaticTask( const AmoebaReferencePmeMultipoleForce& owner, const vector<MultipoleParticleData>& particleData ) :
+                    owner(owner), particleData(particleData), energy(owner._threads->getNumThreads(), 0.0),
+                    forces(owner._threads->getNumThreads()), torques(owner._threads->getNumThreads()) {
+    }
+    void execute( OpenMM::ThreadPool& threads, int threadIndex ){
+        forces[threadIndex].resize( particleData.size() );
+        torques[threadIndex].resize( particleData.size() );
+        vector<RealOpenMM> scaleFactors( LAST_SCALE_TYPE_INDEX, 1.0 );
+        const NeighborList& pairs = *owner._neighborList;
+        unsigned int start, end;
+        getThreadPairRange( pairs.size(), threadIndex, threads.getNumThreads(), start, end );
+        for( unsigned int kk = start; kk < end; kk++ ){
+            unsigned int ii = pairs[kk].first;
+            unsigned int jj = pairs[kk].second;
+            if( jj <= owner._maxScaleIndex[ii] ){
+                owner.getMultipoleScaleFactors( ii, jj, scaleFactors );
+            }
+            energy[threadIndex] += owner.calculatePmeDirectElectrostaticPairIxn( particleData[ii], particleData[jj], scaleFactors,
+                                                                                 forces[threadIndex], torques[threadIndex] );
+            if( jj <= owner._maxScaleIndex[ii] ){
+                for( unsigned int ll = 0; ll < LAST_SCALE_TYPE_INDEX; ll++ ){
+                    scaleFactors[ll] = 1.0;
+                }
+            }
+        }
+    }
+    const AmoebaReferencePmeMultipoleForce& owner;
+    const vector<MultipoleParticleData>& particleData;
+    vector<RealOpenMM> energy;
+    vector<vector<RealVec> > forces;
+    vector<vector<RealVec> > torques;
+};
+
 AmoebaReferencePmeMultipoleForce::AmoebaReferencePmeMultipoleForce( void ) :
                AmoebaReferenceMultipoleForce(PME),
                _cutoffDistance(1.0), _cutoffDistanceSquared(1.0),
-               _pmeGridSize(0), _totalGridSize(0), _alphaEwald(0.0) 
+               _pmeGridSize(0), _totalGridSize(0), _alphaEwald(0.0),
+               _neighborList(NULL), _threads(NULL)
 {
 
     _fftplan = NULL;
@@ -4507,6 +4785,16 @@ int compareInt2( const int2& v1, const int2& v2 )
     return v1[1] < v2[1];
 }
 
+void AmoebaReferencePmeMultipoleForce::setNeighborList( const NeighborList* neighborList )
+{
+    _neighborList = neighborList;
+}
+
+void AmoebaReferencePmeMultipoleForce::setThreadPool( OpenMM::ThreadPool* threads )
+{
+    _threads = threads;
+}
+
 void AmoebaReferencePmeMultipoleForce::resizePmeArrays( void )
 {
 
@@ -4704,6 +4992,14 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn( cons
                                                                             const MultipoleParticleData& particleJ,
                                                                             RealOpenMM dscale, RealOpenMM pscale )
 {
+    calculateFixedMultipoleFieldPairIxn( particleI, particleJ, dscale, pscale, _fixedMultipoleField, _fixedMultipoleFieldPolar );
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn( const MultipoleParticleData& particleI,
+                                                                            const MultipoleParticleData& particleJ,
+                                                                            RealOpenMM dscale, RealOpenMM pscale,
+                                                                            vector<RealVec>& field, vector<RealVec>& fieldPolar ) const
+{
 
     // compute the real space portion of the Ewald summation
 
@@ -4780,11 +5076,11 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn( cons
     unsigned int iIndex    = particleI.particleIndex;
     unsigned int jIndex    = particleJ.particleIndex;
 
-    _fixedMultipoleField[iIndex]      += fim - fid;
-    _fixedMultipoleField[jIndex]      += fjm - fjd;
+    field[iIndex]         += fim - fid;
+    field[jIndex]         += fjm - fjd;
 
-    _fixedMultipoleFieldPolar[iIndex] += fim - fip;
-    _fixedMultipoleFieldPolar[jIndex] += fjm - fjp;
+    fieldPolar[iIndex]    += fim - fip;
+    fieldPolar[jIndex]    += fjm - fjp;
 
     return;
 }
@@ -4818,7 +5114,20 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField( const vecto
 
     // include direct space fixed multipole fields
 
-    this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField( particleData );
+    if( _neighborList == NULL || _threads == NULL ){
+        this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField( particleData );
+        return;
+    }
+
+    FixedMultipoleFieldTask task( *this, particleData );
+    _threads->execute( task );
+    _threads->waitForThreads();
+    for( unsigned int ii = 0; ii < task.field.size(); ii++ ){
+        for( unsigned int jj = 0; jj < _numParticles; jj++ ){
+            _fixedMultipoleField[jj]      += task.field[ii][jj];
+            _fixedMultipoleFieldPolar[jj] += task.fieldPolar[ii][jj];
+        }
+    }
 
     return;
 }
@@ -5755,9 +6064,24 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields( const std::
 
     // direct space ixns
 
-    for( unsigned int ii = 0; ii < particleData.size(); ii++ ){
-        for( unsigned int jj = ii + 1; jj < particleData.size(); jj++ ){
-            calculateDirectInducedDipolePairIxns( particleData[ii], particleData[jj], updateInducedDipoleFields );
+    if( _neighborList == NULL || _threads == NULL ){
+        for( unsigned int ii = 0; ii < particleData.size(); ii++ ){
+            for( unsigned int jj = ii + 1; jj < particleData.size(); jj++ ){
+                calculateDirectInducedDipolePairIxns( particleData[ii], particleData[jj], updateInducedDipoleFields );
+            }
+        }
+    } else {
+        InducedDipoleFieldTask task( *this, particleData, updateInducedDipoleFields );
+        _threads->execute( task );
+        _threads->waitForThreads();
+        for( unsigned int ii = 0; ii < task.threadFields.size(); ii++ ){
+            for( unsigned int kk = 0; kk < updateInducedDipoleFields.size(); kk++ ){
+                vector<RealVec>& field             = updateInducedDipoleFields[kk].inducedDipoleField;
+                const vector<RealVec>& threadField = task.threadFields[ii][kk].inducedDipoleField;
+                for( unsigned int jj = 0; jj < field.size(); jj++ ){
+                    field[jj] += threadField[jj];
+                }
+            }
         }
     }
 
@@ -6624,21 +6948,34 @@ RealOpenMM AmoebaReferencePmeMultipoleForce::calculateElectrostatic( const std::
 
     // loop over particle pairs for direct space interactions
 
-    for( unsigned int ii = 0; ii < particleData.size(); ii++ ){
-        for( unsigned int jj = ii+1; jj < particleData.size(); jj++ ){
+    if( _neighborList == NULL || _threads == NULL ){
+        for( unsigned int ii = 0; ii < particleData.size(); ii++ ){
+            for( unsigned int jj = ii+1; jj < particleData.size(); jj++ ){
 
-            if( jj <= _maxScaleIndex[ii] ){
-                getMultipoleScaleFactors( ii, jj, scaleFactors);
-            }
+                if( jj <= _maxScaleIndex[ii] ){
+                    getMultipoleScaleFactors( ii, jj, scaleFactors);
+                }
 
-            energy += calculatePmeDirectElectrostaticPairIxn( particleData[ii], particleData[jj], scaleFactors, forces, torques );
+                energy += calculatePmeDirectElectrostaticPairIxn( particleData[ii], particleData[jj], scaleFactors, forces, torques );
 
-            if( jj <= _maxScaleIndex[ii] ){
-                for( unsigned int kk = 0; kk < LAST_SCALE_TYPE_INDEX; kk++ ){
-                    scaleFactors[kk] = 1.0;
+                if( jj <= _maxScaleIndex[ii] ){
+                    for( unsigned int kk = 0; kk < LAST_SCALE_TYPE_INDEX; kk++ ){
+                        scaleFactors[kk] = 1.0;
+                    }
                 }
             }
         }
+    } else {
+        ElectrostaticTask task( *this, particleData );
+        _threads->execute( task );
+        _threads->waitForThreads();
+        for( unsigned int ii = 0; ii < task.energy.size(); ii++ ){
+            energy += task.energy[ii];
+            for( unsigned int jj = 0; jj < particleData.size(); jj++ ){
+                forces[jj]  += task.forces[ii][jj];
+                torques[jj] += task.torques[ii][jj];
+            }
+        }
     }
 
     calculatePmeSelfTorque( particleData, torques ); 
@@ -27,6 +27,8 @@
 #include "RealVec.h"
 #include "openmm/AmoebaMultipoleForce.h"
 #include "AmoebaReferenceGeneralizedKirkwoodForce.h"
+#include "ReferenceNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
 #include <map>
 #include "fftpack.h"
 #include <complex>
@@ -335,6 +337,19 @@ public:
         Direct = 1 
     };  
 
+    enum InducedDipoleSolver {
+
+        /** 
+         * Successive over-relaxation
+         */
+        SOR = 0,
+
+        /** 
+         * Conjugate gradient, preconditioned by the polarizabilities
+         */
+        PCG = 1 
+    };  
+
     /**
      * Constructor
      * 
@@ -382,6 +397,37 @@ public:
      */
     void setPolarizationType( PolarizationType polarizationType );
 
+    /**
+     * Get the method used to converge mutual induced dipoles.
+     * 
+     * @return solver
+     */
+    InducedDipoleSolver getInducedDipoleSolver( void ) const;
+
+    /**
+     * Set the method used to converge mutual induced dipoles.
+     * 
+     * @param  solver solver
+     */
+    void setInducedDipoleSolver( InducedDipoleSolver solver );
+
+    /**
+     * Set the initial guess for the mutual induced dipoles; used in place of the direct
+     * induced dipoles when the polarization type is Mutual.  Pass empty vectors to clear the guess.
+     * 
+     * @param  inducedDipole       guess for induced dipoles
+     * @param  inducedDipolePolar  guess for induced dipoles polar
+     */
+    void setInitialInducedDipoles( const std::vector<RealVec>& inducedDipole, const std::vector<RealVec>& inducedDipolePolar );
+
+    /**
+     * Get the induced dipoles from the most recent calculation.
+     * 
+     * @param  inducedDipole       output induced dipoles
+     * @param  inducedDipolePolar  output induced dipoles polar
+     */
+    void getInducedDipoles( std::vector<RealVec>& inducedDipole, std::vector<RealVec>& inducedDipolePolar ) const;
+
     /**
      * Get flag indicating if mutual induced dipoles are converged.
      *
@@ -574,6 +620,7 @@ protected:
 
     NonbondedMethod _nonbondedMethod;
     PolarizationType _polarizationType;
+    InducedDipoleSolver _inducedDipoleSolver;
 
     RealOpenMM _electric;
     RealOpenMM _dielectric;
@@ -590,6 +637,8 @@ protected:
     std::vector<RealVec> _fixedMultipoleFieldPolar;
     std::vector<RealVec> _inducedDipole;
     std::vector<RealVec> _inducedDipolePolar;
+    std::vector<RealVec> _initialInducedDipole;
+    std::vector<RealVec> _initialInducedDipolePolar;
 
     int _mutualInducedDipoleConverged;
     int _mutualInducedDipoleIterations;
@@ -842,6 +891,26 @@ protected:
     void convergeInduceDipoles( const std::vector<MultipoleParticleData>& particleData,
                                 std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField );
 
+    /**
+     * Converge induced dipoles by successive over-relaxation.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    void convergeInduceDipolesBySOR( const std::vector<MultipoleParticleData>& particleData,
+                                     std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField );
+
+    /**
+     * Converge induced dipoles by the conjugate gradient method.  Each set of induced dipoles solves the symmetric
+     * system (1/polarity - T) mu = E, where T gives the field due to the induced dipoles, so this is preconditioned
+     * by the polarities.
+     * 
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    void convergeInduceDipolesByPCG( const std::vector<MultipoleParticleData>& particleData,
+                                     std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField );
+
     /**
      * Update fields due to induced dipoles for each particle.
      * 
@@ -1283,8 +1352,29 @@ public:
      */
      void setPeriodicBoxSize( RealVec& boxSize );
 
+    /**
+     * Set the list of particle pairs to use for direct space interactions.  The list must contain
+     * every pair within the cutoff, with the lower index first; pairs beyond the cutoff are skipped.
+     * If no list is set, all pairs are looped over.
+     *
+     * @param neighborList  pairs to loop over; must remain valid while forces are computed
+     */
+     void setNeighborList( const NeighborList* neighborList );
+
+    /**
+     * Set the thread pool used to compute direct space interactions in parallel.  Only used
+     * when a neighbor list has been set.
+     *
+     * @param threads  thread pool; must remain valid while forces are computed
+     */
+     void setThreadPool( OpenMM::ThreadPool* threads );
+
 private:
 
+    class FixedMultipoleFieldTask;
+    class InducedDipoleFieldTask;
+    class ElectrostaticTask;
+
     static const int AMOEBA_PME_ORDER;
     static const RealOpenMM SQRT_PI;
 
@@ -1315,6 +1405,9 @@ private:
     std::vector<RealOpenMM4> _pmeBsplineTheta;
     std::vector<RealOpenMM4> _pmeBsplineDtheta;
 
+    const NeighborList* _neighborList;
+    OpenMM::ThreadPool* _threads;
+
     /**
      * Resize PME arrays.
      * 
@@ -1370,6 +1463,21 @@ private:
      */
     void calculateFixedMultipoleFieldPairIxn( const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
                                               RealOpenMM dscale, RealOpenMM pscale );
+
+    /**
+     * Calculate direct-space field at site I due fixed multipoles at site J and vice versa,
+     * accumulating into the given arrays.
+     * 
+     * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
+     * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param dScale                  d-scale value for i-j interaction
+     * @param pScale                  p-scale value for i-j interaction
+     * @param field                   fixed multipole field to be updated
+     * @param fieldPolar              fixed multipole polar field to be updated
+     */
+    void calculateFixedMultipoleFieldPairIxn( const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                              RealOpenMM dscale, RealOpenMM pscale,
+                                              std::vector<RealVec>& field, std::vector<RealVec>& fieldPolar ) const;
     
     /**
      * Calculate fixed multipole fields.
@@ -0,0 +1,80 @@
+
+/* Portions copyright (c) 2013 Stanford University and Simbios.
+ * Contributors: Pande Group
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "AmoebaReferenceNeighborList.h"
+#include <algorithm>
+
+using std::vector;
+
+AmoebaReferenceNeighborList::AmoebaReferenceNeighborList( double cutoff, double padding ) :
+                    _cutoff(cutoff), _padding(padding), _listPadding(0.0), _usePeriodic(false) {
+}
+
+bool AmoebaReferenceNeighborList::update( const vector<RealVec>& positions, const RealVec& periodicBoxSize, bool usePeriodic,
+                                          const ReferenceExclusionList& exclusions ){
+
+    bool rebuild = (positions.size() != _lastPositions.size() || usePeriodic != _usePeriodic);
+    if( !rebuild && usePeriodic ){
+        rebuild = (periodicBoxSize[0] != _periodicBoxSize[0] || periodicBoxSize[1] != _periodicBoxSize[1] || periodicBoxSize[2] != _periodicBoxSize[2]);
+    }
+    if( !rebuild ){
+        double maxMove2 = 0.25*_listPadding*_listPadding;
+        for( unsigned int ii = 0; ii < positions.size() && !rebuild; ii++ ){
+            RealVec delta = positions[ii] - _lastPositions[ii];
+            rebuild       = (delta.dot( delta ) > maxMove2);
+        }
+    }
+    if( !rebuild ){
+        return false;
+    }
+
+    // with periodic boundary conditions the list cannot extend past half the box
+
+    double maxDistance = _cutoff + _padding;
+    if( usePeriodic ){
+        double halfBox = 0.5*std::min( periodicBoxSize[0], std::min( periodicBoxSize[1], periodicBoxSize[2] ) );
+        maxDistance    = std::max( _cutoff, std::min( maxDistance, halfBox ) );
+    }
+    _listPadding     = maxDistance - _cutoff;
+    _usePeriodic     = usePeriodic;
+    _periodicBoxSize = periodicBoxSize;
+    _lastPositions   = positions;
+
+    computeNeighborListVoxelHash( _neighborList, positions.size(), positions, exclusions, periodicBoxSize, usePeriodic, maxDistance, 0.0 );
+    for( unsigned int ii = 0; ii < _neighborList.size(); ii++ ){
+        if( _neighborList[ii].first > _neighborList[ii].second ){
+            std::swap( _neighborList[ii].first, _neighborList[ii].second );
+        }
+    }
+    std::sort( _neighborList.begin(), _neighborList.end() );
+    return true;
+}
+
+const NeighborList& AmoebaReferenceNeighborList::getNeighborList( void ) const {
+    return _neighborList;
+}
+
+double AmoebaReferenceNeighborList::getCutoff( void ) const {
+    return _cutoff;
+}
@@ -0,0 +1,93 @@
+
+/* Portions copyright (c) 2013 Stanford University and Simbios.
+ * Contributors: Pande Group
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __AmoebaReferenceNeighborList_H__
+#define __AmoebaReferenceNeighborList_H__
+
+#include "RealVec.h"
+#include "ReferenceNeighborList.h"
+#include <vector>
+
+using namespace OpenMM;
+
+// ---------------------------------------------------------------------------------------
+
+/**
+ * A buffered cell list shared by the AMOEBA multipole and vdW reference forces.
+ *
+ * Pairs are found with the voxel hash in ReferenceNeighborList using the cutoff plus a padding
+ * distance, and the list is reused until some particle has moved more than half the padding since
+ * it was built.  Each pair is stored with the lower index first and the list is sorted, so looping
+ * over it visits interactions in the same order as a double loop over particles.
+ */
+
+class AmoebaReferenceNeighborList {
+
+public:
+
+    /**
+     * Constructor
+     *
+     * @param cutoff   interaction cutoff
+     * @param padding  extra distance included in the list so it can be reused over several steps
+     */
+    AmoebaReferenceNeighborList( double cutoff, double padding );
+
+    /**
+     * Rebuild the list if the box has changed or any particle has moved more than half the padding.
+     *
+     * @param positions        particle positions
+     * @param periodicBoxSize  periodic box dimensions
+     * @param usePeriodic      if true, apply periodic boundary conditions
+     * @param exclusions       pairs to leave out of the list
+     *
+     * @return true if the list was rebuilt
+     */
+    bool update( const std::vector<RealVec>& positions, const RealVec& periodicBoxSize, bool usePeriodic,
+                 const ReferenceExclusionList& exclusions );
+
+    /**
+     * Get the pairs within cutoff plus padding as of the last rebuild.
+     */
+    const NeighborList& getNeighborList( void ) const;
+
+    /**
+     * Get the interaction cutoff.
+     */
+    double getCutoff( void ) const;
+
+private:
+
+    double _cutoff;
+    double _padding;
+    double _listPadding;
+    bool _usePeriodic;
+    RealVec _periodicBoxSize;
+    std::vector<RealVec> _lastPositions;
+    NeighborList _neighborList;
+};
+
+// ---------------------------------------------------------------------------------------
+
+#endif // __AmoebaReferenceNeighborList_H__
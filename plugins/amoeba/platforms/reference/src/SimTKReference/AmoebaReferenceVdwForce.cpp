@@ -29,8 +29,9 @@
 
 using std::vector;
 using OpenMM::RealVec;
+using OpenMM::ReferenceExclusionList;
 
-AmoebaReferenceVdwForce::AmoebaReferenceVdwForce( ) : _nonbondedMethod(NoCutoff), _cutoff(1.0e+10), _taperCutoffFactor(0.9) {
+AmoebaReferenceVdwForce::AmoebaReferenceVdwForce( ) : _nonbondedMethod(NoCutoff), _cutoff(1.0e+10), _taperCutoffFactor(0.9), _threads(NULL) {
 
     setTaperCoefficients( _cutoff );
     setSigmaCombiningRule( "ARITHMETIC" );
@@ -39,7 +40,7 @@ AmoebaReferenceVdwForce::AmoebaReferenceVdwForce( ) : _nonbondedMethod(NoCutoff)
 }
 
 
-AmoebaReferenceVdwForce::AmoebaReferenceVdwForce( const std::string& sigmaCombiningRule, const std::string& epsilonCombiningRule ) : _nonbondedMethod(NoCutoff), _cutoff(1.0e+10), _taperCutoffFactor(0.9) {
+AmoebaReferenceVdwForce::AmoebaReferenceVdwForce( const std::string& sigmaCombiningRule, const std::string& epsilonCombiningRule ) : _nonbondedMethod(NoCutoff), _cutoff(1.0e+10), _taperCutoffFactor(0.9), _threads(NULL) {
 
     setTaperCoefficients( _cutoff );
     setSigmaCombiningRule( sigmaCombiningRule );
@@ -81,6 +82,10 @@ void AmoebaReferenceVdwForce::setPeriodicBox( const RealVec& box ){
     _periodicBoxDimensions = box;
 }
 
+void AmoebaReferenceVdwForce::setThreadPool( OpenMM::ThreadPool* threads ){
+    _threads = threads;
+}
+
 RealVec AmoebaReferenceVdwForce::getPeriodicBox( void ) const {
     return _periodicBoxDimensions;
 }
@@ -208,6 +213,10 @@ RealOpenMM AmoebaReferenceVdwForce::calculatePairIxn( RealOpenMM combindedSigma,
     }
 
     RealOpenMM r_ij_2       = xr*xr + yr*yr + zr*zr;
+    if( (_nonbondedMethod == CutoffNonPeriodic || _nonbondedMethod == CutoffPeriodic) && r_ij_2 > _cutoff*_cutoff ){
+        force[0] = force[1] = force[2] = 0.0;
+        return 0.0;
+    }
     RealOpenMM r_ij         = SQRT(r_ij_2);
     RealOpenMM sigma_7      = combindedSigma*combindedSigma*combindedSigma;
                sigma_7      = sigma_7*sigma_7*combindedSigma;
@@ -277,7 +286,7 @@ RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
                                                              const std::vector<RealOpenMM>& sigmas,
                                                              const std::vector<RealOpenMM>& epsilons,
                                                              const std::vector<RealOpenMM>& reductions,
-                                                             const std::vector< std::set<int> >& allExclusions,
+                                                             const ReferenceExclusionList& allExclusions,
                                                              vector<RealVec>& forces ) const {
 
     // ---------------------------------------------------------------------------------------
@@ -308,8 +317,8 @@ RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
  
         RealOpenMM sigmaI      = sigmas[ii];
         RealOpenMM epsilonI    = epsilons[ii];
-        for( std::set<int>::const_iterator jj = allExclusions[ii].begin(); jj != allExclusions[ii].end(); jj++ ){
-            exclusions[*jj] = 1;
+        for( int jj = 0; jj < allExclusions.getNumExclusions(ii); jj++ ){
+            exclusions[allExclusions.getExclusions(ii)[jj]] = 1;
         }
 
         for( unsigned int jj = ii+1; jj < static_cast<unsigned int>(numParticles); jj++ ){
@@ -341,44 +350,61 @@ RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
             }
         }
 
-        for( std::set<int>::const_iterator jj = allExclusions[ii].begin(); jj != allExclusions[ii].end(); jj++ ){
-            exclusions[*jj] = 0;
+        for( int jj = 0; jj < allExclusions.getNumExclusions(ii); jj++ ){
+            exclusions[allExclusions.getExclusions(ii)[jj]] = 0;
         }
     }
 
     return energy;
 }
 
-RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
-                                                             const vector<RealVec>& particlePositions,
-                                                             const std::vector<int>& indexIVs, 
-                                                             const std::vector<RealOpenMM>& sigmas,
-                                                             const std::vector<RealOpenMM>& epsilons,
-                                                             const std::vector<RealOpenMM>& reductions,
-                                                             const NeighborList& neighborList,
-                                                             vector<RealVec>& forces ) const {
-
-    // ---------------------------------------------------------------------------------------
+class AmoebaReferenceVdwForce::NeighborListTask : public OpenMM::ThreadPool::Task {
+public:
+    NeighborListTask( const AmoebaReferenceVdwForce& owner, const std::vector<Vec3>& reducedPositions, const std::vector<int>& indexIVs,
+                      const std::vector<RealOpenMM>& sigmas, const std::vector<RealOpenMM>& epsilons,
+                      const std::vector<RealOpenMM>& reductions, const NeighborList& neighborList ) :
+            owner(owner), reducedPositions(reducedPositions), indexIVs(indexIVs), sigmas(sigmas), epsilons(epsilons),
+            reductions(reductions), neighborList(neighborList), energy(owner._threads->getNumThreads(), 0.0), forces(owner._threads->getNumThreads()) {
+    }
+    void execute( OpenMM::ThreadPool& threads, int threadIndex ){
+        unsigned int numPairs = neighborList.size();
+        unsigned int chunk    = (numPairs+threads.getNumThreads()-1)/threads.getNumThreads();
+        unsigned int start    = std::min( numPairs, threadIndex*chunk );
+        unsigned int end      = std::min( numPairs, start+chunk );
+        forces[threadIndex].resize( reducedPositions.size() );
+        energy[threadIndex]   = owner.calculateNeighborListIxns( reducedPositions, indexIVs, sigmas, epsilons, reductions,
+                                                                 neighborList, start, end, forces[threadIndex] );
+    }
+    const AmoebaReferenceVdwForce& owner;
+    const std::vector<Vec3>& reducedPositions;
+    const std::vector<int>& indexIVs;
+    const std::vector<RealOpenMM>& sigmas;
+    const std::vector<RealOpenMM>& epsilons;
+    const std::vector<RealOpenMM>& reductions;
+    const NeighborList& neighborList;
+    std::vector<RealOpenMM> energy;
+    std::vector<std::vector<RealVec> > forces;
+};
+
+RealOpenMM AmoebaReferenceVdwForce::calculateNeighborListIxns( const std::vector<Vec3>& reducedPositions,
+                                                               const std::vector<int>& indexIVs, 
+                                                               const std::vector<RealOpenMM>& sigmas,
+                                                               const std::vector<RealOpenMM>& epsilons,
+                                                               const std::vector<RealOpenMM>& reductions,
+                                                               const NeighborList& neighborList,
+                                                               unsigned int start, unsigned int end,
+                                                               vector<RealVec>& forces ) const {
 
-    static const RealOpenMM zero          = 0.0;
     static const RealOpenMM one           = 1.0;
-    static const RealOpenMM two           = 2.0;
-
-    // ---------------------------------------------------------------------------------------
-
-    // set reduced coordinates
 
-    std::vector<Vec3> reducedPositions;
-    setReducedPositions( numParticles, particlePositions, indexIVs, reductions, reducedPositions );
- 
     // loop over neighbor list
     //    (1) calculate pair vdw ixn
     //    (2) accumulate forces: if particle is a site where interaction position != particle position,
     //        then call addReducedForce() to apportion force to particle and its covalent partner
     //        based on reduction factor
 
-    RealOpenMM energy = zero;
-    for( unsigned int ii = 0; ii < neighborList.size(); ii++ ){
+    RealOpenMM energy = 0.0;
+    for( unsigned int ii = start; ii < end; ii++ ){
 
         OpenMM::AtomPair pair       = neighborList[ii];
         int siteI                   = pair.first;
@@ -410,3 +436,43 @@ RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
 
     return energy;
 }
+
+RealOpenMM AmoebaReferenceVdwForce::calculateForceAndEnergy( int numParticles,
+                                                             const vector<RealVec>& particlePositions,
+                                                             const std::vector<int>& indexIVs, 
+                                                             const std::vector<RealOpenMM>& sigmas,
+                                                             const std::vector<RealOpenMM>& epsilons,
+                                                             const std::vector<RealOpenMM>& reductions,
+                                                             const NeighborList& neighborList,
+                                                             vector<RealVec>& forces ) const {
+
+    // ---------------------------------------------------------------------------------------
+
+    static const RealOpenMM zero          = 0.0;
+
+    // ---------------------------------------------------------------------------------------
+
+    // set reduced coordinates
+
+    std::vector<Vec3> reducedPositions;
+    setReducedPositions( numParticles, particlePositions, indexIVs, reductions, reducedPositions );
+ 
+    if( _threads == NULL ){
+        return calculateNeighborListIxns( reducedPositions, indexIVs, sigmas, epsilons, reductions, neighborList, 0, neighborList.size(), forces );
+    }
+
+    // each thread handles a contiguous block of the neighbor list and accumulates into its own force array
+
+    NeighborListTask task( *this, reducedPositions, indexIVs, sigmas, epsilons, reductions, neighborList );
+    _threads->execute( task );
+    _threads->waitForThreads();
+    RealOpenMM energy = zero;
+    for( unsigned int ii = 0; ii < task.energy.size(); ii++ ){
+        energy += task.energy[ii];
+        for( unsigned int jj = 0; jj < static_cast<unsigned int>(numParticles); jj++ ){
+            forces[jj] += task.forces[ii][jj];
+        }
+    }
+
+    return energy;
+}
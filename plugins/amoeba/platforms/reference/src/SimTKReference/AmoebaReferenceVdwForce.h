@@ -28,6 +28,7 @@
 #include "RealVec.h"
 #include "openmm/Vec3.h"
 #include "ReferenceNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
 #include <string>
 #include <vector>
 
@@ -211,7 +212,7 @@ public:
                                         const std::vector<int>& indexIVs, 
                                         const std::vector<RealOpenMM>& sigmas, const std::vector<RealOpenMM>& epsilons,
                                         const std::vector<RealOpenMM>& reductions,
-                                        const std::vector< std::set<int> >& vdwExclusions,
+                                        const OpenMM::ReferenceExclusionList& vdwExclusions,
                                         std::vector<OpenMM::RealVec>& forces ) const;
          
     /**---------------------------------------------------------------------------------------
@@ -238,8 +239,21 @@ public:
                                         const NeighborList& neighborList,
                                         std::vector<OpenMM::RealVec>& forces ) const;
          
+    /**---------------------------------------------------------------------------------------
+    
+       Set the thread pool used to loop over the neighbor list in parallel; if none is set
+       (the default), the neighbor list is processed on the calling thread
+    
+       @param threads                 thread pool; must remain valid while forces are computed
+    
+       --------------------------------------------------------------------------------------- */
+    
+    void setThreadPool( OpenMM::ThreadPool* threads );
+         
 private:
 
+    class NeighborListTask;
+
     // taper coefficient indices
 
     static const int C3=0;
@@ -254,6 +268,7 @@ private:
     double _taperCutoff;
     RealOpenMM _taperCoefficients[3];
     RealVec _periodicBoxDimensions;
+    OpenMM::ThreadPool* _threads;
     CombiningFunction _combineSigmas;
     RealOpenMM arithmeticSigmaCombiningRule( RealOpenMM sigmaI, RealOpenMM sigmaJ ) const;
     RealOpenMM  geometricSigmaCombiningRule( RealOpenMM sigmaI, RealOpenMM sigmaJ ) const;
@@ -282,6 +297,29 @@ private:
     
        --------------------------------------------------------------------------------------- */
     
+    /**---------------------------------------------------------------------------------------
+    
+       Calculate Vdw ixns for a range of entries in a neighbor list
+    
+       @param reducedPositions        reduced positions of particles
+       @param indexIVs                position index for associated reducing particle
+       @param sigmas                  particle sigmas 
+       @param epsilons                particle epsilons
+       @param reductions              particle reduction factors
+       @param neighborList            neighbor list
+       @param start                   first neighbor list entry to process
+       @param end                     one past the last neighbor list entry to process
+       @param forces                  add forces to this vector
+    
+       @return energy
+    
+       --------------------------------------------------------------------------------------- */
+    
+    RealOpenMM calculateNeighborListIxns( const std::vector<Vec3>& reducedPositions, const std::vector<int>& indexIVs, 
+                                          const std::vector<RealOpenMM>& sigmas, const std::vector<RealOpenMM>& epsilons,
+                                          const std::vector<RealOpenMM>& reductions, const NeighborList& neighborList,
+                                          unsigned int start, unsigned int end, std::vector<OpenMM::RealVec>& forces ) const;
+
     void setReducedPositions( int numParticles, const std::vector<RealVec>& particlePositions,
                               const std::vector<int>& indexIVs, const std::vector<RealOpenMM>& reductions,
                               std::vector<Vec3>& reducedPositions ) const;
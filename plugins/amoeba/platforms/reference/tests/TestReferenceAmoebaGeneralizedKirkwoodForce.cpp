@@ -39,6 +39,7 @@
 #include "openmm/System.h"
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/LangevinIntegrator.h"
+#include "openmm/VerletIntegrator.h"
 #include <iostream>
 #include <vector>
 #include <stdlib.h>
@@ -7159,6 +7160,71 @@ static void testGeneralizedKirkwoodAmmoniaMutualPolarization( FILE* log ) {
     compareForcesEnergy( testName, expectedEnergy, energy, expectedForces, forces, tolerance, log );
 }
 
+// compute the energy, forces and system multipole moments using each of the induced dipole solvers,
+// and check they agree.  The system must contain a single AmoebaMultipoleForce using mutual polarization.
+
+static void compareInducedDipoleSolvers( System& system, const std::vector<Vec3>& positions ){
+
+    AmoebaMultipoleForce* amoebaMultipoleForce = NULL;
+    for( int ii = 0; ii < system.getNumForces(); ii++ ){
+        if( dynamic_cast<AmoebaMultipoleForce*>(&system.getForce(ii)) != NULL ){
+            amoebaMultipoleForce = dynamic_cast<AmoebaMultipoleForce*>(&system.getForce(ii));
+        }
+    }
+    ASSERT( amoebaMultipoleForce != NULL );
+    ASSERT_EQUAL( AmoebaMultipoleForce::PCG, amoebaMultipoleForce->getInducedDipoleSolver() );
+
+    std::vector<double> energy(2);
+    std::vector< std::vector<Vec3> > forces(2);
+    std::vector< std::vector<double> > moments(2);
+    AmoebaMultipoleForce::InducedDipoleSolver solvers[2] = { AmoebaMultipoleForce::PCG, AmoebaMultipoleForce::SOR };
+    for( int ii = 0; ii < 2; ii++ ){
+        amoebaMultipoleForce->setInducedDipoleSolver( solvers[ii] );
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, Platform::getPlatformByName( "Reference" ) );
+        context.setPositions(positions);
+        State state = context.getState(State::Forces | State::Energy);
+        energy[ii]  = state.getPotentialEnergy();
+        forces[ii]  = state.getForces();
+        amoebaMultipoleForce->getSystemMultipoleMoments( context, moments[ii] );
+    }
+    amoebaMultipoleForce->setInducedDipoleSolver( AmoebaMultipoleForce::PCG );
+
+    // The two solvers take different paths to the same dipoles, so the results should agree closely
+    // but not be bitwise identical.
+
+    ASSERT( energy[0] != energy[1] );
+    ASSERT_EQUAL_TOL( energy[0], energy[1], 1.0e-5 );
+    for( unsigned int ii = 0; ii < positions.size(); ii++ ){
+        ASSERT_EQUAL_VEC( forces[0][ii], forces[1][ii], 1.0e-4 );
+    }
+
+    // The dipole moment of the system includes the induced dipoles.
+
+    for( int ii = 1; ii < 4; ii++ ){
+        ASSERT_EQUAL_TOL( moments[0][ii], moments[1][ii], 1.0e-5 );
+    }
+}
+
+// compare the PCG and SOR induced dipole solvers with GK
+
+static void testGeneralizedKirkwoodInducedDipoleSolvers( FILE* log ) {
+
+    System system;
+    AmoebaGeneralizedKirkwoodForce* amoebaGeneralizedKirkwoodForce  = new AmoebaGeneralizedKirkwoodForce();
+    setupMultipoleAmmonia(system, amoebaGeneralizedKirkwoodForce, AmoebaMultipoleForce::Mutual, 0);
+    std::vector<Vec3> positions;
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, Platform::getPlatformByName("Reference"));
+        std::vector<Vec3> forces;
+        double energy;
+        getForcesEnergyMultipoleAmmonia(context, forces, energy, log );
+        positions = context.getState(State::Positions).getPositions();
+    }
+    compareInducedDipoleSolvers( system, positions );
+}
+
 // test GK mutual polarization for system comprised of two ammonia molecules
 // including cavity term
 
@@ -8479,6 +8545,7 @@ int main( int numberOfArguments, char* argv[] ) {
         testGeneralizedKirkwoodAmmoniaMutualPolarization( log );
         testGeneralizedKirkwoodAmmoniaDirectPolarization( log );
         testGeneralizedKirkwoodAmmoniaMutualPolarizationWithCavityTerm( log );
+        testGeneralizedKirkwoodInducedDipoleSolvers( log );
         testGeneralizedKirkwoodVillinDirectPolarization( log );
         testGeneralizedKirkwoodVillinMutualPolarization( log );
 
@@ -39,7 +39,11 @@
 #include "openmm/System.h"
 #include "openmm/AmoebaMultipoleForce.h"
 #include "openmm/LangevinIntegrator.h"
+#include "openmm/VerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "ReferencePlatform.h"
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <stdlib.h>
 #include <stdio.h>
@@ -502,22 +506,31 @@ static void testMultipoleAmmoniaMutualPolarization( FILE* log ) {
         exceptionThrown = true;
     }
     ASSERT(exceptionThrown);
+
+    // Querying the force should not count as a parameter change; updating it should.
+
+    ContextImpl* contextImpl = *reinterpret_cast<ContextImpl**>(&context);
+    int version = contextImpl->getForceParametersVersion();
+    std::vector<double> moments, potential;
+    std::vector<Vec3> grid(1, Vec3(0.5, 0.5, 0.5));
+    amoebaMultipoleForce->getSystemMultipoleMoments(context, moments);
+    amoebaMultipoleForce->getElectrostaticPotential(grid, context, potential);
+    ASSERT_EQUAL(version, contextImpl->getForceParametersVersion());
     amoebaMultipoleForce->updateParametersInContext(context);
+    ASSERT(contextImpl->getForceParametersVersion() != version);
     state1 = context.getState(State::Forces | State::Energy);
     compareForcesEnergy( testName, state2.getPotentialEnergy(), state1.getPotentialEnergy(), state2.getForces(), state1.getForces(), tolerance, log );
 }
 
 // setup for box of 4 water molecules -- used to test PME
 
-static void setupAndGetForcesEnergyMultipoleWater( AmoebaMultipoleForce::NonbondedMethod nonbondedMethod,
-                                                   AmoebaMultipoleForce::PolarizationType polarizationType,
-                                                   double cutoff, int inputPmeGridDimension, std::vector<Vec3>& forces,
-                                                   double& energy, FILE* log ){
+static void setupMultipoleWater( AmoebaMultipoleForce::NonbondedMethod nonbondedMethod,
+                                 AmoebaMultipoleForce::PolarizationType polarizationType,
+                                 double cutoff, int inputPmeGridDimension, int historySize,
+                                 System& system, std::vector<Vec3>& positions ){
 
     // beginning of Multipole setup
 
-    System system;
-
     // box dimensions
 
     double boxDimension                               = 1.8643;
@@ -533,6 +546,7 @@ static void setupAndGetForcesEnergyMultipoleWater( AmoebaMultipoleForce::Nonbond
     amoebaMultipoleForce->setCutoffDistance( cutoff );
     amoebaMultipoleForce->setMutualInducedTargetEpsilon( 1.0e-06 );
     amoebaMultipoleForce->setMutualInducedMaxIterations( 500 );
+    amoebaMultipoleForce->setMutualInducedHistorySize( historySize );
     amoebaMultipoleForce->setAEwald( 5.4459052e+00 );
     amoebaMultipoleForce->setEwaldErrorTolerance( 1.0e-04 );
 
@@ -620,7 +634,7 @@ static void setupAndGetForcesEnergyMultipoleWater( AmoebaMultipoleForce::Nonbond
     
     } 
  
-    std::vector<Vec3> positions(numberOfParticles);
+    positions.resize(numberOfParticles);
 
     positions[0]              = Vec3(  -8.7387270e-01,   5.3220410e-01,    7.4214000e-03 );
     positions[1]              = Vec3(  -9.6050090e-01,   5.1173410e-01,   -2.2202700e-02 );
@@ -636,6 +650,16 @@ static void setupAndGetForcesEnergyMultipoleWater( AmoebaMultipoleForce::Nonbond
     positions[11]             = Vec3(   5.0590640e-01,   1.8880920e-01,   -6.8813470e-01 );
 
     system.addForce(amoebaMultipoleForce);
+}
+
+static void setupAndGetForcesEnergyMultipoleWater( AmoebaMultipoleForce::NonbondedMethod nonbondedMethod,
+                                                   AmoebaMultipoleForce::PolarizationType polarizationType,
+                                                   double cutoff, int inputPmeGridDimension, std::vector<Vec3>& forces,
+                                                   double& energy, FILE* log ){
+
+    System system;
+    std::vector<Vec3> positions;
+    setupMultipoleWater( nonbondedMethod, polarizationType, cutoff, inputPmeGridDimension, 0, system, positions );
 
     std::string platformName;
     platformName = "Reference";
@@ -718,6 +742,169 @@ static void testMultipoleWaterPMEMutualPolarization( FILE* log ) {
     compareForcesEnergy( testName, expectedEnergy, energy, expectedForces, forces, tolerance, log );
 }
 
+// test that extrapolating induced dipoles from previous steps reproduces the trajectory
+// obtained without history, and that the history is restored from checkpoints
+
+static void testMultipoleWaterPMEMutualInducedHistory( FILE* log ) {
+
+    System system1, system2;
+    std::vector<Vec3> positions;
+    setupMultipoleWater( AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.70, 20, 0, system1, positions );
+    setupMultipoleWater( AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.70, 20, 4, system2, positions );
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context context1(system1, integrator1, Platform::getPlatformByName( "Reference" ) );
+    Context context2(system2, integrator2, Platform::getPlatformByName( "Reference" ) );
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+
+    for( int step = 0; step < 6; step++ ){
+        integrator1.step(1);
+        integrator2.step(1);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1.0e-5);
+        for( unsigned int ii = 0; ii < positions.size(); ii++ ){
+            ASSERT_EQUAL_VEC(state1.getForces()[ii], state2.getForces()[ii], 1.0e-4);
+        }
+    }
+
+    std::stringstream checkpoint;
+    context2.createCheckpoint(checkpoint);
+    integrator2.step(3);
+    State state1 = context2.getState(State::Forces | State::Energy);
+    context2.loadCheckpoint(checkpoint);
+    integrator2.step(3);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1.0e-10);
+    for( unsigned int ii = 0; ii < positions.size(); ii++ ){
+        ASSERT_EQUAL_VEC(state1.getForces()[ii], state2.getForces()[ii], 1.0e-10);
+    }
+}
+
+// test that a System with two AmoebaMultipoleForces keeps a separate induced dipole history for each one
+
+static void testMultipleForcesInducedHistory( FILE* log ) {
+
+    System system1, system2;
+    std::vector<Vec3> positions;
+    setupMultipoleWater( AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.70, 20, 0, system1, positions );
+    setupMultipoleWater( AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.70, 20, 4, system2, positions );
+    System* systems[] = { &system1, &system2 };
+    for( int ii = 0; ii < 2; ii++ ){
+        AmoebaMultipoleForce* second = new AmoebaMultipoleForce( dynamic_cast<const AmoebaMultipoleForce&>(systems[ii]->getForce(0)) );
+        for( int jj = 0; jj < second->getNumMultipoles(); jj++ ){
+            double charge, thole, damping, polarity;
+            int axisType, atomX, atomY, atomZ;
+            std::vector<double> dipole, quadrupole;
+            second->getMultipoleParameters(jj, charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, polarity);
+            second->setMultipoleParameters(jj, 0.5*charge, dipole, quadrupole, axisType, atomZ, atomX, atomY, thole, damping, 2.0*polarity);
+        }
+        systems[ii]->addForce(second);
+    }
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context context1(system1, integrator1, Platform::getPlatformByName( "Reference" ) );
+    Context context2(system2, integrator2, Platform::getPlatformByName( "Reference" ) );
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for( int step = 0; step < 6; step++ ){
+        integrator1.step(1);
+        integrator2.step(1);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1.0e-5);
+        for( unsigned int ii = 0; ii < positions.size(); ii++ ){
+            ASSERT_EQUAL_VEC(state1.getForces()[ii], state2.getForces()[ii], 1.0e-4);
+        }
+    }
+
+    // Each force should have recorded its own history.
+
+    ContextImpl* contextImpl = *reinterpret_cast<ContextImpl**>(&context2);
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(contextImpl->getPlatformData());
+    int numHistories = 0;
+    for( std::map<std::string, std::vector<double> >::const_iterator iter = data->checkpointData.begin(); iter != data->checkpointData.end(); ++iter ){
+        if( iter->first.find( "inducedDipoles" ) != std::string::npos ){
+            ASSERT_EQUAL(4, static_cast<int>(iter->second[0]));
+            numHistories++;
+        }
+    }
+    ASSERT_EQUAL(2, numHistories);
+}
+
+// compute the energy, forces and system multipole moments using each of the induced dipole solvers,
+// and check they agree.  The system must contain a single AmoebaMultipoleForce using mutual polarization.
+
+static void compareInducedDipoleSolvers( System& system, const std::vector<Vec3>& positions ){
+
+    AmoebaMultipoleForce* amoebaMultipoleForce = NULL;
+    for( int ii = 0; ii < system.getNumForces(); ii++ ){
+        if( dynamic_cast<AmoebaMultipoleForce*>(&system.getForce(ii)) != NULL ){
+            amoebaMultipoleForce = dynamic_cast<AmoebaMultipoleForce*>(&system.getForce(ii));
+        }
+    }
+    ASSERT( amoebaMultipoleForce != NULL );
+    ASSERT_EQUAL( AmoebaMultipoleForce::PCG, amoebaMultipoleForce->getInducedDipoleSolver() );
+
+    std::vector<double> energy(2);
+    std::vector< std::vector<Vec3> > forces(2);
+    std::vector< std::vector<double> > moments(2);
+    AmoebaMultipoleForce::InducedDipoleSolver solvers[2] = { AmoebaMultipoleForce::PCG, AmoebaMultipoleForce::SOR };
+    for( int ii = 0; ii < 2; ii++ ){
+        amoebaMultipoleForce->setInducedDipoleSolver( solvers[ii] );
+        VerletIntegrator integrator(0.001);
+        Context context(system, integrator, Platform::getPlatformByName( "Reference" ) );
+        context.setPositions(positions);
+        State state = context.getState(State::Forces | State::Energy);
+        energy[ii]  = state.getPotentialEnergy();
+        forces[ii]  = state.getForces();
+        amoebaMultipoleForce->getSystemMultipoleMoments( context, moments[ii] );
+    }
+    amoebaMultipoleForce->setInducedDipoleSolver( AmoebaMultipoleForce::PCG );
+
+    // The two solvers take different paths to the same dipoles, so the results should agree closely
+    // but not be bitwise identical.
+
+    ASSERT( energy[0] != energy[1] );
+    ASSERT_EQUAL_TOL( energy[0], energy[1], 1.0e-5 );
+    for( unsigned int ii = 0; ii < positions.size(); ii++ ){
+        ASSERT_EQUAL_VEC( forces[0][ii], forces[1][ii], 1.0e-4 );
+    }
+
+    // The dipole moment of the system includes the induced dipoles.
+
+    for( int ii = 1; ii < 4; ii++ ){
+        ASSERT_EQUAL_TOL( moments[0][ii], moments[1][ii], 1.0e-5 );
+    }
+}
+
+// compare the PCG and SOR induced dipole solvers, with no cutoff and with PME
+
+static void testInducedDipoleSolvers( FILE* log ) {
+
+    System ammoniaSystem;
+    AmoebaMultipoleForce* amoebaMultipoleForce = new AmoebaMultipoleForce();
+    setupMultipoleAmmonia(ammoniaSystem, amoebaMultipoleForce, AmoebaMultipoleForce::NoCutoff, AmoebaMultipoleForce::Mutual, 9000000.0, 0);
+    std::vector<Vec3> ammoniaPositions(ammoniaSystem.getNumParticles());
+    {
+        VerletIntegrator integrator(0.001);
+        Context context(ammoniaSystem, integrator, Platform::getPlatformByName( "Reference" ) );
+        std::vector<Vec3> forces;
+        double energy;
+        getForcesEnergyMultipoleAmmonia(context, forces, energy);
+        ammoniaPositions = context.getState(State::Positions).getPositions();
+    }
+    compareInducedDipoleSolvers( ammoniaSystem, ammoniaPositions );
+
+    System waterSystem;
+    std::vector<Vec3> waterPositions;
+    setupMultipoleWater( AmoebaMultipoleForce::PME, AmoebaMultipoleForce::Mutual, 0.70, 20, 0, waterSystem, waterPositions );
+    compareInducedDipoleSolvers( waterSystem, waterPositions );
+}
+
 // check validation of traceless/symmetric quadrupole tensor
 
 static void testQuadrupoleValidation( FILE* log ){
@@ -2786,6 +2973,12 @@ int main( int numberOfArguments, char* argv[] ) {
 
         testMultipoleWaterPMEDirectPolarization( log );
         testMultipoleWaterPMEMutualPolarization( log );
+        testMultipoleWaterPMEMutualInducedHistory( log );
+        testMultipleForcesInducedHistory( log );
+
+        // compare the induced dipole solvers
+
+        testInducedDipoleSolvers( log );
 
         // check validation of traceless/symmetric quadrupole tensor
 
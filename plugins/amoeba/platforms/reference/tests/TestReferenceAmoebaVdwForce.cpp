@@ -544,6 +544,87 @@ void testVdwPBC( FILE* log ) {
     compareForcesEnergy( testName, expectedEnergy, energy, expectedForces, forces, tolerance, log );
 }
 
+// build a jittered grid of particles interacting through AmoebaVdwForce
+
+void setupVdwGrid( System& system, std::vector<Vec3>& positions ){
+
+    int gridSize                          = 4;
+    double spacing                        = 0.5;
+    double boxDimension                   = 2.0;
+    AmoebaVdwForce* amoebaVdwForce        = new AmoebaVdwForce();
+    amoebaVdwForce->setCutoff( 0.6 );
+    amoebaVdwForce->setNonbondedMethod( AmoebaVdwForce::CutoffPeriodic );
+    amoebaVdwForce->setUseDispersionCorrection( 0 );
+    system.setDefaultPeriodicBoxVectors( Vec3( boxDimension, 0.0, 0.0 ), Vec3( 0.0, boxDimension, 0.0 ), Vec3( 0.0, 0.0, boxDimension ) );
+    for( int ii = 0; ii < gridSize; ii++ ){
+        for( int jj = 0; jj < gridSize; jj++ ){
+            for( int kk = 0; kk < gridSize; kk++ ){
+                int index = system.addParticle( 16.0 );
+                amoebaVdwForce->addParticle( index, 0.3 + 0.01*(index%3), 0.4, 0.0 );
+                positions.push_back( Vec3( spacing*ii + 0.1*sin( 1.3*index ), spacing*jj + 0.1*cos( 0.7*index ), spacing*kk + 0.1*sin( 2.1*index ) ) );
+            }
+        }
+    }
+
+    // exclude each even particle's interaction with the next one
+
+    for( int ii = 0; ii < system.getNumParticles(); ii++ ){
+        std::vector<int> exclusions;
+        exclusions.push_back( ii );
+        exclusions.push_back( ii%2 == 0 ? ii+1 : ii-1 );
+        amoebaVdwForce->setParticleExclusions( ii, exclusions );
+    }
+    system.addForce( amoebaVdwForce );
+}
+
+void getVdwForcesEnergy( System& system, const std::vector<Vec3>& positions, std::vector<Vec3>& forces, double& energy ){
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, Platform::getPlatformByName( "Reference" ) );
+    context.setPositions(positions);
+    State state                      = context.getState(State::Forces | State::Energy);
+    forces                           = state.getForces();
+    energy                           = state.getPotentialEnergy();
+}
+
+// the neighbor list is kept across evaluations while particles move only slightly, and rebuilt once they
+// move farther; either way the results must match a Context that builds its list from scratch
+
+void testVdwNeighborListReuse( FILE* log ) {
+
+    std::string testName      = "testVdwNeighborListReuse";
+
+    System system;
+    std::vector<Vec3> positions;
+    setupVdwGrid( system, positions );
+    int numberOfParticles     = system.getNumParticles();
+    LangevinIntegrator integrator(0.0, 0.1, 0.01);
+    Context context(system, integrator, Platform::getPlatformByName( "Reference" ) );
+    double tolerance          = 1.0e-05;
+
+    for( int step = 0; step < 8; step++ ){
+
+        // the first steps move every particle by much less than the padding, so the list is only rebuilt once the
+        // displacements add up; the last step moves one particle into the range of particles that were outside
+        // the cutoff plus padding
+
+        if( step > 0 && step < 7 ){
+            for( int ii = 0; ii < numberOfParticles; ii++ ){
+                positions[ii] += Vec3( 0.01*sin( 1.0*ii + step ), 0.01*cos( 2.0*ii + step ), 0.01*sin( 3.0*ii - step ) );
+            }
+        } else if( step == 7 ){
+            positions[5] += Vec3( 0.35, -0.3, 0.2 );
+        }
+        context.setPositions(positions);
+        State state                      = context.getState(State::Forces | State::Energy);
+        std::vector<Vec3> forces         = state.getForces();
+        std::vector<Vec3> expectedForces;
+        double expectedEnergy;
+        getVdwForcesEnergy( system, positions, expectedForces, expectedEnergy );
+        ASSERT( expectedEnergy != 0.0 );
+        compareForcesEnergy( testName, expectedEnergy, state.getPotentialEnergy(), expectedForces, forces, tolerance, log );
+    }
+}
+
 // create box of 216 water molecules
 
 void setupAndGetForcesEnergyVdwWater( const std::string& sigmaCombiningRule, const std::string& epsilonCombiningRule, double cutoff,
@@ -2016,6 +2097,10 @@ int main( int numberOfArguments, char* argv[] ) {
 
         testVdwPBC( log );
 
+        // test reuse and rebuilding of the neighbor list
+
+        testVdwNeighborListReuse( log );
+
         // tests based on box of water
 
         int includeVdwDispersionCorrection = 0;
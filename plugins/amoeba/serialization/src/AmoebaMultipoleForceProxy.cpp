@@ -68,7 +68,7 @@ void loadCovalentMap( const SerializationNode& map, std::vector< int >& covalent
 }
 
 void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 2);
+    node.setIntProperty("version", 4);
     const AmoebaMultipoleForce& force = *reinterpret_cast<const AmoebaMultipoleForce*>(object);
 
     node.setIntProperty("nonbondedMethod",                  force.getNonbondedMethod());
@@ -76,6 +76,8 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
     //node.setIntProperty("pmeBSplineOrder",                  force.getPmeBSplineOrder());
     //node.setIntProperty("mutualInducedIterationMethod",     force.getMutualInducedIterationMethod());
     node.setIntProperty("mutualInducedMaxIterations",       force.getMutualInducedMaxIterations());
+    node.setIntProperty("mutualInducedHistorySize",         force.getMutualInducedHistorySize());
+    node.setIntProperty("inducedDipoleSolver",              force.getInducedDipoleSolver());
 
     node.setDoubleProperty("cutoffDistance",                force.getCutoffDistance());
     node.setDoubleProperty("aEwald",                        force.getAEwald());
@@ -124,19 +126,25 @@ void AmoebaMultipoleForceProxy::serialize(const void* object, SerializationNode&
 }
 
 void* AmoebaMultipoleForceProxy::deserialize(const SerializationNode& node) const {
-    if (node.getIntProperty("version") > 2)
+    if (node.getIntProperty("version") > 4)
         throw OpenMMException("Unsupported version number");
     AmoebaMultipoleForce* force = new AmoebaMultipoleForce();
 
     try {
 
         force->setNonbondedMethod( static_cast<AmoebaMultipoleForce::NonbondedMethod>(node.getIntProperty( "nonbondedMethod" )) );
-        if( node.getIntProperty("version") == 2 ){
+        if( node.getIntProperty("version") >= 2 ){
             force->setPolarizationType( static_cast<AmoebaMultipoleForce::PolarizationType>(node.getIntProperty( "polarizationType" )) );
         }
         //force->setPmeBSplineOrder( node.getIntProperty( "pmeBSplineOrder" ) );
         //force->setMutualInducedIterationMethod( static_cast<AmoebaMultipoleForce::MutualInducedIterationMethod>(node.getIntProperty( "mutualInducedIterationMethod" ) ) );
         force->setMutualInducedMaxIterations( node.getIntProperty( "mutualInducedMaxIterations" ) );
+        if( node.getIntProperty("version") >= 3 ){
+            force->setMutualInducedHistorySize( node.getIntProperty( "mutualInducedHistorySize" ) );
+        }
+        if( node.getIntProperty("version") >= 4 ){
+            force->setInducedDipoleSolver( static_cast<AmoebaMultipoleForce::InducedDipoleSolver>(node.getIntProperty( "inducedDipoleSolver" )) );
+        }
 
         force->setCutoffDistance( node.getDoubleProperty( "cutoffDistance" ) );
         force->setAEwald( node.getDoubleProperty( "aEwald" ) );
@@ -69,9 +69,10 @@ void testSerialization() {
     gridDimension.push_back( 63 );
     gridDimension.push_back( 61 );
     force1.setPmeGridDimensions( gridDimension ); 
-    //force1.setMutualInducedIterationMethod( AmoebaMultipoleForce::SOR ); 
+    force1.setInducedDipoleSolver( AmoebaMultipoleForce::SOR ); 
     force1.setMutualInducedMaxIterations( 200 ); 
     force1.setMutualInducedTargetEpsilon( 1.0e-05 ); 
+    force1.setMutualInducedHistorySize( 3 ); 
     //force1.setElectricConstant( 138.93 ); 
     force1.setEwaldErrorTolerance( 1.0e-05 ); 
 
@@ -119,6 +120,8 @@ void testSerialization() {
     //ASSERT_EQUAL(force1.getMutualInducedIterationMethod(),  force2.getMutualInducedIterationMethod());
     ASSERT_EQUAL(force1.getMutualInducedMaxIterations(),    force2.getMutualInducedMaxIterations());
     ASSERT_EQUAL(force1.getMutualInducedTargetEpsilon(),    force2.getMutualInducedTargetEpsilon());
+    ASSERT_EQUAL(force1.getMutualInducedHistorySize(),      force2.getMutualInducedHistorySize());
+    ASSERT_EQUAL(force1.getInducedDipoleSolver(),           force2.getInducedDipoleSolver());
     //ASSERT_EQUAL(force1.getElectricConstant(),              force2.getElectricConstant());
     ASSERT_EQUAL(force1.getEwaldErrorTolerance(),           force2.getEwaldErrorTolerance());
 
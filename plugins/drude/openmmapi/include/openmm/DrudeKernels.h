@@ -138,6 +138,13 @@ public:
      * Compute the kinetic energy.
      */
     virtual double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator) = 0;
+    /**
+     * Get the results of the minimization performed by the most recent call to execute().
+     *
+     * @param evaluations  on exit, the number of force evaluations the minimization used
+     * @param rmsForce     on exit, the root mean square force on the Drude particles when the minimization finished
+     */
+    virtual void getMinimizationResults(int& evaluations, double& rmsForce) = 0;
 };
 
 } // namespace OpenMM
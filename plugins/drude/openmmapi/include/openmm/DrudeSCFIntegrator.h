@@ -73,6 +73,20 @@ public:
     void setMinimizationErrorTolerance(double tol) {
         tolerance = tol;
     }
+    /**
+     * Get the root mean square force on the Drude particles at the end of the minimization performed
+     * in the most recent time step (in kJ/mol/nm).  Compare this to getMinimizationErrorTolerance()
+     * to see how well the minimization converged.
+     */
+    double getLastMinimizationError() const {
+        return lastError;
+    }
+    /**
+     * Get the number of force evaluations used by the minimization in the most recent time step.
+     */
+    int getLastMinimizationEvaluations() const {
+        return lastEvaluations;
+    }
     /**
      * Advance a simulation through time by taking a series of time steps.
      *
@@ -104,7 +118,8 @@ protected:
      */
     double computeKineticEnergy();
 private:
-    double tolerance;
+    double tolerance, lastError;
+    int lastEvaluations;
     Kernel kernel;
 };
 
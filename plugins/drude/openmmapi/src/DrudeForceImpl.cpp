@@ -151,5 +151,6 @@ std::vector<std::string> DrudeForceImpl::getKernelNames() {
 }
 
 void DrudeForceImpl::updateParametersInContext(ContextImpl& context) {
+    context.forceParametersChanged();
     kernel.getAs<CalcDrudeForceKernel>().copyParametersToContext(context, owner);
 }
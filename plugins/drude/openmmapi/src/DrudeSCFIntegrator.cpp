@@ -42,7 +42,7 @@ using namespace OpenMM;
 using std::string;
 using std::vector;
 
-DrudeSCFIntegrator::DrudeSCFIntegrator(double stepSize) {
+DrudeSCFIntegrator::DrudeSCFIntegrator(double stepSize) : lastError(0.0), lastEvaluations(0) {
     setStepSize(stepSize);
     setMinimizationErrorTolerance(0.1);
     setConstraintTolerance(1e-5);
@@ -90,5 +90,6 @@ void DrudeSCFIntegrator::step(int steps) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false);
         kernel.getAs<IntegrateDrudeSCFStepKernel>().execute(*context, *this);
+        kernel.getAs<IntegrateDrudeSCFStepKernel>().getMinimizationResults(lastEvaluations, lastError);
     }
 }
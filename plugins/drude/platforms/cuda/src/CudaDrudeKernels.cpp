@@ -458,7 +458,10 @@ struct MinimizerData {
     ContextImpl& context;
     CudaContext& cu;
     vector<int>& drudeParticles;
-    MinimizerData(ContextImpl& context, CudaContext& cu, vector<int>& drudeParticles) : context(context), cu(cu), drudeParticles(drudeParticles) {}
+    int evaluations;
+    double rmsForce;
+    MinimizerData(ContextImpl& context, CudaContext& cu, vector<int>& drudeParticles) : context(context), cu(cu), drudeParticles(drudeParticles),
+            evaluations(0), rmsForce(0.0) {}
 };
 
 static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
@@ -504,6 +507,11 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
         g[3*i+1] = forceScale*force[index+paddedNumAtoms];
         g[3*i+2] = forceScale*force[index+paddedNumAtoms*2];
     }
+    double sum = 0.0;
+    for (int i = 0; i < 3*numDrudeParticles; i++)
+        sum += g[i]*g[i];
+    data->evaluations++;
+    data->rmsForce = (numDrudeParticles == 0 ? 0.0 : sqrt(sum/numDrudeParticles));
     return energy;
 }
 
@@ -546,4 +554,11 @@ void CudaIntegrateDrudeSCFStepKernel::minimize(ContextImpl& context, double tole
     lbfgsfloatval_t fx;
     MinimizerData data(context, cu, drudeParticles);
     lbfgs(numDrudeParticles*3, minimizerPos, &fx, evaluate, NULL, &data, &minimizerParams);
+    lastEvaluations = data.evaluations;
+    lastRmsForce = data.rmsForce;
+}
+
+void CudaIntegrateDrudeSCFStepKernel::getMinimizationResults(int& evaluations, double& rmsForce) {
+    evaluations = lastEvaluations;
+    rmsForce = lastRmsForce;
 }
\ No newline at end of file
@@ -122,7 +122,7 @@ private:
 class CudaIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
 public:
     CudaIntegrateDrudeSCFStepKernel(std::string name, const Platform& platform, CudaContext& cu) :
-            IntegrateDrudeSCFStepKernel(name, platform), cu(cu), minimizerPos(NULL) {
+            IntegrateDrudeSCFStepKernel(name, platform), cu(cu), minimizerPos(NULL), lastEvaluations(0), lastRmsForce(0.0) {
     }
     ~CudaIntegrateDrudeSCFStepKernel();
     /**
@@ -147,6 +147,13 @@ public:
      * @param integrator  the DrudeSCFIntegrator this kernel is being used for
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
+    /**
+     * Get the results of the minimization performed by the most recent call to execute().
+     *
+     * @param evaluations  on exit, the number of force evaluations the minimization used
+     * @param rmsForce     on exit, the root mean square force on the Drude particles when the minimization finished
+     */
+    void getMinimizationResults(int& evaluations, double& rmsForce);
 private:
     void minimize(ContextImpl& context, double tolerance);
     CudaContext& cu;
@@ -154,6 +161,8 @@ private:
     std::vector<int> drudeParticles;
     lbfgsfloatval_t *minimizerPos;
     lbfgs_parameter_t minimizerParams;
+    int lastEvaluations;
+    double lastRmsForce;
     CUfunction kernel1, kernel2;
 };
 
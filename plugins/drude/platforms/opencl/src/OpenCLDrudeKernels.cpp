@@ -476,7 +476,10 @@ struct MinimizerData {
     ContextImpl& context;
     OpenCLContext& cl;
     vector<int>& drudeParticles;
-    MinimizerData(ContextImpl& context, OpenCLContext& cl, vector<int>& drudeParticles) : context(context), cl(cl), drudeParticles(drudeParticles) {}
+    int evaluations;
+    double rmsForce;
+    MinimizerData(ContextImpl& context, OpenCLContext& cl, vector<int>& drudeParticles) : context(context), cl(cl), drudeParticles(drudeParticles),
+            evaluations(0), rmsForce(0.0) {}
 };
 
 static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
@@ -531,6 +534,11 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
             g[3*i+2] = -force[index].z;
         }
     }
+    double sum = 0.0;
+    for (int i = 0; i < 3*numDrudeParticles; i++)
+        sum += g[i]*g[i];
+    data->evaluations++;
+    data->rmsForce = (numDrudeParticles == 0 ? 0.0 : sqrt(sum/numDrudeParticles));
     return energy;
 }
 
@@ -573,4 +581,11 @@ void OpenCLIntegrateDrudeSCFStepKernel::minimize(ContextImpl& context, double to
     lbfgsfloatval_t fx;
     MinimizerData data(context, cl, drudeParticles);
     lbfgs(numDrudeParticles*3, minimizerPos, &fx, evaluate, NULL, &data, &minimizerParams);
+    lastEvaluations = data.evaluations;
+    lastRmsForce = data.rmsForce;
+}
+
+void OpenCLIntegrateDrudeSCFStepKernel::getMinimizationResults(int& evaluations, double& rmsForce) {
+    evaluations = lastEvaluations;
+    rmsForce = lastRmsForce;
 }
\ No newline at end of file
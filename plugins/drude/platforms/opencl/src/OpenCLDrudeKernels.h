@@ -123,7 +123,7 @@ private:
 class OpenCLIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
 public:
     OpenCLIntegrateDrudeSCFStepKernel(std::string name, const Platform& platform, OpenCLContext& cl) :
-            IntegrateDrudeSCFStepKernel(name, platform), cl(cl), hasInitializedKernels(false), minimizerPos(NULL) {
+            IntegrateDrudeSCFStepKernel(name, platform), cl(cl), hasInitializedKernels(false), minimizerPos(NULL), lastEvaluations(0), lastRmsForce(0.0) {
     }
     ~OpenCLIntegrateDrudeSCFStepKernel();
     /**
@@ -148,6 +148,13 @@ public:
      * @param integrator  the DrudeSCFIntegrator this kernel is being used for
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
+    /**
+     * Get the results of the minimization performed by the most recent call to execute().
+     *
+     * @param evaluations  on exit, the number of force evaluations the minimization used
+     * @param rmsForce     on exit, the root mean square force on the Drude particles when the minimization finished
+     */
+    void getMinimizationResults(int& evaluations, double& rmsForce);
 private:
     void minimize(ContextImpl& context, double tolerance);
     OpenCLContext& cl;
@@ -156,6 +163,8 @@ private:
     std::vector<int> drudeParticles;
     lbfgsfloatval_t *minimizerPos;
     lbfgs_parameter_t minimizerParams;
+    int lastEvaluations;
+    double lastRmsForce;
     cl::Kernel kernel1, kernel2;
 };
 
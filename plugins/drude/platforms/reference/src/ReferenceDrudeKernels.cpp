@@ -32,15 +32,24 @@
 #include "ReferenceDrudeKernels.h"
 #include "openmm/HarmonicAngleForce.h"
 #include "openmm/OpenMMException.h"
+#include "openmm/VirtualSite.h"
 #include "openmm/internal/ContextImpl.h"
-#include "SimTKOpenMMUtilities.h"
+#include "openmm/internal/ForceImpl.h"
+#include "ReferenceRandomStreams.h"
 #include "ReferenceCCMAAlgorithm.h"
 #include "ReferenceVirtualSites.h"
+#include <cmath>
 #include <set>
 
 using namespace OpenMM;
 using namespace std;
 
+/**
+ * The number of correction pairs the SCF minimizer keeps in its L-BFGS history.
+ */
+static const int MINIMIZER_HISTORY_SIZE = 6;
+static const int MINIMIZER_MAX_ITERATIONS = 1000;
+
 static vector<RealVec>& extractPositions(ContextImpl& context) {
     ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
     return *((vector<RealVec>*) data->positions);
@@ -243,7 +252,7 @@ ReferenceIntegrateDrudeLangevinStepKernel::~ReferenceIntegrateDrudeLangevinStepK
 }
 
 void ReferenceIntegrateDrudeLangevinStepKernel::initialize(const System& system, const DrudeLangevinIntegrator& integrator, const DrudeForce& force) {
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
     
     // Identify particle pairs and ordinary particles.
     
@@ -300,13 +309,18 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
     const RealOpenMM fscale = (1-vscale)/integrator.getFriction();
     const RealOpenMM kT = BOLTZ*integrator.getTemperature();
     const RealOpenMM noisescale = sqrt(2*kT*integrator.getFriction())*sqrt(0.5*(1-vscale*vscale)/integrator.getFriction());
-    for (int i = 0; i < (int) normalParticles.size(); i++) {
+    int numNormal = normalParticles.size();
+    int numPairs = pairParticles.size();
+    vector<RealOpenMM> noise(3*numNormal+6*numPairs);
+    if (noise.size() > 0)
+        data.random->fillNormallyDistributedRandomNumbers(&noise[0], noise.size());
+    for (int i = 0; i < numNormal; i++) {
         int index = normalParticles[i];
         RealOpenMM invMass = particleInvMass[index];
         if (invMass != 0.0) {
             RealOpenMM sqrtInvMass = sqrt(invMass);
             for (int j = 0; j < 3; j++)
-                vel[index][j] = vscale*vel[index][j] + fscale*invMass*force[index][j] + noisescale*sqrtInvMass*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+                vel[index][j] = vscale*vel[index][j] + fscale*invMass*force[index][j] + noisescale*sqrtInvMass*noise[3*i+j];
         }
     }
     
@@ -316,7 +330,8 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
     const RealOpenMM fscaleDrude = (1-vscaleDrude)/integrator.getDrudeFriction();
     const RealOpenMM kTDrude = BOLTZ*integrator.getDrudeTemperature();
     const RealOpenMM noisescaleDrude = sqrt(2*kTDrude*integrator.getDrudeFriction())*sqrt(0.5*(1-vscaleDrude*vscaleDrude)/integrator.getDrudeFriction());
-    for (int i = 0; i < (int) pairParticles.size(); i++) {
+    const RealOpenMM* pairNoise = (numPairs > 0 ? &noise[3*numNormal] : NULL);
+    for (int i = 0; i < numPairs; i++) {
         int p1 = pairParticles[i].first;
         int p2 = pairParticles[i].second;
         RealOpenMM mass1fract = pairInvTotalMass[i]/particleInvMass[p1];
@@ -328,8 +343,8 @@ void ReferenceIntegrateDrudeLangevinStepKernel::execute(ContextImpl& context, co
         RealVec cmForce = force[p1]+force[p2];
         RealVec relForce = force[p2]*mass1fract - force[p1]*mass2fract;
         for (int j = 0; j < 3; j++) {
-            cmVel[j] = vscale*cmVel[j] + fscale*pairInvTotalMass[i]*cmForce[j] + noisescale*sqrtInvTotalMass*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-            relVel[j] = vscaleDrude*relVel[j] + fscaleDrude*pairInvReducedMass[i]*relForce[j] + noisescaleDrude*sqrtInvReducedMass*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+            cmVel[j] = vscale*cmVel[j] + fscale*pairInvTotalMass[i]*cmForce[j] + noisescale*sqrtInvTotalMass*pairNoise[6*i+j];
+            relVel[j] = vscaleDrude*relVel[j] + fscaleDrude*pairInvReducedMass[i]*relForce[j] + noisescaleDrude*sqrtInvReducedMass*pairNoise[6*i+3+j];
         }
         vel[p1] = cmVel-relVel*mass2fract;
         vel[p2] = cmVel+relVel*mass1fract;
@@ -370,8 +385,6 @@ double ReferenceIntegrateDrudeLangevinStepKernel::computeKineticEnergy(ContextIm
 ReferenceIntegrateDrudeSCFStepKernel::~ReferenceIntegrateDrudeSCFStepKernel() {
     if (constraints != NULL)
         delete constraints;
-    if (minimizerPos != NULL)
-        lbfgs_free(minimizerPos);
 }
 
 void ReferenceIntegrateDrudeSCFStepKernel::initialize(const System& system, const DrudeSCFIntegrator& integrator, const DrudeForce& force) {
@@ -382,7 +395,16 @@ void ReferenceIntegrateDrudeSCFStepKernel::initialize(const System& system, cons
         double charge, polarizability, aniso12, aniso34;
         force.getParticleParameters(i, p, p1, p2, p3, p4, charge, polarizability, aniso12, aniso34);
         drudeParticles.push_back(p);
+        drudeParents.push_back(p1);
+        
+        // The spring to the parent dominates the Hessian with respect to the Drude particle's
+        // position, so its inverse makes a good diagonal preconditioner for the minimizer.
+        
+        double k = (polarizability > 0.0 ? charge*charge/polarizability : 0.0);
+        drudeInvSpringConstant.push_back(k > 0.0 ? 1.0/k : 1.0);
     }
+    displacement.resize(drudeParticles.size());
+    prevDisplacement.resize(drudeParticles.size());
 
     // Record particle masses.
 
@@ -411,16 +433,7 @@ void ReferenceIntegrateDrudeSCFStepKernel::initialize(const System& system, cons
         findAnglesForCCMA(system, angles);
         constraints = new ReferenceCCMAAlgorithm(system.getNumParticles(), numConstraints, constraintIndices, constraintDistances, particleMass, angles, (RealOpenMM)integrator.getConstraintTolerance());
     }
-    
-    // Initialize the energy minimizer.
-    
-    minimizerPos = lbfgs_malloc(drudeParticles.size()*3);
-    if (minimizerPos == NULL)
-        throw OpenMMException("DrudeSCFIntegrator: Failed to allocate memory");
-    lbfgs_parameter_init(&minimizerParams);
-    minimizerParams.linesearch = LBFGS_LINESEARCH_BACKTRACKING_STRONG_WOLFE;
-    if (sizeof(RealOpenMM) < 8)
-        minimizerParams.xtol = 1e-7;
+
 }
 
 void ReferenceIntegrateDrudeSCFStepKernel::execute(ContextImpl& context, const DrudeSCFIntegrator& integrator) {
@@ -467,25 +480,34 @@ double ReferenceIntegrateDrudeSCFStepKernel::computeKineticEnergy(ContextImpl& c
     return computeShiftedKineticEnergy(context, particleInvMass, 0.5*integrator.getStepSize(), constraints);
 }
 
-struct MinimizerData {
-    ContextImpl& context;
-    vector<int>& drudeParticles;
-    MinimizerData(ContextImpl& context, vector<int>& drudeParticles) : context(context), drudeParticles(drudeParticles) {}
-};
-
-static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
-    MinimizerData* data = reinterpret_cast<MinimizerData*>(instance);
-    ContextImpl& context = data->context;
-    vector<int>& drudeParticles = data->drudeParticles;
-    int numDrudeParticles = drudeParticles.size();
-
-    // Compute the force and energy for this configuration.
+void ReferenceIntegrateDrudeSCFStepKernel::getMinimizationResults(int& evaluations, double& rmsForce) {
+    evaluations = lastEvaluations;
+    rmsForce = lastRmsForce;
+}
 
+double ReferenceIntegrateDrudeSCFStepKernel::computeEnergyAndGradient(ContextImpl& context, const vector<double>& x, vector<double>& g) {
     vector<RealVec>& pos = extractPositions(context);
     vector<RealVec>& force = extractForces(context);
+    int numDrudeParticles = drudeParticles.size();
     for (int i = 0; i < numDrudeParticles; i++)
         pos[drudeParticles[i]] = RealVec(x[3*i], x[3*i+1], x[3*i+2]);
-    double energy = context.calcForcesAndEnergy(true, true);
+    double energy = 0.0;
+    if (useSubsetForces) {
+        // Only compute the interactions that involve Drude particles.  Everything else contributes
+        // a constant to the energy, which does not affect the minimization.
+        
+        for (int i = 0; i < (int) force.size(); i++)
+            force[i] = RealVec();
+        for (int i = 0; i < (int) subsetForceImpls.size(); i++) {
+            double subsetEnergy;
+            if (subsetForceImpls[i]->calcSubsetForcesAndEnergy(context, drudeParticles, subsetEnergy))
+                energy += subsetEnergy;
+            else
+                energy += subsetForceImpls[i]->calcForcesAndEnergy(context, true, true, 0xFFFFFFFF);
+        }
+    }
+    else
+        energy = context.calcForcesAndEnergy(true, true);
     for (int i = 0; i < numDrudeParticles; i++) {
         RealVec f = force[drudeParticles[i]];
         g[3*i] = -f[0];
@@ -495,26 +517,190 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
     return energy;
 }
 
-void ReferenceIntegrateDrudeSCFStepKernel::minimize(ContextImpl& context, double tolerance) {
-    // Record the initial positions and determine a normalization constant for scaling the tolerance.
+void ReferenceIntegrateDrudeSCFStepKernel::findSubsetForces(ContextImpl& context) {
+    hasFoundSubsetForces = true;
+    const System& system = context.getSystem();
+    vector<bool> isDrude(system.getNumParticles(), false);
+    for (int i = 0; i < (int) drudeParticles.size(); i++)
+        isDrude[drudeParticles[i]] = true;
+    
+    // Virtual sites are not updated during the minimization, so if any of them depends on a Drude
+    // particle, just evaluate the full system.
+    
+    for (int i = 0; i < system.getNumParticles(); i++)
+        if (system.isVirtualSite(i)) {
+            const VirtualSite& site = system.getVirtualSite(i);
+            if (isDrude[i])
+                return;
+            for (int j = 0; j < site.getNumParticles(); j++)
+                if (isDrude[site.getParticle(j)])
+                    return;
+        }
+    
+    // Forces that do not involve any Drude particle are skipped.  The others compute just the interactions
+    // involving the Drude particles if they can, and otherwise are evaluated in full.
+    
+    useSubsetForces = true;
+    vector<ForceImpl*>& impls = context.getForceImpls();
+    for (int i = 0; i < (int) impls.size(); i++)
+        if (impls[i]->involvesParticles(isDrude))
+            subsetForceImpls.push_back(impls[i]);
+}
 
+void ReferenceIntegrateDrudeSCFStepKernel::computeSearchDirection(const vector<double>& g, vector<double>& dir) {
+    // Apply the L-BFGS two loop recursion, using the inverse spring constants as the initial Hessian.
+    
+    int n = g.size();
+    int numPairs = historyS.size();
+    vector<double> alpha(numPairs);
+    dir = g;
+    for (int i = numPairs-1; i >= 0; i--) {
+        const vector<double>& s = historyS[i];
+        const vector<double>& y = historyY[i];
+        double sq = 0.0;
+        for (int j = 0; j < n; j++)
+            sq += s[j]*dir[j];
+        alpha[i] = historyRho[i]*sq;
+        for (int j = 0; j < n; j++)
+            dir[j] -= alpha[i]*y[j];
+    }
+    for (int j = 0; j < n; j++)
+        dir[j] *= drudeInvSpringConstant[j/3];
+    for (int i = 0; i < numPairs; i++) {
+        const vector<double>& s = historyS[i];
+        const vector<double>& y = historyY[i];
+        double yr = 0.0;
+        for (int j = 0; j < n; j++)
+            yr += y[j]*dir[j];
+        double beta = historyRho[i]*yr;
+        for (int j = 0; j < n; j++)
+            dir[j] += s[j]*(alpha[i]-beta);
+    }
+    for (int j = 0; j < n; j++)
+        dir[j] = -dir[j];
+}
+
+void ReferenceIntegrateDrudeSCFStepKernel::clearHistory() {
+    historyS.clear();
+    historyY.clear();
+    historyRho.clear();
+}
+
+void ReferenceIntegrateDrudeSCFStepKernel::minimize(ContextImpl& context, double tolerance) {
     vector<RealVec>& pos = extractPositions(context);
     int numDrudeParticles = drudeParticles.size();
-    double norm = 0.0;
+    if (numDrudeParticles == 0) {
+        lastEvaluations = 0;
+        lastRmsForce = 0.0;
+        return;
+    }
+    
+    // Predict the starting positions by extrapolating the displacements from the parent
+    // particles that were found on the previous steps.
+    
+    if (numStoredDisplacements == 1)
+        for (int i = 0; i < numDrudeParticles; i++)
+            pos[drudeParticles[i]] = pos[drudeParents[i]]+displacement[i];
+    else if (numStoredDisplacements > 1)
+        for (int i = 0; i < numDrudeParticles; i++)
+            pos[drudeParticles[i]] = pos[drudeParents[i]]+displacement[i]*2-prevDisplacement[i];
+    if (!hasFoundSubsetForces)
+        findSubsetForces(context);
+    int n = 3*numDrudeParticles;
+    vector<double> x(n), g(n), dir(n), xNew(n), gNew(n);
     for (int i = 0; i < numDrudeParticles; i++) {
         RealVec p = pos[drudeParticles[i]];
-        minimizerPos[3*i] = p[0];
-        minimizerPos[3*i+1] = p[1];
-        minimizerPos[3*i+2] = p[2];
-        norm += p.dot(p);
+        x[3*i] = p[0];
+        x[3*i+1] = p[1];
+        x[3*i+2] = p[2];
     }
-    norm /= numDrudeParticles;
-    norm = (norm < 1 ? 1 : sqrt(norm));
-    minimizerParams.epsilon = tolerance/norm;
     
-    // Perform the minimization.
-
-    lbfgsfloatval_t fx;
-    MinimizerData data(context, drudeParticles);
-    lbfgs(numDrudeParticles*3, minimizerPos, &fx, evaluate, NULL, &data, &minimizerParams);
-}
\ No newline at end of file
+    // Minimize with L-BFGS.  The correction pairs are kept from one step to the next, since the
+    // curvature of the energy with respect to the Drude particles changes little between steps.
+    
+    double energy = computeEnergyAndGradient(context, x, g);
+    int evaluations = 1;
+    double gradNorm2 = 0.0;
+    for (int j = 0; j < n; j++)
+        gradNorm2 += g[j]*g[j];
+    double tolerance2 = tolerance*tolerance*numDrudeParticles;
+    for (int iteration = 0; iteration < MINIMIZER_MAX_ITERATIONS && gradNorm2 > tolerance2; iteration++) {
+        computeSearchDirection(g, dir);
+        double slope = 0.0;
+        for (int j = 0; j < n; j++)
+            slope += dir[j]*g[j];
+        if (slope >= 0.0) {
+            // The history is no longer consistent with the current configuration.
+            
+            clearHistory();
+            computeSearchDirection(g, dir);
+            slope = 0.0;
+            for (int j = 0; j < n; j++)
+                slope += dir[j]*g[j];
+        }
+        
+        // Perform a backtracking line search.
+        
+        double step = 1.0;
+        double newEnergy, newGradNorm2;
+        bool accepted = false;
+        for (int attempt = 0; attempt < 10 && !accepted; attempt++) {
+            for (int j = 0; j < n; j++)
+                xNew[j] = x[j]+step*dir[j];
+            newEnergy = computeEnergyAndGradient(context, xNew, gNew);
+            evaluations++;
+            newGradNorm2 = 0.0;
+            for (int j = 0; j < n; j++)
+                newGradNorm2 += gNew[j]*gNew[j];
+            if (newEnergy <= energy+1e-4*step*slope)
+                accepted = true;
+            else if (newEnergy-energy <= 1e-10*fabs(energy) && newGradNorm2 < gradNorm2)
+                accepted = true; // The energy change is lost in roundoff error.
+            else
+                step *= 0.5;
+        }
+        if (!accepted) {
+            if (historyS.size() == 0)
+                break;
+            clearHistory();
+            continue;
+        }
+        
+        // Record the new correction pair.
+        
+        vector<double> s(n), y(n);
+        double sy = 0.0;
+        for (int j = 0; j < n; j++) {
+            s[j] = xNew[j]-x[j];
+            y[j] = gNew[j]-g[j];
+            sy += s[j]*y[j];
+        }
+        if (sy > 0.0) {
+            if (historyS.size() == MINIMIZER_HISTORY_SIZE) {
+                historyS.erase(historyS.begin());
+                historyY.erase(historyY.begin());
+                historyRho.erase(historyRho.begin());
+            }
+            historyS.push_back(s);
+            historyY.push_back(y);
+            historyRho.push_back(1.0/sy);
+        }
+        x.swap(xNew);
+        g.swap(gNew);
+        energy = newEnergy;
+        gradNorm2 = newGradNorm2;
+    }
+    
+    // Store the final positions and record the displacements for extrapolating on the next step.
+    
+    for (int i = 0; i < numDrudeParticles; i++) {
+        int p = drudeParticles[i];
+        pos[p] = RealVec(x[3*i], x[3*i+1], x[3*i+2]);
+        prevDisplacement[i] = displacement[i];
+        displacement[i] = pos[p]-pos[drudeParents[i]];
+    }
+    if (numStoredDisplacements < 2)
+        numStoredDisplacements++;
+    lastEvaluations = evaluations;
+    lastRmsForce = sqrt(gradNorm2/numDrudeParticles);
+}
@@ -35,7 +35,6 @@
 #include "ReferencePlatform.h"
 #include "openmm/DrudeKernels.h"
 #include "RealVec.h"
-#include "lbfgs.h"
 #include <utility>
 #include <vector>
 
@@ -43,6 +42,9 @@ class ReferenceConstraintAlgorithm;
 
 namespace OpenMM {
 
+class ForceImpl;
+class ReferenceCalcNonbondedForceKernel;
+
 /**
  * This kernel is invoked by DrudeForce to calculate the forces acting on the system and the energy of the system.
  */
@@ -127,7 +129,8 @@ private:
 class ReferenceIntegrateDrudeSCFStepKernel : public IntegrateDrudeSCFStepKernel {
 public:
     ReferenceIntegrateDrudeSCFStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) :
-        IntegrateDrudeSCFStepKernel(name, platform), data(data), constraints(NULL), minimizerPos(NULL) {
+        IntegrateDrudeSCFStepKernel(name, platform), data(data), constraints(NULL), numStoredDisplacements(0), lastEvaluations(0), lastRmsForce(0.0),
+        hasFoundSubsetForces(false), useSubsetForces(false) {
     }
     ~ReferenceIntegrateDrudeSCFStepKernel();
     /**
@@ -152,14 +155,33 @@ public:
      * @param integrator  the DrudeSCFIntegrator this kernel is being used for
      */
     double computeKineticEnergy(ContextImpl& context, const DrudeSCFIntegrator& integrator);
+    /**
+     * Get the results of the minimization performed by the most recent call to execute().
+     *
+     * @param evaluations  on exit, the number of force evaluations the minimization used
+     * @param rmsForce     on exit, the root mean square force on the Drude particles when the minimization finished
+     */
+    void getMinimizationResults(int& evaluations, double& rmsForce);
 private:
     void minimize(ContextImpl& context, double tolerance);
+    double computeEnergyAndGradient(ContextImpl& context, const std::vector<double>& x, std::vector<double>& g);
+    void computeSearchDirection(const std::vector<double>& g, std::vector<double>& dir);
+    void clearHistory();
+    void findSubsetForces(ContextImpl& context);
     ReferencePlatform::PlatformData& data;
     std::vector<int> drudeParticles;
+    std::vector<int> drudeParents;
+    std::vector<double> drudeInvSpringConstant;
     std::vector<double> particleInvMass;
     ReferenceConstraintAlgorithm* constraints;
-    lbfgsfloatval_t *minimizerPos;
-    lbfgs_parameter_t minimizerParams;
+    std::vector<std::vector<double> > historyS, historyY;
+    std::vector<double> historyRho;
+    std::vector<RealVec> displacement, prevDisplacement;
+    int numStoredDisplacements;
+    int lastEvaluations;
+    double lastRmsForce;
+    bool hasFoundSubsetForces, useSubsetForces;
+    std::vector<ForceImpl*> subsetForceImpls;
 };
 
 } // namespace OpenMM
@@ -48,7 +48,7 @@
 using namespace OpenMM;
 using namespace std;
 
-void testWater() {
+void testWater(NonbondedForce::NonbondedMethod method) {
     // Create a box of SWM4-NDP water molecules.  This involves constraints, virtual sites,
     // and Drude particles.
     
@@ -62,7 +62,7 @@ void testWater() {
     system.addForce(nonbonded);
     system.addForce(drude);
     system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
-    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setNonbondedMethod(method);
     nonbonded->setCutoffDistance(1.0);
     for (int i = 0; i < numMolecules; i++) {
         int startIndex = system.getNumParticles();
@@ -108,6 +108,7 @@ void testWater() {
     State state = context.getState(State::Energy);
     double initialEnergy;
     int numSteps = 1000;
+    int totalEvaluations = 0;
     for (int i = 0; i < numSteps; i++) {
         integ.step(1);
         state = context.getState(State::Energy | State::Forces);
@@ -121,12 +122,20 @@ void testWater() {
             norm += sqrt(force[j].dot(force[j]));
         norm = (norm/numMolecules);
         ASSERT(norm < 1.0);
+        ASSERT(integ.getLastMinimizationError() < 1.0);
+        ASSERT(integ.getLastMinimizationEvaluations() > 0);
+        totalEvaluations += integ.getLastMinimizationEvaluations();
     }
+    
+    // Starting each minimization from an extrapolated guess should make most of them very cheap.
+    
+    ASSERT(totalEvaluations < 15*numSteps);
 }
 
 int main() {
     try {
-        testWater();
+        testWater(NonbondedForce::CutoffPeriodic);
+        testWater(NonbondedForce::NoCutoff);
     }
     catch(const std::exception& e) {
         std::cout << "exception: " << e.what() << std::endl;
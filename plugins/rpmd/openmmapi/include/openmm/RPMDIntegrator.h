@@ -61,10 +61,44 @@ namespace OpenMM {
  * might simulate a 32 copy ring polymer and evaluate bonded forces on every copy, but contract
  * it down to only 6 copies for computing nonbonded interactions, and down to only a single
  * copy (the centroid) for computing the reciprocal space part of PME.
+ * 
+ * By default the ring polymer is coupled to a heat bath with the path integral Langevin
+ * equation (PILE-L) thermostat.  Call setThermostatType() to select a different one.
+ * 
+ * This integrator cannot be used with MonteCarloBarostat, since that would change the
+ * positions of each copy independently.  To simulate at constant pressure, add an
+ * RPMDMonteCarloBarostat to the System instead.
  */
 
+class RPMDMonteCarloBarostatImpl;
+
 class OPENMM_EXPORT_RPMD RPMDIntegrator : public Integrator {
 public:
+    /**
+     * This is an enumeration of the different thermostats that may be applied to the ring polymer.
+     */
+    enum ThermostatType {
+        /**
+         * The path integral Langevin equation (PILE-L) thermostat.  The centroid of every particle is coupled
+         * to a local Langevin thermostat, and the remaining normal modes are critically damped.  This is the default.
+         */
+        PileL = 0,
+        /**
+         * The global path integral Langevin equation (PILE-G) thermostat.  The internal normal modes are
+         * treated as in PILE-L, but the centroids are coupled to a global stochastic velocity rescaling
+         * thermostat.  Because it only acts on the total kinetic energy of the centroids, it has much less
+         * effect on dynamical properties than PILE-L.
+         */
+        PileG = 1,
+        /**
+         * The internal normal modes are treated as in PILE-L, but no thermostat is applied to the centroids.
+         */
+        NoCentroidThermostat = 2,
+        /**
+         * No thermostat is applied, so the ring polymer evolves at constant energy.
+         */
+        NoThermostat = 3
+    };
     /**
      * Create a RPMDIntegrator.
      *
@@ -127,6 +161,20 @@ public:
     void setFriction(double coeff) {
         friction = coeff;
     }
+    /**
+     * Get the type of thermostat applied to the ring polymer.
+     */
+    ThermostatType getThermostatType() const {
+        return thermostatType;
+    }
+    /**
+     * Set the type of thermostat applied to the ring polymer.  With PileL, the friction coefficient
+     * is that of the centroid Langevin thermostat.  With PileG, its inverse is the time constant of
+     * the centroid velocity rescaling thermostat.
+     */
+    void setThermostatType(ThermostatType type) {
+        thermostatType = type;
+    }
     /**
      * Get the random number seed.  See setRandomNumberSeed() for details.
      */
@@ -210,11 +258,19 @@ protected:
      * Compute the kinetic energy of the system at the current time.
      */
     double computeKineticEnergy();
+    /**
+     * The kinetic energy is computed directly from the velocities.
+     */
+    bool kineticEnergyRequiresForce() const {
+        return false;
+    }
 private:
     double temperature, friction;
     int numCopies, randomNumberSeed;
+    ThermostatType thermostatType;
     std::map<int, int> contractions;
     bool forcesAreValid, hasSetPosition, hasSetVelocity, isFirstStep;
+    RPMDMonteCarloBarostatImpl* barostat;
     Kernel kernel;
 };
 
@@ -31,8 +31,11 @@
 
 #include "openmm/RPMDIntegrator.h"
 #include "openmm/Context.h"
+#include "openmm/MonteCarloAnisotropicBarostat.h"
+#include "openmm/MonteCarloBarostat.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/RPMDMonteCarloBarostatImpl.h"
 #include "openmm/RpmdKernels.h"
 #include <cmath>
 #include <ctime>
@@ -42,7 +45,7 @@ using namespace OpenMM;
 using namespace std;
 
 RPMDIntegrator::RPMDIntegrator(int numCopies, double temperature, double frictionCoeff, double stepSize, const map<int, int>& contractions) :
-        numCopies(numCopies), contractions(contractions), forcesAreValid(false), hasSetPosition(false), hasSetVelocity(false), isFirstStep(true) {
+        numCopies(numCopies), thermostatType(PileL), contractions(contractions), forcesAreValid(false), hasSetPosition(false), hasSetVelocity(false), isFirstStep(true), barostat(NULL) {
     setTemperature(temperature);
     setFriction(frictionCoeff);
     setStepSize(stepSize);
@@ -51,7 +54,7 @@ RPMDIntegrator::RPMDIntegrator(int numCopies, double temperature, double frictio
 }
 
 RPMDIntegrator::RPMDIntegrator(int numCopies, double temperature, double frictionCoeff, double stepSize) :
-        numCopies(numCopies), forcesAreValid(false), hasSetPosition(false), hasSetVelocity(false), isFirstStep(true) {
+        numCopies(numCopies), thermostatType(PileL), forcesAreValid(false), hasSetPosition(false), hasSetVelocity(false), isFirstStep(true), barostat(NULL) {
     setTemperature(temperature);
     setFriction(frictionCoeff);
     setStepSize(stepSize);
@@ -64,6 +67,15 @@ void RPMDIntegrator::initialize(ContextImpl& contextRef) {
         throw OpenMMException("This Integrator is already bound to a context");
     if (contextRef.getSystem().getNumConstraints() > 0)
         throw OpenMMException("RPMDIntegrator cannot be used with Systems that include constraints");
+    barostat = NULL;
+    const vector<ForceImpl*>& forceImpls = contextRef.getForceImpls();
+    for (int i = 0; i < (int) forceImpls.size(); i++) {
+        const Force& force = forceImpls[i]->getOwner();
+        if (dynamic_cast<const MonteCarloBarostat*>(&force) != NULL || dynamic_cast<const MonteCarloAnisotropicBarostat*>(&force) != NULL)
+            throw OpenMMException("RPMDIntegrator cannot be used with MonteCarloBarostat.  Use RPMDMonteCarloBarostat instead.");
+        if (dynamic_cast<RPMDMonteCarloBarostatImpl*>(forceImpls[i]) != NULL)
+            barostat = dynamic_cast<RPMDMonteCarloBarostatImpl*>(forceImpls[i]);
+    }
     context = &contextRef;
     owner = &contextRef.getOwner();
     kernel = context->getPlatform().createKernel(IntegrateRPMDStepKernel::Name(), contextRef);
@@ -72,6 +84,7 @@ void RPMDIntegrator::initialize(ContextImpl& contextRef) {
 
 void RPMDIntegrator::cleanup() {
     kernel = Kernel();
+    barostat = NULL;
 }
 
 void RPMDIntegrator::stateChanged(State::DataType changed) {
@@ -191,6 +204,8 @@ void RPMDIntegrator::step(int steps) {
         isFirstStep = false;
     }
     for (int i = 0; i < steps; ++i) {
+        if (barostat != NULL && barostat->updateRingPolymer(*context, *this))
+            forcesAreValid = false;
         kernel.getAs<IntegrateRPMDStepKernel>().execute(*context, *this, forcesAreValid);
         forcesAreValid = true;
     }
@@ -0,0 +1,153 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+
+#include "openmm/internal/RPMDMonteCarloBarostatImpl.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/Context.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace OpenMM;
+using namespace OpenMM_SFMT;
+using std::vector;
+
+const float BOLTZMANN = 1.380658e-23f; // (J/K)
+const float AVOGADRO = 6.0221367e23f;
+const float RGAS = BOLTZMANN*AVOGADRO; // (J/(mol K))
+const float BOLTZ = RGAS/1000;         // (kJ/(mol K))
+
+RPMDMonteCarloBarostatImpl::RPMDMonteCarloBarostatImpl(const RPMDMonteCarloBarostat& owner) : owner(owner), step(0) {
+}
+
+void RPMDMonteCarloBarostatImpl::initialize(ContextImpl& context) {
+    Vec3 box[3];
+    context.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    double volume = box[0][0]*box[1][1]*box[2][2];
+    volumeScale = 0.01*volume;
+    numAttempted = 0;
+    numAccepted = 0;
+    init_gen_rand(owner.getRandomNumberSeed(), random);
+}
+
+bool RPMDMonteCarloBarostatImpl::updateRingPolymer(ContextImpl& context, RPMDIntegrator& integrator) {
+    if (++step < owner.getFrequency() || owner.getFrequency() == 0)
+        return false;
+    step = 0;
+    int numCopies = integrator.getNumCopies();
+
+    // Record the current positions of every copy, and compute the average potential energy.
+
+    vector<vector<Vec3> > initialPositions(numCopies);
+    double initialEnergy = 0.0;
+    for (int i = 0; i < numCopies; i++) {
+        State state = integrator.getState(i, State::Positions | State::Energy);
+        initialPositions[i] = state.getPositions();
+        initialEnergy += state.getPotentialEnergy();
+    }
+    initialEnergy /= numCopies;
+
+    // Modify the periodic box size.
+
+    Vec3 box[3];
+    context.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    double volume = box[0][0]*box[1][1]*box[2][2];
+    double deltaVolume = volumeScale*2*(genrand_real2(random)-0.5);
+    double newVolume = volume+deltaVolume;
+    double lengthScale = std::pow(newVolume/volume, 1.0/3.0);
+
+    // Scale the centroid of each molecule, and translate every copy of the molecule by the same
+    // amount so the internal modes of the ring polymer are unchanged.
+
+    const vector<vector<int> >& molecules = context.getMolecules();
+    vector<vector<Vec3> > newPositions = initialPositions;
+    for (int i = 0; i < (int) molecules.size(); i++) {
+        Vec3 center;
+        for (int copy = 0; copy < numCopies; copy++)
+            for (int j = 0; j < (int) molecules[i].size(); j++)
+                center += initialPositions[copy][molecules[i][j]];
+        center *= 1.0/(numCopies*molecules[i].size());
+        Vec3 delta = center*(lengthScale-1.0);
+        for (int copy = 0; copy < numCopies; copy++)
+            for (int j = 0; j < (int) molecules[i].size(); j++)
+                newPositions[copy][molecules[i][j]] += delta;
+    }
+    for (int i = 0; i < numCopies; i++)
+        integrator.setPositions(i, newPositions[i]);
+    context.getOwner().setPeriodicBoxVectors(box[0]*lengthScale, box[1]*lengthScale, box[2]*lengthScale);
+
+    // Compute the energy of the modified system.
+    
+    double finalEnergy = 0.0;
+    for (int i = 0; i < numCopies; i++)
+        finalEnergy += integrator.getState(i, State::Energy).getPotentialEnergy();
+    finalEnergy /= numCopies;
+    double pressure = context.getParameter(RPMDMonteCarloBarostat::Pressure())*(AVOGADRO*1e-25);
+    double kT = BOLTZ*integrator.getTemperature();
+    double w = finalEnergy-initialEnergy + pressure*deltaVolume - molecules.size()*kT*std::log(newVolume/volume);
+    bool accepted = true;
+    if (w > 0 && genrand_real2(random) > std::exp(-w/kT)) {
+        // Reject the step.
+
+        for (int i = 0; i < numCopies; i++)
+            integrator.setPositions(i, initialPositions[i]);
+        context.getOwner().setPeriodicBoxVectors(box[0], box[1], box[2]);
+        volume = newVolume;
+        accepted = false;
+    }
+    else
+        numAccepted++;
+    numAttempted++;
+    if (numAttempted >= 10) {
+        if (numAccepted < 0.25*numAttempted) {
+            volumeScale /= 1.1;
+            numAttempted = 0;
+            numAccepted = 0;
+        }
+        else if (numAccepted > 0.75*numAttempted) {
+            volumeScale = std::min(volumeScale*1.1, volume*0.3);
+            numAttempted = 0;
+            numAccepted = 0;
+        }
+    }
+    return accepted;
+}
+
+std::map<std::string, double> RPMDMonteCarloBarostatImpl::getDefaultParameters() {
+    std::map<std::string, double> parameters;
+    parameters[RPMDMonteCarloBarostat::Pressure()] = getOwner().getDefaultPressure();
+    return parameters;
+}
+
+std::vector<std::string> RPMDMonteCarloBarostatImpl::getKernelNames() {
+    return std::vector<std::string>();
+}
@@ -183,6 +183,8 @@ void CudaIntegrateRPMDStepKernel::initialize(const System& system, const RPMDInt
 }
 
 void CudaIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid) {
+    if (integrator.getThermostatType() != RPMDIntegrator::PileL)
+        throw OpenMMException("RPMDIntegrator: The CUDA platform only supports the PILE-L thermostat");
     cu.setAsCurrent();
     CudaIntegrationUtilities& integration = cu.getIntegrationUtilities();
     
@@ -41,6 +41,14 @@
 using namespace OpenMM;
 using namespace std;
 
+static const int CENTROID_ENERGY_THREADS = 64;
+
+static double getGaussianRandom(OpenMM_SFMT::SFMT& random) {
+    double u1 = OpenMM_SFMT::genrand_real2(random);
+    double u2 = OpenMM_SFMT::genrand_real2(random);
+    return sqrt(-2.0*log(1.0-u1))*cos(2.0*M_PI*u2);
+}
+
 OpenCLIntegrateRPMDStepKernel::~OpenCLIntegrateRPMDStepKernel() {
     if (forces != NULL)
         delete forces;
@@ -52,6 +60,8 @@ OpenCLIntegrateRPMDStepKernel::~OpenCLIntegrateRPMDStepKernel() {
         delete contractedForces;
     if (contractedPositions != NULL)
         delete contractedPositions;
+    if (centroidEnergy != NULL)
+        delete centroidEnergy;
 }
 
 void OpenCLIntegrateRPMDStepKernel::initialize(const System& system, const RPMDIntegrator& integrator) {
@@ -69,6 +79,12 @@ void OpenCLIntegrateRPMDStepKernel::initialize(const System& system, const RPMDI
     positions = new OpenCLArray(cl, numCopies*paddedParticles, elementSize, "rpmdPositions");
     velocities = new OpenCLArray(cl, numCopies*paddedParticles, elementSize, "rpmdVelocities");
     cl.getIntegrationUtilities().initRandomNumberGenerator((unsigned int) integrator.getRandomNumberSeed());
+    OpenMM_SFMT::init_gen_rand((unsigned int) integrator.getRandomNumberSeed(), random);
+    numMassive = 0;
+    for (int i = 0; i < numParticles; i++)
+        if (system.getParticleMass(i) != 0.0)
+            numMassive++;
+    centroidEnergy = new OpenCLArray(cl, CENTROID_ENERGY_THREADS, useDoublePrecision ? sizeof(cl_double) : sizeof(cl_float), "rpmdCentroidEnergy");
     
     // Fill in the posq and velm arrays with safe values to avoid a risk of nans.
     
@@ -143,6 +159,8 @@ void OpenCLIntegrateRPMDStepKernel::initialize(const System& system, const RPMDI
     copyToContextKernel = cl::Kernel(program, "copyDataToContext");
     copyFromContextKernel = cl::Kernel(program, "copyDataFromContext");
     translateKernel = cl::Kernel(program, "applyCellTranslations");
+    centroidEnergyKernel = cl::Kernel(program, "computeCentroidKineticEnergy");
+    centroidScaleKernel = cl::Kernel(program, "scaleCentroidVelocities");
     
     // Create kernels for doing contractions.
     
@@ -173,6 +191,9 @@ void OpenCLIntegrateRPMDStepKernel::initializeKernels(ContextImpl& context) {
     translateKernel.setArg<cl::Buffer>(0, positions->getDeviceBuffer());
     translateKernel.setArg<cl::Buffer>(1, cl.getPosq().getDeviceBuffer());
     translateKernel.setArg<cl::Buffer>(2, cl.getAtomIndexArray().getDeviceBuffer());
+    centroidEnergyKernel.setArg<cl::Buffer>(0, velocities->getDeviceBuffer());
+    centroidEnergyKernel.setArg<cl::Buffer>(1, centroidEnergy->getDeviceBuffer());
+    centroidScaleKernel.setArg<cl::Buffer>(0, velocities->getDeviceBuffer());
     copyToContextKernel.setArg<cl::Buffer>(0, velocities->getDeviceBuffer());
     copyToContextKernel.setArg<cl::Buffer>(1, cl.getVelm().getDeviceBuffer());
     copyToContextKernel.setArg<cl::Buffer>(3, cl.getPosq().getDeviceBuffer());
@@ -192,7 +213,6 @@ void OpenCLIntegrateRPMDStepKernel::initializeKernels(ContextImpl& context) {
 }
 
 void OpenCLIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid) {
-    OpenCLIntegrationUtilities& integration = cl.getIntegrationUtilities();
     if (!hasInitializedKernel)
         initializeKernels(context);
     
@@ -201,29 +221,21 @@ void OpenCLIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDInte
     if (!forcesAreValid)
         computeForces(context);
     
-    // Apply the PILE-L thermostat.
+    // Apply the thermostat.
     
     bool useDoublePrecision = (cl.getUseDoublePrecision() || cl.getUseMixedPrecision());
     const double dt = integrator.getStepSize();
-    pileKernel.setArg<cl_uint>(2, integration.prepareRandomNumbers(numParticles*numCopies));
-    pileKernel.setArg<cl::Buffer>(1, integration.getRandom().getDeviceBuffer()); // Do this *after* prepareRandomNumbers(), which might rebuild the array.
     if (useDoublePrecision) {
-        pileKernel.setArg<cl_double>(3, dt);
-        pileKernel.setArg<cl_double>(4, integrator.getTemperature()*BOLTZ);
-        pileKernel.setArg<cl_double>(5, integrator.getFriction());
         stepKernel.setArg<cl_double>(3, dt);
         stepKernel.setArg<cl_double>(4, integrator.getTemperature()*BOLTZ);
         velocitiesKernel.setArg<cl_double>(2, dt);
     }
     else {
-        pileKernel.setArg<cl_float>(3, (cl_float) dt);
-        pileKernel.setArg<cl_float>(4, (cl_float) (integrator.getTemperature()*BOLTZ));
-        pileKernel.setArg<cl_float>(5, (cl_float) integrator.getFriction());
         stepKernel.setArg<cl_float>(3, (cl_float) dt);
         stepKernel.setArg<cl_float>(4, (cl_float) (integrator.getTemperature()*BOLTZ));
         velocitiesKernel.setArg<cl_float>(2, (cl_float) dt);
     }
-    cl.executeKernel(pileKernel, numParticles*numCopies, workgroupSize);
+    applyThermostat(integrator);
 
     // Update positions and velocities.
     
@@ -236,10 +248,9 @@ void OpenCLIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDInte
     // Update velocities.
     cl.executeKernel(velocitiesKernel, numParticles*numCopies, workgroupSize);
 
-    // Apply the PILE-L thermostat again.
+    // Apply the thermostat again.
 
-    pileKernel.setArg<cl_uint>(2, integration.prepareRandomNumbers(numParticles*numCopies));
-    cl.executeKernel(pileKernel, numParticles*numCopies, workgroupSize);
+    applyThermostat(integrator);
 
     // Update the time and step count.
 
@@ -255,6 +266,70 @@ void OpenCLIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDInte
     }
 }
 
+void OpenCLIntegrateRPMDStepKernel::applyThermostat(const RPMDIntegrator& integrator) {
+    RPMDIntegrator::ThermostatType type = integrator.getThermostatType();
+    if (type == RPMDIntegrator::NoThermostat)
+        return;
+    OpenCLIntegrationUtilities& integration = cl.getIntegrationUtilities();
+    bool useDoublePrecision = (cl.getUseDoublePrecision() || cl.getUseMixedPrecision());
+    const double dt = integrator.getStepSize();
+    const double kT = integrator.getTemperature()*BOLTZ;
+    pileKernel.setArg<cl_uint>(2, integration.prepareRandomNumbers(numParticles*numCopies));
+    pileKernel.setArg<cl::Buffer>(1, integration.getRandom().getDeviceBuffer()); // Do this *after* prepareRandomNumbers(), which might rebuild the array.
+    if (useDoublePrecision) {
+        pileKernel.setArg<cl_double>(3, dt);
+        pileKernel.setArg<cl_double>(4, kT);
+        pileKernel.setArg<cl_double>(5, integrator.getFriction());
+    }
+    else {
+        pileKernel.setArg<cl_float>(3, (cl_float) dt);
+        pileKernel.setArg<cl_float>(4, (cl_float) kT);
+        pileKernel.setArg<cl_float>(5, (cl_float) integrator.getFriction());
+    }
+    pileKernel.setArg<cl_int>(6, type == RPMDIntegrator::PileL ? 1 : 0);
+    cl.executeKernel(pileKernel, numParticles*numCopies, workgroupSize);
+    if (type != RPMDIntegrator::PileG || numMassive == 0)
+        return;
+
+    // Apply a global stochastic velocity rescaling thermostat to the centroids.  The kinetic
+    // energy is summed on the device, and the scale factor is chosen on the host.
+
+    cl.executeKernel(centroidEnergyKernel, CENTROID_ENERGY_THREADS, CENTROID_ENERGY_THREADS);
+    double centroidKE = 0.0;
+    if (useDoublePrecision) {
+        vector<cl_double> energy;
+        centroidEnergy->download(energy);
+        for (int i = 0; i < (int) energy.size(); i++)
+            centroidKE += energy[i];
+    }
+    else {
+        vector<cl_float> energy;
+        centroidEnergy->download(energy);
+        for (int i = 0; i < (int) energy.size(); i++)
+            centroidKE += energy[i];
+    }
+    if (centroidKE == 0.0)
+        return;
+    const int dof = 3*numMassive;
+    const double r1 = getGaussianRandom(random);
+    double sumSquares = 0.0;
+    for (int i = 1; i < dof; i++) {
+        double r = getGaussianRandom(random);
+        sumSquares += r*r;
+    }
+    const double targetKE = 0.5*dof*numCopies*kT;
+    const double c = exp(-0.5*dt*integrator.getFriction());
+    const double ratio = targetKE/(dof*centroidKE);
+    const double alpha2 = c + (1.0-c)*(r1*r1+sumSquares)*ratio + 2.0*r1*sqrt(c*(1.0-c)*ratio);
+    const double sign = (r1+sqrt(c/((1.0-c)*ratio)) < 0.0 ? -1.0 : 1.0);
+    const double alpha = sign*sqrt(alpha2);
+    if (useDoublePrecision)
+        centroidScaleKernel.setArg<cl_double>(1, alpha);
+    else
+        centroidScaleKernel.setArg<cl_float>(1, (cl_float) alpha);
+    cl.executeKernel(centroidScaleKernel, numParticles);
+}
+
 void OpenCLIntegrateRPMDStepKernel::computeForces(ContextImpl& context) {
     // Compute forces from all groups that didn't have a specified contraction.
 
@@ -35,6 +35,7 @@
 #include "openmm/RpmdKernels.h"
 #include "OpenCLContext.h"
 #include "OpenCLArray.h"
+#include "sfmt/SFMT.h"
 #include <map>
 namespace OpenMM {
 
@@ -45,7 +46,7 @@ namespace OpenMM {
 class OpenCLIntegrateRPMDStepKernel : public IntegrateRPMDStepKernel {
 public:
     OpenCLIntegrateRPMDStepKernel(std::string name, const Platform& platform, OpenCLContext& cl) :
-            IntegrateRPMDStepKernel(name, platform), cl(cl), hasInitializedKernel(false), forces(NULL), positions(NULL), velocities(NULL), contractedForces(NULL), contractedPositions(NULL) {
+            IntegrateRPMDStepKernel(name, platform), cl(cl), hasInitializedKernel(false), forces(NULL), positions(NULL), velocities(NULL), contractedForces(NULL), contractedPositions(NULL), centroidEnergy(NULL) {
     }
     ~OpenCLIntegrateRPMDStepKernel();
     /**
@@ -86,10 +87,11 @@ public:
 private:
     void initializeKernels(ContextImpl& context);
     void computeForces(ContextImpl& context);
+    void applyThermostat(const RPMDIntegrator& integrator);
     std::string createFFT(int size, const std::string& variable, bool forward);
     OpenCLContext& cl;
     bool hasInitializedKernel;
-    int numCopies, numParticles, workgroupSize;
+    int numCopies, numParticles, numMassive, workgroupSize;
     std::map<int, int> groupsByCopies;
     int groupsNotContracted;
     OpenCLArray* forces;
@@ -97,7 +99,10 @@ private:
     OpenCLArray* velocities;
     OpenCLArray* contractedForces;
     OpenCLArray* contractedPositions;
+    OpenCLArray* centroidEnergy;
+    OpenMM_SFMT::SFMT random;
     cl::Kernel pileKernel, stepKernel, velocitiesKernel, copyToContextKernel, copyFromContextKernel, translateKernel;
+    cl::Kernel centroidEnergyKernel, centroidScaleKernel;
     std::map<int, cl::Kernel> positionContractionKernels;
     std::map<int, cl::Kernel> forceContractionKernels;
 };
@@ -15,10 +15,10 @@ mixed4 multiplyComplexImagPartConj(mixed2 c1, mixed4 c2r, mixed4 c2i) {
 }
 
 /**
- * Apply the PILE-L thermostat.
+ * Apply the PILE-L thermostat.  If applyToCentroid is 0, only the internal modes are thermostatted.
  */
 __kernel void applyPileThermostat(__global mixed4* velm, __global float4* random, unsigned int randomIndex,
-        mixed dt, mixed kT, mixed friction) {
+        mixed dt, mixed kT, mixed friction, int applyToCentroid) {
     const int numBlocks = get_global_size(0)/NUM_COPIES;
     const int blockStart = NUM_COPIES*(get_local_id(0)/NUM_COPIES);
     const int indexInBlock = get_local_id(0)-blockStart;
@@ -52,7 +52,8 @@ __kernel void applyPileThermostat(__global mixed4* velm, __global float4* random
         if (indexInBlock == 0) {
             // Apply a local Langevin thermostat to the centroid mode.
 
-            vreal[0].xyz = vreal[0].xyz*c1_0 + c3_0*convert_mixed4(random[randomIndex]).xyz;
+            if (applyToCentroid)
+                vreal[0].xyz = vreal[0].xyz*c1_0 + c3_0*convert_mixed4(random[randomIndex]).xyz;
         }
         else {
             // Use critical damping white noise for the remaining modes.
@@ -79,6 +80,41 @@ __kernel void applyPileThermostat(__global mixed4* velm, __global float4* random
     }
 }
 
+/**
+ * Compute the kinetic energy of the centroid mode.  Each thread sums the contributions from a
+ * subset of particles, and the partial sums are added up on the host.
+ */
+__kernel void computeCentroidKineticEnergy(__global mixed4* velm, __global mixed* energy) {
+    mixed sum = 0.0f;
+    for (int particle = get_global_id(0); particle < NUM_ATOMS; particle += get_global_size(0)) {
+        mixed invMass = velm[particle].w;
+        if (invMass != 0) {
+            mixed4 centroid = (mixed4) (0.0f, 0.0f, 0.0f, 0.0f);
+            for (int k = 0; k < NUM_COPIES; k++)
+                centroid.xyz += velm[particle+k*PADDED_NUM_ATOMS].xyz;
+            centroid.xyz /= NUM_COPIES;
+            sum += NUM_COPIES*(centroid.x*centroid.x+centroid.y*centroid.y+centroid.z*centroid.z)/invMass;
+        }
+    }
+    energy[get_global_id(0)] = 0.5f*sum;
+}
+
+/**
+ * Scale the centroid velocity of every particle, leaving the internal modes unchanged.
+ */
+__kernel void scaleCentroidVelocities(__global mixed4* velm, mixed scale) {
+    for (int particle = get_global_id(0); particle < NUM_ATOMS; particle += get_global_size(0)) {
+        if (velm[particle].w != 0) {
+            mixed4 centroid = (mixed4) (0.0f, 0.0f, 0.0f, 0.0f);
+            for (int k = 0; k < NUM_COPIES; k++)
+                centroid.xyz += velm[particle+k*PADDED_NUM_ATOMS].xyz;
+            centroid.xyz *= (scale-1.0f)/NUM_COPIES;
+            for (int k = 0; k < NUM_COPIES; k++)
+                velm[particle+k*PADDED_NUM_ATOMS].xyz += centroid.xyz;
+        }
+    }
+}
+
 /**
  * Advance the positions and velocities.
  */
@@ -53,7 +53,7 @@ using namespace std;
 
 extern "C" OPENMM_EXPORT void registerRPMDOpenCLKernelFactories();
 
-void testFreeParticles() {
+void testFreeParticles(RPMDIntegrator::ThermostatType thermostat) {
     const int numParticles = 100;
     const int numCopies = 30;
     const double temperature = 300.0;
@@ -62,6 +62,7 @@ void testFreeParticles() {
     for (int i = 0; i < numParticles; i++)
         system.addParticle(mass);
     RPMDIntegrator integ(numCopies, temperature, 10.0, 0.001);
+    integ.setThermostatType(thermostat);
     Platform& platform = Platform::getPlatformByName("OpenCL");
     Context context(system, integ, platform);
     OpenMM_SFMT::SFMT sfmt;
@@ -437,7 +438,8 @@ int main(int argc, char* argv[]) {
         registerRPMDOpenCLKernelFactories();
         if (argc > 1)
             Platform::getPlatformByName("OpenCL").setPropertyDefaultValue("OpenCLPrecision", string(argv[1]));
-        testFreeParticles();
+        testFreeParticles(RPMDIntegrator::PileL);
+        testFreeParticles(RPMDIntegrator::PileG);
         testParaHydrogen();
         testCMMotionRemoval();
         testVirtualSites();
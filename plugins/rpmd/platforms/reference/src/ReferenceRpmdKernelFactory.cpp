@@ -51,7 +51,8 @@ extern "C" void initRpmdReferenceKernels() {
 }
 
 KernelImpl* ReferenceRpmdKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
+    ReferencePlatform::PlatformData& data = *static_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
     if (name == IntegrateRPMDStepKernel::Name())
-        return new ReferenceIntegrateRPMDStepKernel(name, platform);
+        return new ReferenceIntegrateRPMDStepKernel(name, platform, data);
     throw OpenMMException((std::string("Tried to create kernel with illegal kernel name '")+name+"'").c_str());
 }
@@ -31,8 +31,10 @@
 
 #include "ReferenceRpmdKernels.h"
 #include "openmm/OpenMMException.h"
+#include "openmm/VerletIntegrator.h"
 #include "openmm/internal/ContextImpl.h"
-#include "SimTKOpenMMUtilities.h"
+#include "ReferenceRandomStreams.h"
+#include <algorithm>
 
 using namespace OpenMM;
 using namespace std;
@@ -52,7 +54,44 @@ static vector<RealVec>& extractForces(ContextImpl& context) {
     return *((vector<RealVec>*) data->forces);
 }
 
+class ReferenceIntegrateRPMDStepKernel::ComputeForcesTask : public ThreadPool::Task {
+public:
+    ComputeForcesTask(ContextImpl& context, const vector<Context*>& shadowContexts, const vector<vector<RealVec> >& copyPositions,
+            vector<vector<RealVec> >& copyForces, int numCopies, int groups) : context(context), shadowContexts(shadowContexts),
+            copyPositions(copyPositions), copyForces(copyForces), numCopies(numCopies), groups(groups) {
+    }
+    void execute(ThreadPool& threads, int threadIndex) {
+        for (int i = threadIndex; i < numCopies; i += threads.getNumThreads()) {
+            if (threadIndex == 0) {
+                extractPositions(context) = copyPositions[i];
+                context.calcForcesAndEnergy(true, false, groups);
+                copyForces[i] = extractForces(context);
+            }
+            else {
+                Context& shadow = *shadowContexts[threadIndex-1];
+                int numParticles = copyPositions[i].size();
+                vector<Vec3> pos(numParticles);
+                for (int j = 0; j < numParticles; j++)
+                    pos[j] = copyPositions[i][j];
+                shadow.setPositions(pos);
+                State state = shadow.getState(State::Forces, false, groups);
+                const vector<Vec3>& f = state.getForces();
+                for (int j = 0; j < numParticles; j++)
+                    copyForces[i][j] = f[j];
+            }
+        }
+    }
+    ContextImpl& context;
+    const vector<Context*>& shadowContexts;
+    const vector<vector<RealVec> >& copyPositions;
+    vector<vector<RealVec> >& copyForces;
+    int numCopies, groups;
+};
+
 ReferenceIntegrateRPMDStepKernel::~ReferenceIntegrateRPMDStepKernel() {
+    deleteShadowContexts();
+    if (threads != NULL)
+        delete threads;
     if (fft != NULL)
         fftpack_destroy(fft);
     for (map<int, fftpack*>::const_iterator iter = contractionFFT.begin(); iter != contractionFFT.end(); ++iter)
@@ -72,7 +111,8 @@ void ReferenceIntegrateRPMDStepKernel::initialize(const System& system, const RP
         forces[i].resize(numParticles);
     }
     fftpack_init_1d(&fft, numCopies);
-    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    threads = new ThreadPool();
+    data.random->setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
     
     // Build a list of contractions.
     
@@ -116,57 +156,15 @@ void ReferenceIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDI
     const RealOpenMM dt = integrator.getStepSize();
     const RealOpenMM halfdt = 0.5*dt;
     const System& system = context.getSystem();
-    vector<RealVec>& pos = extractPositions(context);
-    vector<RealVec>& vel = extractVelocities(context);
-    vector<RealVec>& f = extractForces(context);
     
     // Loop over copies and compute the force on each one.
     
     if (!forcesAreValid)
         computeForces(context, integrator);
 
-    // Apply the PILE-L thermostat.
+    // Apply the thermostat.
     
-    vector<t_complex> v(numCopies);
-    vector<t_complex> q(numCopies);
-    const RealOpenMM hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
-    const RealOpenMM scale = 1.0/sqrt((RealOpenMM) numCopies);
-    const RealOpenMM nkT = numCopies*BOLTZ*integrator.getTemperature();
-    const RealOpenMM twown = 2.0*nkT/hbar;
-    const RealOpenMM c1_0 = exp(-halfdt*integrator.getFriction());
-    const RealOpenMM c2_0 = sqrt(1.0-c1_0*c1_0);
-    for (int particle = 0; particle < numParticles; particle++) {
-        if (system.getParticleMass(particle) == 0.0)
-            continue;
-        const RealOpenMM c3_0 = c2_0*sqrt(nkT/system.getParticleMass(particle));
-        for (int component = 0; component < 3; component++) {
-            for (int k = 0; k < numCopies; k++)
-                v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
-            fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
-            
-            // Apply a local Langevin thermostat to the centroid mode.
-
-            v[0].re = v[0].re*c1_0 + c3_0*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-
-            // Use critical damping white noise for the remaining modes.
-            
-            for (int k = 1; k <= numCopies/2; k++) {
-                const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
-                const RealOpenMM wk = twown*sin(k*M_PI/numCopies);
-                const RealOpenMM c1 = exp(-2.0*wk*halfdt);
-                const RealOpenMM c2 = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
-                const RealOpenMM c3 = c2*sqrt(nkT/system.getParticleMass(particle));
-                RealOpenMM rand1 = c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                RealOpenMM rand2 = (isCenter ? 0.0 : c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
-                v[k] = v[k]*c1 + t_complex(rand1, rand2);
-                if (k < numCopies-k)
-                    v[numCopies-k] = v[numCopies-k]*c1 + t_complex(rand1, -rand2);
-            }
-            fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
-            for (int k = 0; k < numCopies; k++)
-                velocities[k][particle][component] = scale*v[k].re;
-        }
-    }
+    applyThermostat(system, integrator);
 
     // Update velocities.
     
@@ -175,8 +173,21 @@ void ReferenceIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDI
             if (system.getParticleMass(j) != 0.0)
                 velocities[i][j] += forces[i][j]*(halfdt/system.getParticleMass(j));
     
-    // Evolve the free ring polymer by transforming to the frequency domain.
+    // Evolve the free ring polymer by transforming to the frequency domain.  The propagator
+    // for each normal mode is the same for every particle, so compute it only once.
 
+    vector<t_complex> v(numCopies);
+    vector<t_complex> q(numCopies);
+    const RealOpenMM hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const RealOpenMM scale = 1.0/sqrt((RealOpenMM) numCopies);
+    const RealOpenMM nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const RealOpenMM twown = 2.0*nkT/hbar;
+    vector<RealOpenMM> wk(numCopies), coswt(numCopies), sinwt(numCopies);
+    for (int k = 1; k < numCopies; k++) {
+        wk[k] = twown*sin(k*M_PI/numCopies);
+        coswt[k] = cos(wk[k]*dt);
+        sinwt[k] = sin(wk[k]*dt);
+    }
     for (int particle = 0; particle < numParticles; particle++) {
         if (system.getParticleMass(particle) == 0.0)
             continue;
@@ -189,13 +200,8 @@ void ReferenceIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDI
             fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
             q[0] += v[0]*dt;
             for (int k = 1; k < numCopies; k++) {
-                const RealOpenMM wk = twown*sin(k*M_PI/numCopies);
-                const RealOpenMM wt = wk*dt;
-                const RealOpenMM coswt = cos(wt);
-                const RealOpenMM sinwt = sin(wt);
-                const RealOpenMM wm = wk*system.getParticleMass(particle);
-                const t_complex vprime = v[k]*coswt - q[k]*(wk*sinwt); // Advance velocity from t to t+dt
-                q[k] = v[k]*(sinwt/wk) + q[k]*coswt; // Advance position from t to t+dt
+                const t_complex vprime = v[k]*coswt[k] - q[k]*(wk[k]*sinwt[k]); // Advance velocity from t to t+dt
+                q[k] = v[k]*(sinwt[k]/wk[k]) + q[k]*coswt[k]; // Advance position from t to t+dt
                 v[k] = vprime;
             }
             fftpack_exec_1d(fft, FFTPACK_BACKWARD, &q[0], &q[0]);
@@ -218,44 +224,112 @@ void ReferenceIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDI
             if (system.getParticleMass(j) != 0.0)
                 velocities[i][j] += forces[i][j]*(halfdt/system.getParticleMass(j));
 
-    // Apply the PILE-L thermostat again.
+    // Apply the thermostat again.
+    
+    applyThermostat(system, integrator);
     
+    // Update the time.
+    
+    context.setTime(context.getTime()+dt);
+}
+
+void ReferenceIntegrateRPMDStepKernel::applyThermostat(const System& system, const RPMDIntegrator& integrator) {
+    RPMDIntegrator::ThermostatType type = integrator.getThermostatType();
+    if (type == RPMDIntegrator::NoThermostat)
+        return;
+    const bool localCentroid = (type == RPMDIntegrator::PileL);
+    const int numCopies = positions.size();
+    const int numParticles = positions[0].size();
+    const RealOpenMM halfdt = 0.5*integrator.getStepSize();
+    vector<t_complex> v(numCopies);
+    const RealOpenMM hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
+    const RealOpenMM scale = 1.0/sqrt((RealOpenMM) numCopies);
+    const RealOpenMM nkT = numCopies*BOLTZ*integrator.getTemperature();
+    const RealOpenMM twown = 2.0*nkT/hbar;
+
+    // Compute the damping coefficients for each mode.  Mode 0 is the centroid.  The remaining
+    // modes use critical damping white noise.
+
+    vector<RealOpenMM> c1(numCopies/2+1), c2(numCopies/2+1);
+    c1[0] = exp(-halfdt*integrator.getFriction());
+    c2[0] = sqrt(1.0-c1[0]*c1[0]);
+    for (int k = 1; k <= numCopies/2; k++) {
+        const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
+        const RealOpenMM wk = twown*sin(k*M_PI/numCopies);
+        c1[k] = exp(-2.0*wk*halfdt);
+        c2[k] = sqrt((1.0-c1[k]*c1[k])/2) * (isCenter ? sqrt(2.0) : 1.0);
+    }
+
+    // Every component of every particle with nonzero mass needs one random number for each
+    // internal mode, plus one for the centroid if it gets a local thermostat.  Generate all
+    // of them at once.
+
+    int numMassive = 0;
+    for (int particle = 0; particle < numParticles; particle++)
+        if (system.getParticleMass(particle) != 0.0)
+            numMassive++;
+    const int noisePerComponent = (localCentroid ? numCopies : numCopies-1);
+    noise.resize(3*noisePerComponent*numMassive);
+    if (noise.size() > 0)
+        data.random->fillNormallyDistributedRandomNumbers(&noise[0], noise.size());
+    int nextNoise = 0;
     for (int particle = 0; particle < numParticles; particle++) {
         if (system.getParticleMass(particle) == 0.0)
             continue;
-        const RealOpenMM c3_0 = c2_0*sqrt(nkT/system.getParticleMass(particle));
+        const RealOpenMM sqrtkTm = sqrt(nkT/system.getParticleMass(particle));
         for (int component = 0; component < 3; component++) {
             for (int k = 0; k < numCopies; k++)
                 v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
             fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
-            
-            // Apply a local Langevin thermostat to the centroid mode.
-
-            v[0].re = v[0].re*c1_0 + c3_0*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-
-            // Use critical damping white noise for the remaining modes.
-            
+            if (localCentroid)
+                v[0].re = v[0].re*c1[0] + c2[0]*sqrtkTm*noise[nextNoise++];
             for (int k = 1; k <= numCopies/2; k++) {
                 const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
-                const RealOpenMM wk = twown*sin(k*M_PI/numCopies);
-                const RealOpenMM c1 = exp(-2.0*wk*halfdt);
-                const RealOpenMM c2 = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
-                const RealOpenMM c3 = c2*sqrt(nkT/system.getParticleMass(particle));
-                RealOpenMM rand1 = c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                RealOpenMM rand2 = (isCenter ? 0.0 : c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
-                v[k] = v[k]*c1 + t_complex(rand1, rand2);
+                const RealOpenMM c3 = c2[k]*sqrtkTm;
+                RealOpenMM rand1 = c3*noise[nextNoise++];
+                RealOpenMM rand2 = (isCenter ? 0.0 : c3*noise[nextNoise++]);
+                v[k] = v[k]*c1[k] + t_complex(rand1, rand2);
                 if (k < numCopies-k)
-                    v[numCopies-k] = v[numCopies-k]*c1 + t_complex(rand1, -rand2);
+                    v[numCopies-k] = v[numCopies-k]*c1[k] + t_complex(rand1, -rand2);
             }
             fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
             for (int k = 0; k < numCopies; k++)
                 velocities[k][particle][component] = scale*v[k].re;
         }
     }
-    
-    // Update the time.
-    
-    context.setTime(context.getTime()+dt);
+    if (type != RPMDIntegrator::PileG || numMassive == 0)
+        return;
+
+    // Apply a global stochastic velocity rescaling thermostat to the centroids.  Scaling the
+    // centroid mode is equivalent to adding a multiple of the centroid velocity to every copy.
+
+    vector<RealVec> centroidVelocity(numParticles);
+    double centroidKE = 0.0;
+    for (int particle = 0; particle < numParticles; particle++) {
+        if (system.getParticleMass(particle) == 0.0)
+            continue;
+        for (int k = 0; k < numCopies; k++)
+            centroidVelocity[particle] += velocities[k][particle];
+        centroidVelocity[particle] *= 1.0/numCopies;
+        centroidKE += 0.5*numCopies*system.getParticleMass(particle)*centroidVelocity[particle].dot(centroidVelocity[particle]);
+    }
+    if (centroidKE == 0.0)
+        return;
+    const int dof = 3*numMassive;
+    noise.resize(dof);
+    data.random->fillNormallyDistributedRandomNumbers(&noise[0], dof);
+    double sumSquares = 0.0;
+    for (int i = 1; i < dof; i++)
+        sumSquares += noise[i]*noise[i];
+    const double targetKE = 0.5*dof*nkT;
+    const double c = c1[0];
+    const double ratio = targetKE/(dof*centroidKE);
+    const double alpha2 = c + (1.0-c)*(noise[0]*noise[0]+sumSquares)*ratio + 2.0*noise[0]*sqrt(c*(1.0-c)*ratio);
+    const double sign = (noise[0]+sqrt(c/((1.0-c)*ratio)) < 0.0 ? -1.0 : 1.0);
+    const RealOpenMM alpha = sign*sqrt(alpha2);
+    for (int particle = 0; particle < numParticles; particle++)
+        for (int k = 0; k < numCopies; k++)
+            velocities[k][particle] += centroidVelocity[particle]*(alpha-1.0);
 }
 
 void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const RPMDIntegrator& integrator) {
@@ -263,9 +337,8 @@ void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const
     const int numParticles = positions[0].size();
     vector<RealVec>& pos = extractPositions(context);
     vector<RealVec>& vel = extractVelocities(context);
-    vector<RealVec>& f = extractForces(context);
     
-    // Compute forces from all groups that didn't have a specified contraction.
+    // Update the state of each copy.  This modifies the Context, so it must be done serially.
     
     for (int i = 0; i < totalCopies; i++) {
         pos = positions[i];
@@ -274,9 +347,11 @@ void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const
         context.updateContextState();
         positions[i] = pos;
         velocities[i] = vel;
-        context.calcForcesAndEnergy(true, false, groupsNotContracted);
-        forces[i] = f;
     }
+
+    // Compute forces from all groups that didn't have a specified contraction.
+
+    computeCopyForces(context, positions, forces, totalCopies, groupsNotContracted);
     
     // Now loop over contractions and compute forces from them.
     
@@ -313,9 +388,9 @@ void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const
         for (int i = 0; i < copies; i++) {
             pos = contractedPositions[i];
             context.computeVirtualSites();
-            context.calcForcesAndEnergy(true, false, groupFlags);
-            contractedForces[i] = f;
+            contractedPositions[i] = pos;
         }
+        computeCopyForces(context, contractedPositions, contractedForces, copies, groupFlags);
         
         // Apply the forces to the original copies.
         
@@ -342,6 +417,59 @@ void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const
     }
 }
 
+void ReferenceIntegrateRPMDStepKernel::computeCopyForces(ContextImpl& context, const vector<vector<RealVec> >& copyPositions,
+        vector<vector<RealVec> >& copyForces, int numCopies, int groups) {
+    int numEvaluators = min(threads->getNumThreads(), numCopies);
+    if (numEvaluators < 2) {
+        vector<RealVec>& pos = extractPositions(context);
+        vector<RealVec>& f = extractForces(context);
+        for (int i = 0; i < numCopies; i++) {
+            pos = copyPositions[i];
+            context.calcForcesAndEnergy(true, false, groups);
+            copyForces[i] = f;
+        }
+        return;
+    }
+    updateShadowContexts(context, numEvaluators);
+    ComputeForcesTask task(context, shadowContexts, copyPositions, copyForces, numCopies, groups);
+    threads->execute(task);
+    threads->waitForThreads();
+}
+
+void ReferenceIntegrateRPMDStepKernel::updateShadowContexts(ContextImpl& context, int numEvaluators) {
+    // Per-particle parameters changed with updateParametersInContext() only reach the main Context.  The
+    // Forces in the System hold the new values, so rebuilding the shadows picks them up.
+
+    if (context.getForceParametersVersion() != shadowParametersVersion) {
+        deleteShadowContexts();
+        shadowParametersVersion = context.getForceParametersVersion();
+    }
+    while ((int) shadowContexts.size() < numEvaluators-1) {
+        Integrator* integrator = new VerletIntegrator(0.001);
+        shadowIntegrators.push_back(integrator);
+        shadowContexts.push_back(context.getOwner().clone(*integrator));
+    }
+    Vec3 a, b, c;
+    context.getPeriodicBoxVectors(a, b, c);
+    const map<string, double>& parameters = context.getParameters();
+    for (int i = 0; i < (int) shadowContexts.size(); i++) {
+        Context& shadow = *shadowContexts[i];
+        shadow.setPeriodicBoxVectors(a, b, c);
+        for (map<string, double>::const_iterator iter = parameters.begin(); iter != parameters.end(); ++iter)
+            if (shadow.getParameter(iter->first) != iter->second)
+                shadow.setParameter(iter->first, iter->second);
+    }
+}
+
+void ReferenceIntegrateRPMDStepKernel::deleteShadowContexts() {
+    for (int i = 0; i < (int) shadowContexts.size(); i++) {
+        delete shadowContexts[i];
+        delete shadowIntegrators[i];
+    }
+    shadowContexts.clear();
+    shadowIntegrators.clear();
+}
+
 double ReferenceIntegrateRPMDStepKernel::computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator) {
     const System& system = context.getSystem();
     int numParticles = system.getNumParticles();
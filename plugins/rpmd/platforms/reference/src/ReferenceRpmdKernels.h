@@ -33,7 +33,9 @@
  * -------------------------------------------------------------------------- */
 
 #include "ReferencePlatform.h"
+#include "openmm/Context.h"
 #include "openmm/RpmdKernels.h"
+#include "openmm/internal/ThreadPool.h"
 #include "RealVec.h"
 #include "fftpack.h"
 
@@ -42,11 +44,18 @@ namespace OpenMM {
 /**
  * This kernel is invoked by RPMDIntegrator to take one time step, and to get and
  * set the state of system copies.
+ *
+ * When more than one thread is available, the forces on different copies are computed
+ * in parallel.  The first thread uses the Context the integrator is bound to, while each
+ * of the others evaluates forces in its own shadow Context cloned from it, so data that
+ * depends only on the System is shared.  Global parameters and periodic box vectors are
+ * copied to the shadow Contexts before every evaluation, and they are rebuilt whenever
+ * the parameters of a Force are updated in the main Context.
  */
 class ReferenceIntegrateRPMDStepKernel : public IntegrateRPMDStepKernel {
 public:
-    ReferenceIntegrateRPMDStepKernel(std::string name, const Platform& platform) :
-            IntegrateRPMDStepKernel(name, platform), fft(NULL) {
+    ReferenceIntegrateRPMDStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) :
+            IntegrateRPMDStepKernel(name, platform), data(data), fft(NULL), threads(NULL), shadowParametersVersion(0) {
     }
     ~ReferenceIntegrateRPMDStepKernel();
     /**
@@ -85,7 +94,25 @@ public:
      */
     void copyToContext(int copy, ContextImpl& context);
 private:
+    class ComputeForcesTask;
     void computeForces(ContextImpl& context, const RPMDIntegrator& integrator);
+    /**
+     * Compute the forces from a set of force groups on each of several copies, distributing
+     * the copies between threads.  Virtual sites must already have been computed.
+     */
+    void computeCopyForces(ContextImpl& context, const std::vector<std::vector<RealVec> >& copyPositions,
+            std::vector<std::vector<RealVec> >& copyForces, int numCopies, int groups);
+    /**
+     * Make sure there is an up to date shadow Context for every thread after the first, and
+     * copy the current global parameters and periodic box vectors to them.
+     */
+    void updateShadowContexts(ContextImpl& context, int numEvaluators);
+    void deleteShadowContexts();
+    /**
+     * Apply the integrator's thermostat to the velocities for half a time step.
+     */
+    void applyThermostat(const System& system, const RPMDIntegrator& integrator);
+    ReferencePlatform::PlatformData& data;
     std::vector<std::vector<RealVec> > positions;
     std::vector<std::vector<RealVec> > velocities;
     std::vector<std::vector<RealVec> > forces;
@@ -95,6 +122,11 @@ private:
     int groupsNotContracted;
     fftpack* fft;
     std::map<int, fftpack*> contractionFFT;
+    std::vector<RealOpenMM> noise;
+    ThreadPool* threads;
+    std::vector<Context*> shadowContexts;
+    std::vector<Integrator*> shadowIntegrators;
+    int shadowParametersVersion;
 };
 
 } // namespace OpenMM
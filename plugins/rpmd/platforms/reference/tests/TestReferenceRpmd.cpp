@@ -37,20 +37,24 @@
 #include "openmm/CMMotionRemover.h"
 #include "openmm/Context.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/MonteCarloBarostat.h"
 #include "openmm/NonbondedForce.h"
+#include "openmm/OpenMMException.h"
 #include "openmm/Platform.h"
 #include "openmm/System.h"
 #include "openmm/RPMDIntegrator.h"
+#include "openmm/RPMDMonteCarloBarostat.h"
 #include "openmm/VirtualSite.h"
 #include "SimTKOpenMMUtilities.h"
 #include "sfmt/SFMT.h"
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 
 using namespace OpenMM;
 using namespace std;
 
-void testFreeParticles() {
+void testFreeParticles(RPMDIntegrator::ThermostatType thermostat) {
     const int numParticles = 100;
     const int numCopies = 30;
     const double temperature = 300.0;
@@ -59,6 +63,7 @@ void testFreeParticles() {
     for (int i = 0; i < numParticles; i++)
         system.addParticle(mass);
     RPMDIntegrator integ(numCopies, temperature, 10.0, 0.001);
+    integ.setThermostatType(thermostat);
     Platform& platform = Platform::getPlatformByName("Reference");
     Context context(system, integ, platform);
     OpenMM_SFMT::SFMT sfmt;
@@ -313,12 +318,164 @@ void testContractions() {
     ASSERT_USUALLY_EQUAL_TOL(expectedKE, meanKE, 1e-2);
 }
 
+void testIdealGasWithBarostat() {
+    const int numParticles = 64;
+    const int numCopies = 4;
+    const int frequency = 10;
+    const int steps = 1000;
+    const double pressure = 1.5;
+    const double pressureInMD = pressure*(AVOGADRO*1e-25); // pressure in kJ/mol/nm^3
+    const double temperature = 300.0;
+    const double initialVolume = 2*numParticles*BOLTZ*temperature/pressureInMD;
+    const double initialLength = std::pow(initialVolume, 1.0/3.0);
+
+    // Create a gas of noninteracting particles.
+
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(initialLength, 0, 0), Vec3(0, initialLength, 0), Vec3(0, 0, initialLength));
+    for (int i = 0; i < numParticles; ++i)
+        system.addParticle(1.0);
+    RPMDMonteCarloBarostat* barostat = new RPMDMonteCarloBarostat(pressure, frequency);
+    system.addForce(barostat);
+    RPMDIntegrator integ(numCopies, temperature, 1.0, 0.01);
+    Platform& platform = Platform::getPlatformByName("Reference");
+    Context context(system, integ, platform);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(initialLength*genrand_real2(sfmt), initialLength*genrand_real2(sfmt), initialLength*genrand_real2(sfmt));
+    for (int i = 0; i < numCopies; i++)
+        integ.setPositions(i, positions);
+
+    // Let it equilibrate.
+
+    integ.step(10000);
+
+    // Now run it for a while and see if the volume is correct.
+
+    double volume = 0.0;
+    for (int i = 0; i < steps; ++i) {
+        Vec3 box[3];
+        integ.getState(0, 0).getPeriodicBoxVectors(box[0], box[1], box[2]);
+        volume += box[0][0]*box[1][1]*box[2][2];
+        integ.step(frequency);
+    }
+    volume /= steps;
+    double expected = (numParticles+1)*BOLTZ*temperature/pressureInMD;
+    ASSERT_USUALLY_EQUAL_TOL(expected, volume, 3/std::sqrt((double) steps));
+}
+
+void testEnergyOfEachCopy() {
+    // Each copy's energy should be computed from its own positions, even though they are all
+    // copied into the same Context.
+
+    const int numCopies = 4;
+    const double k = 100.0;
+    const double r0 = 0.15;
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, r0, k);
+    system.addForce(bonds);
+    RPMDIntegrator integ(numCopies, 300.0, 1.0, 0.001);
+    Platform& platform = Platform::getPlatformByName("Reference");
+    Context context(system, integ, platform);
+    vector<Vec3> positions(2);
+    for (int i = 0; i < numCopies; i++) {
+        positions[1] = Vec3(0.1+0.05*i, 0, 0);
+        integ.setPositions(i, positions);
+    }
+    for (int repeat = 0; repeat < 2; repeat++)
+        for (int i = 0; i < numCopies; i++) {
+            double dr = 0.1+0.05*i-r0;
+            ASSERT_EQUAL_TOL(0.5*k*dr*dr, integ.getState(i, State::Energy).getPotentialEnergy(), 1e-5);
+        }
+}
+
+void testMultithreadedForces() {
+    // Forces on different copies are computed on several threads, each with its own Context.  The trajectory
+    // should be identical to one computed on a single thread, including after per-particle parameters change.
+
+    const int numParticles = 4;
+    const int numCopies = 5;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles, Vec3());
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 1.0);
+        positions[i] = Vec3(0.4*i, 0.1*(i%2), 0);
+    }
+    RPMDIntegrator integ1(numCopies, 300.0, 1.0, 0.001);
+    RPMDIntegrator integ2(numCopies, 300.0, 1.0, 0.001);
+    integ1.setThermostatType(RPMDIntegrator::NoThermostat);
+    integ2.setThermostatType(RPMDIntegrator::NoThermostat);
+    Platform& platform = Platform::getPlatformByName("Reference");
+    static char threadsMany[] = "OPENMM_CPU_THREADS=3";
+    static char threadsOne[] = "OPENMM_CPU_THREADS=1";
+    static char threadsDefault[] = "OPENMM_CPU_THREADS=";
+    putenv(threadsMany);
+    Context context1(system, integ1, platform);
+    putenv(threadsOne);
+    Context context2(system, integ2, platform);
+    putenv(threadsDefault);
+    for (int i = 0; i < numCopies; i++) {
+        positions[0][2] = 0.02*i;
+        integ1.setPositions(i, positions);
+        integ2.setPositions(i, positions);
+        integ1.setVelocities(i, velocities);
+        integ2.setVelocities(i, velocities);
+    }
+    for (int iteration = 0; iteration < 2; iteration++) {
+        if (iteration == 1) {
+            for (int i = 0; i < numParticles; i++)
+                nonbonded->setParticleParameters(i, i%2 == 0 ? 1.0 : -1.0, 0.2, 1.0);
+            nonbonded->updateParametersInContext(context1);
+            nonbonded->updateParametersInContext(context2);
+        }
+        integ1.step(5);
+        integ2.step(5);
+        for (int i = 0; i < numCopies; i++) {
+            vector<Vec3> pos1 = integ1.getState(i, State::Positions).getPositions();
+            vector<Vec3> pos2 = integ2.getState(i, State::Positions).getPositions();
+            for (int j = 0; j < numParticles; j++)
+                ASSERT_EQUAL_VEC(pos2[j], pos1[j], 1e-10);
+        }
+    }
+}
+
+void testStandardBarostatRejected() {
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(2, 0, 0), Vec3(0, 2, 0), Vec3(0, 0, 2));
+    system.addParticle(1.0);
+    system.addForce(new MonteCarloBarostat(1.0, 300.0));
+    RPMDIntegrator integ(4, 300.0, 1.0, 0.001);
+    Platform& platform = Platform::getPlatformByName("Reference");
+    bool threwException = false;
+    try {
+        Context context(system, integ, platform);
+    }
+    catch (const OpenMMException& ex) {
+        threwException = true;
+    }
+    ASSERT(threwException);
+}
+
 int main() {
     try {
-        testFreeParticles();
+        testFreeParticles(RPMDIntegrator::PileL);
+        testFreeParticles(RPMDIntegrator::PileG);
         testCMMotionRemoval();
         testVirtualSites();
         testContractions();
+        testIdealGasWithBarostat();
+        testStandardBarostatRejected();
+        testEnergyOfEachCopy();
+        testMultithreadedForces();
     }
     catch(const std::exception& e) {
         std::cout << "exception: " << e.what() << std::endl;
@@ -59,10 +59,17 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
     HarmonicBondForce* force = new HarmonicBondForce();
     try {
         const SerializationNode& bonds = node.getChildNode("Bonds");
-        for (int i = 0; i < (int) bonds.getChildren().size(); i++) {
+        int numBonds = bonds.getChildren().size();
+        vector<int> particles1(numBonds), particles2(numBonds);
+        vector<double> lengths(numBonds), k(numBonds);
+        for (int i = 0; i < numBonds; i++) {
             const SerializationNode& bond = bonds.getChildren()[i];
-            force->addBond(bond.getIntProperty("p1"), bond.getIntProperty("p2"), bond.getDoubleProperty("d"), bond.getDoubleProperty("k"));
+            particles1[i] = bond.getIntProperty("p1");
+            particles2[i] = bond.getIntProperty("p2");
+            lengths[i] = bond.getDoubleProperty("d");
+            k[i] = bond.getDoubleProperty("k");
         }
+        force->addBonds(particles1, particles2, lengths, k);
     }
     catch (...) {
         delete force;
@@ -75,15 +75,29 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
         force->setReactionFieldDielectric(node.getDoubleProperty("rfDielectric"));
         force->setUseDispersionCorrection(node.getIntProperty("dispersionCorrection"));
         const SerializationNode& particles = node.getChildNode("Particles");
-        for (int i = 0; i < (int) particles.getChildren().size(); i++) {
+        int numParticles = particles.getChildren().size();
+        vector<double> charges(numParticles), sigmas(numParticles), epsilons(numParticles);
+        for (int i = 0; i < numParticles; i++) {
             const SerializationNode& particle = particles.getChildren()[i];
-            force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
+            charges[i] = particle.getDoubleProperty("q");
+            sigmas[i] = particle.getDoubleProperty("sig");
+            epsilons[i] = particle.getDoubleProperty("eps");
         }
+        force->addParticles(charges, sigmas, epsilons);
         const SerializationNode& exceptions = node.getChildNode("Exceptions");
-        for (int i = 0; i < (int) exceptions.getChildren().size(); i++) {
+        int numExceptions = exceptions.getChildren().size();
+        vector<int> particles1(numExceptions), particles2(numExceptions);
+        vector<double> chargeProds(numExceptions), exceptionSigmas(numExceptions), exceptionEpsilons(numExceptions);
+        for (int i = 0; i < numExceptions; i++) {
             const SerializationNode& exception = exceptions.getChildren()[i];
-            force->addException(exception.getIntProperty("p1"), exception.getIntProperty("p2"), exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
+            particles1[i] = exception.getIntProperty("p1");
+            particles2[i] = exception.getIntProperty("p2");
+            chargeProds[i] = exception.getDoubleProperty("q");
+            exceptionSigmas[i] = exception.getDoubleProperty("sig");
+            exceptionEpsilons[i] = exception.getDoubleProperty("eps");
         }
+        force->reserveExceptions(numExceptions);
+        force->addExceptions(particles1, particles2, chargeProds, exceptionSigmas, exceptionEpsilons);
     }
     catch (...) {
         delete force;
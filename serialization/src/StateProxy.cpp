@@ -69,6 +69,22 @@ void StateProxy::serialize(const void* object, SerializationNode& node) const {
     } catch (const OpenMMException &) {
         // do nothing
     }
+    try {
+        const vector<double>& groupEnergies = s.getPotentialEnergyByGroup();
+        SerializationNode& groupEnergiesNode = node.createChildNode("GroupEnergies");
+        for (int i = 0; i < (int) groupEnergies.size(); i++)
+            groupEnergiesNode.createChildNode("Energy").setDoubleProperty("e", groupEnergies[i]);
+    } catch (const OpenMMException &) {
+        // do nothing
+    }
+    try {
+        const vector<double>& forceEnergies = s.getPotentialEnergyByForce();
+        SerializationNode& forceEnergiesNode = node.createChildNode("ForceEnergies");
+        for (int i = 0; i < (int) forceEnergies.size(); i++)
+            forceEnergiesNode.createChildNode("Energy").setDoubleProperty("e", forceEnergies[i]);
+    } catch (const OpenMMException &) {
+        // do nothing
+    }
     try {
         s.getPositions();
         SerializationNode& positionsNode = node.createChildNode("Positions");
@@ -136,6 +152,24 @@ void* StateProxy::deserialize(const SerializationNode& node) const {
     } catch (const OpenMMException &) {
         // do nothing    
     }
+    vector<double> outGroupEnergies;
+    try {
+        const SerializationNode& groupEnergiesNode = node.getChildNode("GroupEnergies");
+        for (int i = 0; i < (int) groupEnergiesNode.getChildren().size(); i++)
+            outGroupEnergies.push_back(groupEnergiesNode.getChildren()[i].getDoubleProperty("e"));
+        types = types | State::EnergyByGroup;
+    } catch (const OpenMMException &) {
+        // do nothing
+    }
+    vector<double> outForceEnergies;
+    try {
+        const SerializationNode& forceEnergiesNode = node.getChildNode("ForceEnergies");
+        for (int i = 0; i < (int) forceEnergiesNode.getChildren().size(); i++)
+            outForceEnergies.push_back(forceEnergiesNode.getChildren()[i].getDoubleProperty("e"));
+        types = types | State::EnergyByForce;
+    } catch (const OpenMMException &) {
+        // do nothing
+    }
     vector<Vec3> outPositions;
     vector<Vec3> outVelocities;
     vector<Vec3> outForces;
@@ -186,6 +220,12 @@ void* StateProxy::deserialize(const SerializationNode& node) const {
     if (types & State::Energy) {
         builder.setEnergy(kineticEnergy, potentialEnergy);
     }
+    if (types & State::EnergyByGroup) {
+        builder.setEnergyByGroup(outGroupEnergies);
+    }
+    if (types & State::EnergyByForce) {
+        builder.setEnergyByForce(outForceEnergies);
+    }
     if (types & State::Parameters) {
         builder.setParameters(outStateParams);
     }
@@ -95,8 +95,11 @@ void* SystemProxy::deserialize(const SerializationNode& node) const {
         Vec3 c(boxc.getDoubleProperty("x"), boxc.getDoubleProperty("y"), boxc.getDoubleProperty("z"));
         system->setDefaultPeriodicBoxVectors(a, b, c);
         const SerializationNode& particles = node.getChildNode("Particles");
+        vector<double> masses(particles.getChildren().size());
+        for (int i = 0; i < (int) masses.size(); i++)
+            masses[i] = particles.getChildren()[i].getDoubleProperty("mass");
+        system->addParticles(masses);
         for (int i = 0; i < (int) particles.getChildren().size(); i++) {
-            system->addParticle(particles.getChildren()[i].getDoubleProperty("mass"));
             if (particles.getChildren()[i].getChildren().size() > 0) {
                 const SerializationNode& vsite = particles.getChildren()[i].getChildren()[0];
                 if (vsite.getName() == "TwoParticleAverageSite")
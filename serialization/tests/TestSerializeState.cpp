@@ -83,7 +83,7 @@ void testSerialization() {
 	ctxt->setVelocities(velocities);
 
 	// Serialize and then deserialize it.
-	State s1 = ctxt->getState(State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters);
+	State s1 = ctxt->getState(State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters | State::EnergyByGroup | State::EnergyByForce);
 
 	stringstream buffer;
     XmlSerializer::serialize<State>(&s1, "State", buffer);
@@ -120,6 +120,12 @@ void testSerialization() {
 	ASSERT_EQUAL(s1.getPotentialEnergy(), s2.getPotentialEnergy());
 	ASSERT_EQUAL(s1.getKineticEnergy(), s2.getKineticEnergy());
 	ASSERT_EQUAL(s1.getTime(), s2.getTime());
+	ASSERT_EQUAL(s1.getPotentialEnergyByGroup().size(), s2.getPotentialEnergyByGroup().size());
+	for(int i=0; i<s1.getPotentialEnergyByGroup().size(); i++)
+		ASSERT_EQUAL(s1.getPotentialEnergyByGroup()[i], s2.getPotentialEnergyByGroup()[i]);
+	ASSERT_EQUAL(s1.getPotentialEnergyByForce().size(), s2.getPotentialEnergyByForce().size());
+	for(int i=0; i<s1.getPotentialEnergyByForce().size(); i++)
+		ASSERT_EQUAL(s1.getPotentialEnergyByForce()[i], s2.getPotentialEnergyByForce()[i]);
 
 	map<string, double> p1 = s1.getParameters();
 	map<string, double> p2 = s2.getParameters();
@@ -0,0 +1,156 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2014 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests that plugins found by Platform::loadPluginsFromDirectory() are only loaded when needed,
+ * and that errors loading them are recorded.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Platform.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <pthread.h>
+#ifdef WIN32
+  #include <direct.h>
+#else
+  #include <dlfcn.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+static void* countPlatforms(void* arg) {
+    Platform::getNumPlatforms();
+    Platform::getPlatformByName("Reference");
+    return 0;
+}
+
+/**
+ * Find the path to a shared library that exists on this system and is not an OpenMM plugin, or return
+ * an empty string if none can be found.
+ */
+static string findOrdinaryLibrary() {
+#ifdef WIN32
+    return "";
+#else
+    void* handle = dlopen("libm.so.6", RTLD_LAZY);
+    if (handle == NULL)
+        return "";
+    Dl_info info;
+    void* symbol = dlsym(handle, "cos");
+    if (symbol == NULL || dladdr(symbol, &info) == 0 || info.dli_fname == NULL)
+        return "";
+    return info.dli_fname;
+#endif
+}
+
+void testLazyLoading() {
+    // Create a directory containing a file that is not a valid library.
+
+    string directory = "pluginLoadingTestDirectory";
+#ifdef WIN32
+    _mkdir(directory.c_str());
+    string file = directory+"\\notAPlugin.dll";
+    string lazyFile = directory+"\\lazyPlugin.dll";
+#else
+    mkdir(directory.c_str(), 0777);
+    string file = directory+"/notAPlugin.so";
+    string lazyFile = directory+"/lazyPlugin.so";
+#endif
+    ofstream(file.c_str()) << "This is not a library";
+    try {
+        int numFailures = Platform::getPluginLoadFailures().size();
+        vector<string> found = Platform::loadPluginsFromDirectory(directory);
+        ASSERT_EQUAL(1, found.size());
+
+        // Asking for the failures should try to load it, and record the error.
+
+        ASSERT_EQUAL("Reference", Platform::getPlatformByName("Reference").getName());
+        ASSERT_EQUAL(numFailures+1, Platform::getPluginLoadFailures().size());
+        ASSERT(Platform::getPluginLoadFailures()[numFailures].find("notAPlugin") != string::npos);
+
+        // It should not be loaded a second time.
+
+        Platform::getNumPlatforms();
+        ASSERT_EQUAL(numFailures+1, Platform::getPluginLoadFailures().size());
+
+        // If several threads trigger loading at once, it should still be attempted exactly once.
+
+        Platform::loadPluginsFromDirectory(directory);
+        const int numThreads = 8;
+        vector<pthread_t> threads(numThreads);
+        for (int i = 0; i < numThreads; i++)
+            pthread_create(&threads[i], NULL, countPlatforms, NULL);
+        for (int i = 0; i < numThreads; i++)
+            pthread_join(threads[i], NULL);
+        ASSERT_EQUAL(numFailures+2, Platform::getPluginLoadFailures().size());
+
+        // Looking up a Platform that is already registered should not load anything.  To check this, replace
+        // an invalid file with a real library afterward.  It only loads successfully if it was not tried before.
+
+        string library = findOrdinaryLibrary();
+        if (library != "") {
+            remove(file.c_str());
+            ofstream(lazyFile.c_str()) << "This is not a library";
+            Platform::loadPluginsFromDirectory(directory);
+            ASSERT_EQUAL("Reference", Platform::getPlatformByName("Reference").getName());
+            ifstream source(library.c_str(), ios::binary);
+            ofstream(lazyFile.c_str(), ios::binary) << source.rdbuf();
+            ASSERT_EQUAL(numFailures+2, Platform::getPluginLoadFailures().size());
+        }
+    }
+    catch (...) {
+        remove(file.c_str());
+        remove(lazyFile.c_str());
+        rmdir(directory.c_str());
+        throw;
+    }
+    remove(file.c_str());
+    remove(lazyFile.c_str());
+    rmdir(directory.c_str());
+}
+
+int main() {
+    try {
+        testLazyLoading();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
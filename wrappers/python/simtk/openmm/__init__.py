@@ -35,4 +35,12 @@ else:
 
 from simtk.openmm.openmm import *
 from simtk.openmm.vec3 import Vec3
+
+# Plugins are loaded the first time a Platform or kernel is requested, so these are the
+# libraries that were found, not ones that are known to have loaded successfully.  Any that
+# failed to load are reported by pluginLoadFailures().
 pluginLoadedLibNames = Platform.loadPluginsFromDirectory(Platform.getDefaultPluginsDirectory())
+
+def pluginLoadFailures():
+    """Load any plugins that have not been loaded yet, and return a list of error messages for the ones that failed."""
+    return list(Platform.getPluginLoadFailures())
@@ -32,13 +32,14 @@ __author__ = "Peter Eastman"
 __version__ = "1.0"
 
 import simtk.openmm as mm
-from simtk.openmm.app import DCDFile
-from simtk.unit import nanometer
+from simtk.unit import picoseconds
 
 class DCDReporter(object):
     """DCDReporter outputs a series of frames from a Simulation to a DCD file.
 
-    To use it, create a DCDReporter, then add it to the Simulation's list of reporters.
+    To use it, create a DCDReporter, then add it to the Simulation's list of reporters.  Frames are
+    read directly from the Context and written by a native writer on a background thread, so
+    reporting does not require converting the positions to Python objects.
     """
 
     def __init__(self, file, reportInterval):
@@ -49,7 +50,7 @@ class DCDReporter(object):
          - reportInterval (int) The interval (in time steps) at which to write frames
         """
         self._reportInterval = reportInterval
-        self._out = open(file, 'wb')
+        self._file = file
         self._dcd = None
 
     def describeNextReport(self, simulation):
@@ -62,7 +63,7 @@ class DCDReporter(object):
         positions, velocities, forces, and energies respectively.
         """
         steps = self._reportInterval - simulation.currentStep%self._reportInterval
-        return (steps, True, False, False, False)
+        return (steps, False, False, False, False)
 
     def report(self, simulation, state):
         """Generate a report.
@@ -71,10 +72,8 @@ class DCDReporter(object):
          - simulation (Simulation) The Simulation to generate a report for
          - state (State) The current state of the simulation
         """
+        periodic = (simulation.topology.getUnitCellDimensions() is not None)
         if self._dcd is None:
-            self._dcd = DCDFile(self._out, simulation.topology, simulation.integrator.getStepSize(), 0, self._reportInterval)
-        a,b,c = state.getPeriodicBoxVectors()
-        self._dcd.writeModel(state.getPositions(), mm.Vec3(a[0].value_in_unit(nanometer), b[1].value_in_unit(nanometer), c[2].value_in_unit(nanometer))*nanometer)
-
-    def __del__(self):
-        self._out.close()
+            stepSize = simulation.integrator.getStepSize().value_in_unit(picoseconds)
+            self._dcd = mm.DCDWriter(self._file, simulation.system.getNumParticles(), stepSize, 0, self._reportInterval, periodic)
+        self._dcd.writeFrame(simulation.context, periodic)
@@ -36,6 +36,7 @@ import itertools
 import xml.etree.ElementTree as etree
 from math import sqrt, cos
 import simtk.openmm as mm
+from simtk.openmm.openmm import _ResidueTemplateMatcher, _findAngles, _findPropers, _findImpropers
 import simtk.unit as unit
 import element as elem
 from simtk.openmm.app import Topology
@@ -104,6 +105,8 @@ class ForceField(object):
         self._atomClasses = {'':set()}
         self._forces = []
         self._scripts = []
+        self._templateMatcher = _ResidueTemplateMatcher()
+        self._templateMatcherIndex = {}
         for file in files:
             try:
                 tree = etree.parse(file)
@@ -213,6 +216,16 @@ class ForceField(object):
             index += 1
         return torsion
 
+    def _getTemplateMatcherIndex(self, template):
+        """Get the index of a template in the compiled template matcher, adding it if necessary."""
+        if template not in self._templateMatcherIndex:
+            elements = [-1 if atom.element is None else atom.element.atomic_number for atom in template.atoms]
+            names = [atom.name for atom in template.atoms]
+            bondedTo = [atom.bondedTo for atom in template.atoms]
+            externalBonds = [atom.externalBonds for atom in template.atoms]
+            self._templateMatcherIndex[template] = self._templateMatcher.addTemplate(elements, names, bondedTo, externalBonds)
+        return self._templateMatcherIndex[template]
+
     class _SystemData:
         """Inner class used to encapsulate data about the system being created."""
         def __init__(self):
@@ -315,12 +328,19 @@ class ForceField(object):
             for res in chain.residues():
                 template = None
                 matches = None
-                signature = _createResidueSignature([atom.element for atom in res.atoms()])
+                atoms = list(res.atoms())
+                signature = _createResidueSignature([atom.element for atom in atoms])
                 if signature in self._templateSignatures:
+                    description = None
                     for t in self._templateSignatures[signature]:
-                        matches = _matchResidue(res, t, bondedToAtom)
-                        if matches is not None:
+                        if len(t.atoms) != len(atoms):
+                            continue
+                        if description is None:
+                            description = _describeResidueAtoms(atoms, bondedToAtom)
+                        candidate = self._templateMatcher.matchResidue(self._getTemplateMatcherIndex(t), *description)
+                        if len(candidate) == len(atoms):
                             template = t
+                            matches = candidate
                             break
                 if matches is None:
                     raise ValueError('No template found for residue %d (%s).  This might mean your input topology is missing some atoms or bonds, or possibly that you are using the wrong force field.' % (res.index+1, res.name))
@@ -344,49 +364,12 @@ class ForceField(object):
         elif nonbondedMethod is not NoCutoff and nonbondedMethod is not CutoffNonPeriodic:
             raise ValueError('Requested periodic boundary conditions for a Topology that does not specify periodic box dimensions')
 
-        # Make a list of all unique angles
-
-        uniqueAngles = set()
-        for bond in data.bonds:
-            for atom in bondedToAtom[bond.atom1]:
-                if atom != bond.atom2:
-                    if atom < bond.atom2:
-                        uniqueAngles.add((atom, bond.atom1, bond.atom2))
-                    else:
-                        uniqueAngles.add((bond.atom2, bond.atom1, atom))
-            for atom in bondedToAtom[bond.atom2]:
-                if atom != bond.atom1:
-                    if atom > bond.atom1:
-                        uniqueAngles.add((bond.atom1, bond.atom2, atom))
-                    else:
-                        uniqueAngles.add((atom, bond.atom2, bond.atom1))
-        data.angles = sorted(list(uniqueAngles))
-
-        # Make a list of all unique proper torsions
+        # Make lists of all unique angles, proper torsions, and improper torsions
 
-        uniquePropers = set()
-        for angle in data.angles:
-            for atom in bondedToAtom[angle[0]]:
-                if atom != angle[1]:
-                    if atom < angle[2]:
-                        uniquePropers.add((atom, angle[0], angle[1], angle[2]))
-                    else:
-                        uniquePropers.add((angle[2], angle[1], angle[0], atom))
-            for atom in bondedToAtom[angle[2]]:
-                if atom != angle[1]:
-                    if atom > angle[0]:
-                        uniquePropers.add((angle[0], angle[1], angle[2], atom))
-                    else:
-                        uniquePropers.add((atom, angle[2], angle[1], angle[0]))
-        data.propers = sorted(list(uniquePropers))
-
-        # Make a list of all unique improper torsions
-
-        for atom in range(len(bondedToAtom)):
-            bondedTo = bondedToAtom[atom]
-            if len(bondedTo) > 2:
-                for subset in itertools.combinations(bondedTo, 3):
-                    data.impropers.append((atom, subset[0], subset[1], subset[2]))
+        bondedTo = [list(atoms) for atoms in bondedToAtom]
+        data.angles = list(_findAngles(bondedTo))
+        data.propers = list(_findPropers(bondedTo, data.angles))
+        data.impropers = list(_findImpropers(bondedTo))
 
         # Identify bonds that should be implemented with constraints
 
@@ -484,6 +467,33 @@ def _createResidueSignature(elements):
     return s
 
 
+def _describeResidueAtoms(atoms, bondedToAtom):
+    """Describe the atoms of a residue in the form expected by _ResidueTemplateMatcher.matchResidue().
+
+    Parameters:
+     - atoms (list) The atoms in the residue
+     - bondedToAtom (list) Enumerates which other atoms each atom is bonded to
+    Returns: a tuple containing the atomic number of each atom (-1 for atoms with no element), the name of
+    each atom, the residue-local indices of the atoms each one is bonded to, and the number of bonds each
+    atom forms to atoms outside the residue
+    """
+    renumberAtoms = {}
+    for i in range(len(atoms)):
+        renumberAtoms[atoms[i].index] = i
+    elements = []
+    names = []
+    bondedTo = []
+    externalBonds = []
+    for atom in atoms:
+        elements.append(-1 if atom.element is None else atom.element.atomic_number)
+        names.append(atom.name)
+        bonded = bondedToAtom[atom.index]
+        bonds = [renumberAtoms[x] for x in bonded if x in renumberAtoms]
+        bondedTo.append(bonds)
+        externalBonds.append(len(bonded)-len(bonds))
+    return (elements, names, bondedTo, externalBonds)
+
+
 def _matchResidue(res, template, bondedToAtom):
     """Determine whether a residue matches a template and return a list of corresponding atoms.
 
@@ -40,6 +40,10 @@ class PDBReporter(object):
     To use it, create a PDBReporter, then add it to the Simulation's list of reporters.
     """
 
+    ## Models are written from the State and the topology alone, so Simulation may run this reporter on its
+    ## background thread.
+    asynchronous = True
+
     def __init__(self, file, reportInterval):
         """Create a PDBReporter.
 
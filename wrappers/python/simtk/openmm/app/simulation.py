@@ -33,6 +33,8 @@ __version__ = "1.0"
 
 import simtk.openmm as mm
 import simtk.unit as unit
+import threading
+import Queue
 
 class Simulation(object):
     """Simulation provides a simplified API for running simulations with OpenMM and reporting results.
@@ -47,6 +49,11 @@ class Simulation(object):
     it every 1000 time steps:
 
     simulation.reporters.append(PDBReporter('output.pdb', 1000))
+
+    Reporters that have an attribute called "asynchronous" whose value is True are run on a background
+    thread, so the simulation can continue while they format and write their output.  Such reporters
+    receive a snapshot of the Simulation that contains the topology, system, integrator, and currentStep
+    as of the time the report was requested, but not the Context.
     """
 
     def __init__(self, topology, system, integrator, platform=None, platformProperties=None):
@@ -70,6 +77,9 @@ class Simulation(object):
         self.currentStep = 0
         ## A list of reporters to invoke during the simulation
         self.reporters = []
+        ## If True, reporters that support it are run on a background thread
+        self.asynchronousReports = True
+        self._reportWorker = None
         if platform is None:
             ## The Context containing the current state of the simulation
             self.context = mm.Context(system, integrator)
@@ -89,40 +99,138 @@ class Simulation(object):
         mm.LocalEnergyMinimizer.minimize(self.context, tolerance, maxIterations)
 
     def step(self, steps):
-        """Advance the simulation by integrating a specified number of time steps."""
+        """Advance the simulation by integrating a specified number of time steps.
+
+        All reports generated during the call have been completed by the time this method returns.
+        """
         stepTo = self.currentStep+steps
         nextReport = [None]*len(self.reporters)
-        while self.currentStep < stepTo:
-            nextSteps = stepTo-self.currentStep
-            anyReport = False
-            for i, reporter in enumerate(self.reporters):
-                nextReport[i] = reporter.describeNextReport(self)
-                if nextReport[i][0] > 0 and nextReport[i][0] <= nextSteps:
-                    nextSteps = nextReport[i][0]
-                    anyReport = True
-            stepsToGo = nextSteps
-            while stepsToGo > 10:
-                self.integrator.step(10) # Only take 10 steps at a time, to give Python more chances to respond to a control-c.
-                stepsToGo -= 10
-            self.integrator.step(stepsToGo)
-            self.currentStep += nextSteps
-            if anyReport:
-                getPositions = False
-                getVelocities = False
-                getForces = False
-                getEnergy = False
-                for reporter, next in zip(self.reporters, nextReport):
-                    if next[0] == nextSteps:
-                        if next[1]:
-                            getPositions = True
-                        if next[2]:
-                            getVelocities = True
-                        if next[3]:
-                            getForces = True
-                        if next[4]:
-                            getEnergy = True
-                state = self.context.getState(getPositions=getPositions, getVelocities=getVelocities, getForces=getForces, getEnergy=getEnergy, getParameters=True, enforcePeriodicBox=(self.topology.getUnitCellDimensions() is not None))
-                for reporter, next in zip(self.reporters, nextReport):
-                    if next[0] == nextSteps:
-                        reporter.report(self, state)
+        worker = None
+        try:
+            while self.currentStep < stepTo:
+                nextSteps = stepTo-self.currentStep
+                anyReport = False
+                for i, reporter in enumerate(self.reporters):
+                    nextReport[i] = reporter.describeNextReport(self)
+                    if nextReport[i][0] > 0 and nextReport[i][0] <= nextSteps:
+                        nextSteps = nextReport[i][0]
+                        anyReport = True
+                stepsToGo = nextSteps
+                while stepsToGo > 10:
+                    self.integrator.step(10) # Only take 10 steps at a time, to give Python more chances to respond to a control-c.
+                    stepsToGo -= 10
+                self.integrator.step(stepsToGo)
+                self.currentStep += nextSteps
+                if anyReport:
+                    getPositions = False
+                    getVelocities = False
+                    getForces = False
+                    getEnergy = False
+                    for reporter, next in zip(self.reporters, nextReport):
+                        if next[0] == nextSteps:
+                            if next[1]:
+                                getPositions = True
+                            if next[2]:
+                                getVelocities = True
+                            if next[3]:
+                                getForces = True
+                            if next[4]:
+                                getEnergy = True
+                    state = self.context.getState(getPositions=getPositions, getVelocities=getVelocities, getForces=getForces, getEnergy=getEnergy, getParameters=True, enforcePeriodicBox=(self.topology.getUnitCellDimensions() is not None))
+                    asynchronousReporters = []
+                    for reporter, next in zip(self.reporters, nextReport):
+                        if next[0] == nextSteps:
+                            if self.asynchronousReports and getattr(reporter, 'asynchronous', False):
+                                asynchronousReporters.append(reporter)
+                            else:
+                                reporter.report(self, state)
+                    if len(asynchronousReporters) > 0:
+                        if self._reportWorker is None:
+                            self._reportWorker = _ReportWorker()
+                        worker = self._reportWorker
+                        worker.submit(asynchronousReporters, _SimulationSnapshot(self), state)
+        except:
+            # Let the queued reports finish, but make sure the original exception is the one that propagates.
+            if worker is not None:
+                worker.flush(raiseErrors=False)
+            raise
+        if worker is not None:
+            worker.flush()
+
+
+class _SimulationSnapshot(object):
+    """_SimulationSnapshot records the parts of a Simulation that asynchronous reporters may use, as of the
+    time a report was requested."""
+
+    def __init__(self, simulation):
+        self.topology = simulation.topology
+        self.system = simulation.system
+        self.integrator = simulation.integrator
+        self.currentStep = simulation.currentStep
+
+
+class _ReportWorker(object):
+    """_ReportWorker runs reporters on a background thread.
+
+    Each report is queued along with the State it describes.  The State already holds its own copy of the
+    data, so the simulation can continue while the reports are formatted and written.  At most maxQueued
+    reports may be waiting at once; beyond that, submit() blocks until the worker catches up.  An exception
+    raised by a reporter is rethrown by the next call to submit() or flush().
+
+    A Simulation keeps one worker for its whole lifetime.  The thread does not hold a reference to the
+    worker, so it is stopped when the worker is deleted.
+    """
+
+    def __init__(self, maxQueued=4):
+        self._queue = Queue.Queue(maxQueued)
+        self._errors = []
+        self._thread = threading.Thread(target=_runReports, args=(self._queue, self._errors))
+        self._thread.daemon = True
+        self._thread.start()
 
+    def __del__(self):
+        try:
+            self._queue.put(None)
+        except Exception:
+            pass # The interpreter may already be shutting down.
+
+    def submit(self, reporters, simulation, state):
+        """Queue a State to be passed to a list of reporters."""
+        self._checkForError()
+        self._queue.put((reporters, simulation, state))
+
+    def flush(self, raiseErrors=True):
+        """Wait for all queued reports to be completed.
+
+        If a reporter raised an exception, it is rethrown, or discarded if raiseErrors is False.
+        """
+        self._queue.join()
+        if raiseErrors:
+            self._checkForError()
+        else:
+            del self._errors[:]
+
+    def _checkForError(self):
+        if len(self._errors) > 0:
+            error = self._errors[0]
+            del self._errors[:]
+            raise error
+
+
+def _runReports(queue, errors):
+    """The main loop of a _ReportWorker's thread.  It stops when it receives None."""
+    while True:
+        item = queue.get()
+        try:
+            if item is None:
+                return
+            if len(errors) > 0:
+                continue # Once a reporter has failed, discard any remaining reports.
+            reporters, simulation, state = item
+            try:
+                for reporter in reporters:
+                    reporter.report(simulation, state)
+            except Exception as e:
+                errors.append(e)
+        finally:
+            queue.task_done()
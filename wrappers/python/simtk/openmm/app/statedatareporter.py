@@ -44,6 +44,10 @@ class StateDataReporter(object):
     written in comma-separated-value (CSV) format, but you can specify a different separator to use.
     """
 
+    ## Every value is computed from the State, the System, and the step index, so reports can be generated
+    ## asynchronously.
+    asynchronous = True
+
     def __init__(self, file, reportInterval, step=False, time=False, potentialEnergy=False, kineticEnergy=False, totalEnergy=False, temperature=False, volume=False, density=False, separator=',', systemMass=None):
         """Create a StateDataReporter.
 
@@ -32,6 +32,7 @@ namespace std {
   %template(mapstringstring) map<string,string>;
   %template(mapstringdouble) map<string,double>;
   %template(mapii) map<int,int>;
+  %template(vectormapstringdouble) vector< map<string,double> >;
 };
 
 %include "windows.i"
@@ -41,11 +42,13 @@ namespace std {
 
 #include <sstream>
 
+#include <cstring>
 #include <exception>
 #include <fstream>
 #include "OpenMM.h"
 #include "OpenMMAmoeba.h"
 #include "openmm/RPMDIntegrator.h"
+#include "openmm/RPMDMonteCarloBarostat.h"
 #include "OpenMMDrude.h"
 #include "openmm/serialization/SerializationNode.h"
 #include "openmm/serialization/SerializationProxy.h"
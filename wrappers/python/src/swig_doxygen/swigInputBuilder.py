@@ -57,6 +57,8 @@ def getText(subNodePath, node):
             s = "%s\n\n" % s
     return s.strip()
 
+VEC3_VECTOR_RE=re.compile(r"^const std::vector\s*<\s*(OpenMM::)?Vec3\s*>\s*&$")
+
 OPENMM_RE_PATTERN=re.compile("(.*)OpenMM:[a-zA-Z:]*:(.*)")
 def stripOpenmmPrefix(name, rePattern=OPENMM_RE_PATTERN):
     try:
@@ -423,6 +425,27 @@ class SwigInputBuilder:
                         self.fOutPythonprepend.write("%s   %s\n" % (INDENT, s))
 
                         self.fOutPythonprepend.write("%}\n\n")
+                else:
+                    # Tell stripUnits() which arguments are vectors of Vec3, so numpy arrays
+                    # passed for them are kept as arrays.
+                    vec3Args = []
+                    for i, pNode in enumerate(paramList):
+                        try:
+                            pType = getText('type', pNode)
+                        except IndexError:
+                            pType = getText('type/ref', pNode)
+                        if VEC3_VECTOR_RE.search(pType):
+                            vec3Args.append(str(i))
+                    if vec3Args:
+                        self.fOutPythonprepend.write("%pythonprepend")
+                        self.fOutPythonprepend.write(" OpenMM::%s::%s%s %%{\n"
+                                                     % (shortClassName,
+                                                        methName,
+                                                        mArgsstring))
+                        self.fOutPythonprepend.write("try: args=stripUnits(args, vec3Args=(%s,))\n"
+                                                     % ", ".join(vec3Args))
+                        self.fOutPythonprepend.write("except UnboundLocalError: pass\n")
+                        self.fOutPythonprepend.write("%}\n\n")
 
             #write pythonappend blocks
             if self.fOutPythonappend \
@@ -139,6 +139,7 @@ SKIP_METHODS = [('State',),
                 ('Platform', 'registerKernelFactory'),
                 ('IntegrateRPMDStepKernel',),
                 ('RPMDIntegrator',  'getState'),
+                ('RPMDMonteCarloBarostatImpl',),
                 ('DrudeForceImpl',),
                 ('CalcDrudeForceKernel',),
                 ('IntegrateDrudeLangevinStepKernel',),
@@ -154,6 +155,7 @@ NO_OUTPUT_ARGS = [('LocalEnergyMinimizer', 'minimize', 'context'),
                   ('System', 'getDefaultPeriodicBoxVectors', 'b'),
                   ('System', 'getDefaultPeriodicBoxVectors', 'c'),
                   ('Platform', 'setPropertyValue', 'context'),
+                  ('ReplicaExchange', 'addIntegrator', 'integrator'),
                   ('AmoebaTorsionTorsionForce', 'setTorsionTorsionGrid', 'grid'),
                   ('AmoebaVdwForce', 'setParticleExclusions', 'exclusions'),
                   ('AmoebaMultipoleForce', 'addParticle', 'molecularDipole'),
@@ -220,6 +222,11 @@ UNITS = {
 ("*", "getWeight12") : (None, ()),
 ("*", "getWeight13") : (None, ()),
 ("*", "getWeightCross") : (None, ()),
+("ReplicaExchange", "getPeriodicBoxVectors")
+ : (None, ('unit.nanometer', 'unit.nanometer', 'unit.nanometer')),
+("ReplicaExchange", "getPositions") : ("unit.nanometer", ()),
+("ReplicaExchange", "getVelocities") : ("unit.nanometer/unit.picosecond", ()),
+("ReplicaExchange", "getPotentialEnergy") : ("unit.kilojoule_per_mole", ()),
 ("SerializationNode", "getChildren") : (None, ()),
 ("SerializationNode", "getChildNode") : (None, ()),
 ("SerializationNode", "getProperties") : (None, ()),
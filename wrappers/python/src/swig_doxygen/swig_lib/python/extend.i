@@ -4,6 +4,8 @@
                             int getForces,
                             int getEnergy,
                             int getParameters,
+                            int getEnergyByGroup,
+                            int getEnergyByForce,
                             int enforcePeriodic,
                             int groups) {
     State state;
@@ -14,11 +16,37 @@
     if (getForces) types |= State::Forces;
     if (getEnergy) types |= State::Energy;
     if (getParameters) types |= State::Parameters;
+    if (getEnergyByGroup) types |= State::EnergyByGroup;
+    if (getEnergyByForce) types |= State::EnergyByForce;
     state = self->getState(types, enforcePeriodic, groups);
     Py_END_ALLOW_THREADS
     return _convertStateToLists(state);
   }
 
+  PyObject *_getStateAsBuffers(int getPositions,
+                               int getVelocities,
+                               int getForces,
+                               int getEnergy,
+                               int getParameters,
+                               int getEnergyByGroup,
+                               int getEnergyByForce,
+                               int enforcePeriodic,
+                               int groups) {
+    State state;
+    Py_BEGIN_ALLOW_THREADS
+    int types = 0;
+    if (getPositions) types |= State::Positions;
+    if (getVelocities) types |= State::Velocities;
+    if (getForces) types |= State::Forces;
+    if (getEnergy) types |= State::Energy;
+    if (getParameters) types |= State::Parameters;
+    if (getEnergyByGroup) types |= State::EnergyByGroup;
+    if (getEnergyByForce) types |= State::EnergyByForce;
+    state = self->getState(types, enforcePeriodic, groups);
+    Py_END_ALLOW_THREADS
+    return _convertStateToLists(state, true);
+  }
+
 
   %pythoncode {
     def getState(self,
@@ -28,7 +56,9 @@
                  getEnergy=False,
                  getParameters=False,
                  enforcePeriodicBox=False,
-                 groups=-1):
+                 groups=-1,
+                 getEnergyByGroup=False,
+                 getEnergyByForce=False):
         """
         getState(self,
                  getPositions = False,
@@ -37,7 +67,9 @@
                  getEnergy = False,
                  getParameters = False,
                  enforcePeriodicBox = False,
-                 groups = -1)
+                 groups = -1,
+                 getEnergyByGroup = False,
+                 getEnergyByForce = False)
               -> State
         
         Get a State object recording the current state information stored in this context.
@@ -50,6 +82,8 @@
          - getParameter (bool=False) whether to store context parameters in the State
          - enforcePeriodicBox (bool=False) if false, the position of each particle will be whatever position is stored in the Context, regardless of periodic boundary conditions.  If true, particle positions will be translated so the center of every molecule lies in the same periodic box.
          - groups (int=-1) a set of bit flags for which force groups to include when computing forces and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+         - getEnergyByGroup (bool=False) whether to store the potential energy of each force group in the State
+         - getEnergyByForce (bool=False) whether to store the potential energy of each Force in the State.  This is only supported on platforms that report the energy of each Force separately, such as Reference.
         """
         
         if getPositions: getP=1
@@ -62,12 +96,34 @@
         else: getE=0
         if getParameters: getPa=1
         else: getPa=0
+        if getEnergyByGroup: getEG=1
+        else: getEG=0
+        if getEnergyByForce: getEF=1
+        else: getEF=0
         if enforcePeriodicBox: enforcePeriodic=1
         else: enforcePeriodic=0
 
+        if 'numpy' in sys.modules:
+            # Transfer per-particle data as packed arrays, so no Python object is created for each particle.
+
+            (simTime, periodicBoxVectorsList, energy, coordBuffer, velBuffer,
+             forceBuffer, paramMap, groupEnergies, forceEnergies) = \
+                self._getStateAsBuffers(getP, getV, getF, getE, getPa, getEG, getEF, enforcePeriodic, groups)
+
+            state = State(simTime=simTime,
+                          energy=energy,
+                          coordArray=_bufferToArray(coordBuffer),
+                          velArray=_bufferToArray(velBuffer),
+                          forceArray=_bufferToArray(forceBuffer),
+                          periodicBoxVectorsList=periodicBoxVectorsList,
+                          paramMap=paramMap,
+                          groupEnergies=groupEnergies,
+                          forceEnergies=forceEnergies)
+            return state
+
         (simTime, periodicBoxVectorsList, energy, coordList, velList,
-         forceList, paramMap) = \
-            self._getStateAsLists(getP, getV, getF, getE, getPa, enforcePeriodic, groups)
+         forceList, paramMap, groupEnergies, forceEnergies) = \
+            self._getStateAsLists(getP, getV, getF, getE, getPa, getEG, getEF, enforcePeriodic, groups)
         
         state = State(simTime=simTime,
                       energy=energy,
@@ -75,7 +131,9 @@
                       velList=velList,
                       forceList=forceList,
                       periodicBoxVectorsList=periodicBoxVectorsList,
-                      paramMap=paramMap)
+                      paramMap=paramMap,
+                      groupEnergies=groupEnergies,
+                      forceEnergies=forceEnergies)
         return state
   
     def setState(self, state):
@@ -94,9 +152,13 @@
         """
         self.setTime(state._simTime)
         self.setPeriodicBoxVectors(state._periodicBoxVectorsList[0], state._periodicBoxVectorsList[1], state._periodicBoxVectorsList[2])
-        if state._coordList is not None:
+        if state._coordListNumpy is not None:
+             self.setPositions(state._coordListNumpy)
+        elif state._coordList is not None:
              self.setPositions(state._coordList)
-        if state._velList is not None:
+        if state._velListNumpy is not None:
+             self.setVelocities(state._velListNumpy)
+        elif state._velList is not None:
              self.setVelocities(state._velList)
         if state._paramMap is not None:
              for param in state._paramMap:
@@ -147,6 +209,8 @@ Parameters:
                             int getForces,
                             int getEnergy,
                             int getParameters,
+                            int getEnergyByGroup,
+                            int getEnergyByForce,
                             int enforcePeriodic,
                             int groups) {
     State state;
@@ -157,6 +221,8 @@ Parameters:
     if (getForces) types |= State::Forces;
     if (getEnergy) types |= State::Energy;
     if (getParameters) types |= State::Parameters;
+    if (getEnergyByGroup) types |= State::EnergyByGroup;
+    if (getEnergyByForce) types |= State::EnergyByForce;
     state = self->getState(copy, types, enforcePeriodic, groups);
     Py_END_ALLOW_THREADS
     return _convertStateToLists(state);
@@ -172,7 +238,9 @@ Parameters:
                  getEnergy=False,
                  getParameters=False,
                  enforcePeriodicBox=False,
-                 groups=-1):
+                 groups=-1,
+                 getEnergyByGroup=False,
+                 getEnergyByForce=False):
         """
         getState(self,
                  copy,
@@ -182,7 +250,9 @@ Parameters:
                  getEnergy = False,
                  getParameters = False,
                  enforcePeriodicBox = False,
-                 groups = -1)
+                 groups = -1,
+                 getEnergyByGroup = False,
+                 getEnergyByForce = False)
               -> State
         
         Get a State object recording the current state information about one copy of the system.
@@ -196,6 +266,8 @@ Parameters:
          - getParameter (bool=False) whether to store context parameters in the State
          - enforcePeriodicBox (bool=False) if false, the position of each particle will be whatever position is stored in the Context, regardless of periodic boundary conditions.  If true, particle positions will be translated so the center of every molecule lies in the same periodic box.
          - groups (int=-1) a set of bit flags for which force groups to include when computing forces and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+         - getEnergyByGroup (bool=False) whether to store the potential energy of each force group in the State
+         - getEnergyByForce (bool=False) whether to store the potential energy of each Force in the State.  This is only supported on platforms that report the energy of each Force separately, such as Reference.
         """
         
         if getPositions: getP=1
@@ -208,12 +280,16 @@ Parameters:
         else: getE=0
         if getParameters: getPa=1
         else: getPa=0
+        if getEnergyByGroup: getEG=1
+        else: getEG=0
+        if getEnergyByForce: getEF=1
+        else: getEF=0
         if enforcePeriodicBox: enforcePeriodic=1
         else: enforcePeriodic=0
 
         (simTime, periodicBoxVectorsList, energy, coordList, velList,
-         forceList, paramMap) = \
-            self._getStateAsLists(copy, getP, getV, getF, getE, getPa, enforcePeriodic, groups)
+         forceList, paramMap, groupEnergies, forceEnergies) = \
+            self._getStateAsLists(copy, getP, getV, getF, getE, getPa, getEG, getEF, enforcePeriodic, groups)
         
         state = State(simTime=simTime,
                       energy=energy,
@@ -221,7 +297,9 @@ Parameters:
                       velList=velList,
                       forceList=forceList,
                       periodicBoxVectorsList=periodicBoxVectorsList,
-                      paramMap=paramMap)
+                      paramMap=paramMap,
+                      groupEnergies=groupEnergies,
+                      forceEnergies=forceEnergies)
         return state
   }
 }
@@ -314,8 +392,10 @@ Parameters:
                                 double time,
                                 const std::vector<Vec3>& boxVectors,
                                 const std::map<string, double>& params,
+                                const std::vector<double>& groupEnergies,
+                                const std::vector<double>& forceEnergies,
                                 int types) {
-    OpenMM::State myState =  _convertListsToState(pos,vel,forces,kineticEnergy,potentialEnergy,time,boxVectors,params,types);
+    OpenMM::State myState =  _convertListsToState(pos,vel,forces,kineticEnergy,potentialEnergy,time,boxVectors,params,groupEnergies,forceEnergies,types);
     std::stringstream buffer;
     OpenMM::XmlSerializer::serialize<OpenMM::State>(&myState, "State", buffer);
     return buffer.str();
@@ -339,6 +419,8 @@ Parameters:
       kineticEnergy = 0.0
       potentialEnergy = 0.0
       params = {}
+      groupEnergies = []
+      forceEnergies = []
       types = 0
       try:
         positions = pythonState.getPositions().value_in_unit(unit.nanometers)
@@ -366,16 +448,26 @@ Parameters:
         types |= 16
       except:
         pass
+      try:
+        groupEnergies = pythonState.getPotentialEnergyByGroup().value_in_unit(unit.kilojoules_per_mole)
+        types |= 32
+      except:
+        pass
+      try:
+        forceEnergies = pythonState.getPotentialEnergyByForce().value_in_unit(unit.kilojoules_per_mole)
+        types |= 64
+      except:
+        pass
       time = pythonState.getTime().value_in_unit(unit.picoseconds)
       boxVectors = pythonState.getPeriodicBoxVectors().value_in_unit(unit.nanometers)
-      string = XmlSerializer._serializeStateAsLists(positions, velocities, forces, kineticEnergy, potentialEnergy, time, boxVectors, params, types)
+      string = XmlSerializer._serializeStateAsLists(positions, velocities, forces, kineticEnergy, potentialEnergy, time, boxVectors, params, groupEnergies, forceEnergies, types)
       return string  
 
     @staticmethod
     def _deserializeState(pythonString):
     
       (simTime, periodicBoxVectorsList, energy, coordList, velList,
-       forceList, paramMap) = XmlSerializer._deserializeStringIntoLists(pythonString)
+       forceList, paramMap, groupEnergies, forceEnergies) = XmlSerializer._deserializeStringIntoLists(pythonString)
       
       state = State(simTime=simTime,
                     energy=energy,
@@ -383,7 +475,9 @@ Parameters:
                     velList=velList,
                     forceList=forceList,
                     periodicBoxVectorsList=periodicBoxVectorsList,
-                    paramMap=paramMap)
+                    paramMap=paramMap,
+                    groupEnergies=groupEnergies,
+                    forceEnergies=forceEnergies)
       return state
 
     @staticmethod
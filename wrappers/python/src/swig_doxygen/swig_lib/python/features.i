@@ -2,6 +2,7 @@
 %include exceptions.i
 %include extend.i
 %include header.i
+%include forcefield.i
 %include pythonprepend_all.i
 %include pythonprepend.i
 %include pythonappend.i
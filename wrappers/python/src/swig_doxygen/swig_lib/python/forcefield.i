@@ -0,0 +1,220 @@
+/* Compiled helpers used by simtk.openmm.app.ForceField.createSystem().  They are not part of
+   the public API, so they are renamed to start with an underscore. */
+
+%rename(_ResidueTemplateMatcher) OpenMM::ResidueTemplateMatcher;
+%rename(_findAngles) OpenMM::findAngles;
+%rename(_findPropers) OpenMM::findPropers;
+%rename(_findImpropers) OpenMM::findImpropers;
+
+%inline %{
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+namespace OpenMM {
+
+/**
+ * This class determines which residue template each residue of a Topology matches, and which
+ * template atom each of its atoms corresponds to.  Atoms are described by their atomic number
+ * (or -1 if they have no element), their name, the other atoms in the same residue they are
+ * bonded to, and the number of bonds they form to atoms in other residues.
+ *
+ * Results are cached based on the residue's atoms and bond graph, so identical residues (such as
+ * water molecules or lipids) only need to be matched once.
+ */
+class ResidueTemplateMatcher {
+public:
+    ResidueTemplateMatcher() {
+    }
+    /**
+     * Add a template.  Returns the index of the template.
+     */
+    int addTemplate(const std::vector<int>& elements, const std::vector<std::string>& names,
+            const std::vector<std::vector<int> >& bondedTo, const std::vector<int>& externalBonds) {
+        templates.push_back(AtomGraph(elements, names, bondedTo, externalBonds));
+        return templates.size()-1;
+    }
+    /**
+     * Determine whether a residue matches a template.  Returns a vector specifying which atom of the
+     * template each atom of the residue corresponds to, or an empty vector if it does not match.
+     */
+    std::vector<int> matchResidue(int templateIndex, const std::vector<int>& elements, const std::vector<std::string>& names,
+            const std::vector<std::vector<int> >& bondedTo, const std::vector<int>& externalBonds) {
+        AtomGraph residue(elements, names, bondedTo, externalBonds);
+        std::pair<int, std::string> key(templateIndex, residue.getKey());
+        std::map<std::pair<int, std::string>, std::vector<int> >::const_iterator cached = cache.find(key);
+        if (cached != cache.end())
+            return cached->second;
+        const AtomGraph& templ = templates[templateIndex];
+        int numAtoms = residue.elements.size();
+        std::vector<int> matches(numAtoms, 0);
+        std::vector<bool> hasMatch(numAtoms, false);
+        if (numAtoms != (int) templ.elements.size() || !findAtomMatches(templ, residue, matches, hasMatch, 0))
+            matches.clear();
+        cache[key] = matches;
+        return matches;
+    }
+private:
+    struct AtomGraph {
+        AtomGraph(const std::vector<int>& elements, const std::vector<std::string>& names,
+                const std::vector<std::vector<int> >& bondedTo, const std::vector<int>& externalBonds) :
+                elements(elements), names(names), externalBonds(externalBonds) {
+            for (int i = 0; i < (int) bondedTo.size(); i++)
+                this->bondedTo.push_back(std::set<int>(bondedTo[i].begin(), bondedTo[i].end()));
+        }
+        std::string getKey() const {
+            std::stringstream key;
+            for (int i = 0; i < (int) elements.size(); i++) {
+                key << elements[i] << ' ' << names[i] << ' ' << externalBonds[i];
+                for (std::set<int>::const_iterator iter = bondedTo[i].begin(); iter != bondedTo[i].end(); ++iter)
+                    key << ' ' << *iter;
+                key << '\n';
+            }
+            return key.str();
+        }
+        std::vector<int> elements;
+        std::vector<std::string> names;
+        std::vector<std::set<int> > bondedTo;
+        std::vector<int> externalBonds;
+    };
+    static bool findAtomMatches(const AtomGraph& templ, const AtomGraph& residue, std::vector<int>& matches, std::vector<bool>& hasMatch, int position) {
+        // This is the same backtracking search as _findAtomMatches() in forcefield.py.
+
+        int numAtoms = residue.elements.size();
+        if (position == numAtoms)
+            return true;
+        int element = residue.elements[position];
+        const std::set<int>& bonded = residue.bondedTo[position];
+        for (int i = 0; i < numAtoms; i++) {
+            if (hasMatch[i] || templ.bondedTo[i].size() != bonded.size() || templ.externalBonds[i] != residue.externalBonds[position])
+                continue;
+            if (templ.elements[i] != element && !(templ.elements[i] == -1 && templ.names[i] == residue.names[position]))
+                continue;
+
+            // See if the bonds for this identification are consistent.
+
+            bool allBondsMatch = true;
+            for (std::set<int>::const_iterator iter = bonded.begin(); iter != bonded.end() && allBondsMatch; ++iter)
+                if (*iter < position && templ.bondedTo[i].find(matches[*iter]) == templ.bondedTo[i].end())
+                    allBondsMatch = false;
+            if (allBondsMatch) {
+                // This is a possible match, so trying matching the rest of the residue.
+
+                matches[position] = i;
+                hasMatch[i] = true;
+                if (findAtomMatches(templ, residue, matches, hasMatch, position+1))
+                    return true;
+                hasMatch[i] = false;
+            }
+        }
+        return false;
+    }
+    std::vector<AtomGraph> templates;
+    std::map<std::pair<int, std::string>, std::vector<int> > cache;
+};
+
+/**
+ * Find all unique angles formed by the bonds in a system, given the atoms each atom is bonded to.
+ * Each angle is ordered so that its first atom has a lower index than its last one, and the angles
+ * are returned in sorted order.
+ */
+std::vector<std::vector<int> > findAngles(const std::vector<std::vector<int> >& bondedTo) {
+    std::vector<std::vector<int> > angles;
+    std::vector<int> angle(3);
+    for (int center = 0; center < (int) bondedTo.size(); center++) {
+        const std::vector<int>& bonded = bondedTo[center];
+        for (int i = 0; i < (int) bonded.size(); i++)
+            for (int j = i+1; j < (int) bonded.size(); j++) {
+                angle[0] = std::min(bonded[i], bonded[j]);
+                angle[1] = center;
+                angle[2] = std::max(bonded[i], bonded[j]);
+                if (angle[0] != angle[2])
+                    angles.push_back(angle);
+            }
+    }
+    std::sort(angles.begin(), angles.end());
+    angles.erase(std::unique(angles.begin(), angles.end()), angles.end());
+    return angles;
+}
+
+/**
+ * Find all unique proper torsions, given the atoms each atom is bonded to and the list of angles
+ * returned by findAngles().  Each torsion is ordered so that its first atom has a lower index than
+ * its last one, and the torsions are returned in sorted order.
+ */
+std::vector<std::vector<int> > findPropers(const std::vector<std::vector<int> >& bondedTo, const std::vector<std::vector<int> >& angles) {
+    std::vector<std::vector<int> > propers;
+    std::vector<int> torsion(4);
+    for (int i = 0; i < (int) angles.size(); i++) {
+        const std::vector<int>& angle = angles[i];
+        const std::vector<int>& bonded0 = bondedTo[angle[0]];
+        for (int j = 0; j < (int) bonded0.size(); j++) {
+            int atom = bonded0[j];
+            if (atom == angle[1])
+                continue;
+            if (atom < angle[2]) {
+                torsion[0] = atom;
+                torsion[1] = angle[0];
+                torsion[2] = angle[1];
+                torsion[3] = angle[2];
+            }
+            else {
+                torsion[0] = angle[2];
+                torsion[1] = angle[1];
+                torsion[2] = angle[0];
+                torsion[3] = atom;
+            }
+            propers.push_back(torsion);
+        }
+        const std::vector<int>& bonded2 = bondedTo[angle[2]];
+        for (int j = 0; j < (int) bonded2.size(); j++) {
+            int atom = bonded2[j];
+            if (atom == angle[1])
+                continue;
+            if (atom > angle[0]) {
+                torsion[0] = angle[0];
+                torsion[1] = angle[1];
+                torsion[2] = angle[2];
+                torsion[3] = atom;
+            }
+            else {
+                torsion[0] = atom;
+                torsion[1] = angle[2];
+                torsion[2] = angle[1];
+                torsion[3] = angle[0];
+            }
+            propers.push_back(torsion);
+        }
+    }
+    std::sort(propers.begin(), propers.end());
+    propers.erase(std::unique(propers.begin(), propers.end()), propers.end());
+    return propers;
+}
+
+/**
+ * Find all improper torsions: every combination of three atoms bonded to a common central atom.
+ * The central atom comes first.  The combinations are generated in the same order as
+ * itertools.combinations(), based on the order in which bondedTo lists the atoms.
+ */
+std::vector<std::vector<int> > findImpropers(const std::vector<std::vector<int> >& bondedTo) {
+    std::vector<std::vector<int> > impropers;
+    std::vector<int> torsion(4);
+    for (int atom = 0; atom < (int) bondedTo.size(); atom++) {
+        const std::vector<int>& bonded = bondedTo[atom];
+        int numBonded = bonded.size();
+        torsion[0] = atom;
+        for (int i = 0; i < numBonded; i++)
+            for (int j = i+1; j < numBonded; j++)
+                for (int k = j+1; k < numBonded; k++) {
+                    torsion[1] = bonded[i];
+                    torsion[2] = bonded[j];
+                    torsion[3] = bonded[k];
+                    impropers.push_back(torsion);
+                }
+    }
+    return impropers;
+}
+
+} // namespace OpenMM
+%}
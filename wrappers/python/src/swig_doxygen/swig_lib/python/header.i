@@ -20,6 +20,58 @@ PyObject *copyVVec3ToList(std::vector<Vec3> vVec3) {
   return pyList;
 }
 
+PyObject *copyVDoubleToList(const std::vector<double>& values) {
+  int n = values.size();
+  PyObject* pyList = PyList_New(n);
+  for (int i = 0; i < n; i++)
+    PyList_SET_ITEM(pyList, i, PyFloat_FromDouble(values[i]));
+  return pyList;
+}
+
+/* Copy a vector of Vec3 objects into a bytearray of packed doubles.  Python code can view this
+   as an (N,3) array with numpy.frombuffer(), without creating an object for every element.
+   Returns NULL with a Python exception set if the bytearray cannot be allocated. */
+PyObject *copyVVec3ToBuffer(const std::vector<Vec3>& vVec3) {
+  int n = vVec3.size();
+  PyObject* buffer = PyByteArray_FromStringAndSize(NULL, 3*n*sizeof(double));
+  if (buffer == NULL)
+    return NULL;
+  double* data = (double*) PyByteArray_AS_STRING(buffer);
+  for (int i = 0; i < n; i++) {
+    const OpenMM::Vec3& v = vVec3[i];
+    data[3*i] = v[0];
+    data[3*i+1] = v[1];
+    data[3*i+2] = v[2];
+  }
+  return buffer;
+}
+
+/* If obj exposes a C-contiguous (N,3) array of native doubles through the buffer protocol,
+   copy it into vVec and return true.  Otherwise return false and leave vVec unchanged. */
+bool copyBufferToVVec3(PyObject* obj, std::vector<Vec3>& vVec) {
+  if (!PyObject_CheckBuffer(obj))
+    return false;
+  Py_buffer view;
+  if (PyObject_GetBuffer(obj, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+    PyErr_Clear();
+    return false;
+  }
+  const char* format = view.format;
+  if (format != NULL && (format[0] == '@' || format[0] == '=' || format[0] == '<'))
+    format++;
+  bool isVec3Array = (format != NULL && strcmp(format, "d") == 0 && view.itemsize == sizeof(double) &&
+                      view.ndim == 2 && view.shape[1] == 3);
+  if (isVec3Array) {
+    int n = (int) view.shape[0];
+    const double* data = (const double*) view.buf;
+    vVec.resize(n);
+    for (int i = 0; i < n; i++)
+      vVec[i] = OpenMM::Vec3(data[3*i], data[3*i+1], data[3*i+2]);
+  }
+  PyBuffer_Release(&view);
+  return isVec3Array;
+}
+
 State _convertListsToState( const std::vector<Vec3> &pos, 
                             const std::vector<Vec3> &vel, 
                             const std::vector<Vec3> &forces,
@@ -28,6 +80,8 @@ State _convertListsToState( const std::vector<Vec3> &pos,
                             double time,
                             const std::vector<Vec3> &boxVectors,
                             const std::map<std::string, double> &params,
+                            const std::vector<double> &groupEnergies,
+                            const std::vector<double> &forceEnergies,
                             int types ) {  
     State::StateBuilder sb(time); 
     if(types & State::Positions)
@@ -40,11 +94,15 @@ State _convertListsToState( const std::vector<Vec3> &pos,
       sb.setEnergy(kineticEnergy, potentialEnergy);
     if(types & State::Parameters)
       sb.setParameters(params);
+    if(types & State::EnergyByGroup)
+      sb.setEnergyByGroup(groupEnergies);
+    if(types & State::EnergyByForce)
+      sb.setEnergyByForce(forceEnergies);
     sb.setPeriodicBoxVectors(boxVectors[0], boxVectors[1], boxVectors[2]);
     return sb.getState();
 }
 
-PyObject *_convertStateToLists(const State& state) {
+PyObject *_convertStateToLists(const State& state, bool asBuffers=false) {
     double simTime;
     PyObject *pPeriodicBoxVectorsList;
     PyObject *pEnergy;
@@ -53,6 +111,8 @@ PyObject *_convertStateToLists(const State& state) {
     PyObject *pForces;
     PyObject *pyTuple;
     PyObject *pParameters;
+    PyObject *pGroupEnergies;
+    PyObject *pForceEnergies;
     simTime=state.getTime();
 
     OpenMM::Vec3 myVecA;
@@ -73,21 +133,21 @@ PyObject *_convertStateToLists(const State& state) {
     pPeriodicBoxVectorsList = Py_BuildValue("N,N,N", pyVec1, pyVec2, pyVec3);
 
     try {
-      pPositions = copyVVec3ToList(state.getPositions());
+      pPositions = (asBuffers ? copyVVec3ToBuffer(state.getPositions()) : copyVVec3ToList(state.getPositions()));
     }
     catch (std::exception& ex) {
       pPositions = Py_None;
       Py_INCREF(Py_None);
     }
     try {
-      pVelocities = copyVVec3ToList(state.getVelocities());
+      pVelocities = (asBuffers ? copyVVec3ToBuffer(state.getVelocities()) : copyVVec3ToList(state.getVelocities()));
     }
     catch (std::exception& ex) {
       pVelocities = Py_None;
       Py_INCREF(Py_None);
     }
     try {
-      pForces = copyVVec3ToList(state.getForces());
+      pForces = (asBuffers ? copyVVec3ToBuffer(state.getForces()) : copyVVec3ToList(state.getForces()));
     }
     catch (std::exception& ex) {
       pForces = Py_None;
@@ -112,11 +172,39 @@ PyObject *_convertStateToLists(const State& state) {
       pParameters = Py_None;
       Py_INCREF(Py_None);
     }
+    try {
+      pGroupEnergies = copyVDoubleToList(state.getPotentialEnergyByGroup());
+    }
+    catch (std::exception& ex) {
+      pGroupEnergies = Py_None;
+      Py_INCREF(Py_None);
+    }
+    try {
+      pForceEnergies = copyVDoubleToList(state.getPotentialEnergyByForce());
+    }
+    catch (std::exception& ex) {
+      pForceEnergies = Py_None;
+      Py_INCREF(Py_None);
+    }
+
+    if (pPositions == NULL || pVelocities == NULL || pForces == NULL) {
+      // A buffer could not be allocated.  Release everything else and let the Python exception propagate.
+      Py_DECREF(pPeriodicBoxVectorsList);
+      Py_DECREF(pEnergy);
+      Py_XDECREF(pPositions);
+      Py_XDECREF(pVelocities);
+      Py_XDECREF(pForces);
+      Py_DECREF(pParameters);
+      Py_DECREF(pGroupEnergies);
+      Py_DECREF(pForceEnergies);
+      return NULL;
+    }
   
-    pyTuple=Py_BuildValue("(d,N,N,N,N,N,N)",
+    pyTuple=Py_BuildValue("(d,N,N,N,N,N,N,N,N)",
                           simTime, pPeriodicBoxVectorsList, pEnergy,
                           pPositions, pVelocities,
-                          pForces, pParameters);
+                          pForces, pParameters,
+                          pGroupEnergies, pForceEnergies);
   
     return pyTuple;
 }
@@ -56,7 +56,12 @@ class State(_object):
                  velList=None,
                  forceList=None,
                  periodicBoxVectorsList=None,
-                 paramMap=None):
+                 paramMap=None,
+                 coordArray=None,
+                 velArray=None,
+                 forceArray=None,
+                 groupEnergies=None,
+                 forceEnergies=None):
         self._simTime=simTime
         self._periodicBoxVectorsList=periodicBoxVectorsList
         self._periodicBoxVectorsListNumpy=None
@@ -67,12 +72,14 @@ class State(_object):
             self._eK0=None
             self._eP0=None
         self._coordList=coordList
-        self._coordListNumpy=None
+        self._coordListNumpy=coordArray
         self._velList=velList
-        self._velListNumpy=None
+        self._velListNumpy=velArray
         self._forceList=forceList
-        self._forceListNumpy=None
+        self._forceListNumpy=forceArray
         self._paramMap=paramMap
+        self._groupEnergies=groupEnergies
+        self._forceEnergies=forceEnergies
 
     def __getstate__(self):
         serializationString = XmlSerializer.serializeState(self)
@@ -123,7 +130,7 @@ class State(_object):
            or unit.nanometer.  See the following for details:
            https://simtk.org/home/python_units
            """
-        if self._coordList is None:
+        if self._coordList is None and self._coordListNumpy is None:
             raise TypeError('Positions were not requested in getState() call, so are not available.')
 
         if asNumpy:
@@ -131,6 +138,8 @@ class State(_object):
                 self._coordListNumpy=numpy.array(self._coordList)
             returnValue=self._coordListNumpy
         else:
+            if self._coordList is None:
+                self._coordList=_arrayToVec3List(self._coordListNumpy)
             returnValue=self._coordList
 
         returnValue = unit.Quantity(returnValue, unit.nanometers)
@@ -147,7 +156,7 @@ class State(_object):
            etc.  See the following for details:
            https://simtk.org/home/python_units
            """
-        if self._velList is None:
+        if self._velList is None and self._velListNumpy is None:
             raise TypeError('Velocities were not requested in getState() call, so are not available.')
 
         if asNumpy:
@@ -155,6 +164,8 @@ class State(_object):
                 self._velListNumpy=numpy.array(self._velList)
             returnValue=self._velListNumpy
         else:
+            if self._velList is None:
+                self._velList=_arrayToVec3List(self._velListNumpy)
             returnValue=self._velList
 
         returnValue = unit.Quantity(returnValue, unit.nanometers/unit.picosecond)
@@ -172,7 +183,7 @@ class State(_object):
            See the following for details:
            https://simtk.org/home/python_units
            """
-        if self._forceList is None:
+        if self._forceList is None and self._forceListNumpy is None:
             raise TypeError('Forces were not requested in getState() call, so are not available.')
 
         if asNumpy:
@@ -180,6 +191,8 @@ class State(_object):
                 self._forceListNumpy=numpy.array(self._forceList)
             returnValue=self._forceListNumpy
         else:
+            if self._forceList is None:
+                self._forceList=_arrayToVec3List(self._forceListNumpy)
             returnValue=self._forceList
 
         returnValue = unit.Quantity(returnValue,
@@ -208,6 +221,22 @@ class State(_object):
             raise TypeError('Energy was not requested in getState() call, so it is not available.')
         return self._eP0 * unit.kilojoule_per_mole
 
+    def getPotentialEnergyByGroup(self):
+        """Get a list containing the potential energy of each force group with units.
+           Element i is the energy of group i, or 0 if that group was not included.
+        """
+        if self._groupEnergies is None:
+            raise TypeError('Energy by group was not requested in getState() call, so it is not available.')
+        return self._groupEnergies * unit.kilojoule_per_mole
+
+    def getPotentialEnergyByForce(self):
+        """Get a list containing the potential energy of each Force in the System with units.
+           Element i is the energy of Force i, or 0 if its group was not included.
+        """
+        if self._forceEnergies is None:
+            raise TypeError('Energy by force was not requested in getState() call, so it is not available.')
+        return self._forceEnergies * unit.kilojoule_per_mole
+
     def getParameters(self):
         """Get a map containing the values of all parameters.
         """
@@ -216,6 +245,17 @@ class State(_object):
         return self._paramMap
 
 
+def _bufferToArray(buffer):
+    """Wrap a buffer of packed doubles returned by the C++ code as an (N,3) numpy array without copying it."""
+    if buffer is None:
+        return None
+    return numpy.frombuffer(buffer, dtype=numpy.float64).reshape(-1, 3)
+
+def _arrayToVec3List(array):
+    """Convert an (N,3) numpy array to a list of Vec3 objects."""
+    return [Vec3(v[0], v[1], v[2]) for v in array.tolist()]
+
+
 # Strings can cause trouble
 # as can any container that has infinite levels of containment
 def _is_string(x):
@@ -233,11 +273,16 @@ def _is_string(x):
      except StopIteration:
          return False
 
-def stripUnits(args):
+def stripUnits(args, vec3Args=()):
     """
     getState(self, quantity) 
           -> value with *no* units
 
+    vec3Args lists the positions of arguments that are passed to C++ as vectors of Vec3.
+    An (N,3) numpy array in one of those positions is kept as an array of doubles, so it
+    can be copied without creating an object for each element.  All other numpy arrays
+    are converted to lists.
+
     Examples
     >>> import simtk
 
@@ -273,9 +318,13 @@ def stripUnits(args):
 
     """
     newArgList=[]
-    for arg in args:
+    for i, arg in enumerate(args):
         if 'numpy' in sys.modules and isinstance(arg, numpy.ndarray):
-           arg = arg.tolist()
+           if i in vec3Args and arg.ndim == 2 and arg.shape[1] == 3:
+               # Keep arrays of vectors as arrays, so they can be passed to C++ without creating an object for each element.
+               arg = numpy.ascontiguousarray(arg, dtype=numpy.float64)
+           else:
+               arg = arg.tolist()
         elif unit.is_quantity(arg):
             # JDC: Ugly workaround for OpenMM using 'bar' for fundamental pressure unit.
             if arg.unit.is_compatible(unit.bar):
@@ -7,7 +7,11 @@
   PyObject *o;
   PyObject *o1;
 
-  pLength=(int)PySequence_Length($input);
+  // Contiguous (N,3) arrays of doubles, such as numpy arrays, are copied directly.
+  if (OpenMM::copyBufferToVVec3($input, vVec))
+    pLength=0;
+  else
+    pLength=(int)PySequence_Length($input);
   for (i=0; i<pLength; i++) {
     o=PySequence_GetItem($input, i);
     itemLength = (int) PySequence_Length(o);